@@ -1,4 +1,7 @@
 #define NR_OF_LIGHTS 4
+#define PREFILTER_CACHE_PATH "prefilterMap.iblcache"
+#define BRDF_LUT_CACHE_PATH "brdfLUT.lutcache"
+#define ENVIRONMENT_CACHE_PATH "environmentMap.iblcache"
 #include <stdio.h>
 #include <stdlib.h>
 #include <cmath>
@@ -29,7 +32,31 @@
 #include "src/Framebuffer.h"
 #include "src/Shadows.h"
 #include "src/Bloom.h"
+#include "src/TAA.h"
+#include "src/DynamicResolution.h"
+#include "src/Upscaler.h"
+#include "src/IBLCache.h"
+#include "src/SphericalHarmonics.h"
+#include "src/BRDFLUT.h"
+#include "src/EnvironmentMap.h"
+#include "src/ReflectionProbes.h"
+#include "src/IrradianceVolume.h"
+#include "src/VisibilityBuffer.h"
+#include "src/Profiler.h"
+#include "src/Bounds.h"
+#include "src/FrustumCuller.h"
+#include "src/DrawList.h"
+#include "src/DepthPrepass.h"
+#include "src/Transparency.h"
+#include "src/SSR.h"
 #include "src/Scene.h"
+#include "src/JobSystem.h"
+#include "src/TextureLoader.h"
+#include "src/SceneJobs.h"
+#include "src/BVH.h"
+#include "src/SpatialIndex.h"
+#include "src/OcclusionCuller.h"
+#include "src/HiZOcclusion.h"
 #include "src/Assets.h"
 #include "src/MasterRenderer.h"
 
@@ -44,11 +71,16 @@ float calculateExposure(unsigned int FBO);
 void renderSphere();
 void renderQuad();
 void renderCube();
+void renderSpherePositions();
+void renderCubePositions();
+void generateSphere(std::vector<glm::vec3>& positions, std::vector<glm::vec3>& normals, std::vector<glm::vec2>& uvs, std::vector<unsigned int>& indices, unsigned int segments = 64);
+void generateCube(std::vector<glm::vec3>& positions, std::vector<glm::vec3>& normals, std::vector<glm::vec2>& uvs, std::vector<unsigned int>& indices);
 
 const float Pi = 3.14159265359f;
 
 unsigned int wWidth = 1920 * 1 / 2, wHeight = 1080 * 1 / 2;
 unsigned int ImGuiWindowWidth = 400, ImGuiWindowHeight = wHeight;
+unsigned int maxRenderWidth = wWidth, maxRenderHeight = wHeight; //size the render targets are allocated at, the scene is rendered into a part of them
 bool fullscreen = false, fKeyPressed = false;
 
 // camera
@@ -68,6 +100,25 @@ float exposure = 0.0f;
 float bloom = 0.05f;
 bool lensDirt = true;
 
+bool taaEnabled = true;
+int taaSSAOKernelSize = 16; //SSAO kernel size used while TAA is on, the noise changes every frame so the samples accumulate over time
+
+bool visibilityBufferEnabled = false; //writes the G-buffer through the visibility buffer instead of rasterizing the materials directly
+#define VISIBILITY_BENCHMARK_FRAMES 600
+
+#define MAX_GLASS_ORBS 4096
+#define SCENE_BENCHMARK_NODES 1000000
+#define BVH_BENCHMARK_OBJECTS 100000
+#define OCCLUSION_BENCHMARK_OBJECTS 100000
+bool sceneJobsCulling = true; //the draw list and the shadow casters come from the scene jobs' culled views instead of culling the spheres in every pass
+bool occlusionCullingEnabled = true; //drops the G-buffer objects hidden behind the others in a small depth buffer rasterized on the CPU
+int nrOfGlassOrbs = 1024; //transparent instances drawn by the weighted blended transparency pass
+bool hiZOcclusionEnabled = true; //culls the glass orbs hidden behind the opaque depth on the GPU before they are drawn
+
+DynamicResolution dynamicResolution(0.5f, 1.0f, DRS_DEFAULT_TARGET_FRAME_TIME);
+UpscalerPreset upscalerPreset = UPSCALER_NATIVE; //fixed render scale, the scene is upscaled to the window by the spatial upscaler
+EnvironmentBakePath environmentBakePath = ENVIRONMENT_BAKE_GPU; //the CPU path gives the same cubemap without rendering, for headless bakes
+
 int ssaoKernalSize = 64;
 float ssaoRadius = 0.5f;
 float ssaoBias = 0.025;
@@ -126,8 +177,21 @@ int main()
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 330 core");
 
+    //worker threads for the CPU side work, the main thread runs jobs as well while it waits for them
+    JobSystem& jobSystem = GetJobSystem();
+    jobSystem.Init();
+
     stbi_set_flip_vertically_on_load(1);
 
+    //render targets are allocated once for the largest size the window can be, resizing and dynamic resolution only change the viewport
+    const GLFWvidmode* videoMode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+    if(videoMode)
+    {
+        maxRenderWidth = std::max(maxRenderWidth, (unsigned int)videoMode->width);
+        maxRenderHeight = std::max(maxRenderHeight, (unsigned int)videoMode->height);
+    }
+    dynamicResolution.Init(maxRenderWidth, maxRenderHeight);
+
     glEnable(GL_DEPTH_TEST);//enables the Depth Buffer and depth testing
     glDepthFunc(GL_LEQUAL);
     glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
@@ -137,9 +201,7 @@ int main()
     DShader defaultBlinnPhongShader("ProgramFiles\\Resources\\Shaders\\default\\defaultBlinnPhongShader.V.shader", "ProgramFiles\\Resources\\Shaders\\default\\defaultBlinnPhongShader.F.shader");
     DShader defaultPBRShader("ProgramFiles\\Resources\\Shaders\\default\\defaultPBRShader.V.shader", "ProgramFiles\\Resources\\Shaders\\default\\defaultPBRShader.F.shader");
 
-    Shader irradianceShader("ProgramFiles\\Resources\\Shaders\\cubemap.V.shader", "ProgramFiles\\Resources\\Shaders\\irradianceConvolution.F.shader");
     Shader prefilterShader("ProgramFiles\\Resources\\Shaders\\cubemap.V.shader", "ProgramFiles\\Resources\\Shaders\\prefilter.F.shader");
-    Shader brdfShader("ProgramFiles\\Resources\\Shaders\\BRDF.V.shader", "ProgramFiles\\Resources\\Shaders\\BRDF.F.shader");
     Shader backgroundShader("ProgramFiles\\Resources\\Shaders\\background.V.shader", "ProgramFiles\\Resources\\Shaders\\background.F.shader");
 
     Shader bloomShader("ProgramFiles\\Resources\\Shaders\\Bloom\\finalBloom.V.shader", "ProgramFiles\\Resources\\Shaders\\Bloom\\finalBloom.F.shader");
@@ -152,7 +214,6 @@ int main()
     Shader SSAOBlurShader("ProgramFiles\\Resources\\Shaders\\SSAO\\SSAO.V.shader", "ProgramFiles\\Resources\\Shaders\\SSAO\\SSAOBlur.F.shader");
 
     PBRSecondPass.use();
-    PBRSecondPass.setInt("irradianceMap", 0);
     PBRSecondPass.setInt("prefilterMap", 1);
     PBRSecondPass.setInt("brdfLUT", 2);
     PBRSecondPass.setInt("LoMap", 3);
@@ -167,41 +228,44 @@ int main()
     backgroundShader.setInt("environmentMap", 0);
 
     //textures
-    unsigned int ironAlbedoMap       = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\rustedIron\\albedo.png   ");
-    unsigned int ironNormalMap       = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\rustedIron\\normal.png   ");
-    unsigned int ironMetallicMap     = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\rustedIron\\metallic.png ");
-    unsigned int ironRoughnessMap    = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\rustedIron\\roughness.png");
-    unsigned int ironAOMap           = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\rustedIron\\ao.png       ");
+    //the material textures are decoded in parallel and uploaded together
+    TextureLoader textureLoader;
+    unsigned int ironAlbedoMap       = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\rustedIron\\albedo.png   ");
+    unsigned int ironNormalMap       = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\rustedIron\\normal.png   ");
+    unsigned int ironMetallicMap     = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\rustedIron\\metallic.png ");
+    unsigned int ironRoughnessMap    = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\rustedIron\\roughness.png");
+    unsigned int ironAOMap           = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\rustedIron\\ao.png       ");
                                      
-    unsigned int goldAlbedoMap       = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\gold\\albedo.png   ");
-    unsigned int goldNormalMap       = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\gold\\normal.png   ");
-    unsigned int goldMetallicMap     = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\gold\\metallic.png ");
-    unsigned int goldRoughnessMap    = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\gold\\roughness.png");
-    unsigned int goldAOMap           = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\gold\\ao.png       ");
-
-    unsigned int grassAlbedoMap      = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\grass\\albedo.png   ");
-    unsigned int grassNormalMap      = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\grass\\normal.png   ");
-    unsigned int grassMetallicMap    = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\grass\\metallic.png ");
-    unsigned int grassRoughnessMap   = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\grass\\roughness.png");
-    unsigned int grassAOMap          = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\grass\\ao.png       ");
-
-    unsigned int plasticAlbedoMap    = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\plastic\\albedo.png   ");
-    unsigned int plasticNormalMap    = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\plastic\\normal.png   ");
-    unsigned int plasticMetallicMap  = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\plastic\\metallic.png ");
-    unsigned int plasticRoughnessMap = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\plastic\\roughness.png");
-    unsigned int plasticAOMap        = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\plastic\\ao.png       ");
-
-    unsigned int wallAlbedoMap       = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\wall\\albedo.png   ");
-    unsigned int wallNormalMap       = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\wall\\normal.png   ");
-    unsigned int wallMetallicMap     = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\wall\\metallic.png ");
-    unsigned int wallRoughnessMap    = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\wall\\roughness.png");
-    unsigned int wallAOMap           = loadTexture("ProgramFiles\\Resources\\Textures\\pbr\\wall\\ao.png       ");
-
-    unsigned int cubeAlbedoMap = loadTexture("ProgramFiles\\Resources\\Textures\\metal.png");
-    unsigned int cubeNormalMap = loadTexture("ProgramFiles\\Resources\\Textures\\toy_box_normal.png");
-    unsigned int cubeMetallicMap = loadTexture("ProgramFiles\\Resources\\Textures\\noise.png");
-    unsigned int cubeRoughnessMap = loadTexture("ProgramFiles\\Resources\\Textures\\noise.png");
-    unsigned int cubeAOMap = loadTexture("ProgramFiles\\Resources\\Textures\\noise.png");
+    unsigned int goldAlbedoMap       = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\gold\\albedo.png   ");
+    unsigned int goldNormalMap       = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\gold\\normal.png   ");
+    unsigned int goldMetallicMap     = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\gold\\metallic.png ");
+    unsigned int goldRoughnessMap    = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\gold\\roughness.png");
+    unsigned int goldAOMap           = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\gold\\ao.png       ");
+
+    unsigned int grassAlbedoMap      = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\grass\\albedo.png   ");
+    unsigned int grassNormalMap      = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\grass\\normal.png   ");
+    unsigned int grassMetallicMap    = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\grass\\metallic.png ");
+    unsigned int grassRoughnessMap   = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\grass\\roughness.png");
+    unsigned int grassAOMap          = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\grass\\ao.png       ");
+
+    unsigned int plasticAlbedoMap    = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\plastic\\albedo.png   ");
+    unsigned int plasticNormalMap    = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\plastic\\normal.png   ");
+    unsigned int plasticMetallicMap  = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\plastic\\metallic.png ");
+    unsigned int plasticRoughnessMap = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\plastic\\roughness.png");
+    unsigned int plasticAOMap        = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\plastic\\ao.png       ");
+
+    unsigned int wallAlbedoMap       = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\wall\\albedo.png   ");
+    unsigned int wallNormalMap       = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\wall\\normal.png   ");
+    unsigned int wallMetallicMap     = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\wall\\metallic.png ");
+    unsigned int wallRoughnessMap    = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\wall\\roughness.png");
+    unsigned int wallAOMap           = textureLoader.Load("ProgramFiles\\Resources\\Textures\\pbr\\wall\\ao.png       ");
+
+    unsigned int cubeAlbedoMap = textureLoader.Load("ProgramFiles\\Resources\\Textures\\metal.png");
+    unsigned int cubeNormalMap = textureLoader.Load("ProgramFiles\\Resources\\Textures\\toy_box_normal.png");
+    unsigned int cubeMetallicMap = textureLoader.Load("ProgramFiles\\Resources\\Textures\\noise.png");
+    unsigned int cubeRoughnessMap = textureLoader.Load("ProgramFiles\\Resources\\Textures\\noise.png");
+    unsigned int cubeAOMap = textureLoader.Load("ProgramFiles\\Resources\\Textures\\noise.png");
+    textureLoader.Finish();
 
 
     //light properties
@@ -231,12 +295,12 @@ int main()
         SSAOSamples.push_back(sample);
     }
 
-    Framebuffer gBuffer(wWidth, wHeight, 1, true);
-    gBuffer.addTextureAttachment(GL_RGB, GL_RGB, GL_NEAREST, GL_NEAREST); //Material Mask texture
-    gBuffer.addTextureAttachment(GL_RGBA16F, GL_RGBA, GL_LINEAR, GL_LINEAR); //Normal/transparency texture
-    gBuffer.addTextureAttachment(GL_RGBA, GL_RGBA, GL_LINEAR, GL_LINEAR); //Albedo texture
-    gBuffer.addTextureAttachment(GL_RGB, GL_RGB, GL_NEAREST, GL_NEAREST); //Metallic/Roughness/Ambient occlusion texture
+    Framebuffer gBuffer(maxRenderWidth, maxRenderHeight, 1, true);
+    gBuffer.addTextureAttachment(GL_RG16, GL_RG, GL_NEAREST, GL_NEAREST); //Octahedral normal texture (filtering across the folds would corrupt it)
+    gBuffer.addTextureAttachment(GL_RGBA8, GL_RGBA, GL_LINEAR, GL_LINEAR); //Albedo texture
+    gBuffer.addTextureAttachment(GL_RGBA8, GL_RGBA, GL_NEAREST, GL_NEAREST); //Metallic/Roughness/Ambient occlusion/Material ID texture
     gBuffer.addTextureAttachment(GL_DEPTH_COMPONENT32, GL_DEPTH_COMPONENT, GL_NEAREST, GL_NEAREST, GL_DEPTH_ATTACHMENT); //Depth buffer
+    gBuffer.addTextureAttachment(GL_RG16F, GL_RG, GL_NEAREST, GL_NEAREST); //Velocity texture (for temporal anti-aliasing)
     if(!gBuffer.checkStatus())
     {
         std::cout << "Error creating gBuffer" << std::endl;
@@ -256,16 +320,15 @@ int main()
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 512, 512);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
     
-    //loads the skybox cube map
-    std::vector<std::string> cubeMapFilePaths;
-    cubeMapFilePaths.push_back("ProgramFiles\\Resources\\Textures\\skybox\\right.jpg");
-    cubeMapFilePaths.push_back("ProgramFiles\\Resources\\Textures\\skybox\\left.jpg");
-    cubeMapFilePaths.push_back("ProgramFiles\\Resources\\Textures\\skybox\\top.jpg");
-    cubeMapFilePaths.push_back("ProgramFiles\\Resources\\Textures\\skybox\\bottom.jpg");
-    cubeMapFilePaths.push_back("ProgramFiles\\Resources\\Textures\\skybox\\front.jpg");
-    cubeMapFilePaths.push_back("ProgramFiles\\Resources\\Textures\\skybox\\back.jpg");
+    //loads the HDR environment as a float16 cubemap with mips, converted once and cached on disk
+    const char* environmentPath = "ProgramFiles\\Resources\\Textures\\equirectangular\\newportLoft.hdr";
     stbi_set_flip_vertically_on_load(false);
-    unsigned int skyboxCubeMap = loadCubemap(cubeMapFilePaths);
+    unsigned int skyboxCubeMap = EnvironmentImporter::LoadEquirectangular(environmentPath, ENVIRONMENT_CACHE_PATH, ENVIRONMENT_DEFAULT_SIZE, environmentBakePath);
+    if(!skyboxCubeMap)
+    {
+        std::cout << "Error loading the environment map" << std::endl;
+        return -1;
+    }
 
     //matrices for capturing data onto the cubemap
     glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
@@ -278,102 +341,73 @@ int main()
         glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
     };
 
-    //creates cubemap for irradiance
-    unsigned int irradianceMap;
-    glGenTextures(1, &irradianceMap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
-    for(unsigned int i = 0; i < 6; i++)
-    {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 32, 32, 0, GL_RGB, GL_FLOAT, nullptr);
-    }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 32, 32);
-
-    //renders (solves the diffuse integral) to create the irradiance map
-    irradianceShader.use();
-    irradianceShader.setInt("environmentMap", 0);
-    irradianceShader.setMat4("projection", captureProjection);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxCubeMap);
-    glViewport(0, 0, 32, 32);
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-
-    for(unsigned int i = 0; i < 6; i++)
-    {
-        irradianceShader.setMat4("view", captureViews[i]);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceMap, 0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    //diffuse irradiance is projected onto spherical harmonics on the CPU, PBRSecondPass evaluates them instead of sampling an irradiance map
+    SH9Color irradianceSH;
+    SHProjector::ProjectEquirectangular(environmentPath, irradianceSH);
 
-        renderCube();
-    }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    //the prefilter map is cached on disk and only baked again when the environment, the bake shaders or the bake size change
+    std::vector<std::string> prefilterSourceFiles;
+    prefilterSourceFiles.push_back(environmentPath);
+    prefilterSourceFiles.push_back("ProgramFiles\\Resources\\Shaders\\cubemap.V.shader");
+    prefilterSourceFiles.push_back("ProgramFiles\\Resources\\Shaders\\prefilter.F.shader");
 
+    const unsigned int prefilterSize = 128;
+    const unsigned int maxMipmapLevels = 5;
+    unsigned long long prefilterKey = IBLCache::ComputeKey(prefilterSourceFiles, { (float)prefilterSize, (float)maxMipmapLevels });
 
     unsigned int prefilterMap;
-    glGenTextures(1, &prefilterMap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
-    for(unsigned int i = 0; i < 6; i++)
+    if(!IBLCache::Load(PREFILTER_CACHE_PATH, prefilterKey, prefilterSize, maxMipmapLevels, prefilterMap))
     {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 128, 128, 0, GL_RGB, GL_FLOAT, nullptr);
-    }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);// enable pre-filter mipmap sampling 
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    //generates mipmaps for cubemap
-    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-
-    //run a quasi monte-carlo simulation on the environment lighting to create a prefilter cubemap
-    prefilterShader.use();
-    prefilterShader.setInt("environmentMap", 0);
-    prefilterShader.setMat4("projection", captureProjection);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxCubeMap);
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    unsigned int maxMipmapLevels = 5;
-    for(unsigned int mip = 0; mip < maxMipmapLevels; mip++)
-    {
-        unsigned int mipWidth = (unsigned int)(128 * std::pow(0.5, mip));
-        unsigned int mipHeight = (unsigned int)(128 * std::pow(0.5, mip));
-        glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mipWidth, mipHeight);
-        glViewport(0, 0, mipWidth, mipHeight);
-
-        float roughness = (float)mip / (float)(maxMipmapLevels - 1);
-        prefilterShader.setFloat("roughness", roughness);
+        glGenTextures(1, &prefilterMap);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
         for(unsigned int i = 0; i < 6; i++)
         {
-            prefilterShader.setMat4("view", captureViews[i]);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, prefilterMap, mip);
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, prefilterSize, prefilterSize, 0, GL_RGB, GL_FLOAT, nullptr);
+        }
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);// enable pre-filter mipmap sampling 
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        //generates mipmaps for cubemap
+        glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+
+        //run a quasi monte-carlo simulation on the environment lighting to create a prefilter cubemap
+        prefilterShader.use();
+        prefilterShader.setInt("environmentMap", 0);
+        prefilterShader.setMat4("projection", captureProjection);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxCubeMap);
+        glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+        for(unsigned int mip = 0; mip < maxMipmapLevels; mip++)
+        {
+            unsigned int mipWidth = (unsigned int)(prefilterSize * std::pow(0.5, mip));
+            unsigned int mipHeight = (unsigned int)(prefilterSize * std::pow(0.5, mip));
+            glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mipWidth, mipHeight);
+            glViewport(0, 0, mipWidth, mipHeight);
+
+            float roughness = (float)mip / (float)(maxMipmapLevels - 1);
+            prefilterShader.setFloat("roughness", roughness);
+            for(unsigned int i = 0; i < 6; i++)
+            {
+                prefilterShader.setMat4("view", captureViews[i]);
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, prefilterMap, mip);
 
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-            renderCube();
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                renderCube();
+            }
         }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, maxMipmapLevels - 1);
+        IBLCache::Save(PREFILTER_CACHE_PATH, prefilterKey, prefilterMap, prefilterSize, maxMipmapLevels);
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
     stbi_set_flip_vertically_on_load(true);
-    int width, height, nrComponents;
-    float* brdfData = stbi_loadf("brdfLUT.hdr", &width, &height, &nrComponents, 0);
-
-    //generates the 2D look-up texture
-    unsigned int brdfLUTTexture;
-    glGenTextures(1, &brdfLUTTexture);
 
-    glBindTexture(GL_TEXTURE_2D, brdfLUTTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, width, height, 0, GL_RGB, GL_FLOAT, brdfData);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    //split-sum BRDF look-up texture, baked on the CPU the first time and loaded from the cache after that
+    unsigned int brdfLUTTexture = BRDFLUT::LoadOrBake(BRDF_LUT_CACHE_PATH);
 
 
     unsigned int mainFBO, mainRBO;
@@ -383,7 +417,7 @@ int main()
 
     glGenTextures(1, &HDRColorBuffer0);
     glBindTexture(GL_TEXTURE_2D, HDRColorBuffer0);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, wWidth, wHeight, 0, GL_RGBA, GL_FLOAT, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, maxRenderWidth, maxRenderHeight, 0, GL_RGBA, GL_FLOAT, 0);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -391,7 +425,7 @@ int main()
 
     glGenTextures(1, &HDRColorBuffer1);
     glBindTexture(GL_TEXTURE_2D, HDRColorBuffer1);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, wWidth, wHeight, 0, GL_RGBA, GL_FLOAT, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, maxRenderWidth, maxRenderHeight, 0, GL_RGBA, GL_FLOAT, 0);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -401,7 +435,7 @@ int main()
     glBindFramebuffer(GL_FRAMEBUFFER, mainFBO);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, HDRColorBuffer0, 0);
     glBindRenderbuffer(GL_RENDERBUFFER, mainRBO);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, wWidth, wHeight);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, maxRenderWidth, maxRenderHeight);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, mainRBO);
     int status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
     if(status != GL_FRAMEBUFFER_COMPLETE)
@@ -416,8 +450,11 @@ int main()
     glm::mat4 model(1.0f);
     glm::mat4 view = camera.GetViewMatrix();
     glm::mat4 inverseView = glm::inverse(view);
-    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)wWidth / (float)wHeight, 0.1f, farClipDist);
+    glm::mat4 projection = camera.GetProjectionMatrix((float)wWidth / (float)wHeight, 0.1f, farClipDist);
     glm::mat4 invProjection = glm::inverse(projection);
+    glm::mat4 viewProjection = projection * view; //un-jittered, used for reprojection
+    glm::mat4 prevViewProjection = viewProjection;
+    glm::mat4 previousModels[6]; //model matrices of the G-buffer objects from the previous frame
     //projection = glm::infinitePerspective(glm::radians(camera.Zoom), (float)wWidth / (float)wHeight, 0.1f);
     backgroundShader.use();
     backgroundShader.setMat4("projection", projection);
@@ -427,7 +464,7 @@ int main()
     glViewport(0, 0, scrWidth, scrHeight);
 
     BloomRenderer bloomRenderer;
-    bloomRenderer.Init(wWidth, wHeight, "ProgramFiles\\Resources\\Textures\\lensDirt0.jpg");
+    bloomRenderer.Init(maxRenderWidth, maxRenderHeight, "ProgramFiles\\Resources\\Textures\\lensDirt0.jpg");
 
     bloomShader.use();
     bloomShader.setInt("scene", 0);
@@ -435,6 +472,22 @@ int main()
     bloomShader.setInt("lensDirtTexture", 2);
     bloomShader.setFloat("NrOfMips", float(bloomRenderer.m_NrMips));
 
+    TAARenderer taaRenderer;
+    taaRenderer.Init(maxRenderWidth, maxRenderHeight);
+
+    SSRRenderer ssrRenderer;
+    ssrRenderer.Init(maxRenderWidth, maxRenderHeight);
+
+    //per pass CPU and GPU times of the PROFILE_ scopes for the performance overlay
+    Profiler& profiler = GetProfiler();
+    profiler.Init();
+
+    char profileCapturePath[128] = "profile.json";
+    int profileCaptureFrames = 120;
+
+    SpatialUpscaler spatialUpscaler;
+    spatialUpscaler.Init(maxRenderWidth, maxRenderHeight);
+
     ShadowRenderer shadowRenderer;
     shadowRenderer.Init();
     shadowRenderer.createShadowMap(0, 1024, 1024, lightPositions[0], lightColors[0], POINT_LIGHT);
@@ -443,10 +496,6 @@ int main()
     shadowRenderer.createShadowMap(3, 1024, 1024, lightPositions[3], lightColors[3], POINT_LIGHT);
 
     GBufferShader.use();
-    GBufferShader.setInt("gMaterialMask", 0);
-    GBufferShader.setInt("gNormal", 1);
-    GBufferShader.setInt("gAlbedo", 2);
-    GBufferShader.setInt("gMetalRoughAO", 3);
     GBufferShader.setInt("albedoMap", 0);
     GBufferShader.setInt("normalMap", 1);
     GBufferShader.setInt("metallicMap", 2);
@@ -455,22 +504,193 @@ int main()
 
     PBRFirstPass.use();
     PBRFirstPass.setInt("light.m_CubeShadowMap", 0);
-    PBRFirstPass.setInt("gMaterialMask", 1);
-    PBRFirstPass.setInt("gNormal", 2);
-    PBRFirstPass.setInt("gAlbedo", 3);
-    PBRFirstPass.setInt("gMetalRoughAO", 4);
-    PBRFirstPass.setInt("gDepth", 5);
+    PBRFirstPass.setInt("gNormal", 1);
+    PBRFirstPass.setInt("gAlbedo", 2);
+    PBRFirstPass.setInt("gMetalRoughAO", 3);
+    PBRFirstPass.setInt("gDepth", 4);
 
     PBRSecondPass.use();
-    PBRSecondPass.setInt("irradianceMap", 0);
     PBRSecondPass.setInt("prefilterMap", 1);
     PBRSecondPass.setInt("brdfLUT", 2);
     PBRSecondPass.setInt("LoMap", 3);
-    PBRSecondPass.setInt("gMaterialMask", 4);
-    PBRSecondPass.setInt("gNormal", 5);
-    PBRSecondPass.setInt("gAlbedo", 6);
-    PBRSecondPass.setInt("gMetalRoughAO", 7);
-    PBRSecondPass.setInt("gDepth", 8);
+    PBRSecondPass.setInt("gNormal", 4);
+    PBRSecondPass.setInt("gAlbedo", 5);
+    PBRSecondPass.setInt("gMetalRoughAO", 6);
+    PBRSecondPass.setInt("gDepth", 7);
+    PBRSecondPass.setInt("ssrTexture", 8);
+    setMaterialTable(PBRSecondPass);
+    irradianceSH.setUniforms(PBRSecondPass, "irradianceSH");
+    ReflectionProbeRenderer::SetSamplers(PBRSecondPass);
+
+    //the probes capture the objects of the G-buffer pass with a diffuse-only shader, they don't move so the captures stay valid
+    unsigned int probeAlbedoMaps[] = { ironAlbedoMap, goldAlbedoMap, grassAlbedoMap, plasticAlbedoMap, wallAlbedoMap };
+    glm::mat4 probeObjectModels[6];
+    for(unsigned int i = 0; i < 5; i++)
+        probeObjectModels[i] = glm::translate(glm::mat4(1.0f), glm::vec3(-5.0f + 2.0f * i, 0.0f, 2.0f));
+    probeObjectModels[5] = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 4.0f)), glm::vec3(0.5f));
+    //everything the captures are made of, a change to any of it bakes the probes again instead of loading stale caches
+    std::vector<std::string> probeSceneFiles = { environmentPath,
+        "ProgramFiles\\Resources\\Textures\\pbr\\rustedIron\\albedo.png", "ProgramFiles\\Resources\\Textures\\pbr\\gold\\albedo.png",
+        "ProgramFiles\\Resources\\Textures\\pbr\\grass\\albedo.png", "ProgramFiles\\Resources\\Textures\\pbr\\plastic\\albedo.png",
+        "ProgramFiles\\Resources\\Textures\\pbr\\wall\\albedo.png", "ProgramFiles\\Resources\\Textures\\metal.png" };
+    std::vector<float> probeSceneParameters;
+    for(unsigned int i = 0; i < NR_OF_LIGHTS; i++)
+        probeSceneParameters.insert(probeSceneParameters.end(), { lightPositions[i].x, lightPositions[i].y, lightPositions[i].z, lightColors[i].r, lightColors[i].g, lightColors[i].b });
+    for(unsigned int i = 0; i < 6; i++)
+        probeSceneParameters.insert(probeSceneParameters.end(), &probeObjectModels[i][0][0], &probeObjectModels[i][0][0] + 16);
+    ReflectionProbeRenderer reflectionProbes;
+    reflectionProbes.Init(skyboxCubeMap, [&](Shader& captureShader)
+    {
+        for(unsigned int i = 0; i < NR_OF_LIGHTS; i++)
+        {
+            captureShader.setVec3("lightPositions[" + std::to_string(i) + "]", lightPositions[i]);
+            captureShader.setVec3("lightColors[" + std::to_string(i) + "]", lightColors[i]);
+        }
+        irradianceSH.setUniforms(captureShader, "irradianceSH");
+
+        glActiveTexture(GL_TEXTURE0);
+        for(unsigned int i = 0; i < 5; i++)
+        {
+            glBindTexture(GL_TEXTURE_2D, probeAlbedoMaps[i]);
+            captureShader.setMat4("model", probeObjectModels[i]);
+            renderSphere();
+        }
+        glBindTexture(GL_TEXTURE_2D, cubeAlbedoMap);
+        captureShader.setMat4("model", probeObjectModels[5]);
+        renderCube();
+    }, probeSceneFiles, probeSceneParameters);
+    reflectionProbes.AddProbe(glm::vec3(-3.0f, 0.0f, 3.5f), glm::vec3(-7.0f, -3.0f, 0.0f), glm::vec3(0.0f, 3.0f, 7.0f));
+    reflectionProbes.AddProbe(glm::vec3( 1.5f, 0.0f, 3.5f), glm::vec3(-1.0f, -3.0f, 0.0f), glm::vec3(5.0f, 3.0f, 7.0f));
+
+    //maps, material IDs, meshes and local bounding spheres of the G-buffer objects, indexed like their model matrices
+    unsigned int objectMaps[6][5] = {
+        { ironAlbedoMap, ironNormalMap, ironMetallicMap, ironRoughnessMap, ironAOMap },
+        { goldAlbedoMap, goldNormalMap, goldMetallicMap, goldRoughnessMap, goldAOMap },
+        { grassAlbedoMap, grassNormalMap, grassMetallicMap, grassRoughnessMap, grassAOMap },
+        { plasticAlbedoMap, plasticNormalMap, plasticMetallicMap, plasticRoughnessMap, plasticAOMap },
+        { wallAlbedoMap, wallNormalMap, wallMetallicMap, wallRoughnessMap, wallAOMap },
+        { cubeAlbedoMap, cubeNormalMap, cubeMetallicMap, cubeRoughnessMap, cubeAOMap }
+    };
+    MaterialID objectMaterialIDs[6] = { MATERIAL_ID_PBR, MATERIAL_ID_PBR, MATERIAL_ID_PBR, MATERIAL_ID_BLINN_PHONG, MATERIAL_ID_CELL_SHADING, MATERIAL_ID_CELL_SHADING };
+    void (*objectMeshes[6])() = { renderSphere, renderSphere, renderSphere, renderSphere, renderSphere, renderCube };
+    void (*objectPositionMeshes[6])() = { renderSpherePositions, renderSpherePositions, renderSpherePositions, renderSpherePositions, renderSpherePositions, renderCubePositions };
+    BoundingBox objectBoxes[6];
+    BoundingSphere objectSpheres[6];
+
+    //the G-buffer objects again as triangle lists with their materials, for the visibility buffer path,
+    //and as occluders for the software occlusion culler, the spheres with a quarter of the segments, whose vertices are a subset of the rendered ones so they stay inside
+    VisibilityBuffer visibilityBuffer;
+    OcclusionCuller occlusionCuller;
+    occlusionCuller.Init(&jobSystem);
+    unsigned int objectOccluders[6];
+    {
+        std::vector<glm::vec3> positions, normals;
+        std::vector<glm::vec2> uvs;
+        std::vector<unsigned int> indices;
+        generateSphere(positions, normals, uvs, indices);
+        unsigned int sphereMesh = visibilityBuffer.AddMesh(positions, normals, uvs, indices);
+        ComputeBounds(&positions[0].x, (unsigned int)positions.size(), 3, objectBoxes[0], objectSpheres[0]);
+        positions.clear(); normals.clear(); uvs.clear(); indices.clear();
+        generateCube(positions, normals, uvs, indices);
+        unsigned int cubeMesh = visibilityBuffer.AddMesh(positions, normals, uvs, indices);
+        ComputeBounds(&positions[0].x, (unsigned int)positions.size(), 3, objectBoxes[5], objectSpheres[5]);
+        objectOccluders[5] = occlusionCuller.AddMesh(positions, indices);
+        positions.clear(); normals.clear(); uvs.clear(); indices.clear();
+        generateSphere(positions, normals, uvs, indices, 16);
+        objectOccluders[0] = occlusionCuller.AddMesh(positions, indices);
+        for(unsigned int i = 1; i < 5; i++)
+        {
+            objectBoxes[i] = objectBoxes[0];
+            objectSpheres[i] = objectSpheres[0];
+            objectOccluders[i] = objectOccluders[0];
+        }
+
+        for(unsigned int i = 0; i < 6; i++)
+        {
+            unsigned int* maps = objectMaps[i];
+            visibilityBuffer.AddInstance(i < 5 ? sphereMesh : cubeMesh, visibilityBuffer.AddMaterial(maps[0], maps[1], maps[2], maps[3], maps[4], objectMaterialIDs[i]));
+        }
+    }
+    bool visibilityBufferAvailable = visibilityBuffer.Init(gBuffer.m_Textures[3], maxRenderWidth, maxRenderHeight);
+
+    //the irradiance volume traces its probes against the bounds of the G-buffer objects where the probes captured them and is relit when the lights move
+    IrradianceVolume irradianceVolume;
+    IrradianceVolume::SetSamplers(PBRSecondPass);
+    for(unsigned int i = 0; i < 6; i++)
+    {
+        glm::vec3 albedo = IrradianceVolume::AverageColor(objectMaps[i][0]);
+        if(objectMeshes[i] == renderCube)
+        {
+            BoundingBox box = objectBoxes[i].Transformed(probeObjectModels[i]);
+            irradianceVolume.AddBox(box.m_Min, box.m_Max, albedo);
+        }
+        else
+        {
+            BoundingSphere sphere = objectSpheres[i].Transformed(probeObjectModels[i]);
+            irradianceVolume.AddSphere(sphere.m_Center, sphere.m_Radius, albedo);
+        }
+    }
+    irradianceVolume.Init(glm::vec3(-7.0f, -3.0f, -1.0f), glm::vec3(5.0f, 3.0f, 7.0f), glm::ivec3(9, 5, 7), irradianceSH);
+    int visibilityBenchmarkFrames = 0;
+    bool visibilityBenchmarkRestore = false;
+
+    DrawList drawList;
+    std::vector<unsigned int> objectsUnoccluded; //one bit per object
+    FrustumCuller objectBounds;
+    std::vector<unsigned int> shadowCasterFaces; //cube faces each object is drawn into for the current shadow map
+    unsigned int nrOfShadowCasterDraws = 0;
+    //world boxes of the objects for picking
+    BVH objectBVH;
+    objectBVH.Init(&jobSystem);
+    std::vector<glm::vec3> objectMins(6), objectMaxs(6);
+    int hoveredObject = -1;
+    //bounding spheres of the objects, each point light only culls and draws the casters within its range
+    SpatialIndex objectIndex;
+    objectIndex.Init(SPATIAL_LOOSE_OCTREE, glm::vec3(0.0f), 64.0f, 4.0f);
+    for(unsigned int i = 0; i < 6; i++)
+        objectIndex.Insert(objectSpheres[i].m_Center, objectSpheres[i].m_Radius);
+    std::vector<unsigned int> shadowCasterCandidates;
+    //scene nodes of the objects, the scene jobs update their world matrices and bounds and cull them against the camera and every shadow map view in one pass.
+    //the culled views hold transform IDs, objectOfTransform maps them back to the object indices the draw list and the shadow casters are built from
+    SceneJobs sceneJobs;
+    sceneJobs.Init(&jobSystem);
+    SceneNode objectNodes[6];
+    std::vector<unsigned int> objectOfTransform;
+    for(unsigned int i = 0; i < 6; i++)
+    {
+        if(objectNodes[i].m_Transform >= objectOfTransform.size())
+            objectOfTransform.resize(objectNodes[i].m_Transform + 1, CULL_VIEW_NO_OBJECT);
+        objectOfTransform[objectNodes[i].m_Transform] = i;
+        objectNodes[i].setBounds(objectBoxes[i], objectSpheres[i]);
+        objectNodes[i].updatePosition(i < 5 ? glm::vec3(-5.0f + 2.0f * i, 0.0f, 2.0f) : glm::vec3(0.0f, 0.0f, 4.0f));
+    }
+    objectNodes[5].updateScale(glm::vec3(0.5f));
+    CullView sceneViews[1 + 6 * NR_OF_LIGHTS]; //the camera's, then the ones of every shadow map
+    unsigned int shadowViews[NR_OF_LIGHTS]; //first view of each shadow map in sceneViews
+    DepthPrepass depthPrepass;
+    depthPrepass.Init();
+
+    //small glass orbs drifting around the objects, drawn unsorted in one instanced draw by the transparency pass
+    TransparencyRenderer transparencyRenderer;
+    transparencyRenderer.Init(maxRenderWidth, maxRenderHeight, gBuffer.m_Textures[3]);
+    HiZOcclusion hiZOcclusion;
+    hiZOcclusion.Init(maxRenderWidth, maxRenderHeight, (GLADloadproc)glfwGetProcAddress);
+    {
+        std::vector<glm::vec3> positions, normals;
+        std::vector<glm::vec2> uvs;
+        std::vector<unsigned int> indices;
+        generateSphere(positions, normals, uvs, indices, 12);
+        transparencyRenderer.SetMesh(positions, normals, uvs, indices);
+    }
+    unsigned int glassAlbedoMap = loadTexture("ProgramFiles\\Resources\\Models\\nanosuit\\glass_dif.png");
+    transparencyRenderer.SetAlbedoMap(glassAlbedoMap);
+    std::vector<glm::vec4> glassOrbSeeds(MAX_GLASS_ORBS); //resting position and phase of every orb
+    std::vector<glm::vec4> glassOrbTints(MAX_GLASS_ORBS);
+    for(unsigned int i = 0; i < MAX_GLASS_ORBS; i++)
+    {
+        glassOrbSeeds[i] = glm::vec4(lerp(-7.0f, 5.0f, randomFloats(generator)), lerp(-2.0f, 2.0f, randomFloats(generator)), lerp(0.0f, 6.0f, randomFloats(generator)), randomFloats(generator) * 2.0f * Pi);
+        glassOrbTints[i] = glm::vec4(lerp(0.6f, 1.0f, randomFloats(generator)), lerp(0.6f, 1.0f, randomFloats(generator)), lerp(0.6f, 1.0f, randomFloats(generator)), lerp(0.2f, 0.6f, randomFloats(generator)));
+    }
 
 
     backgroundShader.use();
@@ -481,11 +701,11 @@ int main()
     {
         SSAOShader.setVec3("samples[" + std::to_string(i) + "]", SSAOSamples[i]);
     }
-    SSAOShader.setInt("gMaterialMask", 0);
-    SSAOShader.setInt("gNormal", 1);
-    SSAOShader.setInt("gMetalRoughAO", 2);
-    SSAOShader.setInt("gDepth", 3);
-    SSAOShader.setInt("noiseTex", 4);
+    SSAOShader.setInt("gNormal", 0);
+    SSAOShader.setInt("gMetalRoughAO", 1);
+    SSAOShader.setInt("gDepth", 2);
+    SSAOShader.setInt("noiseTex", 3);
+    setMaterialTable(SSAOShader);
 
     SSAOBlurShader.use();
     SSAOBlurShader.setInt("occlusionBuffer", 0);
@@ -501,17 +721,29 @@ int main()
     {
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;//this tells us how long a frame is
-        if(frameNR == 0)
-            averageFrameTime = deltaTime;
-        averageFrameTime = (averageFrameTime + deltaTime) / 2.0f;
+        averageFrameTime += (deltaTime - averageFrameTime) / (double)(frameNR + 1);
         lastFrame = currentFrame;
 
+        profiler.BeginFrame();
+
         processInput(window);
 
+        //the upscaler preset sets the resolution the scene is rendered at, dynamic resolution scales it further
+        dynamicResolution.BeginFrame();
+        float upscalerScale = SpatialUpscaler::PresetScale(upscalerPreset);
+        unsigned int sceneWidth = std::max(1u, (unsigned int)(wWidth * upscalerScale + 0.5f));
+        unsigned int sceneHeight = std::max(1u, (unsigned int)(wHeight * upscalerScale + 0.5f));
+        glm::ivec2 renderSize = dynamicResolution.RenderSize(sceneWidth, sceneHeight);
+        glm::vec2 viewportScale = dynamicResolution.ViewportScale(sceneWidth, sceneHeight);
+
         model = glm::mat4(1.0f);
         view = camera.GetViewMatrix();
         inverseView = glm::inverse(view);
-        projection = glm::perspective(glm::radians(camera.Zoom), (float)wWidth / (float)wHeight, 0.1f, farClipDist);
+        if(taaEnabled)
+            camera.UpdateJitter(renderSize.x, renderSize.y);
+        prevViewProjection = viewProjection;
+        viewProjection = camera.GetProjectionMatrix((float)wWidth / (float)wHeight, 0.1f, farClipDist) * view;
+        projection = camera.GetProjectionMatrix((float)wWidth / (float)wHeight, 0.1f, farClipDist, taaEnabled);
         invProjection = glm::inverse(projection);
         backgroundShader.use();
         backgroundShader.setMat4("projection", projection);
@@ -521,182 +753,241 @@ int main()
         glClearColor(1.0f, 1.0f, 1.0f, 1.0f);//This clears the color buffer and sets it to be this color
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        //bakes a few probe faces within the time budget while any probe is queued
+        {
+            PROFILE_GPU("Reflection probes");
+            reflectionProbes.Update();
+        }
 
-        for(unsigned int i = 0; i < NR_OF_LIGHTS; i++)
+        //transforms of the G-buffer objects, shared by the shadow pass and both G-buffer paths
+        for(unsigned int i = 0; i < 5; i++)
+            objectNodes[i].updateRotation((float)sin(glfwGetTime() * 0.1f), glm::vec3(0.0f, 1.0f, 0.0f));
+        unsigned int nrOfSceneViews = 0;
+        if(sceneJobsCulling)
+        {
+            sceneViews[nrOfSceneViews++].SetViewProjection(viewProjection);
+            for(unsigned int i = 0; i < NR_OF_LIGHTS; i++)
+            {
+                shadowViews[i] = nrOfSceneViews;
+                unsigned int nrOfFaces = shadowRenderer.shadowMaps[i]->m_Light->m_Type == POINT_LIGHT ? 6 : 1;
+                for(unsigned int face = 0; face < nrOfFaces; face++)
+                    sceneViews[nrOfSceneViews++].SetViewProjection(shadowRenderer.shadowMaps[i]->m_TransformMatrix[face]);
+            }
+        }
         {
-            shadowRenderer.use(i);
+            PROFILE_CPU("Scene update");
+            sceneJobs.Update(SceneNode::getTransforms(), sceneViews, nrOfSceneViews);
+        }
+        glm::mat4 objectModels[6];
+        for(unsigned int i = 0; i < 6; i++)
+            objectModels[i] = objectNodes[i].getMatrix();
+        //their world space bounding spheres, culled against the camera and every shadow map view
+        objectBounds.Clear();
+        for(unsigned int i = 0; i < 6; i++)
+        {
+            BoundingSphere sphere = objectSpheres[i].Transformed(objectModels[i]);
+            objectBounds.Add(sphere.m_Center, sphere.m_Radius);
+            objectIndex.Move(i, sphere.m_Center, sphere.m_Radius);
+            BoundingBox box = objectNodes[i].getWorldBounds();
+            objectMins[i] = box.m_Min;
+            objectMaxs[i] = box.m_Max;
+        }
+        objectBVH.Update(objectMins, objectMaxs);
 
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        //the object under the cursor, or under the center of the screen while the mouse steers the camera
+        {
+            double cursorX = wWidth * 0.5, cursorY = wHeight * 0.5;
+            if(mouseIsVisible)
+                glfwGetCursorPos(window, &cursorX, &cursorY);
+            glm::vec2 ndc = glm::vec2(2.0f * (float)cursorX / wWidth - 1.0f, 1.0f - 2.0f * (float)cursorY / wHeight);
+            glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+            glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndc, -1.0f, 1.0f);
+            glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc, 1.0f, 1.0f);
+            glm::vec3 rayOrigin = glm::vec3(nearPoint) / nearPoint.w;
+            float pickDistance = farClipDist;
+            unsigned int picked = objectBVH.Raycast(rayOrigin, glm::normalize(glm::vec3(farPoint) / farPoint.w - rayOrigin), pickDistance);
+            hoveredObject = picked == BVH_INVALID ? -1 : (int)picked;
+        }
 
-            model = glm::translate(glm::mat4(1.0f), glm::vec3(-5.0, 0.0, 2.0));
-            shadowRenderer.m_CurrentShader->setMat4("model", model);
-            renderSphere();
-            model = glm::translate(glm::mat4(1.0f), glm::vec3(-3.0, 0.0, 2.0));
-            shadowRenderer.m_CurrentShader->setMat4("model", model);
-            renderSphere();
-            model = glm::translate(glm::mat4(1.0f), glm::vec3(-1.0, 0.0, 2.0));
-            shadowRenderer.m_CurrentShader->setMat4("model", model);
-            renderSphere();
-            model = glm::translate(glm::mat4(1.0f), glm::vec3(1.0, 0.0, 2.0));
-            shadowRenderer.m_CurrentShader->setMat4("model", model);
-            renderSphere();
-            model = glm::translate(glm::mat4(1.0f), glm::vec3(3.0, 0.0, 2.0));
-            shadowRenderer.m_CurrentShader->setMat4("model", model);
-            renderSphere();
-            model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0, 0.0, 4.0));
-            model = glm::scale(model, glm::vec3(0.5f));
-            shadowRenderer.m_CurrentShader->setMat4("model", model);
-            renderCube();
+        {
+            PROFILE_GPU("Shadows");
+            nrOfShadowCasterDraws = 0;
+            for(unsigned int i = 0; i < NR_OF_LIGHTS; i++)
+            {
+                if(sceneJobsCulling)
+                    shadowRenderer.cullShadowCasters(i, objectBounds.Size(), sceneViews + shadowViews[i], objectOfTransform, shadowCasterFaces);
+                else if(shadowRenderer.shadowMaps[i]->m_Light->m_Type == POINT_LIGHT)
+                {
+                    objectIndex.QuerySphere(shadowRenderer.shadowMaps[i]->m_Light->m_Pos, SHADOW_FAR_PLANE, shadowCasterCandidates);
+                    shadowRenderer.cullShadowCasters(i, objectBounds, shadowCasterCandidates, shadowCasterFaces);
+                }
+                else
+                    shadowRenderer.cullShadowCasters(i, objectBounds, shadowCasterFaces);
+                shadowRenderer.use(i);
+
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+                for(unsigned int j = 0; j < 6; j++)
+                {
+                    if(shadowCasterFaces[j] == 0)
+                        continue;
+                    shadowRenderer.setShadowCasterFaces(shadowCasterFaces[j]);
+                    shadowRenderer.m_CurrentShader->setMat4("model", objectModels[j]);
+                    objectMeshes[j]();
+                    nrOfShadowCasterDraws++;
+                }
+            }
+        }
+
+        //the benchmark alternates between the two paths every frame so both are timed on the same views
+        if(visibilityBenchmarkFrames > 0)
+        {
+            visibilityBufferEnabled = visibilityBenchmarkFrames % 2 == 0;
+            if(--visibilityBenchmarkFrames == 0)
+            {
+                std::cout << "G-buffer pass over " << profiler.NrOfGPUSamples("G-buffer (deferred)") + profiler.NrOfGPUSamples("G-buffer (visibility buffer)")
+                          << " frames: deferred " << profiler.GPUMean("G-buffer (deferred)") << "ms, visibility buffer " << profiler.GPUMean("G-buffer (visibility buffer)") << "ms" << std::endl;
+                visibilityBufferEnabled = visibilityBenchmarkRestore;
+            }
         }
 
-        //geometry buffer pass
+        //the glass orbs are uploaded and culled against the previous frame's depth before the G-buffer pass, they are drawn after it
         {
+            PROFILE_GPU("Glass orb culling");
+            std::vector<TransparentInstance>& glassOrbs = transparencyRenderer.Instances();
+            glassOrbs.resize(nrOfGlassOrbs);
+            float time = (float)glfwGetTime();
+            for(int i = 0; i < nrOfGlassOrbs; i++)
+            {
+                glm::vec4 seed = glassOrbSeeds[i];
+                glm::vec3 drift = glm::vec3(sin(time * 0.3f + seed.w), sin(time * 0.2f + seed.w * 2.0f), cos(time * 0.25f + seed.w)) * 0.3f;
+                glassOrbs[i].m_Model = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(seed) + drift), glm::vec3(0.05f + 0.05f * sin(seed.w * 3.0f) * sin(seed.w * 3.0f)));
+                glassOrbs[i].m_Tint = glassOrbTints[i];
+            }
+            transparencyRenderer.Upload(hiZOcclusionEnabled ? &hiZOcclusion : nullptr);
+        }
+
+        //geometry buffer pass, either through the visibility buffer or by rasterizing the materials straight into the G-buffer
+        if(visibilityBufferEnabled)
+        {
+            PROFILE_GPU("G-buffer (visibility buffer)");
+            for(unsigned int i = 0; i < 6; i++)
+            {
+                visibilityBuffer.SetTransform(i, objectModels[i], frameNR == 0 ? objectModels[i] : previousModels[i]);
+                previousModels[i] = objectModels[i];
+            }
+            visibilityBuffer.Render(gBuffer, view, projection, viewProjection, prevViewProjection, renderSize);
+        }
+        else
+        {
+            PROFILE_GPU("G-buffer (deferred)");
+            //frustum culled and sorted front to back, the depth pre-pass and the G-buffer pass draw the same list
+            {
+                PROFILE_CPU("Cull and sort");
+                if(sceneJobsCulling)
+                    drawList.Sort(sceneViews[0], objectOfTransform, objectBounds, view);
+                else
+                    drawList.CullAndSort(objectBounds, view, viewProjection);
+            }
+            if(occlusionCullingEnabled)
+            {
+                PROFILE_CPU("Occlusion culling");
+                occlusionCuller.ClearOccluders();
+                for(unsigned int i = 0; i < drawList.Items().size(); i++)
+                    occlusionCuller.AddOccluder(objectOccluders[drawList.Items()[i].m_Object], objectModels[drawList.Items()[i].m_Object]);
+                occlusionCuller.Render(viewProjection);
+                occlusionCuller.Test(objectMins, objectMaxs, objectsUnoccluded);
+                drawList.RemoveOccluded(objectsUnoccluded);
+            }
+            const std::vector<DrawItem>& drawItems = drawList.Items();
+
             gBuffer.use();
             glClearColor(0.0f, 0.0f, 0.0f, 0.0f);//This clears the color buffer and sets it to be this color
             glEnable(GL_DEPTH_TEST);//enables the Depth Buffer and depth testing
             glDepthMask(GL_TRUE);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
             glDisable(GL_BLEND);
-            glViewport(0, 0, gBuffer.getWidth(), gBuffer.getHeight());
+            glViewport(0, 0, renderSize.x, renderSize.y);
+
+            //lays down the depth with the position only streams, so the G-buffer shader only runs for the visible surfaces
+            bool prepass = depthPrepass.Decide(drawList, viewProjection, projection);
+            if(prepass)
+            {
+                PROFILE_GPU("Depth pre-pass");
+                Shader& prepassShader = depthPrepass.Begin(view, projection);
+                for(unsigned int i = 0; i < drawItems.size(); i++)
+                {
+                    prepassShader.setMat4("model", objectModels[drawItems[i].m_Object]);
+                    objectPositionMeshes[drawItems[i].m_Object]();
+                }
+                depthPrepass.End();
+            }
+
             GBufferShader.use();
             GBufferShader.setMat4("view", view);
             GBufferShader.setFloat("time", glfwGetTime() * 0.1f);
             GBufferShader.setMat4("projection", projection);
+            GBufferShader.setMat4("viewProjection", viewProjection);
+            GBufferShader.setMat4("prevViewProjection", prevViewProjection);
+            for(unsigned int i = 0; i < drawItems.size(); i++)
+            {
+                unsigned int object = drawItems[i].m_Object;
+                for(unsigned int j = 0; j < 5; j++)
+                {
+                    glActiveTexture(GL_TEXTURE0 + j);
+                    glBindTexture(GL_TEXTURE_2D, objectMaps[object][j]);
+                }
 
-            //rusted iron
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, ironAlbedoMap);
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, ironNormalMap);
-            glActiveTexture(GL_TEXTURE2);
-            glBindTexture(GL_TEXTURE_2D, ironMetallicMap);
-            glActiveTexture(GL_TEXTURE3);
-            glBindTexture(GL_TEXTURE_2D, ironRoughnessMap);
-            glActiveTexture(GL_TEXTURE4);
-            glBindTexture(GL_TEXTURE_2D, ironAOMap);
-            
-            model = glm::translate(glm::mat4(1.0f), glm::vec3(-5.0, 0.0, 2.0));
-            model = glm::rotate(model, (float)sin(glfwGetTime() * 0.1f), glm::vec3(0.0f, 1.0f, 0.0f));
-            GBufferShader.setMat4("model", model);
-            GBufferShader.setVec3("material", materialPBR);
-            renderSphere();
-            
-            //gold
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, goldAlbedoMap);
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, goldNormalMap);
-            glActiveTexture(GL_TEXTURE2);
-            glBindTexture(GL_TEXTURE_2D, goldMetallicMap);
-            glActiveTexture(GL_TEXTURE3);
-            glBindTexture(GL_TEXTURE_2D, goldRoughnessMap);
-            glActiveTexture(GL_TEXTURE4);
-            glBindTexture(GL_TEXTURE_2D, goldAOMap);
-            
-            model = glm::translate(glm::mat4(1.0f), glm::vec3(-3.0, 0.0, 2.0));
-            model = glm::rotate(model, (float)sin(glfwGetTime() * 0.1f), glm::vec3(0.0f, 1.0f, 0.0f));
-            GBufferShader.setMat4("model", model);
-            GBufferShader.setVec3("material", materialPBR);
-            renderSphere();
-            
-            //grass
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, grassAlbedoMap);
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, grassNormalMap);
-            glActiveTexture(GL_TEXTURE2);
-            glBindTexture(GL_TEXTURE_2D, grassMetallicMap);
-            glActiveTexture(GL_TEXTURE3);
-            glBindTexture(GL_TEXTURE_2D, grassRoughnessMap);
-            glActiveTexture(GL_TEXTURE4);
-            glBindTexture(GL_TEXTURE_2D, grassAOMap);
-            
-            model = glm::translate(glm::mat4(1.0f), glm::vec3(-1.0, 0.0, 2.0));
-            model = glm::rotate(model, (float)sin(glfwGetTime() * 0.1f), glm::vec3(0.0f, 1.0f, 0.0f));
-            GBufferShader.setMat4("model", model);
-            GBufferShader.setVec3("material", materialPBR);
-            renderSphere();
+                model = objectModels[object];
+                GBufferShader.setMat4("model", model);
+                GBufferShader.setMat4("prevModel", frameNR == 0 ? model : previousModels[object]);
+                GBufferShader.setInt("materialID", objectMaterialIDs[object]);
+                objectMeshes[object]();
+            }
+            if(prepass)
+                depthPrepass.Restore();
 
-            //plastic
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, plasticAlbedoMap);
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, plasticNormalMap);
-            glActiveTexture(GL_TEXTURE2);
-            glBindTexture(GL_TEXTURE_2D, plasticMetallicMap);
-            glActiveTexture(GL_TEXTURE3);
-            glBindTexture(GL_TEXTURE_2D, plasticRoughnessMap);
-            glActiveTexture(GL_TEXTURE4);
-            glBindTexture(GL_TEXTURE_2D, plasticAOMap);
-            
-            model = glm::translate(glm::mat4(1.0f), glm::vec3(1.0, 0.0, 2.0));
-            model = glm::rotate(model, (float)sin(glfwGetTime() * 0.1f), glm::vec3(0.0f, 1.0f, 0.0f));
-            GBufferShader.setMat4("model", model);
-            GBufferShader.setVec3("material", materialBlinnPhong);
-            renderSphere();
-            
-            //wall
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, wallAlbedoMap);
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, wallNormalMap);
-            glActiveTexture(GL_TEXTURE2);
-            glBindTexture(GL_TEXTURE_2D, wallMetallicMap);
-            glActiveTexture(GL_TEXTURE3);
-            glBindTexture(GL_TEXTURE_2D, wallRoughnessMap);
-            glActiveTexture(GL_TEXTURE4);
-            glBindTexture(GL_TEXTURE_2D, wallAOMap);
-            
-            model = glm::translate(glm::mat4(1.0f), glm::vec3(3.0, 0.0, 2.0));
-            model = glm::rotate(model, (float)sin(glfwGetTime() * 0.1f), glm::vec3(0.0f, 1.0f, 0.0f));
-            GBufferShader.setMat4("model", model);
-            GBufferShader.setVec3("material", materialCellShading);
-            renderSphere();
+            //culled objects still need their previous transform for when they come back into view
+            for(unsigned int i = 0; i < 6; i++)
+                previousModels[i] = objectModels[i];
+        }
 
-            //cube
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, cubeAlbedoMap);
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, cubeNormalMap);
-            glActiveTexture(GL_TEXTURE2);
-            glBindTexture(GL_TEXTURE_2D, cubeMetallicMap);
-            glActiveTexture(GL_TEXTURE3);
-            glBindTexture(GL_TEXTURE_2D, cubeRoughnessMap);
-            glActiveTexture(GL_TEXTURE4);
-            glBindTexture(GL_TEXTURE_2D, cubeAOMap);
-
-            model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0, 0.0, 4.0));
-            model = glm::scale(model, glm::vec3(0.5f));
-            GBufferShader.setMat4("model", model);
-            GBufferShader.setVec3("material", materialCellShading);
-            renderCube();
+        //this frame's depth is reduced for the second glass orb culling pass (and is the previous frame's for the next first pass) right after
+        //the G-buffer. The orbs are drawn straight from what the culling captured, without GL 4.2 or its extensions the culled counts
+        //have to be back on the CPU by the draw, which the same frame rarely manages, see the late frames in the Transparency settings
+        if(hiZOcclusionEnabled)
+        {
+            PROFILE_GPU("Glass orb Hi-Z");
+            hiZOcclusion.Build(gBuffer.m_Textures[3], renderSize, viewProjection);
+            transparencyRenderer.CullDisoccluded();
+            glViewport(0, 0, renderSize.x, renderSize.y);
         }
         
         //TO DO: add a SSAO (screen space ambient occlusion) pass
         {{
+            PROFILE_GPU("SSAO");
             glBindFramebuffer(GL_FRAMEBUFFER, mainFBO);
             glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, HDRColorBuffer0, 0);
             glDisable(GL_BLEND);
             glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
             SSAOShader.use();
-            SSAOShader.setInt("kernalSize", ssaoKernalSize);
+            SSAOShader.setInt("kernelSize", taaEnabled ? std::min(ssaoKernalSize, taaSSAOKernelSize) : ssaoKernalSize);
             SSAOShader.setFloat("radius", ssaoRadius);
             SSAOShader.setFloat("bias", ssaoBias);
             SSAOShader.setFloat("time", glfwGetTime());
             SSAOShader.setVec2("noiseScale", glm::vec2(wWidth / 512, wHeight / 512));
             SSAOShader.setMat4("projection", projection);
             SSAOShader.setMat4("invProjection", invProjection);
+            SSAOShader.setVec2("viewportScale", viewportScale);
 
             glActiveTexture(GL_TEXTURE0);
             glBindTexture(GL_TEXTURE_2D, gBuffer.m_Textures[0]);
             glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, gBuffer.m_Textures[1]);
+            glBindTexture(GL_TEXTURE_2D, gBuffer.m_Textures[2]);
             glActiveTexture(GL_TEXTURE2);
             glBindTexture(GL_TEXTURE_2D, gBuffer.m_Textures[3]);
             glActiveTexture(GL_TEXTURE3);
-            glBindTexture(GL_TEXTURE_2D, gBuffer.m_Textures[4]);
-            glActiveTexture(GL_TEXTURE4);
             glBindTexture(GL_TEXTURE_2D, randomNoiseTexture);
 
             renderQuad();
@@ -704,17 +995,30 @@ int main()
             gBuffer.use();
 
             SSAOBlurShader.use();
-            SSAOBlurShader.setVec2("resolution", glm::vec2(wWidth, wHeight));
+            SSAOBlurShader.setVec2("resolution", glm::vec2(maxRenderWidth, maxRenderHeight));
+            SSAOBlurShader.setVec2("viewportScale", viewportScale);
 
             glActiveTexture(GL_TEXTURE0);
             glBindTexture(GL_TEXTURE_2D, HDRColorBuffer0);
 
+            //the blur only writes the metallic/roughness/AO/ID attachment, the rest of the G-buffer is left alone
+            const GLenum ssaoDrawBuffers[] = { GL_NONE, GL_NONE, GL_COLOR_ATTACHMENT2 };
+            glDrawBuffers(3, ssaoDrawBuffers);
             renderQuad();
+            const GLenum gBufferDrawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT4 };
+            glDrawBuffers(4, gBufferDrawBuffers);
         }}
 
 
+        //half resolution screen space reflections traced through a Hi-Z pyramid, the second PBR pass mixes them over the probes
+        {
+            PROFILE_GPU("SSR");
+            ssrRenderer.Render(gBuffer, view, projection, 0.1f, renderSize);
+        }
+
         //PBR double pass
         {
+                PROFILE_GPU("PBR lighting");
          //first PBR pass
                 glBindFramebuffer(GL_FRAMEBUFFER, mainFBO);
                 glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, HDRColorBuffer1, 0);
@@ -729,6 +1033,7 @@ int main()
                 PBRFirstPass.setVec3("camPos", camera.Position);
                 PBRFirstPass.setMat4("inverseView", inverseView);
                 PBRFirstPass.setMat4("invProjection", invProjection);
+                PBRFirstPass.setVec2("viewportScale", viewportScale);
                 for(unsigned int i = 0; i < shadowRenderer.getNrOfShadowMaps(); i++)
                 {
                     PBRFirstPass.setMat4("inverseView", inverseView);
@@ -749,8 +1054,6 @@ int main()
                     glBindTexture(GL_TEXTURE_2D, gBuffer.m_Textures[2]);
                     glActiveTexture(GL_TEXTURE4);
                     glBindTexture(GL_TEXTURE_2D, gBuffer.m_Textures[3]);
-                    glActiveTexture(GL_TEXTURE5);
-                    glBindTexture(GL_TEXTURE_2D, gBuffer.m_Textures[4]);
 
 
                     renderQuad();
@@ -764,7 +1067,7 @@ int main()
                 //second PBR pass
                 glBindFramebuffer(GL_FRAMEBUFFER, mainFBO);
                 glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, HDRColorBuffer0, 0);
-                glViewport(0, 0, wWidth, wHeight);
+                glViewport(0, 0, renderSize.x, renderSize.y);
                 glClearColor(backgroundColor.r, backgroundColor.g, backgroundColor.b, 1.0f);//This clears the color buffer and sets it to be this color
                 glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
                 glEnable(GL_BLEND);
@@ -773,31 +1076,34 @@ int main()
                 PBRSecondPass.setVec3("camPos", camera.Position);
                 PBRSecondPass.setMat4("invProjection", invProjection);
                 PBRSecondPass.setMat4("invView", inverseView);
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
+                PBRSecondPass.setVec2("viewportScale", viewportScale);
                 glActiveTexture(GL_TEXTURE1);
                 glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
                 glActiveTexture(GL_TEXTURE2);
                 glBindTexture(GL_TEXTURE_2D, brdfLUTTexture);
+                reflectionProbes.Bind(PBRSecondPass);
+                irradianceVolume.Upload();
+                irradianceVolume.Bind(PBRSecondPass);
+                PBRSecondPass.setBool("ssrEnabled", ssrRenderer.m_Enabled);
+                glActiveTexture(GL_TEXTURE8);
+                glBindTexture(GL_TEXTURE_2D, ssrRenderer.ReflectionTexture());
 
                 glActiveTexture(GL_TEXTURE3);
                 glBindTexture(GL_TEXTURE_2D, HDRColorBuffer1);
 
                 glActiveTexture(GL_TEXTURE4);
-                glBindTexture(GL_TEXTURE_2D, gBuffer.m_Textures[0]); //Material Mask texture
+                glBindTexture(GL_TEXTURE_2D, gBuffer.m_Textures[0]); //Octahedral normal texture
                 glActiveTexture(GL_TEXTURE5);
-                glBindTexture(GL_TEXTURE_2D, gBuffer.m_Textures[1]); //Normal/Shadows texture
+                glBindTexture(GL_TEXTURE_2D, gBuffer.m_Textures[1]); //Albedo texture
                 glActiveTexture(GL_TEXTURE6);
-                glBindTexture(GL_TEXTURE_2D, gBuffer.m_Textures[2]); //Albedo texture
+                glBindTexture(GL_TEXTURE_2D, gBuffer.m_Textures[2]); //Metallic/Roughness/Ambient Occlusion/Material ID texture
                 glActiveTexture(GL_TEXTURE7);
-                glBindTexture(GL_TEXTURE_2D, gBuffer.m_Textures[3]); //Metallic/Roughness/Ambient Occlusion texture
-                glActiveTexture(GL_TEXTURE8);
-                glBindTexture(GL_TEXTURE_2D, gBuffer.m_Textures[4]); //Depth texture
+                glBindTexture(GL_TEXTURE_2D, gBuffer.m_Textures[3]); //Depth texture
 
                 renderQuad();
         }
 
-        //TO DO: add a transparency pass that renders everything transparent/translucent on top of the gbuffer and handles screen space reflections/refractions
+        //TO DO: handle screen space refractions for the transparent/translucent surfaces
 
 
         for(unsigned int i = 0; i < sizeof(lightPositions) / sizeof(lightPositions[0]); i++)
@@ -810,32 +1116,70 @@ int main()
         shadowRenderer.updateShadowMap(1, lightPositions[1], lightColors[1]);
         shadowRenderer.updateShadowMap(2, lightPositions[2], lightColors[2]);
         shadowRenderer.updateShadowMap(3, lightPositions[3], lightColors[3]);
+        irradianceVolume.SetLights(lightPositions, lightColors, NR_OF_LIGHTS);
 
         //renders skybox
-        backgroundShader.use();
-        backgroundShader.setMat4("view", view);
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LEQUAL);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxCubeMap);
-        
-        renderCube();
-        glDepthFunc(GL_LEQUAL);
+        {
+            PROFILE_GPU("Skybox");
+            backgroundShader.use();
+            backgroundShader.setMat4("view", view);
+            glEnable(GL_DEPTH_TEST);
+            glDepthFunc(GL_LEQUAL);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxCubeMap);
 
+            renderCube();
+            glDepthFunc(GL_LEQUAL);
+        }
 
-        bloomRenderer.RenderBloomTexture(HDRColorBuffer0, 0.0005f);
-        
-        bloomShader.use();
-        bloomShader.setFloat("exposure", exposure);
-        bloomShader.setFloat("bloomStrength", bloom);
-        bloomShader.setInt("isLensDirt", lensDirt);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, HDRColorBuffer0);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, bloomRenderer.BloomTexture());
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, bloomRenderer.LensDirtTexture());
-        renderQuad();
+        //weighted blended transparency, accumulated against the opaque depth of the G-buffer and composited onto the lit scene before TAA and bloom
+        {
+            PROFILE_GPU("Transparency");
+            transparencyRenderer.Render(view, projection, camera.Position, lightPositions, lightColors, NR_OF_LIGHTS, irradianceSH, renderSize);
+            transparencyRenderer.Composite(mainFBO, renderSize);
+        }
+        //next frame's reflection rays see the finished scene
+        ssrRenderer.CaptureSceneColor(mainFBO, renderSize);
+
+
+        //temporal anti-aliasing resolve, everything after this point works on the anti-aliased scene
+        unsigned int sceneTexture = HDRColorBuffer0;
+        if(taaEnabled)
+        {
+            PROFILE_GPU("TAA");
+            sceneTexture = taaRenderer.Resolve(HDRColorBuffer0, gBuffer.m_Textures[4], gBuffer.m_Textures[3], glm::inverse(viewProjection), prevViewProjection, renderSize);
+        }
+
+        {
+            PROFILE_GPU("Bloom");
+            bloomRenderer.RenderBloomTexture(sceneTexture, 0.0005f, viewportScale);
+        }
+
+        //with an upscaler preset the composite is rendered at the render resolution and upscaled afterwards,
+        //otherwise it upscales the rendered part of the scene to the window itself
+        {
+            PROFILE_GPU("Composite and upscale");
+            if(upscalerPreset != UPSCALER_NATIVE)
+                spatialUpscaler.BindInput(renderSize);
+            else
+                glViewport(0, 0, wWidth, wHeight);
+            bloomShader.use();
+            bloomShader.setVec2("viewportScale", viewportScale);
+            bloomShader.setVec2("sceneResolution", glm::vec2(maxRenderWidth, maxRenderHeight));
+            bloomShader.setFloat("exposure", exposure);
+            bloomShader.setFloat("bloomStrength", bloom);
+            bloomShader.setInt("isLensDirt", lensDirt);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, sceneTexture);
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, bloomRenderer.BloomTexture());
+            glActiveTexture(GL_TEXTURE2);
+            glBindTexture(GL_TEXTURE_2D, bloomRenderer.LensDirtTexture());
+            renderQuad();
+
+            if(upscalerPreset != UPSCALER_NATIVE)
+                spatialUpscaler.Upscale(renderSize, glm::ivec2(wWidth, wHeight));
+        }
 
         //shadowRenderer.debugShadowMap(0);
 
@@ -849,7 +1193,38 @@ int main()
             ImGui::SetWindowSize(ImVec2(ImGuiWindowWidth, ImGuiWindowHeight));
             if(ImGui::TreeNode("Application Performance"))
             {
-                ImGui::Text("Application average frame time: %.3fms (%.1f FPS)", deltaTime, 1.0f / deltaTime);
+                ImGui::Text("Frame time: %.3fms (%.1f FPS), mean since start %.3fms", deltaTime * 1000.0f, 1.0f / deltaTime, averageFrameTime * 1000.0);
+                ImGui::Text("Profiled frame: CPU %.3fms, GPU %.3fms", profiler.FrameCPU(), profiler.FrameGPU());
+                ImGui::PlotLines("CPU ms", profiler.CPUHistory(), PROFILER_HISTORY, profiler.HistoryOffset(), NULL, 0.0f, 33.3f, ImVec2(0, 50));
+                ImGui::PlotLines("GPU ms", profiler.GPUHistory(), PROFILER_HISTORY, profiler.HistoryOffset(), NULL, 0.0f, 33.3f, ImVec2(0, 50));
+                if(ImGui::BeginTable("Passes", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+                {
+                    ImGui::TableSetupColumn("Pass");
+                    ImGui::TableSetupColumn("CPU ms");
+                    ImGui::TableSetupColumn("GPU ms");
+                    ImGui::TableHeadersRow();
+                    const std::vector<ProfileStat>& stats = profiler.Stats();
+                    for(unsigned int i = 0; i < stats.size(); i++)
+                    {
+                        if(profiler.Stale(stats[i]))
+                            continue;
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%*s%s", (int)stats[i].m_Depth * 2, "", stats[i].m_Name);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.3f", stats[i].m_CPU);
+                        ImGui::TableNextColumn();
+                        if(stats[i].m_HasGPU)
+                            ImGui::Text("%.3f", stats[i].m_GPU);
+                        else
+                            ImGui::Text("-");
+                    }
+                    ImGui::EndTable();
+                }
+                ImGui::InputText("trace file", profileCapturePath, sizeof(profileCapturePath));
+                ImGui::SliderInt("trace frames", &profileCaptureFrames, 1, 600);
+                if(ImGui::Button(profiler.Capturing() ? "Capturing..." : "Export Chrome trace") && !profiler.Capturing())
+                    profiler.Capture(profileCaptureFrames, profileCapturePath);
                 ImGui::Text("Field of view: %.3f", camera.Zoom);
                 ImGui::TreePop();
             }
@@ -878,9 +1253,174 @@ int main()
                 ImGui::DragFloat3("Light[2] Color   ", glm::value_ptr(lightColors   [2]), 0.1f,   0.0f, 100.0f);
                 ImGui::DragFloat3("Light[3] Position", glm::value_ptr(lightPositions[3]), 0.1f, -50.0f,  50.0f);
                 ImGui::DragFloat3("Light[3] Color   ", glm::value_ptr(lightColors   [3]), 0.1f,   0.0f, 100.0f);
+                ImGui::Text("Shadow caster draws: %d of %d", nrOfShadowCasterDraws, NR_OF_LIGHTS * objectBounds.Size());
+
+                ImGui::TreePop();
+            }
+            if(ImGui::TreeNode("Anti-Aliasing"))
+            {
+                if(ImGui::Button(std::string("TAA: ").append(taaEnabled ? "Enabled" : "Disabled").c_str()))
+                {
+                    taaEnabled = !taaEnabled;
+                    camera.ResetJitter();
+                    taaRenderer.ResetHistory();
+                }
+                ImGui::SliderFloat("history feedback", &taaRenderer.m_Feedback, 0.0f, 0.98f);
+                ImGui::DragInt("TAA SSAO kernel size", &taaSSAOKernelSize, 1.0f, 1, 64);
 
                 ImGui::TreePop();
             }
+            if(ImGui::TreeNode("Dynamic Resolution"))
+            {
+                if(ImGui::Button(std::string("Dynamic Resolution: ").append(dynamicResolution.m_Enabled ? "Enabled" : "Disabled").c_str()))
+                    dynamicResolution.m_Enabled = !dynamicResolution.m_Enabled;
+                ImGui::SliderFloat("target GPU frame time (ms)", &dynamicResolution.m_TargetFrameTime, 4.0f, 50.0f);
+                ImGui::SliderFloat("min scale", &dynamicResolution.m_MinScale, 0.25f, dynamicResolution.m_MaxScale);
+                ImGui::SliderFloat("max scale", &dynamicResolution.m_MaxScale, dynamicResolution.m_MinScale, 1.0f);
+                dynamicResolution.m_Scale = glm::clamp(dynamicResolution.m_Scale, dynamicResolution.m_MinScale, dynamicResolution.m_MaxScale);
+                ImGui::Text("GPU frame time: %.3fms", dynamicResolution.GPUFrameTime());
+                ImGui::Text("Render scale: %.2f (%dx%d)", dynamicResolution.m_Enabled ? dynamicResolution.m_Scale : dynamicResolution.m_MaxScale, renderSize.x, renderSize.y);
+
+                ImGui::TreePop();
+            }
+            if(ImGui::TreeNode("Upscaling"))
+            {
+                if(ImGui::BeginCombo("preset", SpatialUpscaler::PresetName(upscalerPreset)))
+                {
+                    for(int i = 0; i < UPSCALER_PRESET_COUNT; i++)
+                    {
+                        if(ImGui::Selectable(SpatialUpscaler::PresetName((UpscalerPreset)i), upscalerPreset == i))
+                            upscalerPreset = (UpscalerPreset)i;
+                    }
+                    ImGui::EndCombo();
+                }
+                ImGui::SliderFloat("sharpness", &spatialUpscaler.m_Sharpness, 0.0f, 1.0f);
+
+                ImGui::TreePop();
+            }
+            if(ImGui::TreeNode("Reflection Probes"))
+            {
+                if(ImGui::Button(std::string("Reflection Probes: ").append(reflectionProbes.m_Enabled ? "Enabled" : "Disabled").c_str()))
+                    reflectionProbes.m_Enabled = !reflectionProbes.m_Enabled;
+                ImGui::SameLine();
+                if(ImGui::Button("rebake"))
+                    reflectionProbes.RebakeAll();
+                ImGui::SliderFloat("bake budget (ms)", &reflectionProbes.m_Budget, 0.1f, 10.0f);
+                for(unsigned int i = 0; i < reflectionProbes.NrOfProbes(); i++)
+                {
+                    const ReflectionProbe& probe = reflectionProbes.Probe(i);
+                    ImGui::Text("Probe %d: %s (%d/%d)", i, probe.m_Step == REFLECTION_PROBE_BAKE_STEPS ? "baked" : "baking", probe.m_Step, REFLECTION_PROBE_BAKE_STEPS);
+                }
+
+                ImGui::TreePop();
+            }
+            if(ImGui::TreeNode("Irradiance Volume"))
+            {
+                if(ImGui::Button(std::string("Irradiance Volume: ").append(irradianceVolume.m_Enabled ? "Enabled" : "Disabled").c_str()))
+                    irradianceVolume.m_Enabled = !irradianceVolume.m_Enabled;
+                glm::ivec3 volumeResolution = irradianceVolume.Resolution();
+                ImGui::Text("Probes: %dx%dx%d", volumeResolution.x, volumeResolution.y, volumeResolution.z);
+                ImGui::Text("Relit grids uploaded: %d", irradianceVolume.NrOfUploads());
+
+                ImGui::TreePop();
+            }
+            if(ImGui::TreeNode("Visibility Buffer"))
+            {
+                if(visibilityBufferAvailable && ImGui::Button(std::string("G-buffer path: ").append(visibilityBufferEnabled ? "Visibility Buffer" : "Deferred").c_str()))
+                    visibilityBufferEnabled = !visibilityBufferEnabled;
+                ImGui::Text("Instances: %d, triangles: %d", visibilityBuffer.NrOfInstances(), visibilityBuffer.NrOfTriangles());
+                ImGui::Text("Deferred G-buffer pass: %.3fms", profiler.GPUTime("G-buffer (deferred)"));
+                ImGui::Text("Visibility buffer + resolve: %.3fms", profiler.GPUTime("G-buffer (visibility buffer)"));
+                if(visibilityBenchmarkFrames > 0)
+                    ImGui::Text("Benchmarking, %d frames left", visibilityBenchmarkFrames);
+                else if(visibilityBufferAvailable && ImGui::Button("benchmark"))
+                {
+                    profiler.ResetMeans();
+                    visibilityBenchmarkRestore = visibilityBufferEnabled;
+                    visibilityBenchmarkFrames = VISIBILITY_BENCHMARK_FRAMES;
+                }
+                ImGui::TreePop();
+            }
+            if(ImGui::TreeNode("Jobs"))
+            {
+                ImGui::Text("Worker threads: %d + main thread", jobSystem.NrOfWorkers());
+                //these block the frame for a few seconds, the results are printed to the console
+                if(ImGui::Button("benchmark job system"))
+                    JobSystem::Benchmark();
+                if(ImGui::Button("benchmark scene update"))
+                    SceneJobs::Benchmark(jobSystem, SCENE_BENCHMARK_NODES);
+                ImGui::Checkbox("Cull the draw list and shadow casters in the scene update", &sceneJobsCulling);
+                if(sceneJobsCulling)
+                    ImGui::Text("Scene nodes the camera sees: %d of %d", (int)sceneViews[0].m_Visible.size(), SceneNode::getTransforms().Size());
+                ImGui::TreePop();
+            }
+            if(ImGui::TreeNode("Spatial Queries"))
+            {
+                if(hoveredObject < 0)
+                    ImGui::Text("Under the cursor: nothing");
+                else
+                    ImGui::Text("Under the cursor: object %d", hoveredObject);
+                ImGui::Text("BVH nodes: %d, SAH cost x%.2f of the last build", objectBVH.NrOfNodes(), objectBVH.Degradation());
+                //blocks the frame for a few seconds, the results are printed to the console
+                if(ImGui::Button("benchmark BVH"))
+                    BVH::Benchmark(jobSystem, BVH_BENCHMARK_OBJECTS);
+                if(ImGui::Button(std::string("Shadow caster index: ").append(SpatialIndex::ModeName(objectIndex.Mode())).c_str()))
+                    objectIndex.SetMode((SpatialIndexMode)((objectIndex.Mode() + 1) % NR_OF_SPATIAL_INDEX_MODES));
+                //inserts, moves and queries up to a million spheres in both modes
+                if(ImGui::Button("benchmark spatial index"))
+                    SpatialIndex::Benchmark();
+                ImGui::TreePop();
+            }
+            if(ImGui::TreeNode("Depth Pre-pass"))
+            {
+                if(ImGui::Button(std::string("Depth pre-pass: ").append(DepthPrepass::ModeName(depthPrepass.m_Mode)).c_str()))
+                    depthPrepass.m_Mode = (DepthPrepassMode)((depthPrepass.m_Mode + 1) % NR_OF_DEPTH_PREPASS_MODES);
+                ImGui::DragFloat("threshold", &depthPrepass.m_Threshold, 0.05f, 1.0f, 8.0f);
+                ImGui::Text("Estimated depth complexity: %.2f", depthPrepass.DepthComplexity());
+                ImGui::Text("Pre-pass this frame: %s", depthPrepass.Active() ? "yes" : "no");
+                ImGui::Text("Drawn: %d, culled: %d, occluded: %d", (int)drawList.Items().size(), drawList.NrOfCulled(), drawList.NrOfOccluded());
+                ImGui::Checkbox("software occlusion culling", &occlusionCullingEnabled);
+                ImGui::Text("Occluder triangles: %d of %d", occlusionCuller.NrOfRasterized(), occlusionCuller.NrOfTriangles());
+                //rasterizes a fixed city and tests 100000 boxes against it, the results are printed to the console
+                if(ImGui::Button("benchmark occlusion culling"))
+                    OcclusionCuller::Benchmark(jobSystem, OCCLUSION_BENCHMARK_OBJECTS);
+                ImGui::Text("G-buffer pass: %.3fms", profiler.GPUTime("G-buffer (deferred)"));
+                ImGui::TreePop();
+            }
+            if(ImGui::TreeNode("Screen Space Reflections"))
+            {
+                if(ImGui::Button(std::string("SSR: ").append(ssrRenderer.m_Enabled ? "Enabled" : "Disabled").c_str()))
+                {
+                    ssrRenderer.m_Enabled = !ssrRenderer.m_Enabled;
+                    ssrRenderer.ResetHistory();
+                }
+                ImGui::SliderFloat("max roughness", &ssrRenderer.m_MaxRoughness, 0.0f, 1.0f);
+                ImGui::SliderInt("max rays", &ssrRenderer.m_MaxRays, 1, SSR_MAX_RAYS);
+                ImGui::SliderInt("max iterations", &ssrRenderer.m_MaxIterations, 8, 256);
+                ImGui::DragFloat("thickness", &ssrRenderer.m_Thickness, 0.01f, 0.01f, 2.0f);
+                ImGui::SliderFloat("SSR history feedback", &ssrRenderer.m_Feedback, 0.0f, 0.98f);
+                ImGui::Text("Hi-Z levels: %d", ssrRenderer.NrOfHiZLevels());
+                ImGui::Text("Hi-Z build + trace + filter: %.3fms", profiler.GPUTime("SSR"));
+                ImGui::TreePop();
+            }
+            if(ImGui::TreeNode("Transparency"))
+            {
+                if(ImGui::Button(std::string("Weighted blended OIT: ").append(transparencyRenderer.m_Enabled ? "Enabled" : "Disabled").c_str()))
+                    transparencyRenderer.m_Enabled = !transparencyRenderer.m_Enabled;
+                ImGui::SliderInt("glass orbs", &nrOfGlassOrbs, 0, MAX_GLASS_ORBS);
+                ImGui::Text("Instances in the batched draw: %d", transparencyRenderer.NrOfInstances());
+                ImGui::Checkbox("Hi-Z occlusion culling", &hiZOcclusionEnabled);
+                if(hiZOcclusion.FeedbackDrawsAvailable())
+                    ImGui::Checkbox("draw from the transform feedback", &hiZOcclusion.m_UseFeedbackDraws);
+                ImGui::Text("Drawn: %d (%d disoccluded)", transparencyRenderer.NrOfDrawn(), transparencyRenderer.NrOfDisoccluded());
+                if(!hiZOcclusion.DrawsFromFeedback())
+                {
+                    ImGui::Text("Late counts, every orb drawn: %d of %d frames", transparencyRenderer.NrOfLateFrames(), transparencyRenderer.NrOfCulledFrames());
+                    if(ImGui::Button("reset"))
+                        transparencyRenderer.ResetCullingStatistics();
+                }
+                ImGui::TreePop();
+            }
             if(ImGui::TreeNode("SSAO"))
             {
                 ImGui::DragFloat("ssaoRadius", &ssaoRadius, 0.1f, 0.0f, 5.0f);
@@ -899,24 +1439,40 @@ int main()
         }
 
 
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        {
+            PROFILE_GPU("ImGui");
+            ImGui::Render();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+
+        profiler.EndFrame();
+        dynamicResolution.EndFrame();
 
         glfwSwapBuffers(window);//swaps frame buffers
         glfwPollEvents();
     }
 
-    irradianceShader.destroy();
     prefilterShader.destroy();
-    brdfShader.destroy();
     backgroundShader.destroy();
     bloomShader.destroy();
     bloomRenderer.Destroy();
+    taaRenderer.Destroy();
+    dynamicResolution.Destroy();
+    spatialUpscaler.Destroy();
+    reflectionProbes.Destroy();
+    irradianceVolume.Destroy();
+    visibilityBuffer.Destroy();
+    depthPrepass.Destroy();
+    transparencyRenderer.Destroy();
+    hiZOcclusion.Destroy();
+    ssrRenderer.Destroy();
+    profiler.Destroy();
+    jobSystem.Destroy();
     shadowRenderer.Destroy();
     ImGui_ImplGlfw_Shutdown();
     glfwTerminate();//this tells glfw to release any memory that is be using to run the window
     
-    printf("Average frame time : %f.5ms\n", averageFrameTime / 1.0f);
+    printf("Average frame time : %.5fms\n", averageFrameTime * 1000.0);
     
     return 0;
 }
@@ -926,9 +1482,13 @@ int main()
 void framebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
     glViewport(0, 0, width, height);//this changes the viewport to be the same as the window size
-    //this sets the window width and height to be the rescaled ones
-    wWidth = width;
+    //a minimized window has a size of 0, keep rendering at the last size
+    if(width <= (int)ImGuiWindowWidth || height <= 0)
+        return;
+    //this sets the window width and height to be the rescaled ones, the render targets don't need to be resized since they're allocated at the maximum size
+    wWidth = width - ImGuiWindowWidth;
     wHeight = height;
+    ImGuiWindowHeight = height;
 }
 //Function that is called for mouse input       *OPTIMIZABLE*
 void mouseCallback(GLFWwindow* window, double xPos, double yPos)
@@ -1024,34 +1584,10 @@ unsigned int loadTexture(const char* path, bool gammaCorrection)
     int width, height, nrComponents;
     unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
     if(data)
-    {
-        GLenum internalFormat = gammaCorrection ? GL_SRGB_ALPHA : GL_RGBA;
-        GLenum dataFormat = GL_RGBA;
-        if(nrComponents == 1)
-            internalFormat = dataFormat = GL_RED;
-        else if(nrComponents == 3)
-        {
-            internalFormat = gammaCorrection ? GL_SRGB : GL_RGB;
-            dataFormat = GL_RGB;
-        }
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, dataFormat, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        //this makes the textures repeat if texCoords are larger than 1 or less than 0 and tells openGL to use linear upscaling
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);//this frees the image from system memory since it should be in VRAM by now
-    }
-    else
-    {   //this is if the image wasn't read for any reason
+        TextureLoader::Upload(textureID, data, width, height, nrComponents, gammaCorrection);
+    else//this is if the image wasn't read for any reason
         std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
+    stbi_image_free(data);//this frees the image from system memory since it should be in VRAM by now
 
     return textureID;
 }
@@ -1117,60 +1653,62 @@ float calculateExposure(unsigned int FBO, int w = wWidth, int h = wHeight, float
     return exposure;
 }
 
+//position, normal and texture coordinates of the 36 vertices of the cube
+const float cubeVertices[] = {
+    // back face
+    -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
+     1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f, // bottom-right         
+     1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
+     1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
+    -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f, // top-left
+    -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
+    // front face
+    -1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
+     1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
+     1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 0.0f, // bottom-right
+     1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
+    -1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
+    -1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 1.0f, // top-left
+    // left face
+    -1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
+    -1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
+    -1.0f,  1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-left
+    -1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
+    -1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
+    -1.0f, -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-right
+    // right face
+     1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
+     1.0f,  1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-right         
+     1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
+     1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
+     1.0f, -1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left     
+     1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
+    // bottom face
+    -1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
+     1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
+     1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f, // top-left
+     1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
+    -1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
+    -1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f, // bottom-right
+    // top face
+    -1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
+     1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f, // top-right     
+     1.0f,  1.0f , 1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
+     1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
+    -1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f,  // bottom-left        
+    -1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f // top-left
+};
+
 unsigned int cubeVAO = 0, cubeVBO = 0;
 void renderCube()
 {
     if(cubeVAO == 0)
     {
-        float vertices[] = {
-            // back face
-            -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
-             1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f, // bottom-right         
-             1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
-             1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
-            -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f, // top-left
-            -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
-            // front face
-            -1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
-             1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
-             1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 0.0f, // bottom-right
-             1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
-            -1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
-            -1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 1.0f, // top-left
-            // left face
-            -1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
-            -1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
-            -1.0f,  1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-left
-            -1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
-            -1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
-            -1.0f, -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-right
-            // right face
-             1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
-             1.0f,  1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-right         
-             1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
-             1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
-             1.0f, -1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left     
-             1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
-            // bottom face
-            -1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
-             1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
-             1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f, // top-left
-             1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
-            -1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
-            -1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f, // bottom-right
-            // top face
-            -1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
-             1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f, // top-right     
-             1.0f,  1.0f , 1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
-             1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
-            -1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f,  // bottom-left        
-            -1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f // top-left
-        };
         glGenVertexArrays(1, &cubeVAO);
         glGenBuffers(1, &cubeVBO);
 
         glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
 
         glBindVertexArray(cubeVAO);
         glEnableVertexAttribArray(0);
@@ -1186,6 +1724,33 @@ void renderCube()
     glDrawArrays(GL_TRIANGLES, 0, 36);
     glBindVertexArray(0);
 }
+//the cube of renderCube with only the positions, tightly packed for the depth pre-pass
+unsigned int cubePositionVAO = 0, cubePositionVBO = 0;
+void renderCubePositions()
+{
+    if(cubePositionVAO == 0)
+    {
+        float positions[36 * 3];
+        for(unsigned int i = 0; i < 36; i++)
+        {
+            positions[i * 3 + 0] = cubeVertices[i * 8 + 0];
+            positions[i * 3 + 1] = cubeVertices[i * 8 + 1];
+            positions[i * 3 + 2] = cubeVertices[i * 8 + 2];
+        }
+        glGenVertexArrays(1, &cubePositionVAO);
+        glGenBuffers(1, &cubePositionVBO);
+
+        glBindVertexArray(cubePositionVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, cubePositionVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(positions), positions, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    glBindVertexArray(cubePositionVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+    glBindVertexArray(0);
+}
 
 unsigned int quadVAO = 0, quadVBO = 0;
 void renderQuad()
@@ -1218,96 +1783,167 @@ void renderQuad()
     glBindVertexArray(0);
 }
 
-unsigned int sphereVAO = 0;
+unsigned int sphereVAO = 0, spherePositionVAO = 0;
 unsigned int indexCount;
-void renderSphere()
+//builds the sphere's full vertex stream and a position only one sharing its indices, for the depth pre-pass
+void setupSphere()
 {
-    if(sphereVAO == 0)
-    {
-        glGenVertexArrays(1, &sphereVAO);
+    glGenVertexArrays(1, &sphereVAO);
 
-        unsigned int vbo, ebo;
-        glGenBuffers(1, &vbo);
-        glGenBuffers(1, &ebo);
+    unsigned int vbo, ebo;
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ebo);
 
-        std::vector<glm::vec3> positions;
-        std::vector<glm::vec2> uv;
-        std::vector<glm::vec3> normals;
-        std::vector<unsigned int> indices;
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> uv;
+    std::vector<glm::vec3> normals;
+    std::vector<unsigned int> indices;
 
-        const unsigned int X_SEGMENTS = 64;
-        const unsigned int Y_SEGMENTS = 64;
-        for(unsigned int x = 0; x <= X_SEGMENTS; x++)
+    const unsigned int X_SEGMENTS = 64;
+    const unsigned int Y_SEGMENTS = 64;
+    for(unsigned int x = 0; x <= X_SEGMENTS; x++)
+    {
+        for(unsigned int y = 0; y <= Y_SEGMENTS; y++)
         {
-            for(unsigned int y = 0; y <= Y_SEGMENTS; y++)
-            {
-                float xSegment = (float)x / (float)X_SEGMENTS;
-                float ySegment = (float)y / (float)Y_SEGMENTS;
-                float xPos = std::cos(xSegment * 2.0f * Pi) * std::sin(ySegment * Pi);
-                float yPos = std::cos(ySegment * Pi);
-                float zPos = std::sin(xSegment * 2.0f * Pi) * std::sin(ySegment * Pi);
-
-                positions.push_back(glm::vec3(xPos, yPos, zPos));
-                uv.push_back(glm::vec2(xSegment, ySegment));
-                normals.push_back(glm::vec3(xPos, yPos, zPos));
-            }
+            float xSegment = (float)x / (float)X_SEGMENTS;
+            float ySegment = (float)y / (float)Y_SEGMENTS;
+            float xPos = std::cos(xSegment * 2.0f * Pi) * std::sin(ySegment * Pi);
+            float yPos = std::cos(ySegment * Pi);
+            float zPos = std::sin(xSegment * 2.0f * Pi) * std::sin(ySegment * Pi);
+
+            positions.push_back(glm::vec3(xPos, yPos, zPos));
+            uv.push_back(glm::vec2(xSegment, ySegment));
+            normals.push_back(glm::vec3(xPos, yPos, zPos));
         }
+    }
 
-        bool oddRow = false;
-        for(unsigned int y = 0; y < Y_SEGMENTS; y++)
+    bool oddRow = false;
+    for(unsigned int y = 0; y < Y_SEGMENTS; y++)
+    {
+        if(!oddRow)
         {
-            if(!oddRow)
+            for(unsigned int x = 0; x <= X_SEGMENTS; x++)
             {
-                for(unsigned int x = 0; x <= X_SEGMENTS; x++)
-                {
-                    indices.push_back(y * (X_SEGMENTS + 1) + x);
-                    indices.push_back((y + 1) * (X_SEGMENTS + 1) + x);
-                }
+                indices.push_back(y * (X_SEGMENTS + 1) + x);
+                indices.push_back((y + 1) * (X_SEGMENTS + 1) + x);
             }
-            else
+        }
+        else
+        {
+            for(unsigned int x = X_SEGMENTS; x > 0; x--)
             {
-                for(unsigned int x = X_SEGMENTS; x > 0; x--)
-                {
-                    indices.push_back((y + 1) * (X_SEGMENTS + 1) + x);
-                    indices.push_back(y * (X_SEGMENTS + 1) + x);
-                }
+                indices.push_back((y + 1) * (X_SEGMENTS + 1) + x);
+                indices.push_back(y * (X_SEGMENTS + 1) + x);
             }
-            oddRow != oddRow;
         }
-        indexCount = indices.size();
+        oddRow != oddRow;
+    }
+    indexCount = indices.size();
 
-        std::vector<float> data;
-        for(unsigned int i = 0; i < positions.size(); i++)
+    std::vector<float> data;
+    for(unsigned int i = 0; i < positions.size(); i++)
+    {
+        data.push_back(positions[i].x);
+        data.push_back(positions[i].y);
+        data.push_back(positions[i].z);
+        if(normals.size() > 0)
         {
-            data.push_back(positions[i].x);
-            data.push_back(positions[i].y);
-            data.push_back(positions[i].z);
-            if(normals.size() > 0)
-            {
-                data.push_back(normals[i].x);
-                data.push_back(normals[i].y);
-                data.push_back(normals[i].z);
-            }
-            if(uv.size() > 0)
-            {
-                data.push_back(uv[i].x);
-                data.push_back(uv[i].y);
-            }
+            data.push_back(normals[i].x);
+            data.push_back(normals[i].y);
+            data.push_back(normals[i].z);
+        }
+        if(uv.size() > 0)
+        {
+            data.push_back(uv[i].x);
+            data.push_back(uv[i].y);
         }
-        glBindVertexArray(sphereVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-        unsigned int stride = (3 + 2 + 3) * sizeof(float);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
     }
+    glBindVertexArray(sphereVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+    unsigned int stride = (3 + 2 + 3) * sizeof(float);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
+
+    unsigned int positionVBO;
+    glGenVertexArrays(1, &spherePositionVAO);
+    glGenBuffers(1, &positionVBO);
+    glBindVertexArray(spherePositionVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, positionVBO);
+    glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), &positions[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    glBindVertexArray(0);
+}
+void renderSphere()
+{
+    if(sphereVAO == 0)
+        setupSphere();
 
     glBindVertexArray(sphereVAO);
     glDrawElements(GL_TRIANGLE_STRIP, indexCount, GL_UNSIGNED_INT, 0);
-}
\ No newline at end of file
+}
+void renderSpherePositions()
+{
+    if(sphereVAO == 0)
+        setupSphere();
+
+    glBindVertexArray(spherePositionVAO);
+    glDrawElements(GL_TRIANGLE_STRIP, indexCount, GL_UNSIGNED_INT, 0);
+}
+//the sphere of renderSphere as an indexed triangle list
+void generateSphere(std::vector<glm::vec3>& positions, std::vector<glm::vec3>& normals, std::vector<glm::vec2>& uvs, std::vector<unsigned int>& indices, unsigned int segments)
+{
+    const unsigned int X_SEGMENTS = segments;
+    const unsigned int Y_SEGMENTS = segments;
+    for(unsigned int x = 0; x <= X_SEGMENTS; x++)
+    {
+        for(unsigned int y = 0; y <= Y_SEGMENTS; y++)
+        {
+            float xSegment = (float)x / (float)X_SEGMENTS;
+            float ySegment = (float)y / (float)Y_SEGMENTS;
+            float xPos = std::cos(xSegment * 2.0f * Pi) * std::sin(ySegment * Pi);
+            float yPos = std::cos(ySegment * Pi);
+            float zPos = std::sin(xSegment * 2.0f * Pi) * std::sin(ySegment * Pi);
+
+            positions.push_back(glm::vec3(xPos, yPos, zPos));
+            uvs.push_back(glm::vec2(xSegment, ySegment));
+            normals.push_back(glm::vec3(xPos, yPos, zPos));
+        }
+    }
+
+    for(unsigned int y = 0; y < Y_SEGMENTS; y++)
+    {
+        for(unsigned int x = 0; x < X_SEGMENTS; x++)
+        {
+            unsigned int i0 = y * (X_SEGMENTS + 1) + x;
+            unsigned int i1 = (y + 1) * (X_SEGMENTS + 1) + x;
+            indices.push_back(i0);
+            indices.push_back(i1);
+            indices.push_back(i0 + 1);
+            indices.push_back(i0 + 1);
+            indices.push_back(i1);
+            indices.push_back(i1 + 1);
+        }
+    }
+}
+
+//the cube of renderCube as an indexed triangle list
+void generateCube(std::vector<glm::vec3>& positions, std::vector<glm::vec3>& normals, std::vector<glm::vec2>& uvs, std::vector<unsigned int>& indices)
+{
+    for(unsigned int i = 0; i < 36; i++)
+    {
+        const float* vertex = &cubeVertices[i * 8];
+        positions.push_back(glm::vec3(vertex[0], vertex[1], vertex[2]));
+        normals.push_back(glm::vec3(vertex[3], vertex[4], vertex[5]));
+        uvs.push_back(glm::vec2(vertex[6], vertex[7]));
+        indices.push_back(i);
+    }
+}
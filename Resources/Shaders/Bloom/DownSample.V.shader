@@ -4,8 +4,10 @@ layout(location = 1) in vec2 aTexCoords;
 
 out vec2 texCoords;
 
+uniform vec2 viewportScale = vec2(1.0f);
+
 void main()
 {
 	gl_Position = vec4(aPos.x, aPos.y, 0.0f, 1.0f);
-	texCoords = aTexCoords;
+	texCoords = aTexCoords * viewportScale;
 }
\ No newline at end of file
@@ -12,6 +12,10 @@ uniform float bloomStrength = 0.05f;
 uniform float NrOfMips = 5.0f;
 uniform bool isLensDirt;
 
+//dynamic resolution: the scene and bloom textures only hold an image in the viewportScale part of them and are upscaled to the window
+uniform vec2 viewportScale = vec2(1.0f);
+uniform vec2 sceneResolution; //allocated size of the scene texture
+
 vec3 bloom(vec3 hdr, vec3 bloom, vec3 dirt, bool lensDirt)
 {
 	if(lensDirt)
@@ -24,10 +28,48 @@ vec3 bloom(vec3 hdr, vec3 bloom, vec3 dirt, bool lensDirt)
 			   bloomStrength);
 }
 
+//Catmull-Rom bicubic filter done with 9 bilinear taps, it keeps the image sharper than a plain bilinear upscale
+vec3 sampleCatmullRom(sampler2D tex, vec2 uv, vec2 texSize, vec2 uvMax)
+{
+	vec2 samplePos = uv * texSize;
+	vec2 texPos1 = floor(samplePos - 0.5f) + 0.5f;
+	vec2 f = samplePos - texPos1;
+
+	vec2 w0 = f * (-0.5f + f * (1.0f - 0.5f * f));
+	vec2 w1 = 1.0f + f * f * (-2.5f + 1.5f * f);
+	vec2 w2 = f * (0.5f + f * (2.0f - 1.5f * f));
+	vec2 w3 = f * f * (-0.5f + 0.5f * f);
+
+	//the middle two taps are merged into one bilinear tap
+	vec2 w12 = w1 + w2;
+	vec2 offset12 = w2 / w12;
+
+	vec2 texPos0 = min((texPos1 - 1.0f) / texSize, uvMax);
+	vec2 texPos3 = min((texPos1 + 2.0f) / texSize, uvMax);
+	vec2 texPos12 = min((texPos1 + offset12) / texSize, uvMax);
+
+	vec3 result = vec3(0.0f);
+	result += texture(tex, vec2(texPos0.x,  texPos0.y)).rgb  * w0.x  * w0.y;
+	result += texture(tex, vec2(texPos12.x, texPos0.y)).rgb  * w12.x * w0.y;
+	result += texture(tex, vec2(texPos3.x,  texPos0.y)).rgb  * w3.x  * w0.y;
+
+	result += texture(tex, vec2(texPos0.x,  texPos12.y)).rgb * w0.x  * w12.y;
+	result += texture(tex, vec2(texPos12.x, texPos12.y)).rgb * w12.x * w12.y;
+	result += texture(tex, vec2(texPos3.x,  texPos12.y)).rgb * w3.x  * w12.y;
+
+	result += texture(tex, vec2(texPos0.x,  texPos3.y)).rgb  * w0.x  * w3.y;
+	result += texture(tex, vec2(texPos12.x, texPos3.y)).rgb  * w12.x * w3.y;
+	result += texture(tex, vec2(texPos3.x,  texPos3.y)).rgb  * w3.x  * w3.y;
+
+	//negative lobes can ring below zero around very bright pixels
+	return max(result, vec3(0.0f));
+}
+
 void main()
 {
-	vec3 hdrColor = texture(scene, texCoords).rgb;
-	vec3 bloomColor = texture(bloomBlur, texCoords).rgb;
+	vec2 sceneCoords = texCoords * viewportScale;
+	vec3 hdrColor = sampleCatmullRom(scene, sceneCoords, sceneResolution, viewportScale - 0.5f / sceneResolution);
+	vec3 bloomColor = texture(bloomBlur, sceneCoords).rgb;
 	vec3 lensDirt = texture(lensDirtTexture, texCoords).rgb;
 
 	vec3 result = bloom(hdrColor, bloomColor, lensDirt, isLensDirt);
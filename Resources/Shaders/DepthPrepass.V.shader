@@ -0,0 +1,16 @@
+#version 330 core
+layout(location = 0) in vec3 aPos;
+
+//has to match GBuffer.V.shader exactly for the GL_EQUAL depth test of the G-buffer pass
+invariant gl_Position;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 model;
+
+void main()
+{
+	vec4 worldSpacePos = model * vec4(aPos, 1.0f);
+	vec3 viewSpacePos = vec3(view * worldSpacePos);
+	gl_Position = projection * vec4(viewSpacePos, 1.0f);
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#version 330 core
+out float hiZ;
+
+uniform sampler2D source; //the depth buffer for level 0, the previous level otherwise
+uniform vec2 sourceSize;
+uniform bool reduce;
+uniform bool farthest; //max instead of min, for occlusion culling
+
+float combine(float a, float b)
+{
+	return farthest ? max(a, b) : min(a, b);
+}
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	if(!reduce)
+	{
+		hiZ = texelFetch(source, pixel, 0).r;
+		return;
+	}
+
+	//every level is half the size of the previous one rounded up, so a cell covers 2x2 cells below or less at the last row/column
+	ivec2 last = ivec2(sourceSize) - 1;
+	ivec2 p = pixel * 2;
+	float z = texelFetch(source, min(p, last), 0).r;
+	z = combine(z, texelFetch(source, min(p + ivec2(1, 0), last), 0).r);
+	z = combine(z, texelFetch(source, min(p + ivec2(0, 1), last), 0).r);
+	z = combine(z, texelFetch(source, min(p + ivec2(1, 1), last), 0).r);
+	hiZ = z;
+}
\ No newline at end of file
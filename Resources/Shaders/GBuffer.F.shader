@@ -1,13 +1,14 @@
 #version 330
-layout(location = 0) out vec3 gMaterialMask;
-layout(location = 1) out vec4 gNormal;
-layout(location = 2) out vec4 gAlbedo;
-layout(location = 3) out vec3 gMetalRoughAO;
+layout(location = 0) out vec2 gNormal; //octahedral encoded
+layout(location = 1) out vec4 gAlbedo;
+layout(location = 2) out vec4 gMetalRoughAO; //alpha is the material ID / 255
+layout(location = 3) out vec2 gVelocity;
 
-in vec3 materialMask;
 in vec2 texCoords;
 in vec4 worldSpacePos;
 in vec3 normal;
+in vec4 currentClipPos;
+in vec4 previousClipPos;
 
 //material properties
 uniform sampler2D albedoMap;
@@ -16,22 +17,27 @@ uniform sampler2D metallicMap;
 uniform sampler2D roughnessMap;
 uniform sampler2D aoMap;
 uniform float time;
+uniform int materialID = 0;
 
 const float Pi = 3.14159265359f;
 
 vec3 getNormalFromMap(sampler2D map, vec3 pos, vec3 norm, vec2 uv);
+vec2 encodeNormal(vec3 n);
 
 void main()
 {
-	gMaterialMask = materialMask;
-
-	gNormal.rgb = getNormalFromMap(normalMap, worldSpacePos.xyz, normal, texCoords);
-	gNormal.a = 1.0f;
+	gNormal = encodeNormal(getNormalFromMap(normalMap, worldSpacePos.xyz, normal, texCoords));
 
 	gAlbedo = texture(albedoMap, texCoords).rgba;
 	gMetalRoughAO.r = texture(metallicMap, texCoords).r;
 	gMetalRoughAO.g = texture(roughnessMap, texCoords).r;
 	gMetalRoughAO.b = texture(aoMap, texCoords).r;
+	gMetalRoughAO.a = float(materialID) / 255.0f;
+
+	//screen-space motion in texture coordinates from the previous frame to this one
+	vec2 currentNDC = currentClipPos.xy / currentClipPos.w;
+	vec2 previousNDC = previousClipPos.xy / previousClipPos.w;
+	gVelocity = (currentNDC - previousNDC) * 0.5f;
 }
 
 vec3 getNormalFromMap(sampler2D map, vec3 pos, vec3 norm, vec2 uv)
@@ -50,3 +56,13 @@ vec3 getNormalFromMap(sampler2D map, vec3 pos, vec3 norm, vec2 uv)
 
 	return normalize(TBN * tangentNormal);
 }
+
+//projects the normal onto an octahedron and unfolds the lower half over the corners, mapped to [0, 1] for the unorm target
+vec2 encodeNormal(vec3 n)
+{
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	vec2 e = n.xy;
+	if(n.z < 0.0f)
+		e = (1.0f - abs(n.yx)) * vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+	return e * 0.5f + 0.5f;
+}
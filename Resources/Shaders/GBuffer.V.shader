@@ -3,23 +3,31 @@ layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aTexCoords;
 
-out vec3 materialMask;
 out vec2 texCoords;
 out vec4 worldSpacePos;
 out vec3 normal;
+out vec4 currentClipPos;
+out vec4 previousClipPos;
+
+//matches DepthPrepass.V.shader, the G-buffer pass tests against the pre-pass depth with GL_EQUAL
+invariant gl_Position;
 
-uniform vec3 material = vec3(0.0f);
 uniform mat4 projection;
 uniform mat4 view;
 uniform mat4 model;
+//un-jittered matrices of the current and previous frame, used to write per-pixel velocity for temporal anti-aliasing
+uniform mat4 viewProjection;
+uniform mat4 prevViewProjection;
+uniform mat4 prevModel;
 
 void main()
 {
-	materialMask = material;
 	texCoords = aTexCoords;
 	worldSpacePos = model * vec4(aPos, 1.0f);
 	vec3 viewSpacePos = vec3(view * worldSpacePos);
 	mat3 normalMatrix = transpose(inverse(mat3(model)));
 	normal = normalMatrix * aNormal;
+	currentClipPos = viewProjection * worldSpacePos;
+	previousClipPos = prevViewProjection * prevModel * vec4(aPos, 1.0f);
 	gl_Position = projection * vec4(viewSpacePos, 1.0f);
 }
\ No newline at end of file
@@ -0,0 +1,30 @@
+#version 330 core
+layout(points) in;
+layout(points, max_vertices = 1) out;
+
+in vec4 vModel0[];
+in vec4 vModel1[];
+in vec4 vModel2[];
+in vec4 vModel3[];
+in vec4 vPayload[];
+flat in int vVisible[];
+
+//captured by transform feedback, culled instances emit nothing so the kept ones end up packed
+out vec4 model0;
+out vec4 model1;
+out vec4 model2;
+out vec4 model3;
+out vec4 payload;
+
+void main()
+{
+	if(vVisible[0] == 0)
+		return;
+	model0 = vModel0[0];
+	model1 = vModel1[0];
+	model2 = vModel2[0];
+	model3 = vModel3[0];
+	payload = vPayload[0];
+	EmitVertex();
+	EndPrimitive();
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+#version 330 core
+layout(location = 0) in vec4 aModel0; //per instance model matrix, one column per location
+layout(location = 1) in vec4 aModel1;
+layout(location = 2) in vec4 aModel2;
+layout(location = 3) in vec4 aModel3;
+layout(location = 4) in vec4 aPayload;
+
+out vec4 vModel0;
+out vec4 vModel1;
+out vec4 vModel2;
+out vec4 vModel3;
+out vec4 vPayload;
+flat out int vVisible;
+
+struct Pyramid
+{
+	mat4 viewProjection;
+	vec2 size;
+	int levels;
+	bool valid;
+};
+
+uniform Pyramid newest;
+uniform Pyramid older;
+uniform sampler2D newestHiZ;
+uniform sampler2D olderHiZ;
+uniform vec3 boundsCenter; //object space box of the mesh
+uniform vec3 boundsExtent;
+uniform bool disoccluded;
+
+//the box is visible if its nearest depth isn't behind the farthest depth of the at most 2x2 Hi-Z texels covering its screen rectangle
+bool visibleIn(Pyramid pyramid, sampler2D hiZ, vec3 center, vec3 extent)
+{
+	if(!pyramid.valid)
+		return true;
+	vec2 minPixel = vec2(1e30f);
+	vec2 maxPixel = vec2(-1e30f);
+	float nearest = 1.0f;
+	for(int i = 0; i < 8; i++)
+	{
+		vec3 corner = center + extent * vec3((i & 1) != 0 ? 1.0f : -1.0f, (i & 2) != 0 ? 1.0f : -1.0f, (i & 4) != 0 ? 1.0f : -1.0f);
+		vec4 clip = pyramid.viewProjection * vec4(corner, 1.0f);
+		//the box reaches in front of the near plane
+		if(clip.z < -clip.w)
+			return true;
+		vec3 ndc = clip.xyz / clip.w;
+		vec2 pixel = (ndc.xy * 0.5f + 0.5f) * pyramid.size;
+		minPixel = min(minPixel, pixel);
+		maxPixel = max(maxPixel, pixel);
+		nearest = min(nearest, ndc.z * 0.5f + 0.5f);
+	}
+	//outside of that frame's view
+	if(any(lessThan(maxPixel, vec2(0.0f))) || any(greaterThanEqual(minPixel, pyramid.size)) || nearest > 1.0f)
+		return false;
+
+	//a pixel of margin for the sub-pixel jitter the depth was rendered with
+	ivec2 minTexel = ivec2(max(minPixel - 1.0f, vec2(0.0f)));
+	ivec2 maxTexel = ivec2(min(maxPixel + 1.0f, pyramid.size - 1.0f));
+	int span = max(maxTexel.x - minTexel.x, maxTexel.y - minTexel.y);
+	int level = 0;
+	while((span >> level) > 0 && level < pyramid.levels - 1)
+		level++;
+	ivec2 last = ((ivec2(pyramid.size) + (1 << level) - 1) >> level) - 1;
+	ivec2 a = min(minTexel >> level, last);
+	ivec2 b = min(maxTexel >> level, last);
+	float farthest = texelFetch(hiZ, a, level).r;
+	farthest = max(farthest, texelFetch(hiZ, ivec2(b.x, a.y), level).r);
+	farthest = max(farthest, texelFetch(hiZ, ivec2(a.x, b.y), level).r);
+	farthest = max(farthest, texelFetch(hiZ, b, level).r);
+	return nearest <= farthest;
+}
+
+void main()
+{
+	mat4 model = mat4(aModel0, aModel1, aModel2, aModel3);
+	vec3 center = vec3(model * vec4(boundsCenter, 1.0f));
+	vec3 extent = abs(vec3(model[0])) * boundsExtent.x + abs(vec3(model[1])) * boundsExtent.y + abs(vec3(model[2])) * boundsExtent.z;
+
+	bool visible = visibleIn(newest, newestHiZ, center, extent);
+	//the first pass tested against the older pyramid, only what it rejected is drawn again
+	if(disoccluded)
+		visible = visible && !visibleIn(older, olderHiZ, center, extent);
+
+	vModel0 = aModel0;
+	vModel1 = aModel1;
+	vModel2 = aModel2;
+	vModel3 = aModel3;
+	vPayload = aPayload;
+	vVisible = visible ? 1 : 0;
+}
\ No newline at end of file
@@ -17,8 +17,8 @@ struct Light
 uniform vec3 camPos;
 uniform mat4 invView;
 uniform mat4 invProjection;
+uniform vec2 viewportScale = vec2(1.0f);
 uniform Light light;
-uniform sampler2D gMaterialMask;
 uniform sampler2D gNormal;
 uniform sampler2D gAlbedo;
 uniform sampler2D gMetalRoughAO;
@@ -92,19 +92,20 @@ vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
 }
 
 vec3 getPosition(float depthValue, vec2 textureCoords, mat4 inverseProjection);
+vec3 decodeNormal(vec2 e);
 
 void main()
 {
 	vec3 result = vec3(0.0f);
 	float depth = texture(gDepth, texCoords).r;
-	vec3 viewPos = getPosition(depth, texCoords, invProjection);
+	vec3 viewPos = getPosition(depth, texCoords / viewportScale, invProjection);
 	vec3 worldPos = vec3(invView * vec4(viewPos, 1.0f));
 	float shadow = 0.0f;
 
 	vec3 fragToLight = worldPos - light.m_Pos;
 	float currentDepth = length(fragToLight) / light.m_FarPlane;
 	vec3 lightDir = normalize(-fragToLight);
-	vec3 normal = normalize(texture(gNormal, texCoords).rgb);
+	vec3 normal = decodeNormal(texture(gNormal, texCoords).rg);
 	float bias = max(0.0001f * dot(normal, lightDir), 0.01f);
 	vec3 viewDir = normalize(camPos - worldPos);
 	{	//shadow calculations	
@@ -189,4 +190,15 @@ vec3 getPosition(float depthValue, vec2 textureCoords, mat4 inverseProjection)
 	vec4 viewSpacePosition = inverseProjection * clipSpacePosition;
 	vec3 res = viewSpacePosition.xyz / viewSpacePosition.w;
 	return res;
-}
\ No newline at end of file
+}
+
+//normals are octahedral encoded in two unorm channels
+vec3 decodeNormal(vec2 e)
+{
+	e = e * 2.0f - 1.0f;
+	vec3 n = vec3(e, 1.0f - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	return normalize(n);
+}
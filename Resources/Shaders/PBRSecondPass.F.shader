@@ -1,24 +1,46 @@
 #version 330 core
+#define MAX_REFLECTION_PROBES 4
 out vec4 fragColor;
 
 in vec2 texCoords;
 
 //material properties
-uniform sampler2D gMaterialMask;
 uniform sampler2D gNormal;
 uniform sampler2D gAlbedo;
-uniform sampler2D gMetalRoughAO;
+uniform sampler2D gMetalRoughAO; //alpha is the material ID
 uniform sampler2D gDepth;
+uniform vec3 materialTable[4];
 
 //IBL(Image based lighting)
-uniform samplerCube irradianceMap;
 uniform samplerCube prefilterMap;
 uniform sampler2D brdfLUT;
 uniform sampler2D LoMap;
 
+//local reflection probes, blended over the global prefilter map inside their boxes
+uniform samplerCube probeMaps[MAX_REFLECTION_PROBES];
+uniform vec3 probePositions[MAX_REFLECTION_PROBES];
+uniform vec3 probeBoxMin[MAX_REFLECTION_PROBES];
+uniform vec3 probeBoxMax[MAX_REFLECTION_PROBES];
+uniform int nrOfProbes = 0;
+
+//irradiance volume: L1 SH probes with one texture per color channel (xyzw are the 4 coefficients), convolved like irradianceSH
+uniform sampler3D irradianceVolumeR;
+uniform sampler3D irradianceVolumeG;
+uniform sampler3D irradianceVolumeB;
+uniform vec3 volumeMin;
+uniform vec3 volumeMax;
+uniform vec3 volumeResolution;
+uniform bool irradianceVolumeEnabled = false;
+
+//half resolution screen space reflections, the hit weight in alpha says how much they replace the probes/prefilter map
+uniform sampler2D ssrTexture;
+uniform bool ssrEnabled = false;
+
 uniform vec3 camPos;
 uniform mat4 invProjection;
 uniform mat4 invView;
+uniform vec2 viewportScale = vec2(1.0f);
+uniform vec3 irradianceSH[9]; //diffuse irradiance as spherical harmonics, already convolved with the cosine lobe
 
 const float Pi = 3.14159265359f;
 
@@ -67,12 +89,124 @@ vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
 	return F0 + (max(vec3(1.0f - roughness), F0) - F0) * pow(clamp(1.0f - cosTheta, 0.0f, 1.0f), 5.0f);
 }
 
+//evaluates the order 2 spherical harmonics irradiance in the direction of the normal
+vec3 evaluateSH(vec3 n)
+{
+	vec3 result = irradianceSH[0] * 0.282095f;
+	result += irradianceSH[1] * 0.488603f * n.y;
+	result += irradianceSH[2] * 0.488603f * n.z;
+	result += irradianceSH[3] * 0.488603f * n.x;
+	result += irradianceSH[4] * 1.092548f * n.x * n.y;
+	result += irradianceSH[5] * 1.092548f * n.y * n.z;
+	result += irradianceSH[6] * 0.315392f * (3.0f * n.z * n.z - 1.0f);
+	result += irradianceSH[7] * 1.092548f * n.x * n.z;
+	result += irradianceSH[8] * 0.546274f * (n.x * n.x - n.y * n.y);
+	return max(result, vec3(0.0f));
+}
+
+//irradiance from the probe volume, it fades to the environment SH over half a probe cell outside of the volume
+vec3 sampleIrradiance(vec3 worldPos, vec3 n)
+{
+	vec3 environment = evaluateSH(n);
+	if(!irradianceVolumeEnabled)
+		return environment;
+
+	//pushed along the normal so surfaces next to a probe don't pick up the probe behind them
+	vec3 cells = volumeResolution - 1.0f;
+	vec3 t = (worldPos + n * 0.25f * (volumeMax - volumeMin) / cells - volumeMin) / (volumeMax - volumeMin);
+	vec3 outside = max(-t, t - 1.0f) * cells;
+	float weight = clamp(1.0f - 2.0f * max(outside.x, max(outside.y, outside.z)), 0.0f, 1.0f);
+	if(weight <= 0.0f)
+		return environment;
+
+	vec3 uvw = (clamp(t, 0.0f, 1.0f) * cells + 0.5f) / volumeResolution;
+	vec4 basis = vec4(0.282095f, 0.488603f * n.y, 0.488603f * n.z, 0.488603f * n.x);
+	vec3 volume = vec3(dot(texture(irradianceVolumeR, uvw), basis), dot(texture(irradianceVolumeG, uvw), basis), dot(texture(irradianceVolumeB, uvw), basis));
+	return mix(environment, max(volume, vec3(0.0f)), weight);
+}
+
+//sampler arrays can only be indexed with constants in GLSL 3.30
+vec3 sampleProbe(int i, vec3 dir, float lod)
+{
+	if(i == 0) return textureLod(probeMaps[0], dir, lod).rgb;
+	if(i == 1) return textureLod(probeMaps[1], dir, lod).rgb;
+	if(i == 2) return textureLod(probeMaps[2], dir, lod).rgb;
+	return textureLod(probeMaps[3], dir, lod).rgb;
+}
+
+//1 inside the probe's box, fading to 0 over the outer 10% of it
+float probeWeight(int i, vec3 worldPos)
+{
+	vec3 center = (probeBoxMin[i] + probeBoxMax[i]) * 0.5f;
+	vec3 extent = (probeBoxMax[i] - probeBoxMin[i]) * 0.5f;
+	vec3 d = abs(worldPos - center) / extent;
+	return clamp((1.0f - max(d.x, max(d.y, d.z))) * 10.0f, 0.0f, 1.0f);
+}
+
+//intersects the reflection ray with the probe's box and returns the direction from the probe to the hit point
+vec3 parallaxCorrect(int i, vec3 worldPos, vec3 R)
+{
+	vec3 firstPlane = (probeBoxMax[i] - worldPos) / R;
+	vec3 secondPlane = (probeBoxMin[i] - worldPos) / R;
+	vec3 furthestPlane = max(firstPlane, secondPlane);
+	float hitDistance = min(furthestPlane.x, min(furthestPlane.y, furthestPlane.z));
+	return worldPos + R * hitDistance - probePositions[i];
+}
+
+//prefiltered radiance of the 2 nearest probes containing worldPos, whatever they don't cover comes from the global prefilter map
+vec3 sampleReflection(vec3 worldPos, vec3 R, float lod)
+{
+	vec3 globalColor = textureLod(prefilterMap, R, lod).rgb;
+
+	int nearest[2] = int[2](-1, -1);
+	float nearestDistance[2] = float[2](1e30f, 1e30f);
+	for(int i = 0; i < MAX_REFLECTION_PROBES; i++)
+	{
+		if(i >= nrOfProbes)
+			break;
+		if(probeWeight(i, worldPos) <= 0.0f)
+			continue;
+		vec3 offset = worldPos - probePositions[i];
+		float distanceSquared = dot(offset, offset);
+		if(distanceSquared < nearestDistance[0])
+		{
+			nearest[1] = nearest[0];
+			nearestDistance[1] = nearestDistance[0];
+			nearest[0] = i;
+			nearestDistance[0] = distanceSquared;
+		}
+		else if(distanceSquared < nearestDistance[1])
+		{
+			nearest[1] = i;
+			nearestDistance[1] = distanceSquared;
+		}
+	}
+	if(nearest[0] < 0)
+		return globalColor;
+
+	float w0 = probeWeight(nearest[0], worldPos);
+	vec3 localColor = sampleProbe(nearest[0], parallaxCorrect(nearest[0], worldPos, R), lod) * w0;
+	float totalWeight = w0;
+	float coverage = w0;
+	if(nearest[1] >= 0)
+	{
+		//the closer probe gets more weight so the transition between overlapping boxes is smooth
+		float w1 = probeWeight(nearest[1], worldPos) * sqrt(nearestDistance[0] / max(nearestDistance[1], 0.0001f));
+		localColor += sampleProbe(nearest[1], parallaxCorrect(nearest[1], worldPos, R), lod) * w1;
+		totalWeight += w1;
+		coverage = max(coverage, probeWeight(nearest[1], worldPos));
+	}
+	return mix(globalColor, localColor / totalWeight, coverage);
+}
+
 vec3 getPosition(float depthValue, vec2 textureCoords, mat4 inverseProjection);
+vec3 decodeNormal(vec2 e);
 
 void main()
 {
 	//retrieves material properties
-	vec3 material = texture(gMaterialMask, texCoords).rgb;
+	vec4 metalRoughAO = texture(gMetalRoughAO, texCoords);
+	vec3 material = materialTable[int(metalRoughAO.a * 255.0f + 0.5f)];
 	if(material.r == 0.0f && material.g == 0.0f && material.b == 0.0f)
 	{
 		fragColor = vec4(1.0f, 0.0f, 1.0f, 1.0f);
@@ -81,14 +215,14 @@ void main()
 	}
 	float depth = texture(gDepth, texCoords).r;
 
-	vec3 viewPos = getPosition(depth, texCoords, invProjection);
+	vec3 viewPos = getPosition(depth, texCoords / viewportScale, invProjection);
 	vec3 worldPos = vec3(invView * vec4(viewPos, 1.0f));
 	vec3 albedo = pow(texture(gAlbedo, texCoords).rgb, vec3(2.2f));
-	float metallic = texture(gMetalRoughAO, texCoords).r;
-	float roughness = texture(gMetalRoughAO, texCoords).g;
-	float ao = texture(gMetalRoughAO, texCoords).b;
+	float metallic = metalRoughAO.r;
+	float roughness = metalRoughAO.g;
+	float ao = metalRoughAO.b;
 	
-	vec3 N = texture(gNormal, texCoords).rgb;
+	vec3 N = decodeNormal(texture(gNormal, texCoords).rg);
 	vec3 V = normalize(camPos - worldPos);
 	vec3 R = reflect(-V, N);
 
@@ -105,16 +239,20 @@ void main()
 	vec3 kD = vec3(1.0f) - kS;
 	kD *= 1.0f - metallic;
 
-	vec3 irradiance = texture(irradianceMap, N).rgb;
+	vec3 irradiance = sampleIrradiance(worldPos, N);
 	vec3 diffuse = irradiance * albedo;
 
 	const float MAX_REFLECTION_LOD = 4.0f;
-	vec3 prefilteredColor = textureLod(prefilterMap, R, roughness * MAX_REFLECTION_LOD).rgb;
+	vec3 prefilteredColor = sampleReflection(worldPos, R, roughness * MAX_REFLECTION_LOD);
+	if(ssrEnabled)
+	{
+		vec4 ssr = texture(ssrTexture, texCoords);
+		prefilteredColor = mix(prefilteredColor, ssr.rgb, ssr.a);
+	}
 	vec2 brdf = texture(brdfLUT, vec2(max(dot(N, V), 0.0f), roughness)).rg;
 	vec3 specular = prefilteredColor * (F * brdf.x + brdf.y);
 
 	vec3 ambient = (kD * diffuse + specular) * ao;
-	float shadow = texture(gNormal, texCoords).a;
 	vec3 color = ambient + Lo;
 
 	//HDR + Gamma correction
@@ -132,4 +270,15 @@ vec3 getPosition(float depthValue, vec2 textureCoords, mat4 inverseProjection)
 	vec4 viewSpacePosition = inverseProjection * clipSpacePosition;
 	vec3 res = viewSpacePosition.xyz / viewSpacePosition.w;
 	return res;
-}
\ No newline at end of file
+}
+
+//octahedral decode of the G-buffer normal
+vec3 decodeNormal(vec2 e)
+{
+	e = e * 2.0f - 1.0f;
+	vec3 n = vec3(e, 1.0f - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	return normalize(n);
+}
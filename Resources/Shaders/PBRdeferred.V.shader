@@ -4,8 +4,10 @@ layout(location = 1) in vec2 aTexCoords;
 
 out vec2 texCoords;
 
+uniform vec2 viewportScale = vec2(1.0f); //part of the G-buffer that is rendered to, it is smaller than 1 with dynamic resolution
+
 void main()
 {
-	texCoords = aTexCoords;
+	texCoords = aTexCoords * viewportScale;
 	gl_Position = vec4(aPos.xy, 0.0f, 1.0f);
 }
\ No newline at end of file
@@ -0,0 +1,46 @@
+#version 330 core
+out vec4 fragColor;
+
+in vec2 texCoords;
+in vec3 worldPos;
+in vec3 normal;
+
+uniform sampler2D albedoMap;
+
+uniform vec3 lightPositions[4];
+uniform vec3 lightColors[4];
+uniform vec3 irradianceSH[9];
+
+const float Pi = 3.14159265359f;
+
+vec3 evaluateSH(vec3 n)
+{
+	vec3 result = irradianceSH[0] * 0.282095f;
+	result += irradianceSH[1] * 0.488603f * n.y;
+	result += irradianceSH[2] * 0.488603f * n.z;
+	result += irradianceSH[3] * 0.488603f * n.x;
+	result += irradianceSH[4] * 1.092548f * n.x * n.y;
+	result += irradianceSH[5] * 1.092548f * n.y * n.z;
+	result += irradianceSH[6] * 0.315392f * (3.0f * n.z * n.z - 1.0f);
+	result += irradianceSH[7] * 1.092548f * n.x * n.z;
+	result += irradianceSH[8] * 0.546274f * (n.x * n.x - n.y * n.y);
+	return max(result, vec3(0.0f));
+}
+
+void main()
+{
+	//only the diffuse lighting is captured, the probe is blurred by the prefilter pass so specular highlights and shadows would barely show
+	vec3 albedo = pow(texture(albedoMap, texCoords).rgb, vec3(2.2f));
+	vec3 N = normalize(normal);
+
+	vec3 Lo = vec3(0.0f);
+	for(int i = 0; i < 4; i++)
+	{
+		vec3 L = lightPositions[i] - worldPos;
+		float distanceSquared = dot(L, L);
+		float NdotL = max(dot(N, normalize(L)), 0.0f);
+		Lo += albedo / Pi * lightColors[i] * NdotL / distanceSquared;
+	}
+
+	fragColor = vec4(Lo + evaluateSH(N) * albedo, 1.0f);
+}
@@ -0,0 +1,20 @@
+#version 330 core
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTexCoords;
+
+out vec2 texCoords;
+out vec3 worldPos;
+out vec3 normal;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 model;
+
+void main()
+{
+	texCoords = aTexCoords;
+	worldPos = vec3(model * vec4(aPos, 1.0f));
+	normal = transpose(inverse(mat3(model))) * aNormal;
+	gl_Position = projection * view * vec4(worldPos, 1.0f);
+}
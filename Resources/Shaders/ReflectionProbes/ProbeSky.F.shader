@@ -0,0 +1,12 @@
+#version 330 core
+out vec4 fragColor;
+in vec3 worldPos;
+
+uniform samplerCube environmentMap;
+
+void main()
+{
+	//linear HDR color, unlike background.F.shader the capture isn't tone mapped
+	fragColor = vec4(textureLod(environmentMap, worldPos, 0.0f).rgb, 1.0f);
+	gl_FragDepth = 1.0f;
+}
@@ -9,29 +9,32 @@ uniform float radius = 0.5;
 uniform float bias = 0.025;
 uniform float time = 1.0f;
 uniform vec2 noiseScale;
+uniform vec2 viewportScale = vec2(1.0f);
 
 uniform mat4 projection;
 uniform mat4 invProjection;
 
-uniform sampler2D gMaterialMask;
-uniform sampler2D gNormalShadow;
-uniform sampler2D gMetalRoughAO;
+uniform sampler2D gNormal;
+uniform sampler2D gMetalRoughAO; //alpha is the material ID
 uniform sampler2D gDepth;
 uniform sampler2D noiseTex;
+uniform vec3 materialTable[4];
 
 const float Pi = 3.14159265359f;
 
 vec3 getPosition(sampler2D depthMap, vec2 textureCoords, mat4 inverseProjection);
+vec3 decodeNormal(vec2 e);
 
 void main()
 {
-	vec3 material = texture(gMaterialMask, texCoords).rgb;
-	if(material == vec3(0.0f)) //Discard fragment if the material mask buffer is empty at this position
+	vec4 metalRoughAO = texture(gMetalRoughAO, texCoords);
+	vec3 material = materialTable[int(metalRoughAO.a * 255.0f + 0.5f)];
+	if(material == vec3(0.0f)) //Discard fragment if no material was written at this position
 		discard;
 
 	vec3 result = vec3(0.0f);
-	vec3 viewPos = getPosition(gDepth, texCoords, invProjection);
-	vec3 normal = normalize(texture(gNormalShadow, texCoords).rgb);
+	vec3 viewPos = getPosition(gDepth, texCoords / viewportScale, invProjection);
+	vec3 normal = decodeNormal(texture(gNormal, texCoords).rg);
 	vec3 randomVec = normalize(texture(noiseTex, texCoords * noiseScale * time).rgb);
 
 	vec3 tangent = normalize(randomVec - normal * dot(randomVec, normal));
@@ -56,18 +59,30 @@ void main()
 		occlusion += (sampleDepth >= samplePos.z + bias ? 1.0 : 0.0) * rangeCheck;
 	}
 	occlusion = 1.0f - (occlusion / kernelSize);
-	occlusion = texture(gMetalRoughAO, texCoords).b * occlusion;
-	result = vec3(texture(gMetalRoughAO, texCoords).rg, occlusion);
-	fragColor = vec4(result, 1.0f);
+	occlusion = metalRoughAO.b * occlusion;
+	result = vec3(metalRoughAO.rg, occlusion);
+	fragColor = vec4(result, metalRoughAO.a); //the material ID is carried through the blur back into the G-buffer
 }
 
+//textureCoords are screen coordinates, only the viewportScale part of the depth map is rendered to
 vec3 getPosition(sampler2D depthMap, vec2 textureCoords, mat4 inverseProjection)
 {
-	float depthValue = texture(depthMap, textureCoords).r;
+	float depthValue = texture(depthMap, clamp(textureCoords, 0.0f, 1.0f) * viewportScale).r;
 	vec2 xy = textureCoords * 2.0f - vec2(1.0f);
 	float z = depthValue * 2.0f - 1.0f;
 	vec4 clipSpacePosition = vec4(xy, z, 1.0f);
 	vec4 viewSpacePosition = inverseProjection * clipSpacePosition;
 	vec3 res = viewSpacePosition.xyz / viewSpacePosition.w;
 	return res;
-}
\ No newline at end of file
+}
+
+//unfolds the octahedral normal stored in the G-buffer
+vec3 decodeNormal(vec2 e)
+{
+	e = e * 2.0f - 1.0f;
+	vec3 n = vec3(e, 1.0f - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	return normalize(n);
+}
@@ -4,8 +4,10 @@ layout(location = 1) in vec2 aTexCoords;
 
 out vec2 texCoords;
 
+uniform vec2 viewportScale = vec2(1.0f);
+
 void main()
 {
-	texCoords = aTexCoords;
+	texCoords = aTexCoords * viewportScale;
 	gl_Position = vec4(aPos.xy, 1.0f, 1.0f);
 }
\ No newline at end of file
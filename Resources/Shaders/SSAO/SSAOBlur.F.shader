@@ -1,9 +1,5 @@
 #version 330
-layout(location = 0) out vec3 gMaterialMask;
-layout(location = 1) out vec4 gPosition;
-layout(location = 2) out vec4 gNormalShadow;
-layout(location = 3) out vec4 gAlbedo;
-layout(location = 4) out vec3 gMetalRoughAO;
+layout(location = 2) out vec4 gMetalRoughAO;
 
 in vec2 texCoords;
 
@@ -29,7 +25,6 @@ void main()
 
 	occ = occ / 5.0f;
 
-	gMetalRoughAO.r = texture(occlusionBuffer, texCoords).r;
-	gMetalRoughAO.g = texture(occlusionBuffer, texCoords).g;
-	gMetalRoughAO.b = occ;
+	vec4 center = texture(occlusionBuffer, texCoords);
+	gMetalRoughAO = vec4(center.rg, occ, center.a);
 }
\ No newline at end of file
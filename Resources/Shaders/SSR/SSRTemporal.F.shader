@@ -0,0 +1,47 @@
+#version 330 core
+out vec4 fragColor;
+
+uniform sampler2D currentReflection;
+uniform sampler2D historyReflection;
+uniform sampler2D velocityBuffer;
+
+uniform vec2 halfSize; //traced part of the half resolution textures
+uniform vec2 renderSize;
+uniform vec2 prevViewportScale; //part of the history covered by the previous frame
+uniform float feedback;
+uniform bool resetHistory;
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	vec4 current = texelFetch(currentReflection, pixel, 0);
+	if(resetHistory)
+	{
+		fragColor = current;
+		return;
+	}
+
+	//the history is clamped to the neighbourhood of the current trace so stale reflections don't smear
+	vec4 minimum = current;
+	vec4 maximum = current;
+	for(int y = -1; y <= 1; y++)
+	{
+		for(int x = -1; x <= 1; x++)
+		{
+			vec4 neighbour = texelFetch(currentReflection, clamp(pixel + ivec2(x, y), ivec2(0), ivec2(halfSize) - 1), 0);
+			minimum = min(minimum, neighbour);
+			maximum = max(maximum, neighbour);
+		}
+	}
+
+	//reprojected with the motion of the reflecting surface
+	vec2 velocity = texelFetch(velocityBuffer, min(pixel * 2, ivec2(renderSize) - 1), 0).rg;
+	vec2 prevUV = (vec2(pixel) + 0.5f) / halfSize - velocity;
+	if(any(lessThan(prevUV, vec2(0.0f))) || any(greaterThan(prevUV, vec2(1.0f))))
+	{
+		fragColor = current;
+		return;
+	}
+	vec4 history = clamp(texture(historyReflection, prevUV * prevViewportScale), minimum, maximum);
+	fragColor = mix(current, history, feedback);
+}
\ No newline at end of file
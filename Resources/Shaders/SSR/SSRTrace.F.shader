@@ -0,0 +1,229 @@
+#version 330 core
+#define MAX_RAYS 4
+out vec4 fragColor; //average reflected color of the rays that hit, hit weight in alpha
+
+uniform sampler2D hiZ; //min depth pyramid, level 0 is the depth buffer
+uniform sampler2D gNormal;
+uniform sampler2D gMetalRoughAO; //alpha is the material ID
+uniform sampler2D sceneColor; //lit scene of the previous frame
+uniform sampler2D velocityBuffer;
+
+uniform mat4 projection;
+uniform mat4 invProjection;
+uniform mat4 view;
+uniform vec2 renderSize;
+uniform vec2 prevViewportScale; //part of sceneColor covered by the previous frame
+uniform float nearPlane;
+uniform float maxRoughness;
+uniform float thickness;
+uniform int maxRays;
+uniform int maxIterations;
+uniform int maxLevel;
+uniform int frameIndex;
+uniform bool hasSceneColor;
+
+const float Pi = 3.14159265359f;
+
+vec3 decodeNormal(vec2 e);
+vec3 viewPosition(vec2 screenPos, float depth);
+vec3 toScreen(vec3 viewPos);
+float linearDepth(float depth);
+vec2 hammersley(uint i, uint N);
+vec3 importanceSampleGGX(vec2 Xi, vec3 N, float roughness);
+bool traceHiZ(vec3 viewOrigin, vec3 viewDirection, out vec2 hitPos);
+
+void main()
+{
+	//each half resolution pixel shades one of the 4 full resolution pixels it covers, a different one every frame
+	ivec2 pixel = min(ivec2(gl_FragCoord.xy) * 2 + ivec2(frameIndex & 1, (frameIndex >> 1) & 1), ivec2(renderSize) - 1);
+	float depth = texelFetch(hiZ, pixel, 0).r;
+	vec4 metalRoughAO = texelFetch(gMetalRoughAO, pixel, 0);
+	float roughness = metalRoughAO.g;
+	if(!hasSceneColor || depth >= 1.0f || metalRoughAO.a == 0.0f || roughness > maxRoughness)
+	{
+		fragColor = vec4(0.0f);
+		return;
+	}
+
+	vec3 viewPos = viewPosition(vec2(pixel) + 0.5f, depth);
+	vec3 N = normalize(mat3(view) * decodeNormal(texelFetch(gNormal, pixel, 0).rg));
+	vec3 V = normalize(-viewPos);
+	//pushed off the surface so rays don't hit the pixel they start from
+	vec3 origin = viewPos + N * 0.01f * -viewPos.z;
+
+	//mirror-like surfaces trace one ray, rougher ones spread more rays over their GGX lobe
+	int nrOfRays = roughness < 0.05f ? 1 : clamp(int(ceil(roughness / maxRoughness * float(maxRays))), 1, maxRays);
+	float noise = fract(52.9829189f * fract(dot(gl_FragCoord.xy + float(frameIndex) * 5.588238f, vec2(0.06711056f, 0.00583715f))));
+
+	vec3 color = vec3(0.0f);
+	float weight = 0.0f;
+	for(int i = 0; i < MAX_RAYS; i++)
+	{
+		if(i >= nrOfRays)
+			break;
+		vec3 R = reflect(-V, N);
+		if(roughness >= 0.05f)
+		{
+			vec2 Xi = fract(hammersley(uint(i), uint(nrOfRays)) + vec2(noise, fract(noise * 7.31f)));
+			vec3 L = reflect(-V, importanceSampleGGX(Xi, N, roughness));
+			if(dot(L, N) > 0.0f)
+				R = L;
+		}
+
+		vec2 hitPos;
+		if(!traceHiZ(origin, R, hitPos))
+			continue;
+
+		//the hit point was at uv - velocity in the previous frame
+		vec2 uv = hitPos / renderSize;
+		vec2 prevUV = uv - texelFetch(velocityBuffer, ivec2(hitPos), 0).rg;
+		if(any(lessThan(prevUV, vec2(0.0f))) || any(greaterThan(prevUV, vec2(1.0f))))
+			continue;
+
+		//hits close to the screen edges fade out, a ray there could as well have left the screen
+		vec2 edge = min(uv, 1.0f - uv);
+		float fade = clamp(min(edge.x, edge.y) * 10.0f, 0.0f, 1.0f);
+		//PBRSecondPass tone maps and gamma corrects the scene, which is undone to get radiance again
+		vec3 hitColor = min(pow(texture(sceneColor, prevUV * prevViewportScale).rgb, vec3(2.2f)), vec3(0.999f));
+		color += hitColor / (1.0f - hitColor) * fade;
+		weight += fade;
+	}
+	fragColor = weight > 0.0f ? vec4(color / weight, weight / float(nrOfRays)) : vec4(0.0f);
+}
+
+//walks the ray through the min-depth pyramid in screen space (pixels and depth buffer values, which are linear along the ray).
+//while the ray is in front of the nearest depth of its cell the whole cell is skipped and the next one is a level coarser,
+//when it reaches the depth of the cell it goes a level finer, and at level 0 it is a hit if it isn't too far behind the surface
+bool traceHiZ(vec3 viewOrigin, vec3 viewDirection, out vec2 hitPos)
+{
+	hitPos = vec2(0.0f);
+
+	//the end point is kept in front of the near plane so it can be projected
+	float rayLength = 1000.0f;
+	if(viewDirection.z > 0.0f)
+		rayLength = min(rayLength, (-nearPlane - viewOrigin.z) / viewDirection.z * 0.99f);
+	vec3 start = toScreen(viewOrigin);
+	vec3 d = toScreen(viewOrigin + viewDirection * rayLength) - start;
+	float screenLength = max(abs(d.x), abs(d.y));
+	if(screenLength < 1.0f)
+		return false;
+
+	//t goes from 0 at the origin to 1 at the end point, the ray is clipped where it leaves the screen
+	vec2 safeD = vec2(abs(d.x) < 1e-6f ? 1e-6f : d.x, abs(d.y) < 1e-6f ? 1e-6f : d.y);
+	vec2 tScreen = max((vec2(0.0f) - start.xy) / safeD, (renderSize - start.xy) / safeD);
+	float tMax = min(1.0f, min(tScreen.x, tScreen.y));
+	float crossing = 0.001f / screenLength;
+
+	float t = 1.0f / screenLength;
+	int level = 0;
+	for(int i = 0; i < maxIterations; i++)
+	{
+		if(t > tMax)
+			return false;
+		vec3 p = start + d * t;
+		float cellSize = exp2(float(level));
+		vec2 cell = floor(p.xy / cellSize);
+		float minZ = texelFetch(hiZ, ivec2(cell), level).r;
+
+		vec2 boundary = (cell + step(0.0f, d.xy)) * cellSize;
+		vec2 tBoundary = (boundary - start.xy) / safeD;
+		float tExit = min(tBoundary.x, tBoundary.y) + crossing;
+
+		if(p.z < minZ)
+		{
+			float tPlane = d.z > 0.0f ? (minZ - start.z) / d.z : 1e30f;
+			if(tPlane < tExit)
+			{
+				t = max(t, tPlane);
+				level = max(level - 1, 0);
+			}
+			else
+			{
+				t = tExit;
+				level = min(level + 1, maxLevel);
+			}
+		}
+		else if(level > 0)
+			level--;
+		else
+		{
+			if(linearDepth(p.z) - linearDepth(minZ) < thickness)
+			{
+				hitPos = p.xy;
+				return true;
+			}
+			//passed behind a surface, continues past it
+			t = tExit;
+		}
+	}
+	return false;
+}
+
+vec3 viewPosition(vec2 screenPos, float depth)
+{
+	vec4 viewPos = invProjection * vec4(screenPos / renderSize * 2.0f - 1.0f, depth * 2.0f - 1.0f, 1.0f);
+	return viewPos.xyz / viewPos.w;
+}
+
+vec3 toScreen(vec3 viewPos)
+{
+	vec4 clipPos = projection * vec4(viewPos, 1.0f);
+	vec3 ndc = clipPos.xyz / clipPos.w;
+	return vec3((ndc.xy * 0.5f + 0.5f) * renderSize, ndc.z * 0.5f + 0.5f);
+}
+
+float linearDepth(float depth)
+{
+	vec4 viewPos = invProjection * vec4(0.0f, 0.0f, depth * 2.0f - 1.0f, 1.0f);
+	return -viewPos.z / viewPos.w;
+}
+
+// efficient VanDerCorpus calculation: http://holger.dammertz.org/stuff/notes_HammersleyOnHemisphere.html
+float radicalInverse_VdC(uint bits)
+{
+	bits = (bits << 16u) | (bits >> 16u);
+	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+	bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+	bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+	bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+
+	return float(bits) * 2.3283064365386963e-10; // / 0x100000000
+}
+
+vec2 hammersley(uint i, uint N)
+{
+	return vec2(float(i) / float(N), radicalInverse_VdC(i));
+}
+
+vec3 importanceSampleGGX(vec2 Xi, vec3 N, float roughness)
+{
+	float a = roughness * roughness;
+
+	float phi = 2.0f * Pi * Xi.x;
+	float cosTheta = sqrt((1.0f - Xi.y) / (1.0f + (a * a - 1.0f) * Xi.y));
+	float sinTheta = sqrt(1.0f - cosTheta * cosTheta);
+
+	//halfway vector
+	vec3 H;
+	H.x = cos(phi) * sinTheta;
+	H.y = sin(phi) * sinTheta;
+	H.z = cosTheta;
+
+	//from tangent-space to view-space
+	vec3 up = abs(N.z) < 0.999f ? vec3(0.0f, 0.0f, 1.0f) : vec3(1.0f, 0.0f, 0.0f);
+	vec3 tangent = normalize(cross(up, N));
+	vec3 bitangent = cross(N, tangent);
+
+	return normalize(tangent * H.x + bitangent * H.y + N * H.z);
+}
+
+//octahedral decode of the G-buffer normal
+vec3 decodeNormal(vec2 e)
+{
+	e = e * 2.0f - 1.0f;
+	vec3 n = vec3(e, 1.0f - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	return normalize(n);
+}
\ No newline at end of file
@@ -3,6 +3,7 @@ layout(triangles) in;
 layout(triangle_strip, max_vertices = 18) out;
 
 uniform mat4 shadowMatrices[6];
+uniform int culledFaces; //a bit per face the object is outside of
 
 out vec4 fragPos;
 
@@ -10,6 +11,8 @@ void main()
 {
 	for(int face = 0; face < 6; face++)
 	{
+		if((culledFaces & (1 << face)) != 0)
+			continue;
 		gl_Layer = face; //renders to each face on the cubemap
 		for(int i = 0; i < 3; i++)
 		{
@@ -0,0 +1,117 @@
+#version 330 core
+out vec4 fragColor;
+
+in vec2 texCoords;
+
+uniform sampler2D currentColor;
+uniform sampler2D historyColor;
+uniform sampler2D velocityBuffer;
+uniform sampler2D gDepth;
+
+uniform mat4 invViewProjection;
+uniform mat4 prevViewProjection;
+uniform vec2 resolution;
+uniform vec2 viewportScale = vec2(1.0f);
+uniform vec2 prevViewportScale = vec2(1.0f); //the history was rendered with the previous frame's dynamic resolution scale
+uniform float feedback = 0.9f;
+uniform bool resetHistory;
+
+//clamping is done in YCoCg space, it gives a tighter box around the neighbourhood than RGB
+vec3 RGBToYCoCg(vec3 c)
+{
+	return vec3( 0.25f * c.r + 0.5f * c.g + 0.25f * c.b,
+				 0.5f  * c.r              - 0.5f  * c.b,
+				-0.25f * c.r + 0.5f * c.g - 0.25f * c.b);
+}
+
+vec3 YCoCgToRGB(vec3 c)
+{
+	return vec3(c.x + c.y - c.z,
+				c.x       + c.z,
+				c.x - c.y - c.z);
+}
+
+//clips the history color towards the center of the neighbourhood box instead of clamping each channel separately
+vec3 clipToAABB(vec3 color, vec3 boxMin, vec3 boxMax)
+{
+	vec3 center = 0.5f * (boxMax + boxMin);
+	vec3 extents = 0.5f * (boxMax - boxMin) + 0.0001f;
+	vec3 offset = color - center;
+	vec3 unit = abs(offset / extents);
+	float maxUnit = max(unit.x, max(unit.y, unit.z));
+	if(maxUnit > 1.0f)
+		return center + offset / maxUnit;
+	return color;
+}
+
+void main()
+{
+	vec2 texelSize = 1.0f / resolution;
+	vec2 screenCoords = texCoords / viewportScale;
+	vec3 current = texture(currentColor, texCoords).rgb;
+
+	if(resetHistory)
+	{
+		fragColor = vec4(current, 1.0f);
+		return;
+	}
+
+	//neighbourhood statistics and the closest depth (velocity dilation keeps edges from trailing)
+	vec3 m1 = vec3(0.0f);
+	vec3 m2 = vec3(0.0f);
+	vec3 boxMin = vec3(1e20f);
+	vec3 boxMax = vec3(-1e20f);
+	float closestDepth = 1.0f;
+	vec2 closestUV = texCoords;
+	for(int x = -1; x <= 1; x++)
+	{
+		for(int y = -1; y <= 1; y++)
+		{
+			vec2 uv = min(texCoords + vec2(x, y) * texelSize, viewportScale - 0.5f * texelSize);
+			vec3 c = RGBToYCoCg(texture(currentColor, uv).rgb);
+			m1 += c;
+			m2 += c * c;
+			boxMin = min(boxMin, c);
+			boxMax = max(boxMax, c);
+
+			float d = texture(gDepth, uv).r;
+			if(d < closestDepth)
+			{
+				closestDepth = d;
+				closestUV = uv;
+			}
+		}
+	}
+
+	vec2 velocity;
+	if(closestDepth >= 1.0f)
+	{
+		//nothing was written to the G-buffer (skybox), reproject using only the camera's motion
+		vec4 worldPos = invViewProjection * vec4(screenCoords * 2.0f - 1.0f, 1.0f, 1.0f);
+		vec4 prevClip = prevViewProjection * vec4(worldPos.xyz / worldPos.w, 1.0f);
+		velocity = screenCoords - (prevClip.xy / prevClip.w * 0.5f + 0.5f);
+	}
+	else
+		velocity = texture(velocityBuffer, closestUV).rg;
+
+	vec2 historyScreenCoords = screenCoords - velocity;
+	vec2 historyUV = min(historyScreenCoords * prevViewportScale, prevViewportScale - 0.5f * texelSize);
+
+	//variance clipping, the box is shrunk to mean +- 1.25 standard deviations and intersected with the min/max box
+	vec3 mean = m1 / 9.0f;
+	vec3 sigma = sqrt(abs(m2 / 9.0f - mean * mean));
+	boxMin = max(boxMin, mean - 1.25f * sigma);
+	boxMax = min(boxMax, mean + 1.25f * sigma);
+
+	vec3 history = RGBToYCoCg(texture(historyColor, historyUV).rgb);
+	history = clipToAABB(history, boxMin, boxMax);
+
+	//history outside of the screen is invalid, and fast motion blurs so the history is trusted less
+	float blend = feedback;
+	if(historyScreenCoords.x < 0.0f || historyScreenCoords.y < 0.0f || historyScreenCoords.x > 1.0f || historyScreenCoords.y > 1.0f)
+		blend = 0.0f;
+	blend *= 1.0f / (1.0f + length(velocity * resolution * viewportScale) * 0.05f);
+
+	vec3 result = mix(RGBToYCoCg(current), history, blend);
+	fragColor = vec4(max(YCoCgToRGB(result), vec3(0.0f)), 1.0f);
+}
@@ -0,0 +1,66 @@
+#version 330 core
+layout(location = 0) out vec4 accumulation; //weighted premultiplied color, alpha is multiplied into the revealage
+layout(location = 1) out vec4 weight; //only red is stored
+
+in vec2 texCoords;
+in vec3 worldPos;
+in vec3 normal;
+in vec4 tint;
+in float viewDepth;
+
+uniform sampler2D albedoMap;
+
+uniform vec3 camPos;
+uniform int nrOfLights;
+uniform vec3 lightPositions[4];
+uniform vec3 lightColors[4];
+uniform vec3 irradianceSH[9];
+
+const float Pi = 3.14159265359f;
+
+vec3 evaluateSH(vec3 n)
+{
+	vec3 result = irradianceSH[0] * 0.282095f;
+	result += irradianceSH[1] * 0.488603f * n.y;
+	result += irradianceSH[2] * 0.488603f * n.z;
+	result += irradianceSH[3] * 0.488603f * n.x;
+	result += irradianceSH[4] * 1.092548f * n.x * n.y;
+	result += irradianceSH[5] * 1.092548f * n.y * n.z;
+	result += irradianceSH[6] * 0.315392f * (3.0f * n.z * n.z - 1.0f);
+	result += irradianceSH[7] * 1.092548f * n.x * n.z;
+	result += irradianceSH[8] * 0.546274f * (n.x * n.x - n.y * n.y);
+	return max(result, vec3(0.0f));
+}
+
+void main()
+{
+	vec4 albedo = texture(albedoMap, texCoords) * tint;
+	albedo.rgb = pow(albedo.rgb, vec3(2.2f));
+	vec3 N = normalize(normal);
+	vec3 V = normalize(camPos - worldPos);
+	if(!gl_FrontFacing)
+		N = -N;
+
+	//glass reflects more at grazing angles, which also makes it more opaque there
+	float fresnel = 0.04f + 0.96f * pow(1.0f - max(dot(N, V), 0.0f), 5.0f);
+	float alpha = clamp(mix(albedo.a, 1.0f, fresnel), 0.0f, 1.0f);
+
+	vec3 diffuse = evaluateSH(N) * albedo.rgb;
+	vec3 specular = vec3(0.0f);
+	for(int i = 0; i < nrOfLights; i++)
+	{
+		vec3 L = lightPositions[i] - worldPos;
+		float distanceSquared = dot(L, L);
+		L = normalize(L);
+		vec3 radiance = lightColors[i] / distanceSquared;
+		diffuse += albedo.rgb / Pi * radiance * max(dot(N, L), 0.0f);
+		specular += radiance * pow(max(dot(N, normalize(L + V)), 0.0f), 64.0f) * fresnel;
+	}
+	//the highlight is reflected light and isn't attenuated by the coverage
+	vec3 color = diffuse * alpha + specular;
+
+	//weight from McGuire and Bavoil (equation 10), close surfaces dominate the average
+	float w = alpha * clamp(10.0f / (1e-5f + pow(viewDepth / 5.0f, 2.0f) + pow(viewDepth / 200.0f, 6.0f)), 1e-2f, 3e3f);
+	accumulation = vec4(color * w, alpha);
+	weight = vec4(alpha * w, 0.0f, 0.0f, 0.0f);
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#version 330 core
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTexCoords;
+layout(location = 3) in mat4 aModel; //per instance, locations 3-6
+layout(location = 7) in vec4 aTint;
+
+out vec2 texCoords;
+out vec3 worldPos;
+out vec3 normal;
+out vec4 tint;
+out float viewDepth;
+
+uniform mat4 projection;
+uniform mat4 view;
+
+void main()
+{
+	texCoords = aTexCoords;
+	tint = aTint;
+	worldPos = vec3(aModel * vec4(aPos, 1.0f));
+	normal = transpose(inverse(mat3(aModel))) * aNormal;
+	vec4 viewSpacePos = view * vec4(worldPos, 1.0f);
+	viewDepth = -viewSpacePos.z;
+	gl_Position = projection * viewSpacePos;
+}
\ No newline at end of file
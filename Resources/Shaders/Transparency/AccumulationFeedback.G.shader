@@ -0,0 +1,44 @@
+#version 330 core
+layout(points) in;
+layout(triangle_strip, max_vertices = 3) out;
+
+in vec4 vModel0[];
+in vec4 vModel1[];
+in vec4 vModel2[];
+in vec4 vModel3[];
+in vec4 vTint[];
+flat in int vTriangle[];
+
+//same outputs as Accumulation.V
+out vec2 texCoords;
+out vec3 worldPos;
+out vec3 normal;
+out vec4 tint;
+out float viewDepth;
+
+uniform samplerBuffer meshVertices; //the vertex buffer, 2 texels per vertex: position and normal x, normal yz and uv
+uniform usamplerBuffer meshIndices;
+uniform mat4 projection;
+uniform mat4 view;
+
+//emits one triangle of the mesh for one instance, the instance data comes from the transform feedback buffer instead of instanced attributes
+void main()
+{
+	mat4 model = mat4(vModel0[0], vModel1[0], vModel2[0], vModel3[0]);
+	mat3 normalMatrix = transpose(inverse(mat3(model)));
+	for(int i = 0; i < 3; i++)
+	{
+		int index = int(texelFetch(meshIndices, vTriangle[0] * 3 + i).r);
+		vec4 a = texelFetch(meshVertices, index * 2);
+		vec4 b = texelFetch(meshVertices, index * 2 + 1);
+		texCoords = b.zw;
+		tint = vTint[0];
+		worldPos = vec3(model * vec4(a.xyz, 1.0f));
+		normal = normalMatrix * vec3(a.w, b.xy);
+		vec4 viewSpacePos = view * vec4(worldPos, 1.0f);
+		viewDepth = -viewSpacePos.z;
+		gl_Position = projection * viewSpacePos;
+		EmitVertex();
+	}
+	EndPrimitive();
+}
\ No newline at end of file
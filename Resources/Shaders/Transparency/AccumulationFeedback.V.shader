@@ -0,0 +1,23 @@
+#version 330 core
+layout(location = 0) in vec4 aModel0; //one vertex per instance the culling kept, the triangles of the mesh are the instances of the draw
+layout(location = 1) in vec4 aModel1;
+layout(location = 2) in vec4 aModel2;
+layout(location = 3) in vec4 aModel3;
+layout(location = 4) in vec4 aTint;
+
+out vec4 vModel0;
+out vec4 vModel1;
+out vec4 vModel2;
+out vec4 vModel3;
+out vec4 vTint;
+flat out int vTriangle;
+
+void main()
+{
+	vModel0 = aModel0;
+	vModel1 = aModel1;
+	vModel2 = aModel2;
+	vModel3 = aModel3;
+	vTint = aTint;
+	vTriangle = gl_InstanceID;
+}
\ No newline at end of file
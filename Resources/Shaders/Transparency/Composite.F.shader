@@ -0,0 +1,20 @@
+#version 330 core
+out vec4 fragColor;
+
+uniform sampler2D accumulation;
+uniform sampler2D weights;
+
+void main()
+{
+	//the targets are as big as the render targets and the viewport starts at the origin, so pixels map 1:1
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	vec4 accumulated = texelFetch(accumulation, pixel, 0);
+	float revealage = accumulated.a;
+	if(revealage >= 0.999f)
+		discard;
+
+	float totalWeight = texelFetch(weights, pixel, 0).r;
+	vec3 averageColor = accumulated.rgb / max(totalWeight, 1e-5f);
+	//blended with GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA: the scene behind is kept by the revealage
+	fragColor = vec4(averageColor, 1.0f - revealage);
+}
\ No newline at end of file
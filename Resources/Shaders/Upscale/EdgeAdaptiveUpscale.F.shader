@@ -0,0 +1,153 @@
+#version 330 core
+out vec4 fragColor;
+
+in vec2 texCoords;
+
+uniform sampler2D inputTexture;
+
+uniform vec2 inputSize; //part of the input texture that holds the image
+uniform vec2 outputSize;
+uniform vec2 textureSize; //allocated size of the input texture
+uniform float sharpness = 0.8f;
+
+//cheap luma approximation, only used to find the edge direction
+float luma(vec3 c)
+{
+	return c.b * 0.5f + (c.r * 0.5f + c.g);
+}
+
+vec3 fetch(ivec2 p)
+{
+	return texelFetch(inputTexture, clamp(p, ivec2(0), ivec2(inputSize) - 1), 0).rgb;
+}
+
+//accumulates the gradient direction and edge length of one of the 4 bilinear quadrants around the sample position
+//a = above, b = left, c = center, d = right, e = below
+void edgeDirection(inout vec2 dir, inout float len, float w, float a, float b, float c, float d, float e)
+{
+	float dc = d - c;
+	float cb = c - b;
+	float lenX = max(abs(dc), abs(cb));
+	lenX = lenX > 0.0f ? 1.0f / lenX : 0.0f;
+	float dirX = d - b;
+	dir.x += dirX * w;
+	lenX = clamp(abs(dirX) * lenX, 0.0f, 1.0f);
+	len += lenX * lenX * w;
+
+	float ec = e - c;
+	float ca = c - a;
+	float lenY = max(abs(ec), abs(ca));
+	lenY = lenY > 0.0f ? 1.0f / lenY : 0.0f;
+	float dirY = e - a;
+	dir.y += dirY * w;
+	lenY = clamp(abs(dirY) * lenY, 0.0f, 1.0f);
+	len += lenY * lenY * w;
+}
+
+//approximated lanczos2 weight of one tap, the kernel is rotated along the edge and stretched by len
+void filterTap(inout vec3 color, inout float weight, vec2 offset, vec2 dir, vec2 len, float lob, float clp, vec3 c)
+{
+	vec2 v = vec2(offset.x * dir.x + offset.y * dir.y, offset.x * -dir.y + offset.y * dir.x);
+	v *= len;
+	float d2 = min(dot(v, v), clp);
+	float wB = 0.4f * d2 - 1.0f;
+	float wA = lob * d2 - 1.0f;
+	wB *= wB;
+	wA *= wA;
+	wB = 1.5625f * wB - 0.5625f;
+	float w = wB * wA;
+	color += c * w;
+	weight += w;
+}
+
+void main()
+{
+	//position in input pixels, pixel centers are on whole numbers
+	vec2 pp = (gl_FragCoord.xy) * (inputSize / outputSize) - 0.5f;
+	vec2 fp = floor(pp);
+	pp -= fp;
+	ivec2 ip = ivec2(fp);
+
+	// 12 taps around the sample position:
+	//     b c
+	//   e f g h
+	//   i j k l
+	//     n o
+	// === ('f' is the texel at fp) ===
+	vec3 b = fetch(ip + ivec2( 0, -1));
+	vec3 c = fetch(ip + ivec2( 1, -1));
+	vec3 e = fetch(ip + ivec2(-1,  0));
+	vec3 f = fetch(ip + ivec2( 0,  0));
+	vec3 g = fetch(ip + ivec2( 1,  0));
+	vec3 h = fetch(ip + ivec2( 2,  0));
+	vec3 i = fetch(ip + ivec2(-1,  1));
+	vec3 j = fetch(ip + ivec2( 0,  1));
+	vec3 k = fetch(ip + ivec2( 1,  1));
+	vec3 l = fetch(ip + ivec2( 2,  1));
+	vec3 n = fetch(ip + ivec2( 0,  2));
+	vec3 o = fetch(ip + ivec2( 1,  2));
+
+	float bL = luma(b), cL = luma(c), eL = luma(e), fL = luma(f), gL = luma(g), hL = luma(h);
+	float iL = luma(i), jL = luma(j), kL = luma(k), lL = luma(l), nL = luma(n), oL = luma(o);
+
+	//edge direction and length, bilinearly weighted between the 4 center texels
+	vec2 dir = vec2(0.0f);
+	float len = 0.0f;
+	edgeDirection(dir, len, (1.0f - pp.x) * (1.0f - pp.y), bL, eL, fL, gL, jL);
+	edgeDirection(dir, len, pp.x * (1.0f - pp.y),          cL, fL, gL, hL, kL);
+	edgeDirection(dir, len, (1.0f - pp.x) * pp.y,          fL, iL, jL, kL, nL);
+	edgeDirection(dir, len, pp.x * pp.y,                   gL, jL, kL, lL, oL);
+
+	float dirR = dot(dir, dir);
+	if(dirR < 1.0f / 32768.0f)
+		dir = vec2(1.0f, 0.0f);
+	else
+		dir *= inversesqrt(dirR);
+
+	//len is 0 in flat areas and 1 on sharp edges, edges get a kernel stretched along them and a sharper lobe
+	len = len * 0.5f;
+	len *= len;
+	float stretch = dot(dir, dir) / max(abs(dir.x), abs(dir.y));
+	vec2 len2 = vec2(1.0f + (stretch - 1.0f) * len, 1.0f - 0.5f * len);
+	float lob = 0.5f + ((1.0f / 4.0f - 0.04f) - 0.5f) * len;
+	float clp = 1.0f / lob;
+
+	vec3 color = vec3(0.0f);
+	float weight = 0.0f;
+	filterTap(color, weight, vec2( 0.0f, -1.0f) - pp, dir, len2, lob, clp, b);
+	filterTap(color, weight, vec2( 1.0f, -1.0f) - pp, dir, len2, lob, clp, c);
+	filterTap(color, weight, vec2(-1.0f,  1.0f) - pp, dir, len2, lob, clp, i);
+	filterTap(color, weight, vec2( 0.0f,  1.0f) - pp, dir, len2, lob, clp, j);
+	filterTap(color, weight, vec2( 0.0f,  0.0f) - pp, dir, len2, lob, clp, f);
+	filterTap(color, weight, vec2(-1.0f,  0.0f) - pp, dir, len2, lob, clp, e);
+	filterTap(color, weight, vec2( 1.0f,  1.0f) - pp, dir, len2, lob, clp, k);
+	filterTap(color, weight, vec2( 2.0f,  1.0f) - pp, dir, len2, lob, clp, l);
+	filterTap(color, weight, vec2( 2.0f,  0.0f) - pp, dir, len2, lob, clp, h);
+	filterTap(color, weight, vec2( 1.0f,  0.0f) - pp, dir, len2, lob, clp, g);
+	filterTap(color, weight, vec2( 1.0f,  2.0f) - pp, dir, len2, lob, clp, o);
+	filterTap(color, weight, vec2( 0.0f,  2.0f) - pp, dir, len2, lob, clp, n);
+
+	//the negative lobes ring around edges, clamp to the 4 nearest texels to remove it
+	vec3 minColor = min(min(f, g), min(j, k));
+	vec3 maxColor = max(max(f, g), max(j, k));
+	color = clamp(color / weight, minColor, maxColor);
+
+	//contrast adaptive sharpening against the input's cross neighbourhood, the lobe is limited so it can't push the color out of [0, 1]
+	vec2 uv = (fp + pp + 0.5f) / textureSize;
+	vec2 texel = 1.0f / textureSize;
+	vec2 uvMax = (inputSize - 0.5f) / textureSize;
+	vec3 north = texture(inputTexture, min(uv + vec2(0.0f,  texel.y), uvMax)).rgb;
+	vec3 south = texture(inputTexture, min(uv + vec2(0.0f, -texel.y), uvMax)).rgb;
+	vec3 east  = texture(inputTexture, min(uv + vec2( texel.x, 0.0f), uvMax)).rgb;
+	vec3 west  = texture(inputTexture, min(uv + vec2(-texel.x, 0.0f), uvMax)).rgb;
+
+	vec3 mn = min(color, min(min(north, south), min(east, west)));
+	vec3 mx = max(color, max(max(north, south), max(east, west)));
+	vec3 hitMin = mn / (4.0f * mx + 0.0001f);
+	vec3 hitMax = (1.0f - mx) / (4.0f * mn - 4.0f - 0.0001f);
+	vec3 lobeRGB = max(-hitMin, hitMax);
+	float lobe = max(-0.1875f, min(max(lobeRGB.r, max(lobeRGB.g, lobeRGB.b)), 0.0f)) * sharpness;
+
+	color = (lobe * (north + south + east + west) + color) / (4.0f * lobe + 1.0f);
+	fragColor = vec4(clamp(color, 0.0f, 1.0f), 1.0f);
+}
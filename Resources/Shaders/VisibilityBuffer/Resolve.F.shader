@@ -0,0 +1,134 @@
+#version 330 core
+layout(location = 0) out vec2 gNormal; //octahedral encoded
+layout(location = 1) out vec4 gAlbedo;
+layout(location = 2) out vec4 gMetalRoughAO; //alpha is the material ID / 255
+layout(location = 3) out vec2 gVelocity;
+
+uniform usampler2D visibilityBuffer; //triangle ID, instance ID + 1
+uniform samplerBuffer vertexData; //2 texels per vertex: position and u, normal and v
+uniform usamplerBuffer indexData;
+uniform samplerBuffer instanceTransforms; //8 texels per instance: model and previous model matrix
+uniform usamplerBuffer instanceData; //first index, base vertex, material layer, material ID
+
+//every material's maps resampled to one layer
+uniform sampler2DArray albedoMaps;
+uniform sampler2DArray normalMaps;
+uniform sampler2DArray metallicMaps;
+uniform sampler2DArray roughnessMaps;
+uniform sampler2DArray aoMaps;
+
+uniform mat4 projection;
+uniform mat4 view;
+//un-jittered matrices of the current and previous frame, for the velocity
+uniform mat4 viewProjection;
+uniform mat4 prevViewProjection;
+uniform vec2 renderSize;
+
+vec3 barycentrics(vec4 c0, vec4 c1, vec4 c2, vec2 ndc, vec2 pixelSize, out vec3 dx, out vec3 dy);
+vec2 encodeNormal(vec3 n);
+
+void main()
+{
+	uvec2 visibility = texelFetch(visibilityBuffer, ivec2(gl_FragCoord.xy), 0).rg;
+	if(visibility.y == 0u)
+	{
+		gNormal = vec2(0.0f);
+		gAlbedo = vec4(0.0f);
+		gMetalRoughAO = vec4(0.0f);
+		gVelocity = vec2(0.0f);
+		return;
+	}
+
+	int instance = int(visibility.y) - 1;
+	uvec4 info = texelFetch(instanceData, instance);
+	mat4 model = mat4(texelFetch(instanceTransforms, instance * 8 + 0), texelFetch(instanceTransforms, instance * 8 + 1),
+					  texelFetch(instanceTransforms, instance * 8 + 2), texelFetch(instanceTransforms, instance * 8 + 3));
+	mat4 prevModel = mat4(texelFetch(instanceTransforms, instance * 8 + 4), texelFetch(instanceTransforms, instance * 8 + 5),
+						  texelFetch(instanceTransforms, instance * 8 + 6), texelFetch(instanceTransforms, instance * 8 + 7));
+
+	//fetches the triangle's vertices
+	vec3 positions[3];
+	vec3 normals[3];
+	vec2 uvs[3];
+	vec4 clipPositions[3];
+	int firstIndex = int(info.x) + int(visibility.x) * 3;
+	for(int i = 0; i < 3; i++)
+	{
+		int vertex = int(info.y) + int(texelFetch(indexData, firstIndex + i).r);
+		vec4 positionU = texelFetch(vertexData, vertex * 2);
+		vec4 normalV = texelFetch(vertexData, vertex * 2 + 1);
+		positions[i] = positionU.xyz;
+		normals[i] = normalV.xyz;
+		uvs[i] = vec2(positionU.w, normalV.w);
+		clipPositions[i] = projection * view * model * vec4(positions[i], 1.0f);
+	}
+
+	//the barycentric derivatives replace dFdx/dFdy, which are meaningless in a full screen pass
+	vec3 dx, dy;
+	vec2 ndc = gl_FragCoord.xy / renderSize * 2.0f - 1.0f;
+	vec3 weights = barycentrics(clipPositions[0], clipPositions[1], clipPositions[2], ndc, 2.0f / renderSize, dx, dy);
+
+	vec3 position = mat3(positions[0], positions[1], positions[2]) * weights;
+	vec3 normal = mat3(normals[0], normals[1], normals[2]) * weights;
+	mat3x2 uvMatrix = mat3x2(uvs[0], uvs[1], uvs[2]);
+	vec2 uv = uvMatrix * weights;
+	vec2 uvDx = uvMatrix * dx;
+	vec2 uvDy = uvMatrix * dy;
+	vec3 positionDx = mat3(model) * (mat3(positions[0], positions[1], positions[2]) * dx);
+	vec3 positionDy = mat3(model) * (mat3(positions[0], positions[1], positions[2]) * dy);
+
+	vec3 materialUV = vec3(uv, float(info.z)); //the layer is the material
+	vec3 N = normalize(transpose(inverse(mat3(model))) * normal);
+	vec3 T = normalize(positionDx * uvDy.t - positionDy * uvDx.t);
+	vec3 B = normalize(cross(N, T));
+	vec3 tangentNormal = textureGrad(normalMaps, materialUV, uvDx, uvDy).xyz * 2.0f - 1.0f;
+	gNormal = encodeNormal(normalize(mat3(T, B, N) * tangentNormal));
+
+	gAlbedo = textureGrad(albedoMaps, materialUV, uvDx, uvDy);
+	gMetalRoughAO.r = textureGrad(metallicMaps, materialUV, uvDx, uvDy).r;
+	gMetalRoughAO.g = textureGrad(roughnessMaps, materialUV, uvDx, uvDy).r;
+	gMetalRoughAO.b = textureGrad(aoMaps, materialUV, uvDx, uvDy).r;
+	gMetalRoughAO.a = float(info.w) / 255.0f;
+
+	vec4 currentClipPos = viewProjection * model * vec4(position, 1.0f);
+	vec4 previousClipPos = prevViewProjection * prevModel * vec4(position, 1.0f);
+	gVelocity = (currentClipPos.xy / currentClipPos.w - previousClipPos.xy / previousClipPos.w) * 0.5f;
+}
+
+//perspective correct barycentrics of the pixel at ndc and how much they change one pixel to the right (dx) and up (dy)
+vec3 barycentrics(vec4 c0, vec4 c1, vec4 c2, vec2 ndc, vec2 pixelSize, out vec3 dx, out vec3 dy)
+{
+	vec3 invW = 1.0f / vec3(c0.w, c1.w, c2.w);
+	vec2 p0 = c0.xy * invW.x;
+	vec2 p1 = c1.xy * invW.y;
+	vec2 p2 = c2.xy * invW.z;
+
+	//1/w and barycentrics divided by w are linear in screen space
+	float invDet = 1.0f / determinant(mat2(p2 - p1, p0 - p1));
+	vec3 ddxOverW = vec3(p1.y - p2.y, p2.y - p0.y, p0.y - p1.y) * invDet * invW;
+	vec3 ddyOverW = vec3(p2.x - p1.x, p0.x - p2.x, p1.x - p0.x) * invDet * invW;
+	float ddxInvW = ddxOverW.x + ddxOverW.y + ddxOverW.z;
+	float ddyInvW = ddyOverW.x + ddyOverW.y + ddyOverW.z;
+
+	vec2 delta = ndc - p0;
+	float interpolatedInvW = invW.x + delta.x * ddxInvW + delta.y * ddyInvW;
+	vec3 weights = (vec3(invW.x, 0.0f, 0.0f) + delta.x * ddxOverW + delta.y * ddyOverW) / interpolatedInvW;
+
+	ddxOverW *= pixelSize.x;
+	ddyOverW *= pixelSize.y;
+	ddxInvW *= pixelSize.x;
+	ddyInvW *= pixelSize.y;
+	dx = (weights * interpolatedInvW + ddxOverW) / (interpolatedInvW + ddxInvW) - weights;
+	dy = (weights * interpolatedInvW + ddyOverW) / (interpolatedInvW + ddyInvW) - weights;
+	return weights;
+}
+
+//same encoding as GBuffer.F.shader
+vec2 encodeNormal(vec3 n)
+{
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	vec2 e = n.xy;
+	if(n.z < 0.0f)
+		e = (1.0f - abs(n.yx)) * vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+	return e * 0.5f + 0.5f;
+}
\ No newline at end of file
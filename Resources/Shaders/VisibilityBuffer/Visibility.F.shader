@@ -0,0 +1,10 @@
+#version 330 core
+out uvec2 visibility;
+
+uniform int instanceID;
+
+void main()
+{
+	//0 is left for pixels no triangle covers
+	visibility = uvec2(uint(gl_PrimitiveID), uint(instanceID + 1));
+}
\ No newline at end of file
@@ -4,6 +4,7 @@ in vec3 worldPos;
 
 uniform samplerCube environmentMap;
 uniform float roughness;
+uniform float resolution = 512.0f; //resolution of the environment map (per face)
 
 const float Pi = 3.14159265359;
 
@@ -87,7 +88,6 @@ void main()
 			float HdotV = max(dot(H, V), 0.0f);
 			float pdf = D * NdotH / (4.0f * HdotV) + 0.0001;
 
-			float resolution = 512.0f;//resolution of cubemap (per face)
 			float saTexel = 4.0f * Pi / (6.0f * resolution * resolution);
 			float saSample = 1.0f / (float(SAMPLE_COUNT) * pdf + 0.0001f);
 
@@ -0,0 +1,212 @@
+#ifndef BRDF_LUT_H
+#define BRDF_LUT_H
+
+#include <fstream>
+#include <vector>
+#include <glm/gtc/packing.hpp>
+#include "JobSystem.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define BRDF_LUT_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+#define BRDF_LUT_DEFAULT_SIZE 128
+#define BRDF_LUT_DEFAULT_SAMPLE_COUNT 1024
+#define BRDF_LUT_CACHE_MAGIC 0x4C464442 //"BDFL"
+#define BRDF_LUT_CACHE_VERSION 1
+
+//Split-sum BRDF integration look-up table for IBL: x is NdotV, y is roughness, red is the scale and green the bias applied to F0.
+//It's the same integral BRDF.F.shader computes, baked on the CPU by a pool of worker threads (each row has a fixed roughness, so the
+//GGX half vectors are computed once per row and 4 texels of the row are integrated at a time with SSE) and cached as RG16F on disk.
+class BRDFLUT
+{
+public:
+	//loads the look-up table from the cache file, or bakes and caches it if the file is missing or was baked with other settings
+	static unsigned int LoadOrBake(const char* cachePath, unsigned int size = BRDF_LUT_DEFAULT_SIZE, unsigned int sampleCount = BRDF_LUT_DEFAULT_SAMPLE_COUNT)
+	{
+		std::vector<unsigned int> halfData;
+		if(!loadCache(cachePath, size, sampleCount, halfData))
+		{
+			std::vector<float> data;
+			Bake(size, sampleCount, data);
+
+			halfData.resize(size * size);
+			for(unsigned int i = 0; i < size * size; i++)
+				halfData[i] = glm::packHalf2x16(glm::vec2(data[i * 2 + 0], data[i * 2 + 1]));
+			saveCache(cachePath, size, sampleCount, halfData);
+		}
+
+		unsigned int texture;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, size, size, 0, GL_RG, GL_HALF_FLOAT, &halfData[0]);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		return texture;
+	}
+
+	//integrates the table into data (size * size RG pairs, first row is roughness 0), every row is a job
+	static void Bake(unsigned int size, unsigned int sampleCount, std::vector<float>& data)
+	{
+		data.assign(size * size * 2, 0.0f);
+
+		GetJobSystem().ParallelFor(size, 1, [&](unsigned int begin, unsigned int end)
+		{
+			std::vector<float> halfVectors(sampleCount * 2);
+			for(unsigned int row = begin; row < end; row++)
+				bakeRow(row, size, sampleCount, &data[row * size * 2], halfVectors);
+		});
+	}
+private:
+	struct CacheHeader
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned int size;
+		unsigned int sampleCount;
+	};
+
+	static bool loadCache(const char* path, unsigned int size, unsigned int sampleCount, std::vector<unsigned int>& halfData)
+	{
+		std::ifstream file(path, std::ios::in | std::ios::binary);
+		if(!file)
+			return 0;
+
+		CacheHeader header;
+		file.read((char*)&header, sizeof(header));
+		if(!file || header.magic != BRDF_LUT_CACHE_MAGIC || header.version != BRDF_LUT_CACHE_VERSION || header.size != size || header.sampleCount != sampleCount)
+			return 0;
+
+		halfData.resize(size * size);
+		file.read((char*)&halfData[0], size * size * sizeof(unsigned int));
+		if(!file)
+		{
+			std::cout << "BRDF LUT cache is corrupted, baking again: " << path << std::endl;
+			return 0;
+		}
+		return 1;
+	}
+	static void saveCache(const char* path, unsigned int size, unsigned int sampleCount, const std::vector<unsigned int>& halfData)
+	{
+		std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+		CacheHeader header = { BRDF_LUT_CACHE_MAGIC, BRDF_LUT_CACHE_VERSION, size, sampleCount };
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)&halfData[0], halfData.size() * sizeof(unsigned int));
+		if(!file.good())
+			std::cout << "Failed to write BRDF LUT cache: " << path << std::endl;
+	}
+
+	// efficient VanDerCorpus calculation: http://holger.dammertz.org/stuff/notes_HammersleyOnHemisphere.html
+	static float radicalInverse_VdC(unsigned int bits)
+	{
+		bits = (bits << 16u) | (bits >> 16u);
+		bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+		bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+		bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+		bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+		return float(bits) * 2.3283064365386963e-10f; // / 0x100000000
+	}
+
+	static void bakeRow(unsigned int row, unsigned int size, unsigned int sampleCount, float* output, std::vector<float>& halfVectors)
+	{
+		const float Pi = 3.14159265359f;
+		float roughness = (row + 0.5f) / size;
+		float a = roughness * roughness;
+		float k = (roughness * roughness) / 2.0f;
+
+		//GGX importance sampled half vectors around N = +Z, V lies in the XZ plane so only H.x and H.z are needed
+		for(unsigned int i = 0; i < sampleCount; i++)
+		{
+			float phi = 2.0f * Pi * ((float)i / (float)sampleCount);
+			float xi = radicalInverse_VdC(i);
+			float cosTheta = std::sqrt((1.0f - xi) / (1.0f + (a * a - 1.0f) * xi));
+			float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+			halfVectors[i * 2 + 0] = std::sin(phi) * sinTheta;
+			halfVectors[i * 2 + 1] = cosTheta;
+		}
+
+		unsigned int column = 0;
+#ifdef BRDF_LUT_USE_SSE
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 two = _mm_set1_ps(2.0f);
+		const __m128 vk = _mm_set1_ps(k);
+		const __m128 oneMinusK = _mm_set1_ps(1.0f - k);
+		for(; column + 4 <= size; column += 4)
+		{
+			__m128 NdotV = _mm_setr_ps((column + 0.5f) / size, (column + 1.5f) / size, (column + 2.5f) / size, (column + 3.5f) / size);
+			__m128 Vx = _mm_sqrt_ps(_mm_sub_ps(one, _mm_mul_ps(NdotV, NdotV)));
+			__m128 Vz = NdotV;
+			__m128 ggxV = _mm_div_ps(NdotV, _mm_add_ps(_mm_mul_ps(NdotV, oneMinusK), vk));
+
+			__m128 A = zero;
+			__m128 B = zero;
+			for(unsigned int i = 0; i < sampleCount; i++)
+			{
+				__m128 Hx = _mm_set1_ps(halfVectors[i * 2 + 0]);
+				__m128 Hz = _mm_set1_ps(halfVectors[i * 2 + 1]);
+
+				__m128 VdotH = _mm_add_ps(_mm_mul_ps(Vx, Hx), _mm_mul_ps(Vz, Hz));
+				__m128 NdotL = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(two, VdotH), Hz), Vz);
+				__m128 mask = _mm_cmpgt_ps(NdotL, zero);
+				NdotL = _mm_max_ps(NdotL, zero);
+				VdotH = _mm_max_ps(VdotH, zero);
+
+				__m128 ggxL = _mm_div_ps(NdotL, _mm_add_ps(_mm_mul_ps(NdotL, oneMinusK), vk));
+				__m128 G = _mm_mul_ps(ggxL, ggxV);
+				__m128 G_Vis = _mm_div_ps(_mm_mul_ps(G, VdotH), _mm_mul_ps(Hz, NdotV));
+
+				__m128 oneMinusVdotH = _mm_sub_ps(one, VdotH);
+				__m128 Fc = _mm_mul_ps(oneMinusVdotH, oneMinusVdotH);
+				Fc = _mm_mul_ps(_mm_mul_ps(Fc, Fc), oneMinusVdotH);
+
+				A = _mm_add_ps(A, _mm_and_ps(mask, _mm_mul_ps(_mm_sub_ps(one, Fc), G_Vis)));
+				B = _mm_add_ps(B, _mm_and_ps(mask, _mm_mul_ps(Fc, G_Vis)));
+			}
+
+			float resultA[4], resultB[4];
+			_mm_storeu_ps(resultA, A);
+			_mm_storeu_ps(resultB, B);
+			for(unsigned int j = 0; j < 4; j++)
+			{
+				output[(column + j) * 2 + 0] = resultA[j] / sampleCount;
+				output[(column + j) * 2 + 1] = resultB[j] / sampleCount;
+			}
+		}
+#endif
+		//the columns that don't fill a whole SSE register (or all of them without SSE)
+		for(; column < size; column++)
+		{
+			float NdotV = (column + 0.5f) / size;
+			float Vx = std::sqrt(1.0f - NdotV * NdotV);
+			float Vz = NdotV;
+			float ggxV = NdotV / (NdotV * (1.0f - k) + k);
+
+			float A = 0.0f;
+			float B = 0.0f;
+			for(unsigned int i = 0; i < sampleCount; i++)
+			{
+				float Hx = halfVectors[i * 2 + 0];
+				float Hz = halfVectors[i * 2 + 1];
+				float VdotH = Vx * Hx + Vz * Hz;
+				float NdotL = 2.0f * VdotH * Hz - Vz;
+				if(NdotL > 0.0f)
+				{
+					VdotH = std::max(VdotH, 0.0f);
+					float ggxL = NdotL / (NdotL * (1.0f - k) + k);
+					float G_Vis = (ggxL * ggxV * VdotH) / (Hz * NdotV);
+					float Fc = std::pow(1.0f - VdotH, 5.0f);
+					A += (1.0f - Fc) * G_Vis;
+					B += Fc * G_Vis;
+				}
+			}
+			output[column * 2 + 0] = A / sampleCount;
+			output[column * 2 + 1] = B / sampleCount;
+		}
+	}
+};
+
+#endif
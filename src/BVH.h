@@ -0,0 +1,687 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <cfloat>
+#include <cmath>
+#include <glm/glm.hpp>
+#include <src/JobSystem.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define BVH_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+#define BVH_INVALID 0xFFFFFFFFu
+#define BVH_BINS 16 //SAH candidates per axis
+#define BVH_MAX_LEAF_SIZE 4
+#define BVH_PARALLEL_BUILD 4096 //subtrees with more objects are built in their own job
+#define BVH_REBUILD_RATIO 1.5f //refitting stops once the SAH cost has grown by this factor since the last build
+
+//The boxes of the 4 children of a node as separate arrays, so a ray, box or sphere is tested against all of them at once.
+//A slot with m_Count > 0 is a leaf with m_Count objects from m_Child on in the BVH's object order, m_Child == BVH_INVALID an unused slot
+//and anything else an inner node
+struct BVHNode
+{
+	float m_MinX[4], m_MinY[4], m_MinZ[4];
+	float m_MaxX[4], m_MaxY[4], m_MaxZ[4];
+	unsigned int m_Child[4];
+	unsigned int m_Count[4];
+};
+
+//4-ary bounding volume hierarchy over a set of world space boxes, e.g. TransformHierarchy::WorldMins()/WorldMaxs().
+//Objects are referred to by their index in those arrays, objects without bounds (min > max) are left out.
+//A binary tree is built top-down with binned SAH, the subtrees of large nodes are built as jobs, and then collapsed to 4 children per node.
+//Update() refits the boxes bottom-up when objects move and only rebuilds when objects came or went or the SAH cost degraded too much.
+class BVH
+{
+public:
+	BVH()
+		:m_Jobs(nullptr), m_NrOfObjects(0), m_BuildCost(0.0f), m_Cost(0.0f), m_StackSize(1), m_NextBinaryNode(0)
+	{
+
+	}
+
+	//without a job system the build runs on the calling thread
+	void Init(JobSystem* jobs)
+	{
+		m_Jobs = jobs;
+	}
+
+	void Build(const std::vector<glm::vec3>& mins, const std::vector<glm::vec3>& maxs)
+	{
+		m_Min = mins;
+		m_Max = maxs;
+		m_NrOfObjects = (unsigned int)mins.size();
+		m_Objects.clear();
+		m_Centroid.resize(m_NrOfObjects);
+		for(unsigned int i = 0; i < m_NrOfObjects; i++)
+		{
+			if(!valid(i))
+				continue;
+			m_Objects.push_back(i);
+			m_Centroid[i] = (mins[i] + maxs[i]) * 0.5f;
+		}
+		m_Nodes.clear();
+		m_BuildCost = m_Cost = 0.0f;
+		if(m_Objects.empty())
+			return;
+
+		m_BinaryNodes.resize(m_Objects.size() * 2);
+		m_NextBinaryNode = 1;
+		buildNode(0, 0, (unsigned int)m_Objects.size());
+
+		unsigned int depth = 0;
+		collapse(0, 1, depth);
+		m_StackSize = 3 * depth + 1;
+		Refit();
+		m_BuildCost = m_Cost;
+	}
+	//refits to the new boxes, or rebuilds if needed. returns true if the tree was rebuilt
+	bool Update(const std::vector<glm::vec3>& mins, const std::vector<glm::vec3>& maxs)
+	{
+		bool rebuild = mins.size() != m_NrOfObjects || m_Nodes.empty();
+		unsigned int nrValid = 0;
+		for(unsigned int i = 0; i < mins.size() && !rebuild; i++)
+			nrValid += mins[i].x <= maxs[i].x;
+		rebuild = rebuild || nrValid != m_Objects.size();
+		if(!rebuild)
+		{
+			m_Min = mins;
+			m_Max = maxs;
+			//the same number of objects has bounds, but they could be different ones
+			for(unsigned int i = 0; i < m_Objects.size() && !rebuild; i++)
+				rebuild = !valid(m_Objects[i]);
+		}
+		if(!rebuild)
+		{
+			Refit();
+			rebuild = m_Cost > m_BuildCost * BVH_REBUILD_RATIO;
+		}
+		if(rebuild)
+			Build(mins, maxs);
+		return rebuild;
+	}
+	//recomputes the boxes of the nodes from the current object boxes, children are always stored after their parent
+	void Refit()
+	{
+		m_NodeMin.resize(m_Nodes.size());
+		m_NodeMax.resize(m_Nodes.size());
+		for(int n = (int)m_Nodes.size() - 1; n >= 0; n--)
+		{
+			BVHNode& node = m_Nodes[n];
+			glm::vec3 nodeMin(FLT_MAX), nodeMax(-FLT_MAX);
+			for(unsigned int s = 0; s < 4; s++)
+			{
+				if(node.m_Child[s] == BVH_INVALID)
+					continue;
+				glm::vec3 minimum(FLT_MAX), maximum(-FLT_MAX);
+				if(node.m_Count[s] > 0)
+				{
+					for(unsigned int i = node.m_Child[s]; i < node.m_Child[s] + node.m_Count[s]; i++)
+					{
+						minimum = glm::min(minimum, m_Min[m_Objects[i]]);
+						maximum = glm::max(maximum, m_Max[m_Objects[i]]);
+					}
+				}
+				else
+				{
+					minimum = m_NodeMin[node.m_Child[s]];
+					maximum = m_NodeMax[node.m_Child[s]];
+				}
+				setSlot(node, s, minimum, maximum);
+				nodeMin = glm::min(nodeMin, minimum);
+				nodeMax = glm::max(nodeMax, maximum);
+			}
+			m_NodeMin[n] = nodeMin;
+			m_NodeMax[n] = nodeMax;
+		}
+		m_Cost = sahCost();
+	}
+
+	//closest object whose box the ray hits within distance, which is set to the distance of the hit. BVH_INVALID if nothing is hit
+	unsigned int Raycast(const glm::vec3& origin, const glm::vec3& direction, float& distance) const
+	{
+		if(m_Nodes.empty())
+			return BVH_INVALID;
+		glm::vec3 inverse;
+		for(unsigned int i = 0; i < 3; i++)
+			inverse[i] = std::fabs(direction[i]) > 1e-30f ? 1.0f / direction[i] : (direction[i] < 0.0f ? -1e30f : 1e30f);
+
+		std::vector<StackEntry>& stack = traversalStack();
+		unsigned int size = 0;
+		stack[size++] = StackEntry(0, 0.0f);
+		unsigned int hit = BVH_INVALID;
+		float closest = distance;
+		while(size > 0)
+		{
+			StackEntry entry = stack[--size];
+			if(entry.m_Distance > closest)
+				continue;
+			const BVHNode& node = m_Nodes[entry.m_Node];
+			float slotDistance[4];
+			unsigned int mask = intersectRay(node, origin, inverse, closest, slotDistance);
+
+			//inner nodes are pushed furthest first so the closest one is visited next
+			StackEntry inner[4];
+			unsigned int nrInner = 0;
+			for(unsigned int s = 0; s < 4; s++)
+			{
+				if(!(mask & (1u << s)) || node.m_Child[s] == BVH_INVALID)
+					continue;
+				if(node.m_Count[s] == 0)
+				{
+					unsigned int i = nrInner++;
+					for(; i > 0 && inner[i - 1].m_Distance < slotDistance[s]; i--)
+						inner[i] = inner[i - 1];
+					inner[i] = StackEntry(node.m_Child[s], slotDistance[s]);
+					continue;
+				}
+				for(unsigned int i = node.m_Child[s]; i < node.m_Child[s] + node.m_Count[s]; i++)
+				{
+					unsigned int object = m_Objects[i];
+					float t;
+					if(rayBox(m_Min[object], m_Max[object], origin, inverse, closest, t))
+					{
+						closest = t;
+						hit = object;
+					}
+				}
+			}
+			for(unsigned int i = 0; i < nrInner; i++)
+				stack[size++] = inner[i];
+		}
+		if(hit != BVH_INVALID)
+			distance = closest;
+		return hit;
+	}
+	//every object whose box overlaps the box
+	void QueryBox(const glm::vec3& minimum, const glm::vec3& maximum, std::vector<unsigned int>& results) const
+	{
+		results.clear();
+		query([&](const BVHNode& node) { return overlapBox(node, minimum, maximum); },
+		      [&](unsigned int object) { return glm::all(glm::lessThanEqual(m_Min[object], maximum)) && glm::all(glm::greaterThanEqual(m_Max[object], minimum)); },
+		      results);
+	}
+	//every object whose box is at most radius away from center, e.g. the shadow casters in the range of a light
+	void QuerySphere(const glm::vec3& center, float radius, std::vector<unsigned int>& results) const
+	{
+		results.clear();
+		query([&](const BVHNode& node) { return overlapSphere(node, center, radius); },
+		      [&](unsigned int object)
+		      {
+			      glm::vec3 offset = glm::max(glm::max(m_Min[object] - center, center - m_Max[object]), glm::vec3(0.0f));
+			      return glm::dot(offset, offset) <= radius * radius;
+		      },
+		      results);
+	}
+
+	inline unsigned int NrOfNodes() const { return (unsigned int)m_Nodes.size(); }
+	inline unsigned int NrOfObjects() const { return (unsigned int)m_Objects.size(); }
+	//SAH cost relative to the root's surface area, and how much it grew through refitting
+	inline float Cost() const { return m_Cost; }
+	inline float Degradation() const { return m_BuildCost > 0.0f ? m_Cost / m_BuildCost : 1.0f; }
+
+	//times building, refitting, ray casts and sphere queries over nrOfObjects random boxes and checks the queries against brute force,
+	//the results are printed to the console
+	static void Benchmark(JobSystem& jobSystem, unsigned int nrOfObjects = 100000)
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+		std::default_random_engine generator(11);
+		std::uniform_real_distribution<float> position(-500.0f, 500.0f), size(0.5f, 3.0f), unit(-1.0f, 1.0f);
+		std::vector<glm::vec3> mins(nrOfObjects), maxs(nrOfObjects);
+		for(unsigned int i = 0; i < nrOfObjects; i++)
+		{
+			glm::vec3 center(position(generator), position(generator), position(generator));
+			glm::vec3 extent(size(generator), size(generator), size(generator));
+			mins[i] = center - extent;
+			maxs[i] = center + extent;
+		}
+
+		BVH bvh;
+		bvh.Init(&jobSystem);
+		std::cout << "BVH over " << nrOfObjects << " boxes:" << std::endl;
+		unsigned int nrOfWorkers = jobSystem.NrOfActiveWorkers();
+		unsigned int workers[2] = { 0, nrOfWorkers };
+		for(unsigned int w = 0; w < (nrOfWorkers > 0 ? 2u : 1u); w++)
+		{
+			jobSystem.SetNrOfActiveWorkers(workers[w]);
+			Clock::time_point start = Clock::now();
+			bvh.Build(mins, maxs);
+			std::cout << "  build with " << workers[w] + 1 << " threads: " << std::chrono::duration<double, std::milli>(Clock::now() - start).count() << "ms" << std::endl;
+		}
+		jobSystem.SetNrOfActiveWorkers(nrOfWorkers);
+		std::cout << "  " << bvh.NrOfNodes() << " nodes, SAH cost " << bvh.Cost() << std::endl;
+
+		for(unsigned int i = 0; i < nrOfObjects; i++)
+		{
+			glm::vec3 offset(unit(generator), unit(generator), unit(generator));
+			mins[i] += offset;
+			maxs[i] += offset;
+		}
+		Clock::time_point start = Clock::now();
+		bool rebuilt = bvh.Update(mins, maxs);
+		std::cout << "  refit after moving every box: " << std::chrono::duration<double, std::milli>(Clock::now() - start).count() << "ms (" << (rebuilt ? "rebuilt" : "refitted")
+		          << ", cost x" << bvh.Degradation() << ")" << std::endl;
+
+		const unsigned int nrOfRays = 100000, nrOfChecked = 1000;
+		std::vector<glm::vec3> origins(nrOfRays), directions(nrOfRays);
+		for(unsigned int i = 0; i < nrOfRays; i++)
+		{
+			origins[i] = glm::vec3(position(generator), position(generator), position(generator));
+			directions[i] = glm::normalize(glm::vec3(unit(generator), unit(generator), unit(generator)) + glm::vec3(0.0f, 0.0f, 1e-3f));
+		}
+		unsigned int nrOfHits = 0;
+		std::vector<float> distances(nrOfRays);
+		start = Clock::now();
+		for(unsigned int i = 0; i < nrOfRays; i++)
+		{
+			distances[i] = 1000.0f;
+			nrOfHits += bvh.Raycast(origins[i], directions[i], distances[i]) != BVH_INVALID;
+		}
+		double rayTime = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+		unsigned int rayErrors = 0;
+		for(unsigned int i = 0; i < nrOfChecked; i++)
+		{
+			glm::vec3 inverse = 1.0f / directions[i];
+			float closest = 1000.0f, t;
+			bool hit = false;
+			for(unsigned int o = 0; o < nrOfObjects; o++)
+			{
+				if(rayBox(mins[o], maxs[o], origins[i], inverse, closest, t))
+				{
+					closest = t;
+					hit = true;
+				}
+			}
+			if(hit != (distances[i] < 1000.0f) || (hit && std::fabs(closest - distances[i]) > 1e-3f))
+				rayErrors++;
+		}
+		std::cout << "  " << nrOfRays << " rays: " << rayTime / nrOfRays << "us per ray, " << nrOfHits << " hits, " << rayErrors << " mismatches in " << nrOfChecked << " brute force checks" << std::endl;
+
+		const unsigned int nrOfQueries = 10000;
+		const float radius = 25.0f;
+		std::vector<unsigned int> results;
+		size_t nrOfResults = 0;
+		start = Clock::now();
+		for(unsigned int i = 0; i < nrOfQueries; i++)
+		{
+			bvh.QuerySphere(origins[i], radius, results);
+			nrOfResults += results.size();
+		}
+		double sphereTime = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+		unsigned int sphereErrors = 0;
+		for(unsigned int i = 0; i < 100; i++)
+		{
+			bvh.QuerySphere(origins[i], radius, results);
+			unsigned int expected = 0;
+			for(unsigned int o = 0; o < nrOfObjects; o++)
+			{
+				glm::vec3 offset = glm::max(glm::max(mins[o] - origins[i], origins[i] - maxs[o]), glm::vec3(0.0f));
+				expected += glm::dot(offset, offset) <= radius * radius;
+			}
+			sphereErrors += expected != results.size();
+		}
+		std::cout << "  " << nrOfQueries << " radius " << radius << " queries: " << sphereTime / nrOfQueries << "us per query, " << (double)nrOfResults / nrOfQueries << " objects per query, "
+		          << sphereErrors << " mismatches in 100 brute force checks" << std::endl;
+	}
+
+private:
+	struct BinaryNode
+	{
+		glm::vec3 m_Min, m_Max;
+		unsigned int m_Left; //the right child follows the left one
+		unsigned int m_First, m_Count; //objects of leaves
+	};
+	struct StackEntry
+	{
+		unsigned int m_Node;
+		float m_Distance;
+
+		StackEntry()
+			:m_Node(0), m_Distance(0.0f)
+		{
+
+		}
+		StackEntry(unsigned int node, float distance)
+			:m_Node(node), m_Distance(distance)
+		{
+
+		}
+	};
+
+	JobSystem* m_Jobs;
+	unsigned int m_NrOfObjects;
+	std::vector<glm::vec3> m_Min, m_Max, m_Centroid; //boxes of all objects, with and without bounds
+	std::vector<unsigned int> m_Objects; //objects with bounds in leaf order
+	std::vector<BVHNode> m_Nodes; //the root is node 0
+	std::vector<glm::vec3> m_NodeMin, m_NodeMax;
+	float m_BuildCost, m_Cost;
+	unsigned int m_StackSize; //enough for the deepest path of the tree
+	std::vector<BinaryNode> m_BinaryNodes;
+	std::atomic<unsigned int> m_NextBinaryNode;
+
+	inline bool valid(unsigned int object) const { return m_Min[object].x <= m_Max[object].x; }
+	static inline float area(const glm::vec3& minimum, const glm::vec3& maximum)
+	{
+		glm::vec3 size = glm::max(maximum - minimum, glm::vec3(0.0f));
+		return size.x * size.y + size.y * size.z + size.z * size.x;
+	}
+
+	void buildNode(unsigned int index, unsigned int first, unsigned int count)
+	{
+		BinaryNode& node = m_BinaryNodes[index];
+		glm::vec3 minimum(FLT_MAX), maximum(-FLT_MAX), centroidMin(FLT_MAX), centroidMax(-FLT_MAX);
+		for(unsigned int i = first; i < first + count; i++)
+		{
+			unsigned int object = m_Objects[i];
+			minimum = glm::min(minimum, m_Min[object]);
+			maximum = glm::max(maximum, m_Max[object]);
+			centroidMin = glm::min(centroidMin, m_Centroid[object]);
+			centroidMax = glm::max(centroidMax, m_Centroid[object]);
+		}
+		node.m_Min = minimum;
+		node.m_Max = maximum;
+		if(count <= BVH_MAX_LEAF_SIZE)
+		{
+			node.m_First = first;
+			node.m_Count = count;
+			return;
+		}
+
+		//the split between two bins with the lowest left area * left count + right area * right count
+		int bestAxis = -1;
+		unsigned int bestBin = 0;
+		float bestCost = FLT_MAX;
+		for(int axis = 0; axis < 3; axis++)
+		{
+			float extent = centroidMax[axis] - centroidMin[axis];
+			if(extent <= 0.0f)
+				continue;
+			float scale = BVH_BINS / extent;
+			unsigned int binCount[BVH_BINS] = {};
+			glm::vec3 binMin[BVH_BINS], binMax[BVH_BINS];
+			for(unsigned int b = 0; b < BVH_BINS; b++)
+			{
+				binMin[b] = glm::vec3(FLT_MAX);
+				binMax[b] = glm::vec3(-FLT_MAX);
+			}
+			for(unsigned int i = first; i < first + count; i++)
+			{
+				unsigned int object = m_Objects[i];
+				unsigned int b = std::min((unsigned int)((m_Centroid[object][axis] - centroidMin[axis]) * scale), (unsigned int)BVH_BINS - 1);
+				binCount[b]++;
+				binMin[b] = glm::min(binMin[b], m_Min[object]);
+				binMax[b] = glm::max(binMax[b], m_Max[object]);
+			}
+			float leftCost[BVH_BINS - 1];
+			glm::vec3 sweepMin(FLT_MAX), sweepMax(-FLT_MAX);
+			unsigned int sweepCount = 0;
+			for(unsigned int b = 0; b < BVH_BINS - 1; b++)
+			{
+				sweepMin = glm::min(sweepMin, binMin[b]);
+				sweepMax = glm::max(sweepMax, binMax[b]);
+				sweepCount += binCount[b];
+				leftCost[b] = area(sweepMin, sweepMax) * sweepCount;
+			}
+			sweepMin = glm::vec3(FLT_MAX);
+			sweepMax = glm::vec3(-FLT_MAX);
+			sweepCount = 0;
+			for(unsigned int b = BVH_BINS - 1; b > 0; b--)
+			{
+				sweepMin = glm::min(sweepMin, binMin[b]);
+				sweepMax = glm::max(sweepMax, binMax[b]);
+				sweepCount += binCount[b];
+				float cost = leftCost[b - 1] + area(sweepMin, sweepMax) * sweepCount;
+				if(sweepCount < count && cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestBin = b - 1;
+				}
+			}
+		}
+
+		unsigned int middle = first + count / 2;
+		if(bestAxis >= 0)
+		{
+			float scale = BVH_BINS / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+			float axisMin = centroidMin[bestAxis];
+			middle = (unsigned int)(std::partition(m_Objects.begin() + first, m_Objects.begin() + first + count, [&](unsigned int object)
+			{
+				return std::min((unsigned int)((m_Centroid[object][bestAxis] - axisMin) * scale), (unsigned int)BVH_BINS - 1) <= bestBin;
+			}) - m_Objects.begin());
+			if(middle == first || middle == first + count)
+				middle = first + count / 2;
+		}
+
+		unsigned int left = m_NextBinaryNode.fetch_add(2);
+		node.m_Left = left;
+		node.m_Count = 0;
+		unsigned int leftCount = middle - first;
+		if(m_Jobs && count > BVH_PARALLEL_BUILD)
+		{
+			JobCounter counter;
+			m_Jobs->Run([this, left, first, leftCount]() { buildNode(left, first, leftCount); }, &counter);
+			buildNode(left + 1, middle, count - leftCount);
+			m_Jobs->Wait(counter);
+		}
+		else
+		{
+			buildNode(left, first, leftCount);
+			buildNode(left + 1, middle, count - leftCount);
+		}
+	}
+	//turns the binary subtree into 4-ary nodes by repeatedly opening the child with the largest area, returns the node index
+	unsigned int collapse(unsigned int binary, unsigned int level, unsigned int& depth)
+	{
+		depth = std::max(depth, level);
+		unsigned int index = (unsigned int)m_Nodes.size();
+		m_Nodes.push_back(BVHNode());
+
+		unsigned int children[4];
+		unsigned int nrOfChildren = 0;
+		const BinaryNode& root = m_BinaryNodes[binary];
+		if(root.m_Count > 0)
+			children[nrOfChildren++] = binary;
+		else
+		{
+			children[nrOfChildren++] = root.m_Left;
+			children[nrOfChildren++] = root.m_Left + 1;
+			while(nrOfChildren < 4)
+			{
+				int largest = -1;
+				float largestArea = -1.0f;
+				for(unsigned int c = 0; c < nrOfChildren; c++)
+				{
+					const BinaryNode& child = m_BinaryNodes[children[c]];
+					float childArea = area(child.m_Min, child.m_Max);
+					if(child.m_Count == 0 && childArea > largestArea)
+					{
+						largest = (int)c;
+						largestArea = childArea;
+					}
+				}
+				if(largest < 0)
+					break;
+				unsigned int opened = m_BinaryNodes[children[largest]].m_Left;
+				children[largest] = opened;
+				children[nrOfChildren++] = opened + 1;
+			}
+		}
+
+		for(unsigned int s = 0; s < 4; s++)
+		{
+			unsigned int child = BVH_INVALID, count = 0;
+			if(s < nrOfChildren)
+			{
+				const BinaryNode& node = m_BinaryNodes[children[s]];
+				if(node.m_Count > 0)
+				{
+					child = node.m_First;
+					count = node.m_Count;
+				}
+				else
+					child = collapse(children[s], level + 1, depth);
+			}
+			//m_Nodes may have grown, the boxes are filled in by Refit()
+			m_Nodes[index].m_Child[s] = child;
+			m_Nodes[index].m_Count[s] = count;
+			setSlot(m_Nodes[index], s, glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX));
+		}
+		return index;
+	}
+	static inline void setSlot(BVHNode& node, unsigned int slot, const glm::vec3& minimum, const glm::vec3& maximum)
+	{
+		node.m_MinX[slot] = minimum.x; node.m_MinY[slot] = minimum.y; node.m_MinZ[slot] = minimum.z;
+		node.m_MaxX[slot] = maximum.x; node.m_MaxY[slot] = maximum.y; node.m_MaxZ[slot] = maximum.z;
+	}
+	//expected cost of a random ray relative to the root: the area of every inner slot plus the area times the object count of every leaf slot
+	float sahCost() const
+	{
+		if(m_Nodes.empty())
+			return 0.0f;
+		float rootArea = std::max(area(m_NodeMin[0], m_NodeMax[0]), FLT_MIN);
+		float cost = 0.0f;
+		for(unsigned int n = 0; n < m_Nodes.size(); n++)
+		{
+			const BVHNode& node = m_Nodes[n];
+			for(unsigned int s = 0; s < 4; s++)
+			{
+				if(node.m_Child[s] == BVH_INVALID)
+					continue;
+				float slotArea = area(glm::vec3(node.m_MinX[s], node.m_MinY[s], node.m_MinZ[s]), glm::vec3(node.m_MaxX[s], node.m_MaxY[s], node.m_MaxZ[s]));
+				cost += slotArea * (node.m_Count[s] > 0 ? node.m_Count[s] : 1);
+			}
+		}
+		return cost / rootArea;
+	}
+
+	static std::vector<StackEntry>& stackStorage()
+	{
+		static thread_local std::vector<StackEntry> stack;
+		return stack;
+	}
+	std::vector<StackEntry>& traversalStack() const
+	{
+		std::vector<StackEntry>& stack = stackStorage();
+		if(stack.size() < m_StackSize)
+			stack.resize(m_StackSize);
+		return stack;
+	}
+	//depth first traversal into the slots nodeTest returns a bit for, objects of leaves pass if objectTest does
+	template<typename NodeTest, typename ObjectTest>
+	void query(NodeTest nodeTest, ObjectTest objectTest, std::vector<unsigned int>& results) const
+	{
+		if(m_Nodes.empty())
+			return;
+		std::vector<StackEntry>& stack = traversalStack();
+		unsigned int size = 0;
+		stack[size++] = StackEntry(0, 0.0f);
+		while(size > 0)
+		{
+			const BVHNode& node = m_Nodes[stack[--size].m_Node];
+			unsigned int mask = nodeTest(node);
+			for(unsigned int s = 0; s < 4; s++)
+			{
+				if(!(mask & (1u << s)) || node.m_Child[s] == BVH_INVALID)
+					continue;
+				if(node.m_Count[s] == 0)
+				{
+					stack[size++] = StackEntry(node.m_Child[s], 0.0f);
+					continue;
+				}
+				for(unsigned int i = node.m_Child[s]; i < node.m_Child[s] + node.m_Count[s]; i++)
+				{
+					if(objectTest(m_Objects[i]))
+						results.push_back(m_Objects[i]);
+				}
+			}
+		}
+	}
+
+	//slab test, t is the entry distance (0 if the origin is inside)
+	static inline bool rayBox(const glm::vec3& minimum, const glm::vec3& maximum, const glm::vec3& origin, const glm::vec3& inverse, float maxDistance, float& t)
+	{
+		glm::vec3 t0 = (minimum - origin) * inverse, t1 = (maximum - origin) * inverse;
+		glm::vec3 tNear = glm::min(t0, t1), tFar = glm::max(t0, t1);
+		float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+		float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+		t = enter;
+		return enter <= exit;
+	}
+	//a bit per slot whose box the ray enters before maxDistance, with the entry distances
+	static inline unsigned int intersectRay(const BVHNode& node, const glm::vec3& origin, const glm::vec3& inverse, float maxDistance, float distances[4])
+	{
+#ifdef BVH_USE_SSE
+		__m128 originX = _mm_set1_ps(origin.x), originY = _mm_set1_ps(origin.y), originZ = _mm_set1_ps(origin.z);
+		__m128 inverseX = _mm_set1_ps(inverse.x), inverseY = _mm_set1_ps(inverse.y), inverseZ = _mm_set1_ps(inverse.z);
+		__m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.m_MinX), originX), inverseX), t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.m_MaxX), originX), inverseX);
+		__m128 enter = _mm_max_ps(_mm_min_ps(t0, t1), _mm_setzero_ps());
+		__m128 exit = _mm_min_ps(_mm_max_ps(t0, t1), _mm_set1_ps(maxDistance));
+		t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.m_MinY), originY), inverseY);
+		t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.m_MaxY), originY), inverseY);
+		enter = _mm_max_ps(enter, _mm_min_ps(t0, t1));
+		exit = _mm_min_ps(exit, _mm_max_ps(t0, t1));
+		t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.m_MinZ), originZ), inverseZ);
+		t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.m_MaxZ), originZ), inverseZ);
+		enter = _mm_max_ps(enter, _mm_min_ps(t0, t1));
+		exit = _mm_min_ps(exit, _mm_max_ps(t0, t1));
+		_mm_storeu_ps(distances, enter);
+		return (unsigned int)_mm_movemask_ps(_mm_cmple_ps(enter, exit));
+#else
+		unsigned int mask = 0;
+		for(unsigned int s = 0; s < 4; s++)
+		{
+			if(rayBox(glm::vec3(node.m_MinX[s], node.m_MinY[s], node.m_MinZ[s]), glm::vec3(node.m_MaxX[s], node.m_MaxY[s], node.m_MaxZ[s]), origin, inverse, maxDistance, distances[s]))
+				mask |= 1u << s;
+		}
+		return mask;
+#endif
+	}
+	static inline unsigned int overlapBox(const BVHNode& node, const glm::vec3& minimum, const glm::vec3& maximum)
+	{
+#ifdef BVH_USE_SSE
+		__m128 overlap = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(node.m_MinX), _mm_set1_ps(maximum.x)), _mm_cmpge_ps(_mm_loadu_ps(node.m_MaxX), _mm_set1_ps(minimum.x)));
+		overlap = _mm_and_ps(overlap, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(node.m_MinY), _mm_set1_ps(maximum.y)), _mm_cmpge_ps(_mm_loadu_ps(node.m_MaxY), _mm_set1_ps(minimum.y))));
+		overlap = _mm_and_ps(overlap, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(node.m_MinZ), _mm_set1_ps(maximum.z)), _mm_cmpge_ps(_mm_loadu_ps(node.m_MaxZ), _mm_set1_ps(minimum.z))));
+		return (unsigned int)_mm_movemask_ps(overlap);
+#else
+		unsigned int mask = 0;
+		for(unsigned int s = 0; s < 4; s++)
+		{
+			if(node.m_MinX[s] <= maximum.x && node.m_MaxX[s] >= minimum.x && node.m_MinY[s] <= maximum.y && node.m_MaxY[s] >= minimum.y && node.m_MinZ[s] <= maximum.z && node.m_MaxZ[s] >= minimum.z)
+				mask |= 1u << s;
+		}
+		return mask;
+#endif
+	}
+	static inline unsigned int overlapSphere(const BVHNode& node, const glm::vec3& center, float radius)
+	{
+#ifdef BVH_USE_SSE
+		__m128 zero = _mm_setzero_ps();
+		__m128 centerX = _mm_set1_ps(center.x), centerY = _mm_set1_ps(center.y), centerZ = _mm_set1_ps(center.z);
+		__m128 x = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(node.m_MinX), centerX), _mm_sub_ps(centerX, _mm_loadu_ps(node.m_MaxX))), zero);
+		__m128 y = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(node.m_MinY), centerY), _mm_sub_ps(centerY, _mm_loadu_ps(node.m_MaxY))), zero);
+		__m128 z = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(node.m_MinZ), centerZ), _mm_sub_ps(centerZ, _mm_loadu_ps(node.m_MaxZ))), zero);
+		__m128 distance2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+		return (unsigned int)_mm_movemask_ps(_mm_cmple_ps(distance2, _mm_set1_ps(radius * radius)));
+#else
+		unsigned int mask = 0;
+		for(unsigned int s = 0; s < 4; s++)
+		{
+			glm::vec3 offset = glm::max(glm::max(glm::vec3(node.m_MinX[s], node.m_MinY[s], node.m_MinZ[s]) - center, center - glm::vec3(node.m_MaxX[s], node.m_MaxY[s], node.m_MaxZ[s])), glm::vec3(0.0f));
+			if(glm::dot(offset, offset) <= radius * radius)
+				mask |= 1u << s;
+		}
+		return mask;
+#endif
+	}
+};
+
+#endif
@@ -170,12 +170,13 @@ public:
 		delete m_DownSampleShader;
 		delete m_UpSampleShader;
 	}
-	void RenderBloomTexture(unsigned int srcTexture, float filterRadius)
+	//viewportScale is the fraction of srcTexture that holds the image (dynamic resolution), every mip only uses the same fraction of itself
+	void RenderBloomTexture(unsigned int srcTexture, float filterRadius, glm::vec2 viewportScale = glm::vec2(1.0f))
 	{
 		m_FBO.use();
 
-		this->RenderDownSamples(srcTexture);
-		this->RenderUpSamples(filterRadius);
+		this->RenderDownSamples(srcTexture, viewportScale);
+		this->RenderUpSamples(filterRadius, viewportScale);
 
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 		//restore viewport to default
@@ -195,11 +196,12 @@ public:
 			return -1;
 	}
 private:
-	void RenderDownSamples(unsigned int srcTexture)
+	void RenderDownSamples(unsigned int srcTexture, glm::vec2 viewportScale)
 	{
 		const std::vector<BloomMip>& mipChain = m_FBO.MipChain();
 
 		m_DownSampleShader->use();
+		m_DownSampleShader->setVec2("viewportScale", viewportScale);
 		m_DownSampleShader->setVec2("srcResolution", m_SrcViewPortSize);
 		if(m_KarisAverage)
 			m_DownSampleShader->setInt("mipLevel", 0);
@@ -210,7 +212,7 @@ private:
 		for(unsigned int i = 0; i < mipChain.size() - 1; i++)
 		{
 			const BloomMip& mip = mipChain[i];
-			glViewport(0, 0, mip.size.x, mip.size.y);
+			glViewport(0, 0, (int)(mip.size.x * viewportScale.x + 0.5f), (int)(mip.size.y * viewportScale.y + 0.5f));
 			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mip.texture, 0);
 
 			//renders current mip onto screen quad
@@ -226,11 +228,12 @@ private:
 
 		glUseProgram(0);
 	}
-	void RenderUpSamples(float filterRadius)
+	void RenderUpSamples(float filterRadius, glm::vec2 viewportScale)
 	{
 		const std::vector<BloomMip>& mipChain = m_FBO.MipChain();
 
 		m_UpSampleShader->use();
+		m_UpSampleShader->setVec2("viewportScale", viewportScale);
 
 		//additive blending
 		glEnable(GL_BLEND);
@@ -247,7 +250,7 @@ private:
 			glBindTexture(GL_TEXTURE_2D, mip.texture);
 
 			//set size of the viewport to nextMip because we are rendering to this resolution (we are upscaling)
-			glViewport(0, 0, nextMip.size.x, nextMip.size.y);
+			glViewport(0, 0, (int)(nextMip.size.x * viewportScale.x + 0.5f), (int)(nextMip.size.y * viewportScale.y + 0.5f));
 			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, nextMip.texture, 0);
 
 			//renders current mip onto screen quad
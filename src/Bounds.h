@@ -0,0 +1,145 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define BOUNDS_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+//axis aligned box, empty (min > max) until something is added to it
+struct BoundingBox
+{
+	glm::vec3 m_Min;
+	glm::vec3 m_Max;
+
+	BoundingBox()
+		:m_Min(FLT_MAX), m_Max(-FLT_MAX)
+	{
+
+	}
+	BoundingBox(glm::vec3 minimum, glm::vec3 maximum)
+		:m_Min(minimum), m_Max(maximum)
+	{
+
+	}
+
+	inline bool IsEmpty() const { return m_Min.x > m_Max.x; }
+	inline glm::vec3 Center() const { return (m_Min + m_Max) * 0.5f; }
+	inline glm::vec3 Extent() const { return (m_Max - m_Min) * 0.5f; }
+	inline void Add(const glm::vec3& point) { m_Min = glm::min(m_Min, point); m_Max = glm::max(m_Max, point); }
+	inline void Add(const BoundingBox& box) { m_Min = glm::min(m_Min, box.m_Min); m_Max = glm::max(m_Max, box.m_Max); }
+
+	//the box around this box after the transform, from its center and the absolute matrix applied to its extents
+	BoundingBox Transformed(const glm::mat4& matrix) const
+	{
+		if(IsEmpty())
+			return *this;
+		glm::vec3 center = glm::vec3(matrix * glm::vec4(Center(), 1.0f));
+		glm::vec3 extent = Extent();
+		glm::vec3 worldExtent = glm::abs(glm::vec3(matrix[0])) * extent.x + glm::abs(glm::vec3(matrix[1])) * extent.y + glm::abs(glm::vec3(matrix[2])) * extent.z;
+		return BoundingBox(center - worldExtent, center + worldExtent);
+	}
+};
+
+//negative radius while empty
+struct BoundingSphere
+{
+	glm::vec3 m_Center;
+	float m_Radius;
+
+	BoundingSphere()
+		:m_Center(0.0f), m_Radius(-1.0f)
+	{
+
+	}
+	BoundingSphere(glm::vec3 center, float radius)
+		:m_Center(center), m_Radius(radius)
+	{
+
+	}
+
+	inline bool IsEmpty() const { return m_Radius < 0.0f; }
+
+	//the radius grows by the largest scale of the matrix so the sphere stays conservative under non-uniform scaling
+	BoundingSphere Transformed(const glm::mat4& matrix) const
+	{
+		if(IsEmpty())
+			return *this;
+		float scale = std::sqrt(std::max(glm::dot(glm::vec3(matrix[0]), glm::vec3(matrix[0])), std::max(glm::dot(glm::vec3(matrix[1]), glm::vec3(matrix[1])), glm::dot(glm::vec3(matrix[2]), glm::vec3(matrix[2])))));
+		return BoundingSphere(glm::vec3(matrix * glm::vec4(m_Center, 1.0f)), m_Radius * scale);
+	}
+};
+
+//Box and sphere around count points that are stride floats apart, e.g. the positions in an array of vertices.
+//The sphere is centered on the box, which is cheaper than the minimal sphere and only a little larger for typical meshes.
+//4 points are transposed into x, y and z registers at a time, so every min/max/distance instruction covers 4 points.
+//Each point is read as 4 floats, a packed last point (stride 3) is left to the scalar loop so nothing past the array is read.
+inline void ComputeBounds(const float* positions, unsigned int count, unsigned int stride, BoundingBox& box, BoundingSphere& sphere)
+{
+	box = BoundingBox();
+	sphere = BoundingSphere();
+	if(count == 0)
+		return;
+
+	unsigned int i = 0;
+#ifdef BOUNDS_USE_SSE
+	if(count >= 4)
+	{
+		__m128 minX = _mm_set1_ps(FLT_MAX), minY = minX, minZ = minX;
+		__m128 maxX = _mm_set1_ps(-FLT_MAX), maxY = maxX, maxZ = maxX;
+		for(; i + 4 <= count && (stride >= 4 || i + 4 < count); i += 4)
+		{
+			__m128 x = _mm_loadu_ps(positions + (size_t)i * stride), y = _mm_loadu_ps(positions + (size_t)(i + 1) * stride);
+			__m128 z = _mm_loadu_ps(positions + (size_t)(i + 2) * stride), w = _mm_loadu_ps(positions + (size_t)(i + 3) * stride);
+			_MM_TRANSPOSE4_PS(x, y, z, w);
+			minX = _mm_min_ps(minX, x); minY = _mm_min_ps(minY, y); minZ = _mm_min_ps(minZ, z);
+			maxX = _mm_max_ps(maxX, x); maxY = _mm_max_ps(maxY, y); maxZ = _mm_max_ps(maxZ, z);
+		}
+		float lanes[6][4];
+		_mm_storeu_ps(lanes[0], minX); _mm_storeu_ps(lanes[1], minY); _mm_storeu_ps(lanes[2], minZ);
+		_mm_storeu_ps(lanes[3], maxX); _mm_storeu_ps(lanes[4], maxY); _mm_storeu_ps(lanes[5], maxZ);
+		for(unsigned int l = 0; l < 4 && i > 0; l++)
+		{
+			box.Add(glm::vec3(lanes[0][l], lanes[1][l], lanes[2][l]));
+			box.Add(glm::vec3(lanes[3][l], lanes[4][l], lanes[5][l]));
+		}
+	}
+#endif
+	for(; i < count; i++)
+		box.Add(glm::vec3(positions[(size_t)i * stride], positions[(size_t)i * stride + 1], positions[(size_t)i * stride + 2]));
+
+	glm::vec3 center = box.Center();
+	float radius2 = 0.0f;
+	i = 0;
+#ifdef BOUNDS_USE_SSE
+	if(count >= 4)
+	{
+		__m128 centerX = _mm_set1_ps(center.x), centerY = _mm_set1_ps(center.y), centerZ = _mm_set1_ps(center.z);
+		__m128 maxDistance2 = _mm_setzero_ps();
+		for(; i + 4 <= count && (stride >= 4 || i + 4 < count); i += 4)
+		{
+			__m128 x = _mm_loadu_ps(positions + (size_t)i * stride), y = _mm_loadu_ps(positions + (size_t)(i + 1) * stride);
+			__m128 z = _mm_loadu_ps(positions + (size_t)(i + 2) * stride), w = _mm_loadu_ps(positions + (size_t)(i + 3) * stride);
+			_MM_TRANSPOSE4_PS(x, y, z, w);
+			x = _mm_sub_ps(x, centerX); y = _mm_sub_ps(y, centerY); z = _mm_sub_ps(z, centerZ);
+			maxDistance2 = _mm_max_ps(maxDistance2, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+		}
+		float lanes[4];
+		_mm_storeu_ps(lanes, maxDistance2);
+		radius2 = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+	}
+#endif
+	for(; i < count; i++)
+	{
+		glm::vec3 offset = glm::vec3(positions[(size_t)i * stride], positions[(size_t)i * stride + 1], positions[(size_t)i * stride + 2]) - center;
+		radius2 = std::max(radius2, glm::dot(offset, offset));
+	}
+	sphere = BoundingSphere(center, std::sqrt(radius2));
+}
+
+#endif
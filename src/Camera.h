@@ -22,6 +22,7 @@ const float PITCH = 0.0f;
 const float SPEED = 4.0f;
 const float SENSITIVITY = 0.1f;
 const float ZOOM = 75.0f;
+const unsigned int JITTER_SAMPLES = 8; //length of the Halton(2, 3) sequence used for sub-pixel jitter
 
 class Camera
 {
@@ -39,10 +40,13 @@ public:
 	float MovementSpeed;
 	float MouseSensitivity;
 	float Zoom;
+	//sub-pixel jitter (in NDC units) applied to the projection matrix for temporal anti-aliasing
+	glm::vec2 Jitter;
+	unsigned int JitterIndex;
 
 	//constructor to initialize all values of the camera object
 	Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = YAW, float pitch = PITCH)
-		: Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM)
+		: Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM), Jitter(0.0f), JitterIndex(0)
 	{
 		Position = position;
 		WorldUp = up;
@@ -52,7 +56,7 @@ public:
 	}
 	//Constructor with scalar values
 	Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch)
-		: Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM)
+		: Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM), Jitter(0.0f), JitterIndex(0)
 	{
 		Position = glm::vec3(posX, posY, posZ);
 		WorldUp = glm::vec3(upX, upY, upZ);
@@ -65,6 +69,49 @@ public:
 	{
 		return glm::lookAt(Position, Position + Front, Up);
 	}
+	//returns the perspective projection matrix, offset by the current sub-pixel jitter if jittered is true
+	glm::mat4 GetProjectionMatrix(float aspectRatio, float nearPlane, float farPlane, bool jittered = false)
+	{
+		glm::mat4 projection = glm::perspective(glm::radians(Zoom), aspectRatio, nearPlane, farPlane);
+		if(jittered)
+		{
+			projection[2][0] += Jitter.x;
+			projection[2][1] += Jitter.y;
+		}
+		return projection;
+	}
+	//planes of the un-jittered view frustum, see ExtractFrustumPlanes
+	void GetFrustumPlanes(float aspectRatio, float nearPlane, float farPlane, glm::vec4 planes[6])
+	{
+		ExtractFrustumPlanes(GetProjectionMatrix(aspectRatio, nearPlane, farPlane) * GetViewMatrix(), planes);
+	}
+	//the left, right, bottom, top, near and far planes of any view projection matrix (Gribb/Hartmann) as (normal, distance),
+	//normalized and pointing inwards so dot(normal, p) + distance is the signed distance of p to the plane
+	static void ExtractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6])
+	{
+		glm::mat4 m = glm::transpose(viewProjection);
+		planes[0] = m[3] + m[0];
+		planes[1] = m[3] - m[0];
+		planes[2] = m[3] + m[1];
+		planes[3] = m[3] - m[1];
+		planes[4] = m[3] + m[2];
+		planes[5] = m[3] - m[2];
+		for(unsigned int i = 0; i < 6; i++)
+			planes[i] /= glm::length(glm::vec3(planes[i]));
+	}
+
+	//advances the jitter to the next sample of the Halton(2, 3) sequence, scaled to one pixel of a width x height render target
+	void UpdateJitter(unsigned int width, unsigned int height)
+	{
+		JitterIndex = (JitterIndex % JITTER_SAMPLES) + 1;
+		Jitter.x = (Halton(JitterIndex, 2) - 0.5f) * 2.0f / (float)width;
+		Jitter.y = (Halton(JitterIndex, 3) - 0.5f) * 2.0f / (float)height;
+	}
+	void ResetJitter()
+	{
+		Jitter = glm::vec2(0.0f);
+		JitterIndex = 0;
+	}
 
 	void ProcessKeyboard(CameraMovement direction, float deltaTime)
 	{
@@ -113,6 +160,20 @@ public:
 	}
 
 private:
+	//radical inverse of index in the given base, values are in the range [0, 1)
+	static float Halton(unsigned int index, unsigned int base)
+	{
+		float f = 1.0f;
+		float result = 0.0f;
+		while(index > 0)
+		{
+			f /= (float)base;
+			result += f * (float)(index % base);
+			index /= base;
+		}
+		return result;
+	}
+
 	void updateCameraVectors()
 	{
 		glm::vec3 front;
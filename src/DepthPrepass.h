@@ -0,0 +1,151 @@
+#ifndef DEPTH_PREPASS_H
+#define DEPTH_PREPASS_H
+
+#include <vector>
+#include <cmath>
+#include <glm/glm.hpp>
+#include <src/shader.h>
+#include <src/DrawList.h>
+
+#define DEPTH_PREPASS_TILES_X 32 //resolution of the coverage grid of the overdraw estimate
+#define DEPTH_PREPASS_TILES_Y 18
+#define DEPTH_PREPASS_DEFAULT_THRESHOLD 2.0f
+
+enum DepthPrepassMode
+{
+	DEPTH_PREPASS_OFF = 0,
+	DEPTH_PREPASS_ON,
+	DEPTH_PREPASS_AUTO,
+	NR_OF_DEPTH_PREPASS_MODES
+};
+
+//Depth-only pass before the G-buffer pass. The objects are drawn with a position only vertex stream and no color writes,
+//then the G-buffer pass runs with GL_EQUAL and depth writes off, so the G-buffer shader only runs for the visible fragment of every pixel.
+//Both passes have to produce bit identical depths, which is why GBuffer.V.shader and DepthPrepass.V.shader declare gl_Position invariant.
+//In auto mode the pre-pass runs when the estimated depth complexity of the frame is at or above m_Threshold.
+class DepthPrepass
+{
+public:
+	DepthPrepassMode m_Mode;
+	float m_Threshold; //layers per covered pixel above which the pre-pass is expected to pay off
+
+	DepthPrepass()
+		:m_Init(0), m_Mode(DEPTH_PREPASS_AUTO), m_Threshold(DEPTH_PREPASS_DEFAULT_THRESHOLD), m_Shader(nullptr), m_DepthComplexity(0.0f), m_Active(0)
+	{
+
+	}
+	~DepthPrepass()
+	{
+
+	}
+
+	bool Init()
+	{
+		if(m_Init) return 1;
+		m_Shader = new Shader("ProgramFiles\\Resources\\Shaders\\DepthPrepass.V.shader", "ProgramFiles\\Resources\\Shaders\\DepthPrepass.F.shader");
+		m_Init = 1;
+		return 1;
+	}
+	void Destroy()
+	{
+		if(m_Shader)
+		{
+			m_Shader->destroy();
+			delete m_Shader;
+			m_Shader = nullptr;
+		}
+		m_Init = 0;
+	}
+
+	//estimates the depth complexity of the culled draw list and decides whether this frame gets a pre-pass
+	bool Decide(const DrawList& drawList, const glm::mat4& viewProjection, const glm::mat4& projection)
+	{
+		m_DepthComplexity = estimateDepthComplexity(drawList, viewProjection, projection);
+		if(m_Mode == DEPTH_PREPASS_AUTO)
+			m_Active = m_DepthComplexity >= m_Threshold;
+		else
+			m_Active = m_Mode == DEPTH_PREPASS_ON;
+		return m_Active;
+	}
+
+	//the G-buffer's framebuffer has to be bound and cleared, the caller draws the objects with the position only streams after this
+	Shader& Begin(const glm::mat4& view, const glm::mat4& projection)
+	{
+		glEnable(GL_DEPTH_TEST);
+		glDepthFunc(GL_LESS);
+		glDepthMask(GL_TRUE);
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		m_Shader->use();
+		m_Shader->setMat4("view", view);
+		m_Shader->setMat4("projection", projection);
+		return *m_Shader;
+	}
+	//restores the color writes and sets up the depth test for the G-buffer pass
+	void End()
+	{
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		glDepthFunc(GL_EQUAL);
+		glDepthMask(GL_FALSE);
+	}
+	//call after the G-buffer pass of a frame that had a pre-pass
+	void Restore()
+	{
+		glDepthFunc(GL_LESS);
+		glDepthMask(GL_TRUE);
+	}
+
+	inline bool Active() const { return m_Active; }
+	inline float DepthComplexity() const { return m_DepthComplexity; }
+	static const char* ModeName(DepthPrepassMode mode)
+	{
+		static const char* names[NR_OF_DEPTH_PREPASS_MODES] = { "Off", "On", "Auto" };
+		return names[mode];
+	}
+
+private:
+	bool m_Init;
+	Shader* m_Shader;
+	float m_DepthComplexity;
+	bool m_Active;
+
+	//splats the screen rectangles of the bounding spheres into a coarse grid and returns the average number of layers of the covered
+	//tiles. closed meshes are counted twice when back faces aren't culled, the back half is rasterized behind the front half
+	float estimateDepthComplexity(const DrawList& drawList, const glm::mat4& viewProjection, const glm::mat4& projection)
+	{
+		unsigned int tiles[DEPTH_PREPASS_TILES_X * DEPTH_PREPASS_TILES_Y] = {};
+		unsigned int layers = glIsEnabled(GL_CULL_FACE) ? 1 : 2;
+		const std::vector<DrawItem>& items = drawList.Items();
+		for(unsigned int i = 0; i < items.size(); i++)
+		{
+			const DrawItem& item = items[i];
+			int x0 = 0, y0 = 0, x1 = DEPTH_PREPASS_TILES_X - 1, y1 = DEPTH_PREPASS_TILES_Y - 1;
+			//spheres crossing the near plane may cover the whole screen
+			if(item.m_ViewDepth - item.m_Radius > 0.0f)
+			{
+				glm::vec4 clip = viewProjection * glm::vec4(item.m_Center, 1.0f);
+				glm::vec2 center = glm::vec2(clip) / clip.w;
+				//projected radius, widened a bit because off-center spheres project to ellipses
+				glm::vec2 extent = glm::vec2(projection[0][0], projection[1][1]) * item.m_Radius * 1.2f / item.m_ViewDepth;
+				glm::vec2 minimum = (center - extent) * 0.5f + 0.5f;
+				glm::vec2 maximum = (center + extent) * 0.5f + 0.5f;
+				x0 = glm::clamp((int)std::floor(minimum.x * DEPTH_PREPASS_TILES_X), 0, DEPTH_PREPASS_TILES_X);
+				y0 = glm::clamp((int)std::floor(minimum.y * DEPTH_PREPASS_TILES_Y), 0, DEPTH_PREPASS_TILES_Y);
+				x1 = glm::clamp((int)std::floor(maximum.x * DEPTH_PREPASS_TILES_X), -1, DEPTH_PREPASS_TILES_X - 1);
+				y1 = glm::clamp((int)std::floor(maximum.y * DEPTH_PREPASS_TILES_Y), -1, DEPTH_PREPASS_TILES_Y - 1);
+			}
+			for(int y = y0; y <= y1; y++)
+				for(int x = x0; x <= x1; x++)
+					tiles[y * DEPTH_PREPASS_TILES_X + x] += layers;
+		}
+
+		unsigned int covered = 0, total = 0;
+		for(unsigned int i = 0; i < DEPTH_PREPASS_TILES_X * DEPTH_PREPASS_TILES_Y; i++)
+		{
+			covered += tiles[i] > 0 ? 1 : 0;
+			total += tiles[i];
+		}
+		return covered > 0 ? (float)total / (float)covered : 0.0f;
+	}
+};
+
+#endif
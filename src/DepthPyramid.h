@@ -0,0 +1,155 @@
+#ifndef DEPTH_PYRAMID_H
+#define DEPTH_PYRAMID_H
+
+#include <glm/glm.hpp>
+#include <src/shader.h>
+
+void renderQuad();
+
+//what a cell of a level keeps of the 2x2 cells below it
+enum DepthPyramidReduction
+{
+	DEPTH_PYRAMID_MIN = 0, //nearest depth, for tracing rays past empty space (SSR)
+	DEPTH_PYRAMID_MAX, //farthest depth, anything behind it is hidden in the whole cell (occlusion culling)
+	NR_OF_DEPTH_PYRAMID_REDUCTIONS
+};
+
+//A hierarchical depth pyramid (Hi-Z) in the mips of an R32F texture, level 0 a copy of the depth buffer and every level above
+//the min or max of the 2x2 cells below. Every level halves the previous one rounding up, so each cell covers exactly 2x2 cells of the level below.
+//The texture is allocated with power of two sizes so the rounded up levels of any render size fit into the mips.
+class DepthPyramid
+{
+public:
+	DepthPyramid()
+		:m_Init(0), m_ID(0), m_Texture(0), m_Width(0), m_Height(0), m_Levels(0), m_Reduction(DEPTH_PYRAMID_MIN), m_Shader(nullptr)
+	{
+
+	}
+	~DepthPyramid()
+	{
+
+	}
+
+	//width and height are the largest render size
+	bool Init(unsigned int width, unsigned int height, DepthPyramidReduction reduction)
+	{
+		if(m_Init) return 1;
+
+		m_Reduction = reduction;
+		m_Width = 1;
+		m_Height = 1;
+		while(m_Width < width) m_Width *= 2;
+		while(m_Height < height) m_Height *= 2;
+		m_Levels = 1;
+		while((m_Width >> (m_Levels - 1)) > 1 || (m_Height >> (m_Levels - 1)) > 1)
+			m_Levels++;
+
+		glGenTextures(1, &m_Texture);
+		glBindTexture(GL_TEXTURE_2D, m_Texture);
+		for(unsigned int i = 0; i < m_Levels; i++)
+			glTexImage2D(GL_TEXTURE_2D, i, GL_R32F, glm::max(m_Width >> i, 1u), glm::max(m_Height >> i, 1u), 0, GL_RED, GL_FLOAT, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_Levels - 1);
+
+		glGenFramebuffers(1, &m_ID);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_ID);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_Texture, 0);
+		unsigned int attachments[1] = { GL_COLOR_ATTACHMENT0 };
+		glDrawBuffers(1, attachments);
+		int status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		if(status != GL_FRAMEBUFFER_COMPLETE)
+		{
+			printf("DEPTH PYRAMID FRAMEBUFFER ERROR! \nStatus: 0x%x\n", status);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			return 0;
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		m_Shader = new Shader("ProgramFiles\\Resources\\Shaders\\DepthPyramid\\DepthPyramid.V.shader", "ProgramFiles\\Resources\\Shaders\\DepthPyramid\\DepthPyramid.F.shader");
+		m_Shader->use();
+		m_Shader->setInt("source", 0);
+		m_Shader->setBool("farthest", m_Reduction == DEPTH_PYRAMID_MAX);
+		glUseProgram(0);
+
+		m_Init = 1;
+		return 1;
+	}
+	void Destroy()
+	{
+		glDeleteTextures(1, &m_Texture);
+		glDeleteFramebuffers(1, &m_ID);
+		if(m_Shader)
+		{
+			m_Shader->destroy();
+			delete m_Shader;
+		}
+		m_Shader = nullptr;
+		m_Texture = 0;
+		m_ID = 0;
+		m_Init = 0;
+	}
+
+	//copies the depth into level 0 and reduces it level by level, returns the number of levels covering renderSize.
+	//leaves depth testing on and the default framebuffer bound, the viewport is whatever the last level needed
+	unsigned int Build(unsigned int depthTexture, glm::ivec2 renderSize)
+	{
+		glDisable(GL_DEPTH_TEST);
+		glDisable(GL_BLEND);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_ID);
+		m_Shader->use();
+		glm::ivec2 size = renderSize, previousSize = renderSize;
+		unsigned int level = 0;
+		while(true)
+		{
+			//the level that is read is the only one visible to the shader, so reading and writing the same texture isn't a feedback loop
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_Texture, level);
+			glViewport(0, 0, size.x, size.y);
+			glActiveTexture(GL_TEXTURE0);
+			if(level == 0)
+			{
+				glBindTexture(GL_TEXTURE_2D, depthTexture);
+				m_Shader->setVec2("sourceSize", glm::vec2(renderSize));
+				m_Shader->setBool("reduce", 0);
+			}
+			else
+			{
+				glBindTexture(GL_TEXTURE_2D, m_Texture);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - 1);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1);
+				m_Shader->setVec2("sourceSize", glm::vec2(previousSize));
+				m_Shader->setBool("reduce", 1);
+			}
+			renderQuad();
+
+			if((size.x == 1 && size.y == 1) || level + 1 >= m_Levels)
+				break;
+			previousSize = size;
+			size = glm::ivec2((size.x + 1) / 2, (size.y + 1) / 2);
+			level++;
+		}
+		glBindTexture(GL_TEXTURE_2D, m_Texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_Levels - 1);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glEnable(GL_DEPTH_TEST);
+		return level + 1;
+	}
+
+	inline unsigned int Texture() const { return m_Texture; }
+	//of the whole texture, Build returns how many of them cover a render size
+	inline unsigned int NrOfLevels() const { return m_Levels; }
+
+private:
+	bool m_Init;
+	unsigned int m_ID;
+	unsigned int m_Texture;
+	unsigned int m_Width, m_Height, m_Levels;
+	DepthPyramidReduction m_Reduction;
+	Shader* m_Shader;
+};
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef DRAW_LIST_H
+#define DRAW_LIST_H
+
+#include <vector>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <src/FrustumCuller.h>
+
+struct DrawItem
+{
+	unsigned int m_Object; //index of the object the caller draws for this item
+	glm::vec3 m_Center; //world space bounding sphere
+	float m_Radius;
+	float m_ViewDepth; //distance of the bounding sphere's center in front of the camera
+};
+
+//Objects submitted for a camera pass: the ones whose bounding spheres are outside the view frustum are dropped
+//and the rest are sorted front to back, so the depth test rejects as many occluded fragments as possible.
+//The same list feeds the depth pre-pass and the G-buffer pass.
+class DrawList
+{
+public:
+	DrawList()
+		:m_NrOfCulled(0), m_NrOfOccluded(0)
+	{
+
+	}
+
+	void Clear()
+	{
+		m_Items.clear();
+		m_NrOfCulled = 0;
+		m_NrOfOccluded = 0;
+	}
+
+	//culls the spheres of bounds, the object of an item is the index of its sphere.
+	//viewProjection should be the un-jittered one, the frustum planes are extracted from it
+	void CullAndSort(const FrustumCuller& bounds, const glm::mat4& view, const glm::mat4& viewProjection)
+	{
+		Clear();
+		bounds.Cull(viewProjection, m_Visible);
+		for(unsigned int i = 0; i < bounds.Size(); i++)
+		{
+			if(FrustumCuller::Visible(m_Visible, i))
+				addItem(i, bounds, view);
+		}
+		m_NrOfCulled = bounds.Size() - (unsigned int)m_Items.size();
+		sortItems();
+	}
+	//sorts the objects a view that was already culled sees, e.g. by SceneJobs::Update().
+	//objectOfID maps the transform IDs in its m_Visible to the objects' indices in bounds, IDs of anything else are skipped
+	void Sort(const CullView& culled, const std::vector<unsigned int>& objectOfID, const FrustumCuller& bounds, const glm::mat4& view)
+	{
+		const std::vector<unsigned int>& visible = culled.m_Visible;
+		Clear();
+		for(unsigned int i = 0; i < visible.size(); i++)
+		{
+			unsigned int object = CullView::Object(objectOfID, visible[i]);
+			if(object < bounds.Size())
+				addItem(object, bounds, view);
+		}
+		m_NrOfCulled = bounds.Size() - (unsigned int)m_Items.size();
+		sortItems();
+	}
+
+	//drops the items whose object has no bit set in visible, e.g. the result of OcclusionCuller::Test(), the order stays front to back
+	void RemoveOccluded(const std::vector<unsigned int>& visible)
+	{
+		unsigned int size = (unsigned int)m_Items.size();
+		m_Items.erase(std::remove_if(m_Items.begin(), m_Items.end(), [&visible](const DrawItem& item) { return !FrustumCuller::Visible(visible, item.m_Object); }), m_Items.end());
+		m_NrOfOccluded += size - (unsigned int)m_Items.size();
+	}
+
+	inline const std::vector<DrawItem>& Items() const { return m_Items; }
+	inline unsigned int NrOfCulled() const { return m_NrOfCulled; }
+	inline unsigned int NrOfOccluded() const { return m_NrOfOccluded; }
+
+private:
+	std::vector<DrawItem> m_Items;
+	std::vector<unsigned int> m_Visible; //one bit per sphere
+	unsigned int m_NrOfCulled;
+	unsigned int m_NrOfOccluded;
+
+	void addItem(unsigned int object, const FrustumCuller& bounds, const glm::mat4& view)
+	{
+		DrawItem item;
+		item.m_Object = object;
+		item.m_Center = bounds.Center(object);
+		item.m_Radius = bounds.Radius(object);
+		item.m_ViewDepth = -(view * glm::vec4(item.m_Center, 1.0f)).z;
+		m_Items.push_back(item);
+	}
+	void sortItems()
+	{
+		std::sort(m_Items.begin(), m_Items.end(), [](const DrawItem& a, const DrawItem& b) { return a.m_ViewDepth < b.m_ViewDepth; });
+	}
+};
+
+#endif
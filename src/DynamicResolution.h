@@ -0,0 +1,150 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#define DRS_QUERY_COUNT 4 //number of frames the GPU timings are allowed to lag behind before a frame is skipped
+#define DRS_DEFAULT_TARGET_FRAME_TIME 16.6f //milliseconds
+#define DRS_SCALE_STEP 0.05f //largest change of the render scale per adjustment
+#define DRS_COOLDOWN_FRAMES 8 //frames to wait after changing the scale so the new timings can settle
+
+//Adjusts the internal render resolution to hold a target GPU frame time.
+//The GPU time of each frame is measured with GL_TIME_ELAPSED queries that are read back a few frames later, so it never stalls.
+//Render targets are allocated once at the maximum size, the render scale only changes the viewport that is rendered to.
+class DynamicResolution
+{
+public:
+	bool m_Enabled;
+	float m_Scale; //fraction of the output width/height that is rendered
+	float m_MinScale, m_MaxScale;
+	float m_TargetFrameTime; //in milliseconds
+
+	DynamicResolution(float minScale = 0.5f, float maxScale = 1.0f, float targetFrameTime = DRS_DEFAULT_TARGET_FRAME_TIME)
+		:m_Init(0), m_Enabled(1), m_Scale(maxScale), m_MinScale(minScale), m_MaxScale(maxScale), m_TargetFrameTime(targetFrameTime),
+		 m_MaxWidth(0), m_MaxHeight(0), m_FrameIndex(0), m_QueryActive(0), m_GPUFrameTime(0.0f), m_FramesSinceChange(0)
+	{
+
+	}
+	~DynamicResolution()
+	{
+
+	}
+
+	//maxWidth and maxHeight are the size the render targets were allocated with
+	bool Init(unsigned int maxWidth, unsigned int maxHeight)
+	{
+		if(m_Init) return 1;
+
+		m_MaxWidth = maxWidth;
+		m_MaxHeight = maxHeight;
+
+		glGenQueries(DRS_QUERY_COUNT, m_Queries);
+		for(unsigned int i = 0; i < DRS_QUERY_COUNT; i++)
+			m_QueryPending[i] = 0;
+
+		m_Init = 1;
+		return 1;
+	}
+	void Destroy()
+	{
+		glDeleteQueries(DRS_QUERY_COUNT, m_Queries);
+		m_Init = 0;
+	}
+
+	//starts timing the GPU work of this frame, skipped if the query for this slot hasn't been read back yet
+	void BeginFrame()
+	{
+		unsigned int index = m_FrameIndex % DRS_QUERY_COUNT;
+		if(m_QueryPending[index])
+		{
+			m_QueryActive = 0;
+			return;
+		}
+		glBeginQuery(GL_TIME_ELAPSED, m_Queries[index]);
+		m_QueryActive = 1;
+	}
+	//stops timing this frame and reads back any finished queries of previous frames to update the render scale
+	void EndFrame()
+	{
+		if(m_QueryActive)
+		{
+			glEndQuery(GL_TIME_ELAPSED);
+			m_QueryPending[m_FrameIndex % DRS_QUERY_COUNT] = 1;
+			m_QueryActive = 0;
+		}
+		m_FrameIndex++;
+		m_FramesSinceChange++;
+
+		//oldest query first
+		for(unsigned int i = 0; i < DRS_QUERY_COUNT; i++)
+		{
+			unsigned int index = (m_FrameIndex + i) % DRS_QUERY_COUNT;
+			if(!m_QueryPending[index])
+				continue;
+
+			int available = 0;
+			glGetQueryObjectiv(m_Queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+			if(!available)
+				break;
+
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(m_Queries[index], GL_QUERY_RESULT, &elapsed);
+			m_QueryPending[index] = 0;
+			updateScale((float)((double)elapsed / 1000000.0));
+		}
+	}
+
+	//size of the area of the render targets that is rendered to for an output (window) of the given size
+	glm::ivec2 RenderSize(unsigned int outputWidth, unsigned int outputHeight) const
+	{
+		float scale = m_Enabled ? m_Scale : m_MaxScale;
+		int width  = glm::clamp((int)(outputWidth  * scale + 0.5f), 1, (int)m_MaxWidth);
+		int height = glm::clamp((int)(outputHeight * scale + 0.5f), 1, (int)m_MaxHeight);
+		return glm::ivec2(width, height);
+	}
+	//ratio between the rendered area and the allocated render target size, used by full screen passes to scale their texture coordinates
+	glm::vec2 ViewportScale(unsigned int outputWidth, unsigned int outputHeight) const
+	{
+		glm::ivec2 size = RenderSize(outputWidth, outputHeight);
+		return glm::vec2((float)size.x / (float)m_MaxWidth, (float)size.y / (float)m_MaxHeight);
+	}
+
+	inline float GPUFrameTime() const { return m_GPUFrameTime; }
+	inline unsigned int MaxWidth() const { return m_MaxWidth; }
+	inline unsigned int MaxHeight() const { return m_MaxHeight; }
+
+private:
+	bool m_Init;
+	unsigned int m_MaxWidth, m_MaxHeight;
+	unsigned int m_Queries[DRS_QUERY_COUNT];
+	bool m_QueryPending[DRS_QUERY_COUNT];
+	unsigned long long m_FrameIndex;
+	bool m_QueryActive;
+	float m_GPUFrameTime; //smoothed GPU frame time in milliseconds
+	unsigned int m_FramesSinceChange;
+
+	void updateScale(float frameTime)
+	{
+		if(m_GPUFrameTime == 0.0f)
+			m_GPUFrameTime = frameTime;
+		m_GPUFrameTime += (frameTime - m_GPUFrameTime) * 0.1f;
+
+		if(!m_Enabled || m_FramesSinceChange < DRS_COOLDOWN_FRAMES)
+			return;
+
+		//dead zone of 5% around the target so the scale doesn't oscillate
+		float error = (m_GPUFrameTime - m_TargetFrameTime) / m_TargetFrameTime;
+		if(std::abs(error) < 0.05f)
+			return;
+
+		//GPU cost is roughly proportional to the pixel count, which is proportional to the scale squared
+		float desiredScale = m_Scale * std::sqrt(m_TargetFrameTime / m_GPUFrameTime);
+		float newScale = m_Scale + glm::clamp(desiredScale - m_Scale, -DRS_SCALE_STEP, DRS_SCALE_STEP);
+		newScale = glm::clamp(newScale, m_MinScale, m_MaxScale);
+		if(newScale != m_Scale)
+		{
+			m_Scale = newScale;
+			m_FramesSinceChange = 0;
+		}
+	}
+};
+
+#endif
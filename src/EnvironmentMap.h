@@ -0,0 +1,276 @@
+#ifndef ENVIRONMENT_MAP_H
+#define ENVIRONMENT_MAP_H
+
+#include <vector>
+#include <string>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "IBLCache.h"
+#include "JobSystem.h"
+
+#define ENVIRONMENT_DEFAULT_SIZE 512
+void renderCube();
+
+enum EnvironmentBakePath
+{
+	ENVIRONMENT_BAKE_GPU = 0, //renders the faces with equirectangularToCubemap.F.shader, needs a GL context
+	ENVIRONMENT_BAKE_CPU = 1  //resamples the faces on the job system, can run without a GL context (ConvertCPU)
+};
+
+//Imports equirectangular .hdr environments as RGB16F cubemaps with a full mip chain (the prefilter shader samples the mips of the environment),
+//the result is stored in an IBL cache file so the conversion only runs again when the image or the size changes.
+//Images are expected to be loaded top row first (stbi vertical flip disabled) like SHProjector::ProjectEquirectangular does.
+class EnvironmentImporter
+{
+public:
+	//returns the environment cubemap or 0 if the image couldn't be loaded
+	static unsigned int LoadEquirectangular(const char* path, const char* cachePath, unsigned int size = ENVIRONMENT_DEFAULT_SIZE, EnvironmentBakePath bakePath = ENVIRONMENT_BAKE_GPU)
+	{
+		unsigned int nrMips = MipCount(size);
+		unsigned long long key = CacheKey(path, size);
+
+		unsigned int cubemap = 0;
+		if(IBLCache::Load(cachePath, key, size, nrMips, cubemap))
+			return cubemap;
+
+		if(bakePath == ENVIRONMENT_BAKE_CPU)
+		{
+			std::vector<std::vector<unsigned char>> images;
+			if(!ConvertCPU(path, size, images))
+				return 0;
+			IBLCache::SaveImages(cachePath, key, size, nrMips, images);
+			return IBLCache::CreateCubemap(size, nrMips, GL_RGB16F, GL_RGB, GL_HALF_FLOAT, images);
+		}
+
+		cubemap = ConvertGPU(path, size);
+		if(cubemap)
+			IBLCache::Save(cachePath, key, cubemap, size, nrMips);
+		return cubemap;
+	}
+
+	//key of the cache file for an image, both bake paths share it since they give the same result
+	static unsigned long long CacheKey(const char* path, unsigned int size)
+	{
+		std::vector<std::string> sources;
+		sources.push_back(path);
+		sources.push_back("ProgramFiles\\Resources\\Shaders\\equirectangularToCubemap.F.shader");
+		return IBLCache::ComputeKey(sources, { (float)size });
+	}
+	static unsigned int MipCount(unsigned int size)
+	{
+		unsigned int nrMips = 1;
+		while(size > 1)
+		{
+			size >>= 1;
+			nrMips++;
+		}
+		return nrMips;
+	}
+
+	//uploads the image as a float texture and renders it onto the 6 faces, the mips are generated by the driver
+	static unsigned int ConvertGPU(const char* path, unsigned int size)
+	{
+		int width, height, nrChannels;
+		float* data = stbi_loadf(path, &width, &height, &nrChannels, 3);
+		if(!data)
+		{
+			std::cout << "Failed to load equirectangular map: " << path << std::endl;
+			return 0;
+		}
+
+		//the shader maps +Y to the top of the texture (v = 1), so the top row has to be uploaded last
+		std::vector<float> flipped((size_t)width * height * 3);
+		for(int row = 0; row < height; row++)
+			std::copy(data + (size_t)row * width * 3, data + (size_t)(row + 1) * width * 3, flipped.begin() + (size_t)(height - 1 - row) * width * 3);
+		stbi_image_free(data);
+
+		unsigned int equirectangularMap;
+		glGenTextures(1, &equirectangularMap);
+		glBindTexture(GL_TEXTURE_2D, equirectangularMap);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, &flipped[0]);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		unsigned int cubemap;
+		glGenTextures(1, &cubemap);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+		for(unsigned int i = 0; i < 6; i++)
+			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, size, size, 0, GL_RGB, GL_FLOAT, nullptr);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		Shader convertShader("ProgramFiles\\Resources\\Shaders\\cubemap.V.shader", "ProgramFiles\\Resources\\Shaders\\equirectangularToCubemap.F.shader");
+		glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
+		glm::mat4 captureViews[] = {
+			glm::lookAt(glm::vec3(0.0f), glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+			glm::lookAt(glm::vec3(0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+			glm::lookAt(glm::vec3(0.0f), glm::vec3( 0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)),
+			glm::lookAt(glm::vec3(0.0f), glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)),
+			glm::lookAt(glm::vec3(0.0f), glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+			glm::lookAt(glm::vec3(0.0f), glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
+		};
+		convertShader.use();
+		convertShader.setInt("equirectangularMap", 0);
+		convertShader.setMat4("projection", captureProjection);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, equirectangularMap);
+
+		int viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		unsigned int captureFBO;
+		glGenFramebuffers(1, &captureFBO);
+		glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+		glViewport(0, 0, size, size);
+		glDisable(GL_DEPTH_TEST); //every face is fully covered by the cube, no depth attachment needed
+		for(unsigned int i = 0; i < 6; i++)
+		{
+			convertShader.setMat4("view", captureViews[i]);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, cubemap, 0);
+			renderCube();
+		}
+		glEnable(GL_DEPTH_TEST);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+		glDeleteFramebuffers(1, &captureFBO);
+		glDeleteTextures(1, &equirectangularMap);
+		convertShader.destroy();
+
+		glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+		glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+		return cubemap;
+	}
+
+	//converts the image into RGB half float images (every face of a mip level before the next level, like IBLCache::CreateCubemap expects),
+	//the face rows are split into jobs and every mip is a 2x2 box filter of the previous one like glGenerateMipmap
+	static bool ConvertCPU(const char* path, unsigned int size, std::vector<std::vector<unsigned char>>& images)
+	{
+		int width, height, nrChannels;
+		float* data = stbi_loadf(path, &width, &height, &nrChannels, 3);
+		if(!data)
+		{
+			std::cout << "Failed to load equirectangular map: " << path << std::endl;
+			return 0;
+		}
+
+		unsigned int nrMips = MipCount(size);
+		std::vector<std::vector<float>> faces(6, std::vector<float>((size_t)size * size * 3));
+		parallelFor(6 * size, [&](unsigned int row)
+		{
+			unsigned int face = row / size;
+			unsigned int y = row % size;
+			float* output = &faces[face][(size_t)y * size * 3];
+			for(unsigned int x = 0; x < size; x++)
+			{
+				glm::vec3 dir = glm::normalize(cubemapDirection(face, 2.0f * (x + 0.5f) / size - 1.0f, 2.0f * (y + 0.5f) / size - 1.0f));
+				glm::vec3 color = sampleEquirectangular(data, width, height, dir);
+				output[x * 3 + 0] = color.r;
+				output[x * 3 + 1] = color.g;
+				output[x * 3 + 2] = color.b;
+			}
+		});
+		stbi_image_free(data);
+
+		images.assign(nrMips * 6, std::vector<unsigned char>());
+		for(unsigned int mip = 0; mip < nrMips; mip++)
+		{
+			unsigned int mipSize = std::max(size >> mip, 1u);
+			if(mip > 0)
+			{
+				parallelFor(6, [&](unsigned int face)
+				{
+					faces[face] = downsample(faces[face], mipSize * 2);
+				});
+			}
+			for(unsigned int face = 0; face < 6; face++)
+			{
+				std::vector<unsigned char>& image = images[mip * 6 + face];
+				image.resize((size_t)mipSize * mipSize * 3 * sizeof(unsigned short));
+				unsigned short* halfData = (unsigned short*)&image[0];
+				for(size_t i = 0; i < (size_t)mipSize * mipSize * 3; i++)
+					halfData[i] = glm::packHalf1x16(faces[face][i]);
+			}
+		}
+		return 1;
+	}
+private:
+	//calls function(i) for every i in [0, count), every index is a job
+	template<typename Function>
+	static void parallelFor(unsigned int count, Function function)
+	{
+		GetJobSystem().ParallelFor(count, 1, [&](unsigned int begin, unsigned int end)
+		{
+			for(unsigned int index = begin; index < end; index++)
+				function(index);
+		});
+	}
+
+	//direction (not normalized) of the texel at u, v in [-1, 1] on a face, as defined by the GL cube map face selection table
+	static glm::vec3 cubemapDirection(unsigned int face, float u, float v)
+	{
+		switch(face)
+		{
+			case 0:  return glm::vec3( 1.0f, -v, -u);
+			case 1:  return glm::vec3(-1.0f, -v,  u);
+			case 2:  return glm::vec3( u,  1.0f,  v);
+			case 3:  return glm::vec3( u, -1.0f, -v);
+			case 4:  return glm::vec3( u, -v,  1.0f);
+			default: return glm::vec3(-u, -v, -1.0f);
+		}
+	}
+
+	//bilinear sample with the mapping of equirectangularToCubemap.F.shader, wraps horizontally and clamps vertically
+	static glm::vec3 sampleEquirectangular(const float* data, int width, int height, glm::vec3 dir)
+	{
+		float u = std::atan2(dir.z, dir.x) * 0.1591f + 0.5f;
+		float v = std::asin(glm::clamp(dir.y, -1.0f, 1.0f)) * 0.3183f + 0.5f;
+
+		//the top row is +Y (v = 1)
+		float x = u * width - 0.5f;
+		float y = (1.0f - v) * height - 0.5f;
+		int x0 = (int)std::floor(x);
+		int y0 = (int)std::floor(y);
+		float fx = x - x0;
+		float fy = y - y0;
+
+		int x1 = (x0 + 1) % width;
+		x0 = (x0 % width + width) % width;
+		x1 = (x1 % width + width) % width;
+		int y1 = std::min(y0 + 1, height - 1);
+		y0 = std::max(y0, 0);
+		y1 = std::max(y1, 0);
+
+		glm::vec3 c00 = glm::make_vec3(data + ((size_t)y0 * width + x0) * 3);
+		glm::vec3 c10 = glm::make_vec3(data + ((size_t)y0 * width + x1) * 3);
+		glm::vec3 c01 = glm::make_vec3(data + ((size_t)y1 * width + x0) * 3);
+		glm::vec3 c11 = glm::make_vec3(data + ((size_t)y1 * width + x1) * 3);
+		return glm::mix(glm::mix(c00, c10, fx), glm::mix(c01, c11, fx), fy);
+	}
+
+	//halves a square RGB float image with a 2x2 box filter
+	static std::vector<float> downsample(const std::vector<float>& source, unsigned int sourceSize)
+	{
+		unsigned int size = std::max(sourceSize / 2, 1u);
+		std::vector<float> result((size_t)size * size * 3);
+		for(unsigned int y = 0; y < size; y++)
+		{
+			for(unsigned int x = 0; x < size; x++)
+			{
+				for(unsigned int c = 0; c < 3; c++)
+				{
+					unsigned int sx = x * 2, sy = y * 2;
+					float sum = source[((size_t)sy * sourceSize + sx) * 3 + c] + source[((size_t)sy * sourceSize + sx + 1) * 3 + c] +
+					            source[((size_t)(sy + 1) * sourceSize + sx) * 3 + c] + source[((size_t)(sy + 1) * sourceSize + sx + 1) * 3 + c];
+					result[((size_t)y * size + x) * 3 + c] = sum * 0.25f;
+				}
+			}
+		}
+		return result;
+	}
+};
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef FRUSTUM_CULLER_H
+#define FRUSTUM_CULLER_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <src/Camera.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FRUSTUM_CULLER_USE_SSE
+#include <xmmintrin.h>
+#endif
+#if defined(__AVX__)
+#define FRUSTUM_CULLER_USE_AVX
+#include <immintrin.h>
+#endif
+
+//Bounding spheres stored as separate x, y, z and radius arrays, so one frustum plane is tested against 8 (AVX) or 4 (SSE) spheres per instruction.
+//The result of a cull is a bitset with one bit per sphere in the order they were added, the same spheres can be culled against any number of views.
+class FrustumCuller
+{
+public:
+	FrustumCuller()
+	{
+
+	}
+
+	void Clear()
+	{
+		m_X.clear();
+		m_Y.clear();
+		m_Z.clear();
+		m_Radius.clear();
+	}
+	void Reserve(unsigned int size)
+	{
+		m_X.reserve(size);
+		m_Y.reserve(size);
+		m_Z.reserve(size);
+		m_Radius.reserve(size);
+	}
+	//returns the index of the sphere's bit
+	unsigned int Add(const glm::vec3& center, float radius)
+	{
+		m_X.push_back(center.x);
+		m_Y.push_back(center.y);
+		m_Z.push_back(center.z);
+		m_Radius.push_back(radius);
+		return (unsigned int)m_Radius.size() - 1;
+	}
+
+	inline unsigned int Size() const { return (unsigned int)m_Radius.size(); }
+	inline glm::vec3 Center(unsigned int index) const { return glm::vec3(m_X[index], m_Y[index], m_Z[index]); }
+	inline float Radius(unsigned int index) const { return m_Radius[index]; }
+
+	//sets the bit of every sphere that is at least partly inside the view frustum, returns the number of visible spheres
+	unsigned int Cull(const glm::mat4& viewProjection, std::vector<unsigned int>& visible) const
+	{
+		glm::vec4 planes[6];
+		Camera::ExtractFrustumPlanes(viewProjection, planes);
+		return Cull(planes, visible);
+	}
+	//the planes have to be normalized and point inwards
+	unsigned int Cull(const glm::vec4 planes[6], std::vector<unsigned int>& visible) const
+	{
+		unsigned int size = Size();
+		visible.assign((size + 31) / 32, 0);
+		unsigned int nrVisible = 0;
+		unsigned int i = 0;
+#ifdef FRUSTUM_CULLER_USE_AVX
+		for(; i + 8 <= size; i += 8)
+		{
+			__m256 x = _mm256_loadu_ps(&m_X[i]), y = _mm256_loadu_ps(&m_Y[i]), z = _mm256_loadu_ps(&m_Z[i]);
+			__m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&m_Radius[i]));
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for(unsigned int p = 0; p < 6; p++)
+			{
+				__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes[p].x), x), _mm256_mul_ps(_mm256_set1_ps(planes[p].y), y)),
+				                                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes[p].z), z), _mm256_set1_ps(planes[p].w)));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negRadius, _CMP_GT_OQ));
+			}
+			unsigned int bits = (unsigned int)_mm256_movemask_ps(inside);
+			visible[i / 32] |= bits << (i & 31);
+			nrVisible += bitCount(bits);
+		}
+#endif
+#ifdef FRUSTUM_CULLER_USE_SSE
+		for(; i + 4 <= size; i += 4)
+		{
+			__m128 x = _mm_loadu_ps(&m_X[i]), y = _mm_loadu_ps(&m_Y[i]), z = _mm_loadu_ps(&m_Z[i]);
+			__m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&m_Radius[i]));
+			__m128 inside = _mm_cmpeq_ps(x, x); //all bits set, unless x is NaN
+			for(unsigned int p = 0; p < 6; p++)
+			{
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p].x), x), _mm_mul_ps(_mm_set1_ps(planes[p].y), y)),
+				                             _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p].z), z), _mm_set1_ps(planes[p].w)));
+				inside = _mm_and_ps(inside, _mm_cmpgt_ps(distance, negRadius));
+			}
+			unsigned int bits = (unsigned int)_mm_movemask_ps(inside);
+			visible[i / 32] |= bits << (i & 31);
+			nrVisible += bitCount(bits);
+		}
+#endif
+		for(; i < size; i++)
+		{
+			bool inside = true;
+			for(unsigned int p = 0; p < 6 && inside; p++)
+				inside = planes[p].x * m_X[i] + planes[p].y * m_Y[i] + planes[p].z * m_Z[i] + planes[p].w > -m_Radius[i];
+			if(inside)
+			{
+				visible[i / 32] |= 1u << (i & 31);
+				nrVisible++;
+			}
+		}
+		return nrVisible;
+	}
+
+	static inline bool Visible(const std::vector<unsigned int>& visible, unsigned int index) { return (visible[index / 32] >> (index & 31)) & 1u; }
+
+private:
+	std::vector<float> m_X, m_Y, m_Z, m_Radius;
+
+	static inline unsigned int bitCount(unsigned int bits)
+	{
+		unsigned int count = 0;
+		for(; bits; bits &= bits - 1)
+			count++;
+		return count;
+	}
+};
+
+#define CULL_VIEW_NO_OBJECT 0xFFFFFFFFu
+
+//a view the scene is culled against, m_Visible receives the IDs of the transforms whose world bounds intersect its frustum
+struct CullView
+{
+	glm::vec4 m_Planes[6];
+	std::vector<unsigned int> m_Visible;
+
+	void SetViewProjection(const glm::mat4& viewProjection)
+	{
+		Camera::ExtractFrustumPlanes(viewProjection, m_Planes);
+	}
+	//the object a visible transform ID belongs to, objectOfID is indexed by ID. CULL_VIEW_NO_OBJECT for IDs of anything else
+	static inline unsigned int Object(const std::vector<unsigned int>& objectOfID, unsigned int id)
+	{
+		return id < objectOfID.size() ? objectOfID[id] : CULL_VIEW_NO_OBJECT;
+	}
+};
+
+#endif
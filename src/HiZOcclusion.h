@@ -0,0 +1,260 @@
+#ifndef HIZ_OCCLUSION_H
+#define HIZ_OCCLUSION_H
+
+#include <cstring>
+#include <glm/glm.hpp>
+#include <src/shader.h>
+#include <src/DepthPyramid.h>
+
+//transform feedback objects (GL 4.0, ARB_transform_feedback2) and drawing what one captured (GL 4.2, ARB_transform_feedback_instanced),
+//loaded by hand since the loader only has GL 3.3
+#define HIZ_GL_TRANSFORM_FEEDBACK 0x8E22
+typedef void (APIENTRYP HiZGenTransformFeedbacks)(GLsizei n, GLuint* ids);
+typedef void (APIENTRYP HiZDeleteTransformFeedbacks)(GLsizei n, const GLuint* ids);
+typedef void (APIENTRYP HiZBindTransformFeedback)(GLenum target, GLuint id);
+typedef void (APIENTRYP HiZDrawTransformFeedbackInstanced)(GLenum mode, GLuint id, GLsizei instanceCount);
+
+//the instances the culling pass keeps, see HiZOcclusion::Cull
+enum HiZCullPass
+{
+	HIZ_CULL_VISIBLE = 0, //visible in the newest pyramid
+	HIZ_CULL_DISOCCLUDED, //visible in the newest pyramid but not in the one before, the instances the first pass missed
+	NR_OF_HIZ_CULL_PASSES
+};
+
+//a depth pyramid and the view it was built from
+struct HiZPyramid
+{
+	DepthPyramid m_Depth;
+	glm::mat4 m_ViewProjection;
+	glm::ivec2 m_Size; //of level 0, the render size of its frame
+	unsigned int m_Levels;
+	bool m_Valid;
+};
+
+//GPU occlusion culling of instanced draws against a hierarchical max-depth pyramid (Hi-Z) of the G-buffer depth.
+//Each frame's depth is reduced into one of two pyramids, so the pyramid of the previous frame is still there while the next one is built.
+//The first pass tests the instances against the previous frame's pyramid before anything of this frame is drawn,
+//the second one after this frame's depth is reduced, for the instances that were hidden before and are visible now.
+//An instance is one point of a vertex + geometry shader pass with GL_RASTERIZER_DISCARD, the geometry shader only emits the visible ones
+//and transform feedback packs them into the output buffer, which is drawn as the instance buffer of the real draw.
+//Where the context has transform feedback draws each pass captures into its own transform feedback object and DrawFeedback()
+//draws the kept instances with the count the GPU recorded, so nothing comes back to the CPU. Plain GL 3.3 has no way to draw
+//that count, the number of kept instances then comes back through a primitives written query. Count() only polls it,
+//a draw whose count isn't back yet has to fall back to all instances instead of waiting for the GPU.
+//Instances are laid out like TransparentInstance: a model matrix followed by one vec4 that is passed through.
+class HiZOcclusion
+{
+public:
+	bool m_UseFeedbackDraws; //can be turned off to compare with the polled counts
+
+	HiZOcclusion()
+		:m_UseFeedbackDraws(1), m_Init(0), m_VAO(0), m_Newest(0), m_FeedbackDraws(0), m_CullShader(nullptr),
+		m_GenTransformFeedbacks(nullptr), m_DeleteTransformFeedbacks(nullptr), m_BindTransformFeedback(nullptr), m_DrawTransformFeedbackInstanced(nullptr)
+	{
+		for(unsigned int i = 0; i < NR_OF_HIZ_CULL_PASSES; i++)
+		{
+			m_Feedbacks[i] = 0;
+			m_Queries[i] = 0;
+			m_Counts[i] = 0;
+			m_Pending[i] = 0;
+		}
+	}
+	~HiZOcclusion()
+	{
+
+	}
+
+	//width and height are the largest render size, load is the loader of the context's functions for the transform feedback draws
+	bool Init(unsigned int width, unsigned int height, GLADloadproc load = nullptr)
+	{
+		if(m_Init) return 1;
+
+		for(unsigned int p = 0; p < 2; p++)
+		{
+			HiZPyramid& pyramid = m_Pyramids[p];
+			if(!pyramid.m_Depth.Init(width, height, DEPTH_PYRAMID_MAX))
+				return 0;
+			pyramid.m_ViewProjection = glm::mat4(1.0f);
+			pyramid.m_Size = glm::ivec2(0);
+			pyramid.m_Levels = 0;
+			pyramid.m_Valid = 0;
+		}
+
+		//the attributes point at the culled instance buffer in Cull()
+		glGenVertexArrays(1, &m_VAO);
+		glGenQueries(NR_OF_HIZ_CULL_PASSES, m_Queries);
+		loadFeedbackDraws(load);
+		if(m_FeedbackDraws)
+			m_GenTransformFeedbacks(NR_OF_HIZ_CULL_PASSES, m_Feedbacks);
+
+		const char* varyings[5] = { "model0", "model1", "model2", "model3", "payload" };
+		m_CullShader = new Shader("ProgramFiles\\Resources\\Shaders\\Occlusion\\Cull.V.shader", "ProgramFiles\\Resources\\Shaders\\Occlusion\\Cull.G.shader", varyings, 5);
+		m_CullShader->use();
+		m_CullShader->setInt("newestHiZ", 0);
+		m_CullShader->setInt("olderHiZ", 1);
+		glUseProgram(0);
+
+		m_Init = 1;
+		return 1;
+	}
+	void Destroy()
+	{
+		for(unsigned int p = 0; p < 2; p++)
+			m_Pyramids[p].m_Depth.Destroy();
+		glDeleteVertexArrays(1, &m_VAO);
+		glDeleteQueries(NR_OF_HIZ_CULL_PASSES, m_Queries);
+		if(m_FeedbackDraws)
+			m_DeleteTransformFeedbacks(NR_OF_HIZ_CULL_PASSES, m_Feedbacks);
+		m_FeedbackDraws = 0;
+		if(m_CullShader)
+		{
+			m_CullShader->destroy();
+			delete m_CullShader;
+		}
+		m_CullShader = nullptr;
+		m_VAO = 0;
+		m_Init = 0;
+	}
+
+	//reduces this frame's depth into the older pyramid, which then becomes the newest.
+	//viewProjection should be the un-jittered one, the tests add a pixel of margin for the jitter
+	void Build(unsigned int depthTexture, glm::ivec2 renderSize, const glm::mat4& viewProjection)
+	{
+		HiZPyramid& pyramid = m_Pyramids[1 - m_Newest];
+		pyramid.m_Levels = pyramid.m_Depth.Build(depthTexture, renderSize);
+		pyramid.m_ViewProjection = viewProjection;
+		pyramid.m_Size = renderSize;
+		pyramid.m_Valid = 1;
+		m_Newest = 1 - m_Newest;
+	}
+
+	//writes the instances of instanceBuffer the pass keeps into outputBuffer, which has to have room for all of them.
+	//boundsMin/boundsMax are the object space box of the instanced mesh. Without a pyramid every instance is visible and none disoccluded
+	void Cull(HiZCullPass pass, unsigned int instanceBuffer, unsigned int nrOfInstances, const glm::vec3& boundsMin, const glm::vec3& boundsMax, unsigned int outputBuffer)
+	{
+		m_Counts[pass] = 0;
+		m_Pending[pass] = 0;
+		if(nrOfInstances == 0)
+			return;
+
+		glBindVertexArray(m_VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+		for(unsigned int i = 0; i < 5; i++)
+		{
+			glEnableVertexAttribArray(i);
+			glVertexAttribPointer(i, 4, GL_FLOAT, GL_FALSE, 5 * sizeof(glm::vec4), (void*)(i * sizeof(glm::vec4)));
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		m_CullShader->use();
+		m_CullShader->setVec3("boundsCenter", (boundsMin + boundsMax) * 0.5f);
+		m_CullShader->setVec3("boundsExtent", (boundsMax - boundsMin) * 0.5f);
+		m_CullShader->setBool("disoccluded", pass == HIZ_CULL_DISOCCLUDED);
+		setPyramid("newest", m_Pyramids[m_Newest], 0);
+		setPyramid("older", m_Pyramids[1 - m_Newest], 1);
+
+		glEnable(GL_RASTERIZER_DISCARD);
+		if(m_FeedbackDraws)
+			m_BindTransformFeedback(HIZ_GL_TRANSFORM_FEEDBACK, m_Feedbacks[pass]);
+		glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, outputBuffer);
+		glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, m_Queries[pass]);
+		glBeginTransformFeedback(GL_POINTS);
+		glDrawArrays(GL_POINTS, 0, nrOfInstances);
+		glEndTransformFeedback();
+		glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+		glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+		if(m_FeedbackDraws)
+			m_BindTransformFeedback(HIZ_GL_TRANSFORM_FEEDBACK, 0);
+		glDisable(GL_RASTERIZER_DISCARD);
+		glBindVertexArray(0);
+		glUseProgram(0);
+		m_Pending[pass] = 1;
+	}
+	//the number of instances the last Cull of the pass kept, false while the GPU hasn't finished that pass. never waits for it
+	bool Count(HiZCullPass pass, unsigned int& count)
+	{
+		if(m_Pending[pass])
+		{
+			unsigned int available = 0;
+			glGetQueryObjectuiv(m_Queries[pass], GL_QUERY_RESULT_AVAILABLE, &available);
+			if(!available)
+				return 0;
+			glGetQueryObjectuiv(m_Queries[pass], GL_QUERY_RESULT, &m_Counts[pass]);
+			m_Pending[pass] = 0;
+		}
+		count = m_Counts[pass];
+		return 1;
+	}
+
+	//whether the kept instances are drawn with DrawFeedback() instead of a count from Count()
+	inline bool DrawsFromFeedback() const { return m_FeedbackDraws && m_UseFeedbackDraws; }
+	inline bool FeedbackDrawsAvailable() const { return m_FeedbackDraws; }
+	//draws the points the last Cull of the pass kept, instanceCount times, with the bound program and vertex array.
+	//every kept instance is one vertex of the draw, see TransparencyRenderer for drawing a mesh that way
+	void DrawFeedback(HiZCullPass pass, unsigned int instanceCount)
+	{
+		m_DrawTransformFeedbackInstanced(GL_POINTS, m_Feedbacks[pass], instanceCount);
+	}
+
+	inline unsigned int NrOfLevels() const { return m_Pyramids[m_Newest].m_Levels; }
+
+private:
+	bool m_Init;
+	unsigned int m_VAO;
+	HiZPyramid m_Pyramids[2];
+	unsigned int m_Newest;
+	unsigned int m_Queries[NR_OF_HIZ_CULL_PASSES];
+	unsigned int m_Counts[NR_OF_HIZ_CULL_PASSES];
+	bool m_Pending[NR_OF_HIZ_CULL_PASSES];
+	bool m_FeedbackDraws;
+	unsigned int m_Feedbacks[NR_OF_HIZ_CULL_PASSES]; //transform feedback objects, remember how much each pass captured
+	Shader* m_CullShader;
+	HiZGenTransformFeedbacks m_GenTransformFeedbacks;
+	HiZDeleteTransformFeedbacks m_DeleteTransformFeedbacks;
+	HiZBindTransformFeedback m_BindTransformFeedback;
+	HiZDrawTransformFeedbackInstanced m_DrawTransformFeedbackInstanced;
+
+	void loadFeedbackDraws(GLADloadproc load)
+	{
+		m_FeedbackDraws = 0;
+		if(!load)
+			return;
+		int major = 0, minor = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &major);
+		glGetIntegerv(GL_MINOR_VERSION, &minor);
+		bool supported = major > 4 || (major == 4 && minor >= 2);
+		if(!supported)
+		{
+			bool objects = 0, instanced = 0;
+			int nrOfExtensions = 0;
+			glGetIntegerv(GL_NUM_EXTENSIONS, &nrOfExtensions);
+			for(int i = 0; i < nrOfExtensions; i++)
+			{
+				const char* name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+				objects = objects || strcmp(name, "GL_ARB_transform_feedback2") == 0;
+				instanced = instanced || strcmp(name, "GL_ARB_transform_feedback_instanced") == 0;
+			}
+			supported = objects && instanced;
+		}
+		if(!supported)
+			return;
+		m_GenTransformFeedbacks = (HiZGenTransformFeedbacks)load("glGenTransformFeedbacks");
+		m_DeleteTransformFeedbacks = (HiZDeleteTransformFeedbacks)load("glDeleteTransformFeedbacks");
+		m_BindTransformFeedback = (HiZBindTransformFeedback)load("glBindTransformFeedback");
+		m_DrawTransformFeedbackInstanced = (HiZDrawTransformFeedbackInstanced)load("glDrawTransformFeedbackInstanced");
+		m_FeedbackDraws = m_GenTransformFeedbacks && m_DeleteTransformFeedbacks && m_BindTransformFeedback && m_DrawTransformFeedbackInstanced;
+	}
+
+	void setPyramid(const std::string& name, const HiZPyramid& pyramid, unsigned int unit)
+	{
+		m_CullShader->setMat4(name + ".viewProjection", pyramid.m_ViewProjection);
+		m_CullShader->setVec2(name + ".size", glm::vec2(pyramid.m_Size));
+		m_CullShader->setInt(name + ".levels", pyramid.m_Levels);
+		m_CullShader->setBool(name + ".valid", pyramid.m_Valid);
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(GL_TEXTURE_2D, pyramid.m_Depth.Texture());
+	}
+};
+
+#endif
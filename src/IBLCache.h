@@ -0,0 +1,201 @@
+#ifndef IBL_CACHE_H
+#define IBL_CACHE_H
+
+#include <fstream>
+#include <vector>
+#include <string>
+
+#define IBL_CACHE_MAGIC 0x4C424931 //"1IBL"
+#define IBL_CACHE_VERSION 1
+
+//Header of an IBL cache file, followed by the image data of every mip level (largest first) and every face (+X, -X, +Y, -Y, +Z, -Z),
+//each image is prefixed by its size in bytes like in KTX files.
+struct IBLCacheHeader
+{
+	unsigned int magic;
+	unsigned int version;
+	unsigned long long key; //hash of the sources and bake parameters the data was baked from
+	unsigned int width, height;
+	unsigned int nrFaces, nrMips;
+	unsigned int internalFormat, format, type; //GL enums used to upload the data
+};
+
+//Stores baked IBL cubemaps (irradiance, prefiltered environment) on disk so they only need to be baked again when their sources change.
+class IBLCache
+{
+public:
+	//FNV-1a hash of the contents of every file and of the bake parameters, changing any of them gives a different key
+	static unsigned long long ComputeKey(const std::vector<std::string>& files, const std::vector<float>& parameters)
+	{
+		unsigned long long hash = 14695981039346656037ull;
+		unsigned int version = IBL_CACHE_VERSION;
+		hash = hashBytes(hash, (const unsigned char*)&version, sizeof(version));
+
+		for(unsigned int i = 0; i < files.size(); i++)
+		{
+			std::ifstream file(files[i], std::ios::in | std::ios::binary);
+			if(!file)
+			{
+				//a missing file still changes the key so it gets baked (and fails loudly) once it's there
+				hash = hashBytes(hash, (const unsigned char*)files[i].c_str(), files[i].size());
+				continue;
+			}
+			char buffer[4096];
+			while(file)
+			{
+				file.read(buffer, sizeof(buffer));
+				hash = hashBytes(hash, (const unsigned char*)buffer, (unsigned int)file.gcount());
+			}
+		}
+		if(!parameters.empty())
+			hash = hashBytes(hash, (const unsigned char*)&parameters[0], parameters.size() * sizeof(float));
+		return hash;
+	}
+
+	//creates cubemap from the cache file if it exists and was baked with the same key and size, returns false if it needs to be baked
+	static bool Load(const char* path, unsigned long long key, unsigned int size, unsigned int nrMips, unsigned int& cubemap)
+	{
+		std::ifstream file(path, std::ios::in | std::ios::binary);
+		if(!file)
+			return 0;
+
+		IBLCacheHeader header;
+		file.read((char*)&header, sizeof(header));
+		if(!file || header.magic != IBL_CACHE_MAGIC || header.version != IBL_CACHE_VERSION || header.key != key ||
+		   header.width != size || header.height != size || header.nrFaces != 6 || header.nrMips != nrMips)
+		{
+			std::cout << "IBL cache is out of date, baking again: " << path << std::endl;
+			return 0;
+		}
+
+		//reads everything before creating the texture so a truncated file doesn't leave a half filled cubemap
+		std::vector<std::vector<unsigned char>> images(header.nrFaces * header.nrMips);
+		for(unsigned int i = 0; i < images.size(); i++)
+		{
+			unsigned int imageSize = 0;
+			file.read((char*)&imageSize, sizeof(imageSize));
+			unsigned int mipSize = std::max(size >> (i / header.nrFaces), 1u);
+			if(!file || imageSize != mipSize * mipSize * bytesPerPixel(header.format, header.type))
+			{
+				std::cout << "IBL cache is corrupted, baking again: " << path << std::endl;
+				return 0;
+			}
+			images[i].resize(imageSize);
+			file.read((char*)&images[i][0], imageSize);
+			if(!file)
+			{
+				std::cout << "IBL cache is corrupted, baking again: " << path << std::endl;
+				return 0;
+			}
+		}
+
+		cubemap = CreateCubemap(size, header.nrMips, header.internalFormat, header.format, header.type, images);
+		return 1;
+	}
+
+	//creates a cubemap from images ordered like in the cache file (every face of a mip level before the next level)
+	static unsigned int CreateCubemap(unsigned int size, unsigned int nrMips, unsigned int internalFormat, unsigned int format, unsigned int type, const std::vector<std::vector<unsigned char>>& images)
+	{
+		int unpackAlignment;
+		glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		unsigned int cubemap;
+		glGenTextures(1, &cubemap);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+		for(unsigned int mip = 0; mip < nrMips; mip++)
+		{
+			unsigned int mipSize = std::max(size >> mip, 1u);
+			for(unsigned int face = 0; face < 6; face++)
+				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, mip, internalFormat, mipSize, mipSize, 0, format, type, &images[mip * 6 + face][0]);
+		}
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, nrMips > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, nrMips - 1);
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+		return cubemap;
+	}
+
+	//reads the first nrMips levels of cubemap back from the GPU and writes them to the cache file as half floats
+	static bool Save(const char* path, unsigned long long key, unsigned int cubemap, unsigned int size, unsigned int nrMips)
+	{
+		int packAlignment;
+		glGetIntegerv(GL_PACK_ALIGNMENT, &packAlignment);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+		std::vector<std::vector<unsigned char>> images(nrMips * 6);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+		for(unsigned int mip = 0; mip < nrMips; mip++)
+		{
+			unsigned int mipSize = std::max(size >> mip, 1u);
+			for(unsigned int face = 0; face < 6; face++)
+			{
+				images[mip * 6 + face].resize(mipSize * mipSize * bytesPerPixel(GL_RGB, GL_HALF_FLOAT));
+				glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, mip, GL_RGB, GL_HALF_FLOAT, &images[mip * 6 + face][0]);
+			}
+		}
+
+		glPixelStorei(GL_PACK_ALIGNMENT, packAlignment);
+		return SaveImages(path, key, size, nrMips, images);
+	}
+	//writes RGB half float images baked on the CPU (ordered like in CreateCubemap) to the cache file, doesn't need a GL context
+	static bool SaveImages(const char* path, unsigned long long key, unsigned int size, unsigned int nrMips, const std::vector<std::vector<unsigned char>>& images)
+	{
+		std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+		if(!file)
+		{
+			std::cout << "Failed to write IBL cache: " << path << std::endl;
+			return 0;
+		}
+
+		IBLCacheHeader header;
+		header.magic = IBL_CACHE_MAGIC;
+		header.version = IBL_CACHE_VERSION;
+		header.key = key;
+		header.width = size;
+		header.height = size;
+		header.nrFaces = 6;
+		header.nrMips = nrMips;
+		header.internalFormat = GL_RGB16F;
+		header.format = GL_RGB;
+		header.type = GL_HALF_FLOAT;
+		file.write((const char*)&header, sizeof(header));
+
+		for(unsigned int i = 0; i < nrMips * 6; i++)
+		{
+			unsigned int imageSize = (unsigned int)images[i].size();
+			file.write((const char*)&imageSize, sizeof(imageSize));
+			file.write((const char*)&images[i][0], imageSize);
+		}
+
+		if(!file.good())
+		{
+			std::cout << "Failed to write IBL cache: " << path << std::endl;
+			return 0;
+		}
+		return 1;
+	}
+private:
+	static unsigned long long hashBytes(unsigned long long hash, const unsigned char* data, unsigned int size)
+	{
+		for(unsigned int i = 0; i < size; i++)
+		{
+			hash ^= data[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+	static unsigned int bytesPerPixel(unsigned int format, unsigned int type)
+	{
+		unsigned int components = (format == GL_RGBA) ? 4 : (format == GL_RG) ? 2 : (format == GL_RED) ? 1 : 3;
+		unsigned int componentSize = (type == GL_FLOAT) ? 4 : (type == GL_HALF_FLOAT) ? 2 : 1;
+		return components * componentSize;
+	}
+};
+
+#endif
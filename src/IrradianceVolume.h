@@ -0,0 +1,456 @@
+#ifndef IRRADIANCE_VOLUME_H
+#define IRRADIANCE_VOLUME_H
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "SphericalHarmonics.h"
+
+#define IRRADIANCE_VOLUME_MAX_LIGHTS 4
+#define IRRADIANCE_VOLUME_RAY_COUNT 128
+#define IRRADIANCE_VOLUME_FIRST_UNIT 13 //the R, G and B coefficient textures use 3 units starting at this one
+
+//Irradiance volume: a 3D grid of L1 spherical harmonics probes over the scene bounds, sampled trilinearly by PBRSecondPass instead of the
+//global environment SH inside the bounds. Every probe traces rays against a list of analytic occluders once; rays that escape see the sky,
+//rays that hit an occluder see its surface lit by the (shadowed) point lights and the sky. The lights move, so a worker thread relights
+//the cached hits whenever new light positions come in and the main thread uploads the finished grid.
+//Only indirect light is stored, the direct light of the point lights is still computed per pixel by PBRFirstPass.
+class IrradianceVolume
+{
+public:
+	bool m_Enabled;
+	IrradianceVolume()
+		:m_Init(0), m_Enabled(1), m_Resolution(0), m_BoundsMin(0.0f), m_BoundsMax(0.0f), m_Quit(0), m_LightsChanged(0), m_ResultReady(0), m_NrOfLights(0),
+		 m_NrOfUploads(0)
+	{
+		m_Textures[0] = m_Textures[1] = m_Textures[2] = 0;
+	}
+	//the relight thread may still be running if Destroy wasn't called, it has to be joined before the members it uses go away
+	~IrradianceVolume()
+	{
+		stopWorker();
+	}
+
+	//resolution is the number of probes along each axis (at least 2), the outermost probes sit on the bounds
+	bool Init(glm::vec3 boundsMin, glm::vec3 boundsMax, glm::ivec3 resolution, const SH9Color& environmentSH)
+	{
+		if(m_Init) return 1;
+
+		m_BoundsMin = boundsMin;
+		m_BoundsMax = boundsMax;
+		m_Resolution = glm::max(resolution, glm::ivec3(2));
+		m_EnvironmentSH = environmentSH;
+
+		unsigned int nrOfProbes = m_Resolution.x * m_Resolution.y * m_Resolution.z;
+		m_Result.assign(nrOfProbes * 12, 0.0f);
+		m_Uploaded.assign(nrOfProbes * 12, 0.0f);
+
+		glGenTextures(3, m_Textures);
+		for(unsigned int i = 0; i < 3; i++)
+		{
+			glBindTexture(GL_TEXTURE_3D, m_Textures[i]);
+			glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA16F, m_Resolution.x, m_Resolution.y, m_Resolution.z, 0, GL_RGBA, GL_FLOAT, nullptr);
+			glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		}
+		glBindTexture(GL_TEXTURE_3D, 0);
+
+		m_Quit = 0;
+		m_Worker = std::thread(&IrradianceVolume::workerLoop, this);
+		m_Init = 1;
+		return 1;
+	}
+	void Destroy()
+	{
+		if(!m_Init)
+			return;
+		stopWorker();
+		glDeleteTextures(3, m_Textures);
+		m_Init = 0;
+	}
+
+	//occluders have to be added before the first SetLights call, the probe rays are traced against them once
+	void AddSphere(glm::vec3 center, float radius, glm::vec3 albedo)
+	{
+		Occluder occluder;
+		occluder.type = SPHERE_OCCLUDER;
+		occluder.a = center;
+		occluder.b = glm::vec3(radius);
+		occluder.albedo = albedo;
+		m_Occluders.push_back(occluder);
+	}
+	void AddBox(glm::vec3 boxMin, glm::vec3 boxMax, glm::vec3 albedo)
+	{
+		Occluder occluder;
+		occluder.type = BOX_OCCLUDER;
+		occluder.a = boxMin;
+		occluder.b = boxMax;
+		occluder.albedo = albedo;
+		m_Occluders.push_back(occluder);
+	}
+
+	//hands the current lights to the worker thread, it relights the grid in the background if it isn't busy with the previous lights
+	void SetLights(const glm::vec3* positions, const glm::vec3* colors, unsigned int count)
+	{
+		if(!m_Init)
+			return;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_NrOfLights = std::min(count, (unsigned int)IRRADIANCE_VOLUME_MAX_LIGHTS);
+			for(unsigned int i = 0; i < m_NrOfLights; i++)
+			{
+				m_LightPositions[i] = positions[i];
+				m_LightColors[i] = colors[i];
+			}
+			m_LightsChanged = 1;
+		}
+		m_Condition.notify_one();
+	}
+	//uploads the last grid the worker finished, returns true if there was a new one
+	bool Upload()
+	{
+		if(!m_Init)
+			return 0;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if(!m_ResultReady)
+				return 0;
+			m_Uploaded.swap(m_Result);
+			m_ResultReady = 0;
+		}
+		m_NrOfUploads++;
+
+		//m_Uploaded holds 3 floats (R, G, B) for each of the 4 coefficients of every probe, the textures hold 1 channel with 4 coefficients each
+		unsigned int nrOfProbes = m_Resolution.x * m_Resolution.y * m_Resolution.z;
+		std::vector<float> channel(nrOfProbes * 4);
+		for(unsigned int c = 0; c < 3; c++)
+		{
+			for(unsigned int i = 0; i < nrOfProbes; i++)
+				for(unsigned int k = 0; k < 4; k++)
+					channel[i * 4 + k] = m_Uploaded[i * 12 + k * 3 + c];
+			glBindTexture(GL_TEXTURE_3D, m_Textures[c]);
+			glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, m_Resolution.x, m_Resolution.y, m_Resolution.z, GL_RGBA, GL_FLOAT, &channel[0]);
+		}
+		glBindTexture(GL_TEXTURE_3D, 0);
+		return 1;
+	}
+
+	//binds the coefficient textures and sets the volume uniforms of shader (which has to be in use)
+	void Bind(Shader& shader)
+	{
+		bool enabled = m_Init && m_Enabled && m_NrOfUploads > 0;
+		shader.setBool("irradianceVolumeEnabled", enabled);
+		if(!enabled)
+			return;
+		shader.setVec3("volumeMin", m_BoundsMin);
+		shader.setVec3("volumeMax", m_BoundsMax);
+		shader.setVec3("volumeResolution", glm::vec3(m_Resolution));
+		for(unsigned int i = 0; i < 3; i++)
+		{
+			glActiveTexture(GL_TEXTURE0 + IRRADIANCE_VOLUME_FIRST_UNIT + i);
+			glBindTexture(GL_TEXTURE_3D, m_Textures[i]);
+		}
+	}
+	static void SetSamplers(Shader& shader)
+	{
+		shader.use();
+		shader.setInt("irradianceVolumeR", IRRADIANCE_VOLUME_FIRST_UNIT + 0);
+		shader.setInt("irradianceVolumeG", IRRADIANCE_VOLUME_FIRST_UNIT + 1);
+		shader.setInt("irradianceVolumeB", IRRADIANCE_VOLUME_FIRST_UNIT + 2);
+	}
+
+	//linear average color of a mipmapped sRGB texture (its 1x1 mip level), used as the albedo of occluders
+	static glm::vec3 AverageColor(unsigned int texture)
+	{
+		int width, height, level = 0;
+		glBindTexture(GL_TEXTURE_2D, texture);
+		do
+		{
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_WIDTH, &width);
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_HEIGHT, &height);
+			level++;
+		} while(width > 1 || height > 1);
+
+		float color[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		glGetTexImage(GL_TEXTURE_2D, level - 1, GL_RGBA, GL_FLOAT, color);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		return glm::pow(glm::vec3(color[0], color[1], color[2]), glm::vec3(2.2f));
+	}
+
+	glm::ivec3 Resolution()
+	{
+		return m_Resolution;
+	}
+	//number of relit grids that were uploaded so far
+	unsigned int NrOfUploads()
+	{
+		return m_NrOfUploads;
+	}
+private:
+	enum OccluderType
+	{
+		SPHERE_OCCLUDER = 0,
+		BOX_OCCLUDER = 1
+	};
+	struct Occluder
+	{
+		OccluderType type;
+		glm::vec3 a, b; //center and radius of spheres, min and max of boxes
+		glm::vec3 albedo;
+	};
+	//a probe ray that hit an occluder, relit every time the lights change
+	struct RayHit
+	{
+		glm::vec3 direction; //direction from the probe
+		glm::vec3 position, normal, albedo;
+	};
+	struct Probe
+	{
+		float sky[12];          //L1 SH of the sky the probe sees, 4 RGB coefficients
+		std::vector<RayHit> hits;
+		bool inside;            //the probe is inside an occluder, it uses the environment SH
+	};
+
+	bool m_Init;
+	glm::ivec3 m_Resolution;
+	glm::vec3 m_BoundsMin, m_BoundsMax;
+	unsigned int m_Textures[3];
+	SH9Color m_EnvironmentSH;
+	std::vector<Occluder> m_Occluders;
+	std::vector<Probe> m_Probes; //only touched by the worker thread
+
+	std::thread m_Worker;
+	std::mutex m_Mutex;
+	std::condition_variable m_Condition;
+	//shared with the worker thread, guarded by m_Mutex
+	bool m_Quit, m_LightsChanged, m_ResultReady;
+	unsigned int m_NrOfLights;
+	glm::vec3 m_LightPositions[IRRADIANCE_VOLUME_MAX_LIGHTS];
+	glm::vec3 m_LightColors[IRRADIANCE_VOLUME_MAX_LIGHTS];
+	std::vector<float> m_Result;
+
+	//main thread only
+	std::vector<float> m_Uploaded;
+	unsigned int m_NrOfUploads;
+
+	void stopWorker()
+	{
+		if(!m_Worker.joinable())
+			return;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Quit = 1;
+		}
+		m_Condition.notify_one();
+		m_Worker.join();
+	}
+	void workerLoop()
+	{
+		std::vector<float> result(m_Result.size());
+		glm::vec3 lightPositions[IRRADIANCE_VOLUME_MAX_LIGHTS], lightColors[IRRADIANCE_VOLUME_MAX_LIGHTS];
+
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		while(true)
+		{
+			m_Condition.wait(lock, [this]() { return m_Quit || m_LightsChanged; });
+			if(m_Quit)
+				return;
+			unsigned int nrOfLights = m_NrOfLights;
+			for(unsigned int i = 0; i < nrOfLights; i++)
+			{
+				lightPositions[i] = m_LightPositions[i];
+				lightColors[i] = m_LightColors[i];
+			}
+			m_LightsChanged = 0;
+			lock.unlock();
+
+			if(m_Probes.empty())
+				traceProbes();
+			relight(lightPositions, lightColors, nrOfLights, result);
+
+			lock.lock();
+			m_Result.swap(result);
+			m_ResultReady = 1;
+		}
+	}
+
+	glm::vec3 probePosition(int x, int y, int z)
+	{
+		glm::vec3 t = glm::vec3(x, y, z) / glm::vec3(m_Resolution - 1);
+		return glm::mix(m_BoundsMin, m_BoundsMax, t);
+	}
+
+	//traces the rays of every probe once, the occluders don't move
+	void traceProbes()
+	{
+		//L2 radiance of the environment, the stored coefficients are convolved with the cosine lobe (see SHProjector)
+		const float band[SH_COEFFICIENT_COUNT] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+		SH9Color skyRadiance;
+		for(unsigned int c = 0; c < SH_COEFFICIENT_COUNT; c++)
+			skyRadiance.coefficients[c] = m_EnvironmentSH.coefficients[c] / band[c];
+
+		const float sampleWeight = 4.0f * 3.14159265359f / IRRADIANCE_VOLUME_RAY_COUNT;
+		m_Probes.resize(m_Resolution.x * m_Resolution.y * m_Resolution.z);
+		for(int z = 0; z < m_Resolution.z; z++)
+		for(int y = 0; y < m_Resolution.y; y++)
+		for(int x = 0; x < m_Resolution.x; x++)
+		{
+			Probe& probe = m_Probes[(z * m_Resolution.y + y) * m_Resolution.x + x];
+			glm::vec3 origin = probePosition(x, y, z);
+			for(unsigned int i = 0; i < 12; i++)
+				probe.sky[i] = 0.0f;
+			probe.inside = insideOccluder(origin);
+			if(probe.inside)
+				continue;
+
+			for(unsigned int i = 0; i < IRRADIANCE_VOLUME_RAY_COUNT; i++)
+			{
+				//fibonacci sphere directions
+				float cosTheta = 1.0f - 2.0f * (i + 0.5f) / IRRADIANCE_VOLUME_RAY_COUNT;
+				float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+				float phi = i * 2.39996323f;
+				glm::vec3 dir = glm::vec3(std::cos(phi) * sinTheta, cosTheta, std::sin(phi) * sinTheta);
+
+				RayHit hit;
+				if(trace(origin, dir, 1e30f, &hit))
+				{
+					hit.direction = dir;
+					probe.hits.push_back(hit);
+				}
+				else
+					addToL1(probe.sky, dir, skyRadiance.Evaluate(dir) * sampleWeight);
+			}
+		}
+	}
+
+	//sky SH plus the light the occluders reflect towards every probe
+	void relight(const glm::vec3* lightPositions, const glm::vec3* lightColors, unsigned int nrOfLights, std::vector<float>& result)
+	{
+		const float sampleWeight = 4.0f * 3.14159265359f / IRRADIANCE_VOLUME_RAY_COUNT;
+		const float band[4] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f };
+		for(unsigned int p = 0; p < m_Probes.size(); p++)
+		{
+			float* coefficients = &result[p * 12];
+			if(m_Probes[p].inside)
+			{
+				for(unsigned int k = 0; k < 4; k++)
+					for(unsigned int c = 0; c < 3; c++)
+						coefficients[k * 3 + c] = m_EnvironmentSH.coefficients[k][c];
+				continue;
+			}
+
+			float radiance[12];
+			for(unsigned int i = 0; i < 12; i++)
+				radiance[i] = m_Probes[p].sky[i];
+			for(unsigned int i = 0; i < m_Probes[p].hits.size(); i++)
+			{
+				const RayHit& hit = m_Probes[p].hits[i];
+				//lambertian surface: the sky irradiance / Pi is what the environment SH stores, the lights are divided by Pi here
+				glm::vec3 irradiance = m_EnvironmentSH.Evaluate(hit.normal);
+				for(unsigned int l = 0; l < nrOfLights; l++)
+				{
+					glm::vec3 toLight = lightPositions[l] - hit.position;
+					float distanceSquared = glm::dot(toLight, toLight);
+					glm::vec3 L = toLight / std::sqrt(distanceSquared);
+					float NdotL = glm::dot(hit.normal, L);
+					if(NdotL <= 0.0f || trace(hit.position + hit.normal * 0.001f, L, std::sqrt(distanceSquared), nullptr))
+						continue;
+					irradiance += lightColors[l] * NdotL / (distanceSquared * 3.14159265359f);
+				}
+				addToL1(radiance, hit.direction, hit.albedo * irradiance * sampleWeight);
+			}
+
+			for(unsigned int k = 0; k < 4; k++)
+				for(unsigned int c = 0; c < 3; c++)
+					coefficients[k * 3 + c] = radiance[k * 3 + c] * band[k];
+		}
+	}
+
+	static void addToL1(float* coefficients, glm::vec3 dir, glm::vec3 value)
+	{
+		const float basis[4] = { 0.282095f, 0.488603f * dir.y, 0.488603f * dir.z, 0.488603f * dir.x };
+		for(unsigned int k = 0; k < 4; k++)
+		{
+			coefficients[k * 3 + 0] += value.r * basis[k];
+			coefficients[k * 3 + 1] += value.g * basis[k];
+			coefficients[k * 3 + 2] += value.b * basis[k];
+		}
+	}
+
+	bool insideOccluder(glm::vec3 p)
+	{
+		for(unsigned int i = 0; i < m_Occluders.size(); i++)
+		{
+			const Occluder& o = m_Occluders[i];
+			if(o.type == SPHERE_OCCLUDER && glm::dot(p - o.a, p - o.a) < o.b.x * o.b.x)
+				return 1;
+			if(o.type == BOX_OCCLUDER && glm::all(glm::greaterThan(p, o.a)) && glm::all(glm::lessThan(p, o.b)))
+				return 1;
+		}
+		return 0;
+	}
+
+	//closest hit along the ray up to maxDistance, hit can be null for shadow rays
+	bool trace(glm::vec3 origin, glm::vec3 dir, float maxDistance, RayHit* hit)
+	{
+		float closest = maxDistance;
+		int closestIndex = -1;
+		glm::vec3 closestNormal(0.0f);
+		for(unsigned int i = 0; i < m_Occluders.size(); i++)
+		{
+			const Occluder& o = m_Occluders[i];
+			float t;
+			glm::vec3 normal;
+			if(o.type == SPHERE_OCCLUDER)
+			{
+				glm::vec3 oc = origin - o.a;
+				float b = glm::dot(oc, dir);
+				float c = glm::dot(oc, oc) - o.b.x * o.b.x;
+				float discriminant = b * b - c;
+				if(discriminant < 0.0f)
+					continue;
+				t = -b - std::sqrt(discriminant);
+				if(t <= 0.0f)
+					continue;
+				normal = (origin + dir * t - o.a) / o.b.x;
+			}
+			else
+			{
+				glm::vec3 invDir = 1.0f / dir;
+				glm::vec3 t0 = (o.a - origin) * invDir;
+				glm::vec3 t1 = (o.b - origin) * invDir;
+				glm::vec3 tMin = glm::min(t0, t1), tMax = glm::max(t0, t1);
+				float tNear = std::max(tMin.x, std::max(tMin.y, tMin.z));
+				float tFar = std::min(tMax.x, std::min(tMax.y, tMax.z));
+				if(tNear > tFar || tNear <= 0.0f)
+					continue;
+				t = tNear;
+				normal = glm::vec3(0.0f);
+				if(tNear == tMin.x)      normal.x = dir.x > 0.0f ? -1.0f : 1.0f;
+				else if(tNear == tMin.y) normal.y = dir.y > 0.0f ? -1.0f : 1.0f;
+				else                     normal.z = dir.z > 0.0f ? -1.0f : 1.0f;
+			}
+			if(t < closest)
+			{
+				if(!hit)
+					return 1;
+				closest = t;
+				closestIndex = i;
+				closestNormal = normal;
+			}
+		}
+		if(closestIndex < 0)
+			return 0;
+		hit->position = origin + dir * closest;
+		hit->normal = closestNormal;
+		hit->albedo = m_Occluders[closestIndex].albedo;
+		return 1;
+	}
+};
+
+#endif
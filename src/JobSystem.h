@@ -0,0 +1,474 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <utility>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#define JOB_SYSTEM_DEQUE_SIZE 4096 //jobs one thread can have queued, a power of 2. jobs that don't fit run right away
+#define JOB_SYSTEM_POOL_SIZE 4096 //preallocated jobs per thread, a power of 2
+#define JOB_SYSTEM_SPIN_COUNT 64 //rounds of failed stealing before a worker goes to sleep
+
+class JobCounter;
+
+struct Job
+{
+	std::function<void()> m_Task;
+	const std::function<void(unsigned int, unsigned int)>* m_Range; //parallel for chunks call this with m_Begin, m_End instead of m_Task
+	unsigned int m_Begin, m_End;
+	JobCounter* m_Counter;
+	std::atomic<bool> m_Free;
+	bool m_Heap; //allocated because the pool of the thread was used up
+
+	Job()
+		:m_Range(nullptr), m_Begin(0), m_End(0), m_Counter(nullptr), m_Free(true), m_Heap(false)
+	{
+
+	}
+};
+
+//number of unfinished jobs. jobs can be made to wait for a counter, they are started once it reaches zero,
+//so all jobs of a counter have to be added before anything depends on it.
+//The last job decrements the counter under its mutex, so a counter may be destroyed as soon as JobSystem::Wait returns
+class JobCounter
+{
+public:
+	JobCounter()
+		:m_Value(0)
+	{
+
+	}
+
+	inline bool Done() const { return m_Value.load() == 0; }
+
+private:
+	friend class JobSystem;
+	std::atomic<int> m_Value;
+	std::mutex m_Mutex;
+	std::vector<Job*> m_Waiting;
+};
+
+//Chase-Lev work-stealing deque: the owning thread pushes and pops at the bottom, other threads steal from the top
+class JobDeque
+{
+public:
+	JobDeque()
+		:m_Top(0), m_Bottom(0)
+	{
+		for(unsigned int i = 0; i < JOB_SYSTEM_DEQUE_SIZE; i++)
+			m_Jobs[i].store(nullptr, std::memory_order_relaxed);
+	}
+
+	//owner only, returns false if the deque is full
+	bool Push(Job* job)
+	{
+		long long bottom = m_Bottom.load(std::memory_order_relaxed);
+		long long top = m_Top.load(std::memory_order_acquire);
+		if(bottom - top >= JOB_SYSTEM_DEQUE_SIZE)
+			return false;
+		m_Jobs[bottom & (JOB_SYSTEM_DEQUE_SIZE - 1)].store(job, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+		return true;
+	}
+	//owner only, the newest job
+	Job* Pop()
+	{
+		long long bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+		m_Bottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		long long top = m_Top.load(std::memory_order_relaxed);
+		if(top > bottom)
+		{
+			m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+		Job* job = m_Jobs[bottom & (JOB_SYSTEM_DEQUE_SIZE - 1)].load(std::memory_order_relaxed);
+		if(top == bottom)
+		{
+			//the last job, a thief may be taking it at the same time
+			if(!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				job = nullptr;
+			m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+		return job;
+	}
+	//any thread, the oldest job. returns nullptr if empty or if another thread got the job first
+	Job* Steal()
+	{
+		long long top = m_Top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		long long bottom = m_Bottom.load(std::memory_order_acquire);
+		if(top >= bottom)
+			return nullptr;
+		Job* job = m_Jobs[top & (JOB_SYSTEM_DEQUE_SIZE - 1)].load(std::memory_order_relaxed);
+		if(!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			return nullptr;
+		return job;
+	}
+
+private:
+	std::atomic<long long> m_Top;
+	char m_Padding[64]; //keeps the thieves' and the owner's index on different cache lines
+	std::atomic<long long> m_Bottom;
+	std::atomic<Job*> m_Jobs[JOB_SYSTEM_DEQUE_SIZE];
+};
+
+//Work-stealing job scheduler. Every worker thread and the thread that called Init() own a deque, new jobs go into the deque
+//of the thread that adds them and idle threads steal from the others. A thread waiting for a counter runs jobs until it is done.
+//Jobs may only be added from the job threads, other threads run them right away.
+class JobSystem
+{
+public:
+	JobSystem()
+		:m_Init(0), m_Quit(0), m_NrOfActiveWorkers(0), m_Pending(0), m_Sleeping(0)
+	{
+
+	}
+	~JobSystem()
+	{
+
+	}
+
+	//0 workers starts one per hardware thread besides the calling one
+	bool Init(unsigned int nrOfWorkers = 0)
+	{
+		if(m_Init) return 1;
+		if(nrOfWorkers == 0)
+			nrOfWorkers = std::max(1u, std::thread::hardware_concurrency()) - 1;
+		m_Quit = 0;
+		m_NrOfActiveWorkers = nrOfWorkers;
+		for(unsigned int i = 0; i <= nrOfWorkers; i++)
+		{
+			m_Deques.push_back(new JobDeque());
+			m_Pools.push_back(new Job[JOB_SYSTEM_POOL_SIZE]);
+			m_NextJob.push_back(0);
+		}
+		setThreadIndex(0);
+		for(unsigned int i = 1; i <= nrOfWorkers; i++)
+			m_Threads.push_back(std::thread(&JobSystem::worker, this, i));
+		m_Init = 1;
+		return 1;
+	}
+	void Destroy()
+	{
+		if(!m_Init)
+			return;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Quit = 1;
+		}
+		m_WakeUp.notify_all();
+		for(unsigned int i = 0; i < m_Threads.size(); i++)
+			m_Threads[i].join();
+		m_Threads.clear();
+		for(unsigned int i = 0; i < m_Deques.size(); i++)
+		{
+			delete m_Deques[i];
+			delete[] m_Pools[i];
+		}
+		m_Deques.clear();
+		m_Pools.clear();
+		m_NextJob.clear();
+		setThreadIndex(-1);
+		m_Init = 0;
+	}
+
+	//adds a job, counter (if given) counts it until it's finished and it doesn't start before dependency (if given) is done
+	void Run(const std::function<void()>& task, JobCounter* counter = nullptr, JobCounter* dependency = nullptr)
+	{
+		int thread = threadIndex();
+		if(!m_Init || thread < 0)
+		{
+			if(dependency)
+				Wait(*dependency);
+			task();
+			return;
+		}
+		Job* job = allocate(thread);
+		job->m_Task = task;
+		job->m_Range = nullptr;
+		job->m_Counter = counter;
+		if(counter)
+			counter->m_Value++;
+		if(dependency)
+		{
+			std::lock_guard<std::mutex> lock(dependency->m_Mutex);
+			if(dependency->m_Value.load() > 0)
+			{
+				dependency->m_Waiting.push_back(job);
+				return;
+			}
+		}
+		push(thread, job);
+	}
+	//runs jobs until the counter is done
+	void Wait(JobCounter& counter)
+	{
+		int thread = threadIndex();
+		while(counter.m_Value.load() > 0)
+		{
+			Job* job = thread >= 0 && m_Init ? findJob(thread) : nullptr;
+			if(job)
+				execute(job);
+			else
+				std::this_thread::yield();
+		}
+		//the thread that finished the last job may still hold the mutex, it doesn't touch the counter once it lets go
+		std::lock_guard<std::mutex> lock(counter.m_Mutex);
+	}
+	//calls function(begin, end) for every chunk of grain iterations of [0, count) and returns once all chunks are done.
+	//the calling thread runs the first chunk itself and helps with the others while it waits
+	void ParallelFor(unsigned int count, unsigned int grain, const std::function<void(unsigned int, unsigned int)>& function)
+	{
+		if(count == 0)
+			return;
+		grain = std::max(1u, grain);
+		int thread = threadIndex();
+		if(!m_Init || thread < 0 || count <= grain || m_NrOfActiveWorkers == 0)
+		{
+			for(unsigned int begin = 0; begin < count; begin += grain)
+				function(begin, std::min(begin + grain, count));
+			return;
+		}
+
+		JobCounter counter;
+		for(unsigned int begin = grain; begin < count; begin += grain)
+		{
+			Job* job = allocate(thread);
+			job->m_Range = &function;
+			job->m_Begin = begin;
+			job->m_End = std::min(begin + grain, count);
+			job->m_Counter = &counter;
+			counter.m_Value++;
+			push(thread, job);
+		}
+		function(0, grain);
+		Wait(counter);
+	}
+
+	inline unsigned int NrOfWorkers() const { return (unsigned int)m_Threads.size(); }
+	//limits how many workers take jobs, e.g. to measure scaling
+	void SetNrOfActiveWorkers(unsigned int nrOfWorkers)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_NrOfActiveWorkers = std::min(nrOfWorkers, NrOfWorkers());
+		}
+		m_WakeUp.notify_all();
+	}
+	inline unsigned int NrOfActiveWorkers() const { return m_NrOfActiveWorkers; }
+
+	//times spawning empty jobs and a CPU bound parallel for with 1 to all threads, the results are printed to the console
+	static void Benchmark(unsigned int nrOfWorkers = 0)
+	{
+		JobSystem jobs;
+		jobs.Init(nrOfWorkers);
+		const unsigned int nrOfJobs = 100000;
+		std::cout << "Job system with " << jobs.NrOfWorkers() << " workers + the calling thread:" << std::endl;
+
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		JobCounter counter;
+		for(unsigned int i = 0; i < nrOfJobs; i++)
+			jobs.Run([]() {}, &counter);
+		jobs.Wait(counter);
+		double spawn = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / nrOfJobs;
+		std::cout << "  spawn + run of an empty job: " << spawn << "ns" << std::endl;
+
+		start = std::chrono::high_resolution_clock::now();
+		std::function<void(unsigned int, unsigned int)> empty = [](unsigned int, unsigned int) {};
+		jobs.ParallelFor(nrOfJobs, 1, empty);
+		double chunk = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / nrOfJobs;
+		std::cout << "  empty parallel for chunk: " << chunk << "ns" << std::endl;
+
+		const unsigned int count = 1 << 22;
+		std::vector<float> values(count);
+		std::function<void(unsigned int, unsigned int)> work = [&](unsigned int begin, unsigned int end)
+		{
+			for(unsigned int i = begin; i < end; i++)
+				values[i] = std::sqrt(std::sin(i * 0.001f) * std::sin(i * 0.001f) + 1.0f);
+		};
+		double singleThreaded = 0.0;
+		for(unsigned int workers = 0; workers <= jobs.NrOfWorkers(); workers++)
+		{
+			jobs.SetNrOfActiveWorkers(workers);
+			start = std::chrono::high_resolution_clock::now();
+			for(unsigned int i = 0; i < 10; i++)
+				jobs.ParallelFor(count, 4096, work);
+			double time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / 10.0;
+			if(workers == 0)
+				singleThreaded = time;
+			std::cout << "  " << workers + 1 << " threads: " << time << "ms (x" << singleThreaded / time << ")" << std::endl;
+		}
+		jobs.Destroy();
+	}
+
+private:
+	bool m_Init;
+	std::vector<std::thread> m_Threads;
+	std::vector<JobDeque*> m_Deques; //index 0 belongs to the thread that called Init
+	std::vector<Job*> m_Pools;
+	std::vector<unsigned int> m_NextJob;
+	std::mutex m_Mutex;
+	std::condition_variable m_WakeUp;
+	std::atomic<bool> m_Quit;
+	std::atomic<unsigned int> m_NrOfActiveWorkers;
+	std::atomic<int> m_Pending; //jobs sitting in the deques
+	std::atomic<int> m_Sleeping;
+
+	//the deque index of the calling thread in every job system it belongs to, the main thread can be in more than one (see Benchmark)
+	static std::vector<std::pair<const JobSystem*, int>>& threadIndices()
+	{
+		static thread_local std::vector<std::pair<const JobSystem*, int>> indices;
+		return indices;
+	}
+	//index of the deque of the calling thread, -1 for threads that don't belong to this job system
+	int threadIndex() const
+	{
+		const std::vector<std::pair<const JobSystem*, int>>& indices = threadIndices();
+		for(unsigned int i = 0; i < indices.size(); i++)
+		{
+			if(indices[i].first == this)
+				return indices[i].second;
+		}
+		return -1;
+	}
+	//-1 removes the calling thread from this job system
+	void setThreadIndex(int index)
+	{
+		std::vector<std::pair<const JobSystem*, int>>& indices = threadIndices();
+		indices.erase(std::remove_if(indices.begin(), indices.end(), [this](const std::pair<const JobSystem*, int>& entry) { return entry.first == this; }), indices.end());
+		if(index >= 0)
+			indices.push_back(std::make_pair(this, index));
+	}
+
+	//only the owning thread allocates from its pool, any thread may free a job into it
+	Job* allocate(int thread)
+	{
+		Job* pool = m_Pools[thread];
+		for(unsigned int i = 0; i < JOB_SYSTEM_POOL_SIZE; i++)
+		{
+			Job* job = &pool[m_NextJob[thread]++ & (JOB_SYSTEM_POOL_SIZE - 1)];
+			if(job->m_Free.load(std::memory_order_acquire))
+			{
+				job->m_Free.store(false, std::memory_order_relaxed);
+				job->m_Heap = 0;
+				return job;
+			}
+		}
+		Job* job = new Job();
+		job->m_Free = false;
+		job->m_Heap = 1;
+		return job;
+	}
+	void push(int thread, Job* job)
+	{
+		if(!m_Deques[thread]->Push(job))
+		{
+			execute(job);
+			return;
+		}
+		m_Pending++;
+		if(m_Sleeping.load() > 0)
+		{
+			//taking the lock makes sure a worker that is about to sleep either sees the job or gets the notification
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+			}
+			m_WakeUp.notify_one();
+		}
+	}
+	Job* findJob(int thread)
+	{
+		Job* job = m_Deques[thread]->Pop();
+		if(!job)
+		{
+			unsigned int nrOfDeques = (unsigned int)m_Deques.size();
+			unsigned int first = (unsigned int)thread + (unsigned int)m_NextJob[thread];
+			for(unsigned int i = 0; i < nrOfDeques && !job; i++)
+			{
+				unsigned int victim = (first + i) % nrOfDeques;
+				if(victim != (unsigned int)thread)
+					job = m_Deques[victim]->Steal();
+			}
+		}
+		if(job)
+			m_Pending--;
+		return job;
+	}
+	void execute(Job* job)
+	{
+		if(job->m_Range)
+			(*job->m_Range)(job->m_Begin, job->m_End);
+		else
+			job->m_Task();
+
+		JobCounter* counter = job->m_Counter;
+		job->m_Task = nullptr;
+		if(job->m_Heap)
+			delete job;
+		else
+			job->m_Free.store(true, std::memory_order_release);
+
+		if(counter)
+		{
+			//decremented under the mutex: Wait() takes it before returning, so the counter outlives this block,
+			//and Run() sees either a count above 0 or an empty waiting list, never a job that would be left behind
+			std::vector<Job*> waiting;
+			{
+				std::lock_guard<std::mutex> lock(counter->m_Mutex);
+				if(counter->m_Value.fetch_sub(1) == 1)
+					waiting.swap(counter->m_Waiting);
+			}
+			int thread = threadIndex();
+			for(unsigned int i = 0; i < waiting.size(); i++)
+				push(thread, waiting[i]);
+		}
+	}
+	void worker(unsigned int index)
+	{
+		setThreadIndex((int)index);
+		unsigned int spins = 0;
+		while(!m_Quit.load())
+		{
+			if(index <= m_NrOfActiveWorkers.load())
+			{
+				Job* job = findJob(index);
+				if(job)
+				{
+					execute(job);
+					spins = 0;
+					continue;
+				}
+				if(++spins < JOB_SYSTEM_SPIN_COUNT)
+				{
+					std::this_thread::yield();
+					continue;
+				}
+			}
+
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Sleeping++;
+			m_WakeUp.wait(lock, [&]() { return m_Quit.load() || (m_Pending.load() > 0 && index <= m_NrOfActiveWorkers.load()); });
+			m_Sleeping--;
+			spins = 0;
+		}
+	}
+};
+
+//the job system the engine's CPU work runs on, initialized by the main thread
+inline JobSystem& GetJobSystem()
+{
+	static JobSystem jobSystem;
+	return jobSystem;
+}
+
+#endif
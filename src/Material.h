@@ -96,4 +96,23 @@ const glm::vec3 materialPBR =			{ 0.8f, 0.4f, 0.3f };
 const glm::vec3 materialBlinnPhong =	{ 0.5f, 0.1f, 0.9f };
 const glm::vec3 materialCellShading =	{ 0.4f, 0.7f, 0.4f };
 
+//8-bit material IDs stored in the alpha of the G-buffer's metallic/roughness/AO texture, 0 means nothing was drawn to the pixel
+enum MaterialID
+{
+	MATERIAL_ID_NONE = 0,
+	MATERIAL_ID_PBR,
+	MATERIAL_ID_BLINN_PHONG,
+	MATERIAL_ID_CELL_SHADING,
+	NR_OF_MATERIAL_IDS
+};
+
+//the shading masks indexed by material ID, uploaded to the passes that decode the G-buffer
+const glm::vec3 materialTable[NR_OF_MATERIAL_IDS] = { glm::vec3(0.0f), materialPBR, materialBlinnPhong, materialCellShading };
+
+inline void setMaterialTable(Shader& shader)
+{
+	for(unsigned int i = 0; i < NR_OF_MATERIAL_IDS; i++)
+		shader.setVec3("materialTable[" + std::to_string(i) + "]", materialTable[i]);
+}
+
 #endif
\ No newline at end of file
@@ -8,6 +8,7 @@
 
 #include <src/shader.h>
 #include <src/Material.h>
+#include <src/Bounds.h>
 
 #include <iostream>
 #include <string>
@@ -39,6 +40,9 @@ public:
 	unsigned int m_VAO;
 	MeshType m_Type;
 	Shader* m_Shader;
+	//local space bounds of m_Vertices, computed when the mesh is created
+	BoundingBox m_Bounds;
+	BoundingSphere m_BoundingSphere;
 
 	//constructor that takes in vector array of vertices, indices and textures of the mesh
 	Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::string materialID, MeshType type, bool instanced = 0)
@@ -48,6 +52,8 @@ public:
 		this->m_Indices = indices;
 		this->m_MaterialID = materialID;
 		isSetup = 0;
+		if(!m_Vertices.empty())
+			ComputeBounds(&m_Vertices[0].m_Position.x, (unsigned int)m_Vertices.size(), sizeof(Vertex) / sizeof(float), m_Bounds, m_BoundingSphere);
 	}
 
 	~Mesh()//TO DO: add a destructor to destroy all unneeded objects and variables or just to prevent memory leaks
@@ -314,4 +320,21 @@ private:
 	}
 };
 
+//the box around all meshes and the sphere centered on it that encloses every mesh's sphere
+inline void CombineBounds(const std::vector<Mesh>& meshes, BoundingBox& box, BoundingSphere& sphere)
+{
+	box = BoundingBox();
+	sphere = BoundingSphere();
+	for(unsigned int i = 0; i < meshes.size(); i++)
+		box.Add(meshes[i].m_Bounds);
+	if(box.IsEmpty())
+		return;
+	sphere = BoundingSphere(box.Center(), 0.0f);
+	for(unsigned int i = 0; i < meshes.size(); i++)
+	{
+		if(!meshes[i].m_BoundingSphere.IsEmpty())
+			sphere.m_Radius = std::max(sphere.m_Radius, glm::length(meshes[i].m_BoundingSphere.m_Center - sphere.m_Center) + meshes[i].m_BoundingSphere.m_Radius);
+	}
+}
+
 #endif
\ No newline at end of file
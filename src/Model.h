@@ -31,6 +31,9 @@ public:
 	std::vector<Mesh> m_Meshes;
 	std::string m_Directory;
 	bool m_GammaCorrection;
+	//local space bounds of all meshes together
+	BoundingBox m_Bounds;
+	BoundingSphere m_BoundingSphere;
 
 	//constructor that takes in a filepath to a 3D model
 	Model(std::string const &path, unsigned int instances, bool gamma = false)
@@ -73,6 +76,7 @@ private:
 
 		//process ASSIMP's root node recursively
 		processNode(scene->mRootNode, scene);
+		CombineBounds(m_Meshes, m_Bounds, m_BoundingSphere);
 	}
 
 	//processes a node recursively. Processes each mesh located at the node and repeats this for any child nodes
@@ -209,6 +213,9 @@ public:
 	std::string m_Directory;
 	std::string m_FileName;
 	bool m_GammaCorrection;
+	//local space bounds of all meshes together
+	BoundingBox m_Bounds;
+	BoundingSphere m_BoundingSphere;
 
 	//constructor that takes in a filepath to a 3D model
 	PBRModel(std::string const& path, bool gamma = false)
@@ -249,6 +256,7 @@ private:
 
 		//process ASSIMP's root node recursively
 		processNode(scene->mRootNode, scene);
+		CombineBounds(m_Meshes, m_Bounds, m_BoundingSphere);
 	}
 
 	//processes a node recursively. Processes each mesh located at the node and repeats this for any child nodes
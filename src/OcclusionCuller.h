@@ -0,0 +1,392 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <cmath>
+#include <cfloat>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <src/JobSystem.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define OCCLUSION_CULLER_USE_SSE
+#include <xmmintrin.h>
+#endif
+#if defined(__AVX__)
+#define OCCLUSION_CULLER_USE_AVX
+#include <immintrin.h>
+#endif
+
+#define OCCLUSION_WIDTH 256 //a multiple of 8, so rows split evenly into SIMD blocks
+#define OCCLUSION_HEIGHT 128
+#define OCCLUSION_BAND_HEIGHT 8 //rows rasterized by one job
+#define OCCLUSION_TEST_GRAIN 256 //occludees tested by one job, a multiple of 32 so jobs write separate words of the result
+
+struct OcclusionMesh
+{
+	std::vector<glm::vec3> m_Positions;
+	std::vector<unsigned int> m_Indices; //triangle list
+};
+
+//a triangle ready to rasterize, with m_MinY > m_MaxY if it was rejected
+struct OcclusionTriangle
+{
+	int m_MinX, m_MaxX, m_MinY, m_MaxY;
+	float m_EdgeA[3], m_EdgeB[3], m_EdgeC[3]; //edge functions A * x + B * y + C, all >= 0 inside
+	float m_DepthA, m_DepthB, m_DepthC; //depth plane A * x + B * y + C
+};
+
+//Software occlusion culling: a few large occluders are rasterized into a small depth buffer on the CPU,
+//then the screen rectangles of the occludees' boxes are tested against it, so the result doesn't depend on the GPU at all.
+//Rasterizing is split into bands of rows that are jobs of their own, every band tests 8 (AVX) or 4 (SSE) pixels of a row at once.
+//Pixels are covered when their center is, so the result can drop objects that only peek through a gap thinner than a pixel.
+//Triangles that cross the near plane are left out rather than clipped, which only makes the buffer less occluded.
+class OcclusionCuller
+{
+public:
+	OcclusionCuller()
+		:m_Jobs(nullptr), m_ViewProjection(1.0f), m_NrOfRasterized(0)
+	{
+		m_Depth.assign(OCCLUSION_WIDTH * OCCLUSION_HEIGHT, 1.0f);
+	}
+
+	//without a job system everything runs on the calling thread
+	void Init(JobSystem* jobs)
+	{
+		m_Jobs = jobs;
+	}
+
+	//occluder meshes should be simple and lie inside the geometry they stand in for, returns the mesh's index
+	unsigned int AddMesh(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices)
+	{
+		m_Meshes.push_back(OcclusionMesh());
+		m_Meshes.back().m_Positions = positions;
+		m_Meshes.back().m_Indices = indices;
+		return (unsigned int)m_Meshes.size() - 1;
+	}
+
+	void ClearOccluders()
+	{
+		m_Occluders.clear();
+		m_Models.clear();
+	}
+	void AddOccluder(unsigned int mesh, const glm::mat4& model)
+	{
+		m_Occluders.push_back(mesh);
+		m_Models.push_back(model);
+	}
+
+	//clears the depth buffer and rasterizes this frame's occluders, the tests use the same matrix
+	void Render(const glm::mat4& viewProjection)
+	{
+		m_ViewProjection = viewProjection;
+		m_TriangleOffsets.resize(m_Occluders.size() + 1);
+		m_TriangleOffsets[0] = 0;
+		for(unsigned int i = 0; i < m_Occluders.size(); i++)
+			m_TriangleOffsets[i + 1] = m_TriangleOffsets[i] + (unsigned int)m_Meshes[m_Occluders[i]].m_Indices.size() / 3;
+		m_Triangles.resize(m_TriangleOffsets.back());
+
+		run((unsigned int)m_Occluders.size(), 1, [this](unsigned int begin, unsigned int end)
+		{
+			for(unsigned int i = begin; i < end; i++)
+				setupOccluder(i);
+		});
+		m_NrOfRasterized = 0;
+		for(unsigned int i = 0; i < m_Triangles.size(); i++)
+			m_NrOfRasterized += m_Triangles[i].m_MinY <= m_Triangles[i].m_MaxY;
+
+		std::fill(m_Depth.begin(), m_Depth.end(), 1.0f);
+		run(OCCLUSION_HEIGHT / OCCLUSION_BAND_HEIGHT, 1, [this](unsigned int begin, unsigned int end)
+		{
+			for(unsigned int band = begin; band < end; band++)
+				rasterizeBand(band);
+		});
+	}
+
+	//sets the bit of every box that is at least partly visible and returns their number.
+	//Boxes outside of the view are not visible, empty boxes (min > max) always are
+	unsigned int Test(const std::vector<glm::vec3>& mins, const std::vector<glm::vec3>& maxs, std::vector<unsigned int>& visible) const
+	{
+		unsigned int count = (unsigned int)mins.size();
+		visible.assign((count + 31) / 32, 0);
+		std::atomic<unsigned int> nrVisible(0);
+		run(count, OCCLUSION_TEST_GRAIN, [&](unsigned int begin, unsigned int end)
+		{
+			unsigned int chunkVisible = 0;
+			for(unsigned int i = begin; i < end; i++)
+			{
+				if(TestBox(mins[i], maxs[i]))
+				{
+					visible[i / 32] |= 1u << (i & 31);
+					chunkVisible++;
+				}
+			}
+			nrVisible += chunkVisible;
+		});
+		return nrVisible;
+	}
+	//the box is visible if any pixel of its screen rectangle is farther away than its nearest corner
+	bool TestBox(const glm::vec3& minimum, const glm::vec3& maximum) const
+	{
+		if(minimum.x > maximum.x)
+			return true;
+		float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, minZ = FLT_MAX;
+		for(unsigned int i = 0; i < 8; i++)
+		{
+			glm::vec4 clip = m_ViewProjection * glm::vec4(i & 1 ? maximum.x : minimum.x, i & 2 ? maximum.y : minimum.y, i & 4 ? maximum.z : minimum.z, 1.0f);
+			//a corner in front of the near plane, the box reaches the camera
+			if(clip.z < -clip.w)
+				return true;
+			glm::vec3 screen = toScreen(clip);
+			minX = std::min(minX, screen.x); maxX = std::max(maxX, screen.x);
+			minY = std::min(minY, screen.y); maxY = std::max(maxY, screen.y);
+			minZ = std::min(minZ, screen.z);
+		}
+		if(maxX < 0.0f || maxY < 0.0f || minX >= (float)OCCLUSION_WIDTH || minY >= (float)OCCLUSION_HEIGHT || minZ > 1.0f)
+			return false;
+		int x0 = std::max(0, (int)minX), x1 = std::min(OCCLUSION_WIDTH - 1, (int)maxX);
+		int y0 = std::max(0, (int)minY), y1 = std::min(OCCLUSION_HEIGHT - 1, (int)maxY);
+		for(int y = y0; y <= y1; y++)
+		{
+			const float* row = &m_Depth[y * OCCLUSION_WIDTH];
+			int x = x0;
+#ifdef OCCLUSION_CULLER_USE_AVX
+			__m256 nearest8 = _mm256_set1_ps(minZ);
+			for(; x + 8 <= x1 + 1; x += 8)
+			{
+				if(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(row + x), nearest8, _CMP_GE_OQ)) != 0)
+					return true;
+			}
+#endif
+#ifdef OCCLUSION_CULLER_USE_SSE
+			__m128 nearest4 = _mm_set1_ps(minZ);
+			for(; x + 4 <= x1 + 1; x += 4)
+			{
+				if(_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + x), nearest4)) != 0)
+					return true;
+			}
+#endif
+			for(; x <= x1; x++)
+			{
+				if(row[x] >= minZ)
+					return true;
+			}
+		}
+		return false;
+	}
+
+	//window space depth in [0, 1], rows from the bottom of the screen up
+	inline const std::vector<float>& Depth() const { return m_Depth; }
+	inline unsigned int NrOfTriangles() const { return (unsigned int)m_Triangles.size(); }
+	inline unsigned int NrOfRasterized() const { return m_NrOfRasterized; }
+
+	//A fixed city of box buildings with small boxes scattered between them, seen from street level.
+	//Times rasterizing and testing with 1 and all threads, the number of culled boxes is the same on every machine and thread count
+	static void Benchmark(JobSystem& jobSystem, unsigned int nrOfOccludees = 100000)
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+		std::vector<glm::vec3> positions;
+		std::vector<unsigned int> indices;
+		for(unsigned int i = 0; i < 8; i++)
+			positions.push_back(glm::vec3(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : 0.0f, i & 4 ? 1.0f : -1.0f));
+		const unsigned int faces[36] = { 0, 1, 3, 0, 3, 2, 4, 6, 7, 4, 7, 5, 0, 4, 5, 0, 5, 1, 2, 3, 7, 2, 7, 6, 0, 2, 6, 0, 6, 4, 1, 5, 7, 1, 7, 3 };
+		indices.assign(faces, faces + 36);
+
+		OcclusionCuller culler;
+		culler.Init(&jobSystem);
+		unsigned int building = culler.AddMesh(positions, indices);
+		std::default_random_engine generator(5);
+		std::uniform_real_distribution<float> height(10.0f, 40.0f), position(-160.0f, 160.0f), size(0.5f, 2.0f), ground(0.0f, 5.0f);
+		for(int x = -150; x <= 150; x += 30)
+		{
+			for(int z = -150; z <= 150; z += 30)
+				culler.AddOccluder(building, glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3((float)x, 0.0f, (float)z)), glm::vec3(10.0f, height(generator), 10.0f)));
+		}
+		std::vector<glm::vec3> mins(nrOfOccludees), maxs(nrOfOccludees);
+		for(unsigned int i = 0; i < nrOfOccludees; i++)
+		{
+			glm::vec3 center(position(generator), ground(generator), position(generator));
+			mins[i] = center - size(generator);
+			maxs[i] = center + size(generator);
+		}
+		glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), (float)OCCLUSION_WIDTH / OCCLUSION_HEIGHT, 0.1f, 1000.0f)
+		                         * glm::lookAt(glm::vec3(5.0f, 3.0f, -200.0f), glm::vec3(0.0f, 3.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+		std::cout << "Occlusion culling, " << culler.m_Occluders.size() << " buildings and " << nrOfOccludees << " boxes at " << OCCLUSION_WIDTH << "x" << OCCLUSION_HEIGHT << ":" << std::endl;
+		const unsigned int nrOfRuns = 20;
+		std::vector<unsigned int> visible;
+		unsigned int nrOfWorkers = jobSystem.NrOfActiveWorkers();
+		unsigned int workers[2] = { 0, nrOfWorkers };
+		for(unsigned int w = 0; w < (nrOfWorkers > 0 ? 2u : 1u); w++)
+		{
+			jobSystem.SetNrOfActiveWorkers(workers[w]);
+			Clock::time_point start = Clock::now();
+			for(unsigned int r = 0; r < nrOfRuns; r++)
+				culler.Render(viewProjection);
+			double renderTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / nrOfRuns;
+			unsigned int nrVisible = 0;
+			start = Clock::now();
+			for(unsigned int r = 0; r < nrOfRuns; r++)
+				nrVisible = culler.Test(mins, maxs, visible);
+			double testTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / nrOfRuns;
+			std::cout << "  " << workers[w] + 1 << " threads: rasterize " << renderTime << "ms (" << culler.NrOfRasterized() << " of " << culler.NrOfTriangles() << " triangles), test "
+			          << testTime << "ms, " << nrOfOccludees - nrVisible << " of " << nrOfOccludees << " boxes culled" << std::endl;
+		}
+		jobSystem.SetNrOfActiveWorkers(nrOfWorkers);
+	}
+
+private:
+	JobSystem* m_Jobs;
+	glm::mat4 m_ViewProjection;
+	std::vector<float> m_Depth;
+	std::vector<OcclusionMesh> m_Meshes;
+	std::vector<unsigned int> m_Occluders; //mesh of each occluder of this frame
+	std::vector<glm::mat4> m_Models;
+	std::vector<unsigned int> m_TriangleOffsets; //first triangle of each occluder
+	std::vector<OcclusionTriangle> m_Triangles;
+	unsigned int m_NrOfRasterized;
+
+	void run(unsigned int count, unsigned int grain, const std::function<void(unsigned int, unsigned int)>& function) const
+	{
+		if(m_Jobs)
+			m_Jobs->ParallelFor(count, grain, function);
+		else if(count > 0)
+			function(0, count);
+	}
+
+	static inline glm::vec3 toScreen(const glm::vec4& clip)
+	{
+		float inverseW = 1.0f / clip.w;
+		return glm::vec3((clip.x * inverseW * 0.5f + 0.5f) * OCCLUSION_WIDTH, (clip.y * inverseW * 0.5f + 0.5f) * OCCLUSION_HEIGHT, clip.z * inverseW * 0.5f + 0.5f);
+	}
+
+	static std::vector<glm::vec4>& clipStorage()
+	{
+		static thread_local std::vector<glm::vec4> clip;
+		return clip;
+	}
+	void setupOccluder(unsigned int occluder)
+	{
+		const OcclusionMesh& mesh = m_Meshes[m_Occluders[occluder]];
+		glm::mat4 modelViewProjection = m_ViewProjection * m_Models[occluder];
+		std::vector<glm::vec4>& clip = clipStorage();
+		clip.resize(mesh.m_Positions.size());
+		for(unsigned int i = 0; i < mesh.m_Positions.size(); i++)
+			clip[i] = modelViewProjection * glm::vec4(mesh.m_Positions[i], 1.0f);
+
+		OcclusionTriangle* triangles = &m_Triangles[m_TriangleOffsets[occluder]];
+		for(unsigned int t = 0; t < mesh.m_Indices.size() / 3; t++)
+		{
+			OcclusionTriangle& triangle = triangles[t];
+			triangle.m_MinY = 1;
+			triangle.m_MaxY = 0;
+			const glm::vec4& c0 = clip[mesh.m_Indices[t * 3]];
+			const glm::vec4& c1 = clip[mesh.m_Indices[t * 3 + 1]];
+			const glm::vec4& c2 = clip[mesh.m_Indices[t * 3 + 2]];
+			if(c0.z < -c0.w || c1.z < -c1.w || c2.z < -c2.w)
+				continue;
+			glm::vec3 v[3] = { toScreen(c0), toScreen(c1), toScreen(c2) };
+			if(v[0].z > 1.0f && v[1].z > 1.0f && v[2].z > 1.0f)
+				continue;
+			float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[2].x - v[0].x) * (v[1].y - v[0].y);
+			if(std::abs(area) < 1e-6f)
+				continue;
+			//both sides are rasterized, clockwise triangles are turned around so the inside is positive
+			if(area < 0.0f)
+			{
+				std::swap(v[1], v[2]);
+				area = -area;
+			}
+			float minX = std::min(v[0].x, std::min(v[1].x, v[2].x)), maxX = std::max(v[0].x, std::max(v[1].x, v[2].x));
+			float minY = std::min(v[0].y, std::min(v[1].y, v[2].y)), maxY = std::max(v[0].y, std::max(v[1].y, v[2].y));
+			if(maxX < 0.0f || maxY < 0.0f || minX >= (float)OCCLUSION_WIDTH || minY >= (float)OCCLUSION_HEIGHT)
+				continue;
+
+			//edge i is opposite of vertex i, so the edge functions divided by the area are its barycentric coordinates
+			float inverseArea = 1.0f / area;
+			triangle.m_DepthA = triangle.m_DepthB = triangle.m_DepthC = 0.0f;
+			for(unsigned int e = 0; e < 3; e++)
+			{
+				const glm::vec3& a = v[(e + 1) % 3];
+				const glm::vec3& b = v[(e + 2) % 3];
+				triangle.m_EdgeA[e] = a.y - b.y;
+				triangle.m_EdgeB[e] = b.x - a.x;
+				triangle.m_EdgeC[e] = a.x * b.y - a.y * b.x;
+				triangle.m_DepthA += triangle.m_EdgeA[e] * v[e].z * inverseArea;
+				triangle.m_DepthB += triangle.m_EdgeB[e] * v[e].z * inverseArea;
+				triangle.m_DepthC += triangle.m_EdgeC[e] * v[e].z * inverseArea;
+			}
+			triangle.m_MinX = std::max(0, (int)minX);
+			triangle.m_MaxX = std::min(OCCLUSION_WIDTH - 1, (int)maxX);
+			triangle.m_MinY = std::max(0, (int)minY);
+			triangle.m_MaxY = std::min(OCCLUSION_HEIGHT - 1, (int)maxY);
+		}
+	}
+
+	//keeps the nearest depth of every pixel center covered by any triangle in the band's rows
+	void rasterizeBand(unsigned int band)
+	{
+		int bandMinY = band * OCCLUSION_BAND_HEIGHT, bandMaxY = bandMinY + OCCLUSION_BAND_HEIGHT - 1;
+		for(unsigned int t = 0; t < m_Triangles.size(); t++)
+		{
+			const OcclusionTriangle& triangle = m_Triangles[t];
+			if(triangle.m_MinY > bandMaxY || triangle.m_MaxY < bandMinY || triangle.m_MinY > triangle.m_MaxY)
+				continue;
+			int minY = std::max(triangle.m_MinY, bandMinY), maxY = std::min(triangle.m_MaxY, bandMaxY);
+			for(int y = minY; y <= maxY; y++)
+			{
+				float py = (float)y + 0.5f;
+				float* row = &m_Depth[y * OCCLUSION_WIDTH];
+				float rowEdge[3];
+				for(unsigned int e = 0; e < 3; e++)
+					rowEdge[e] = triangle.m_EdgeB[e] * py + triangle.m_EdgeC[e];
+				float rowDepth = triangle.m_DepthB * py + triangle.m_DepthC;
+#if defined(OCCLUSION_CULLER_USE_AVX)
+				const __m256 offsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+				for(int x = triangle.m_MinX & ~7; x <= triangle.m_MaxX; x += 8)
+				{
+					__m256 px = _mm256_add_ps(_mm256_set1_ps((float)x), offsets);
+					__m256 inside = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(triangle.m_EdgeA[0]), px), _mm256_set1_ps(rowEdge[0])), _mm256_setzero_ps(), _CMP_GE_OQ);
+					inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(triangle.m_EdgeA[1]), px), _mm256_set1_ps(rowEdge[1])), _mm256_setzero_ps(), _CMP_GE_OQ));
+					inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(triangle.m_EdgeA[2]), px), _mm256_set1_ps(rowEdge[2])), _mm256_setzero_ps(), _CMP_GE_OQ));
+					if(_mm256_movemask_ps(inside) == 0)
+						continue;
+					__m256 depth = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(triangle.m_DepthA), px), _mm256_set1_ps(rowDepth));
+					__m256 current = _mm256_loadu_ps(row + x);
+					_mm256_storeu_ps(row + x, _mm256_blendv_ps(current, _mm256_min_ps(current, depth), inside));
+				}
+#elif defined(OCCLUSION_CULLER_USE_SSE)
+				const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+				for(int x = triangle.m_MinX & ~3; x <= triangle.m_MaxX; x += 4)
+				{
+					__m128 px = _mm_add_ps(_mm_set1_ps((float)x), offsets);
+					__m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.m_EdgeA[0]), px), _mm_set1_ps(rowEdge[0])), _mm_setzero_ps());
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.m_EdgeA[1]), px), _mm_set1_ps(rowEdge[1])), _mm_setzero_ps()));
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.m_EdgeA[2]), px), _mm_set1_ps(rowEdge[2])), _mm_setzero_ps()));
+					if(_mm_movemask_ps(inside) == 0)
+						continue;
+					__m128 depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.m_DepthA), px), _mm_set1_ps(rowDepth));
+					__m128 current = _mm_loadu_ps(row + x);
+					__m128 nearest = _mm_min_ps(current, depth);
+					_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+				}
+#else
+				for(int x = triangle.m_MinX; x <= triangle.m_MaxX; x++)
+				{
+					float px = (float)x + 0.5f;
+					if(triangle.m_EdgeA[0] * px + rowEdge[0] >= 0.0f && triangle.m_EdgeA[1] * px + rowEdge[1] >= 0.0f && triangle.m_EdgeA[2] * px + rowEdge[2] >= 0.0f)
+						row[x] = std::min(row[x], triangle.m_DepthA * px + rowDepth);
+				}
+#endif
+			}
+		}
+	}
+};
+
+#endif
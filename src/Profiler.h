@@ -0,0 +1,385 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+
+#define PROFILER_FRAME_LATENCY 4 //frames the GPU results may lag behind before a frame is recorded without GPU times
+#define PROFILER_HISTORY 240 //frames kept for the rolling graph
+#define PROFILER_STALE_FRAMES 60 //scopes that didn't run for this many frames are hidden from the table
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+//times the enclosing block on the CPU and, for PROFILE_GPU, the commands it submits on the GPU. the name has to be a string literal
+#define PROFILE_GPU(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name, true)
+#define PROFILE_CPU(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name, false)
+
+struct ProfileEvent
+{
+	const char* m_Name;
+	unsigned int m_Depth;
+	double m_CPUStart, m_CPUEnd; //milliseconds since the profiler was initialized
+	int m_Query; //first of the start/end timestamp query pair, -1 without GPU timing
+	double m_GPUStart, m_GPUEnd; //milliseconds on the GPU's clock, filled in when the queries are read back
+};
+
+//per scope name, smoothed over the last frames
+struct ProfileStat
+{
+	const char* m_Name;
+	unsigned int m_Depth;
+	float m_CPU, m_GPU; //milliseconds
+	bool m_HasGPU;
+	unsigned long long m_LastFrame;
+	double m_GPUTotal; //milliseconds since the last ResetMeans()
+	unsigned int m_NrOfGPUSamples;
+};
+
+//Frame profiler with named scopes that may nest. GPU scopes are timed with a pair of GL_TIMESTAMP queries, which can be taken while
+//a GL_TIME_ELAPSED query is active (dynamic resolution times the whole frame with one). Every frame takes its queries from one of
+//PROFILER_FRAME_LATENCY pools which are read back once the GPU got to them, so profiling never stalls the pipeline.
+//A number of frames can be captured and written as a Chrome trace (chrome://tracing, Perfetto).
+class Profiler
+{
+public:
+	Profiler()
+		:m_Init(0), m_FrameIndex(0), m_LastProcessedFrame(0), m_Current(nullptr), m_Depth(0), m_GPUOffset(0.0), m_CaptureFrames(0)
+	{
+		for(unsigned int i = 0; i < PROFILER_HISTORY; i++)
+		{
+			m_CPUHistory[i] = 0.0f;
+			m_GPUHistory[i] = 0.0f;
+		}
+		m_HistoryIndex = 0;
+		m_FrameCPU = m_FrameGPU = 0.0f;
+	}
+
+	bool Init()
+	{
+		if(m_Init) return 1;
+		m_Start = std::chrono::high_resolution_clock::now();
+		for(unsigned int i = 0; i < PROFILER_FRAME_LATENCY; i++)
+		{
+			m_Frames[i].m_Pending = 0;
+			m_Frames[i].m_NrOfQueries = 0;
+		}
+		m_Init = 1;
+		return 1;
+	}
+	void Destroy()
+	{
+		for(unsigned int i = 0; i < PROFILER_FRAME_LATENCY; i++)
+		{
+			if(!m_Frames[i].m_Queries.empty())
+				glDeleteQueries((GLsizei)m_Frames[i].m_Queries.size(), &m_Frames[i].m_Queries[0]);
+			m_Frames[i].m_Queries.clear();
+		}
+		m_Init = 0;
+	}
+
+	//reads back the finished frames and starts recording a new one
+	void BeginFrame()
+	{
+		readBack();
+
+		Frame& frame = m_Frames[m_FrameIndex % PROFILER_FRAME_LATENCY];
+		//the GPU is more than PROFILER_FRAME_LATENCY frames behind, this frame only gets CPU times
+		m_Current = frame.m_Pending ? &m_ScratchFrame : &frame;
+		m_Current->m_GPUTimed = !frame.m_Pending;
+		m_Current->m_FrameIndex = m_FrameIndex;
+		m_Current->m_Events.clear();
+		m_Current->m_NrOfQueries = 0;
+		m_Current->m_CPUStart = now();
+		m_Depth = 0;
+	}
+	void EndFrame()
+	{
+		if(!m_Current)
+			return;
+		m_Current->m_CPUEnd = now();
+		if(m_Current->m_GPUTimed && m_Current->m_NrOfQueries > 0)
+			m_Current->m_Pending = 1;
+		else
+			process(*m_Current);
+		m_Current = nullptr;
+		m_FrameIndex++;
+	}
+
+	//use PROFILE_GPU/PROFILE_CPU instead, they end the scope at the end of the block
+	int BeginScope(const char* name, bool gpu)
+	{
+		if(!m_Current)
+			return -1;
+		ProfileEvent event;
+		event.m_Name = name;
+		event.m_Depth = m_Depth++;
+		event.m_Query = -1;
+		event.m_GPUStart = event.m_GPUEnd = 0.0;
+		if(gpu && m_Current->m_GPUTimed)
+		{
+			if(m_Current->m_NrOfQueries + 2 > m_Current->m_Queries.size())
+			{
+				unsigned int queries[16];
+				glGenQueries(16, queries);
+				m_Current->m_Queries.insert(m_Current->m_Queries.end(), queries, queries + 16);
+			}
+			event.m_Query = (int)m_Current->m_NrOfQueries;
+			m_Current->m_NrOfQueries += 2;
+			glQueryCounter(m_Current->m_Queries[event.m_Query], GL_TIMESTAMP);
+		}
+		event.m_CPUStart = event.m_CPUEnd = now();
+		m_Current->m_Events.push_back(event);
+		return (int)m_Current->m_Events.size() - 1;
+	}
+	void EndScope(int index)
+	{
+		if(!m_Current || index < 0)
+			return;
+		ProfileEvent& event = m_Current->m_Events[index];
+		if(event.m_Query >= 0)
+			glQueryCounter(m_Current->m_Queries[event.m_Query + 1], GL_TIMESTAMP);
+		event.m_CPUEnd = now();
+		m_Depth--;
+	}
+
+	//records the next nrOfFrames frames that have GPU times and writes them to path as a Chrome trace
+	void Capture(unsigned int nrOfFrames, const std::string& path)
+	{
+		//the offset from the GPU clock to the CPU one, so both timelines line up in the trace
+		GLint64 gpuTime = 0;
+		glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+		m_GPUOffset = now() - (double)gpuTime / 1000000.0;
+		m_CaptureEvents.clear();
+		m_CapturePath = path;
+		m_CaptureFrames = nrOfFrames;
+	}
+	inline bool Capturing() const { return m_CaptureFrames > 0; }
+
+	inline const std::vector<ProfileStat>& Stats() const { return m_Stats; }
+	//a stat is stale if its scope hasn't run in the last frames, e.g. the G-buffer path that is switched off
+	inline bool Stale(const ProfileStat& stat) const { return stat.m_LastFrame + PROFILER_STALE_FRAMES < m_LastProcessedFrame; }
+	float GPUTime(const char* name) const
+	{
+		const ProfileStat* stat = findStat(name);
+		return stat ? stat->m_GPU : 0.0f;
+	}
+	//average GPU time of a scope since the last ResetMeans(), e.g. for a benchmark run
+	float GPUMean(const char* name) const
+	{
+		const ProfileStat* stat = findStat(name);
+		return stat && stat->m_NrOfGPUSamples > 0 ? (float)(stat->m_GPUTotal / stat->m_NrOfGPUSamples) : 0.0f;
+	}
+	unsigned int NrOfGPUSamples(const char* name) const
+	{
+		const ProfileStat* stat = findStat(name);
+		return stat ? stat->m_NrOfGPUSamples : 0;
+	}
+	void ResetMeans()
+	{
+		for(unsigned int i = 0; i < m_Stats.size(); i++)
+		{
+			m_Stats[i].m_GPUTotal = 0.0;
+			m_Stats[i].m_NrOfGPUSamples = 0;
+		}
+	}
+	//CPU time of whole frames and GPU time of all top level GPU scopes, smoothed and as rolling histories (oldest at HistoryOffset())
+	inline float FrameCPU() const { return m_FrameCPU; }
+	inline float FrameGPU() const { return m_FrameGPU; }
+	inline const float* CPUHistory() const { return m_CPUHistory; }
+	inline const float* GPUHistory() const { return m_GPUHistory; }
+	inline int HistoryOffset() const { return (int)m_HistoryIndex; }
+
+private:
+	struct Frame
+	{
+		std::vector<ProfileEvent> m_Events;
+		std::vector<unsigned int> m_Queries;
+		unsigned int m_NrOfQueries;
+		bool m_Pending;
+		bool m_GPUTimed;
+		unsigned long long m_FrameIndex;
+		double m_CPUStart, m_CPUEnd;
+	};
+
+	bool m_Init;
+	std::chrono::high_resolution_clock::time_point m_Start;
+	Frame m_Frames[PROFILER_FRAME_LATENCY];
+	Frame m_ScratchFrame;
+	unsigned long long m_FrameIndex;
+	unsigned long long m_LastProcessedFrame;
+	Frame* m_Current;
+	unsigned int m_Depth;
+
+	std::vector<ProfileStat> m_Stats;
+	float m_FrameCPU, m_FrameGPU;
+	float m_CPUHistory[PROFILER_HISTORY];
+	float m_GPUHistory[PROFILER_HISTORY];
+	unsigned int m_HistoryIndex;
+
+	double m_GPUOffset;
+	unsigned int m_CaptureFrames;
+	std::string m_CapturePath;
+	std::vector<std::string> m_CaptureEvents;
+
+	double now() const
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - m_Start).count();
+	}
+
+	//oldest frame first, stops at the first one the GPU hasn't finished
+	void readBack()
+	{
+		for(unsigned int i = 0; i < PROFILER_FRAME_LATENCY; i++)
+		{
+			Frame& frame = m_Frames[(m_FrameIndex + i) % PROFILER_FRAME_LATENCY];
+			if(!frame.m_Pending)
+				continue;
+
+			int available = 0;
+			glGetQueryObjectiv(frame.m_Queries[frame.m_NrOfQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+			if(!available)
+				break;
+
+			for(unsigned int j = 0; j < frame.m_Events.size(); j++)
+			{
+				ProfileEvent& event = frame.m_Events[j];
+				if(event.m_Query < 0)
+					continue;
+				GLuint64 start = 0, end = 0;
+				glGetQueryObjectui64v(frame.m_Queries[event.m_Query], GL_QUERY_RESULT, &start);
+				glGetQueryObjectui64v(frame.m_Queries[event.m_Query + 1], GL_QUERY_RESULT, &end);
+				event.m_GPUStart = (double)start / 1000000.0;
+				event.m_GPUEnd = (double)end / 1000000.0;
+			}
+			frame.m_Pending = 0;
+			process(frame);
+		}
+	}
+
+	void process(const Frame& frame)
+	{
+		//a scratch frame is processed right away while older frames may still be pending on the GPU
+		if(frame.m_FrameIndex > m_LastProcessedFrame)
+			m_LastProcessedFrame = frame.m_FrameIndex;
+		float frameGPU = 0.0f;
+		for(unsigned int i = 0; i < frame.m_Events.size(); i++)
+		{
+			const ProfileEvent& event = frame.m_Events[i];
+			float cpu = (float)(event.m_CPUEnd - event.m_CPUStart);
+			float gpu = (float)(event.m_GPUEnd - event.m_GPUStart);
+			if(event.m_Query >= 0 && event.m_Depth == 0)
+				frameGPU += gpu;
+
+			ProfileStat& stat = findStat(event);
+			stat.m_CPU += (cpu - stat.m_CPU) * 0.1f;
+			if(event.m_Query >= 0)
+			{
+				stat.m_GPU = stat.m_HasGPU ? stat.m_GPU + (gpu - stat.m_GPU) * 0.1f : gpu;
+				stat.m_HasGPU = 1;
+				stat.m_GPUTotal += gpu;
+				stat.m_NrOfGPUSamples++;
+			}
+			stat.m_LastFrame = frame.m_FrameIndex;
+		}
+
+		float frameCPU = (float)(frame.m_CPUEnd - frame.m_CPUStart);
+		m_FrameCPU += (frameCPU - m_FrameCPU) * 0.1f;
+		if(frame.m_GPUTimed)
+			m_FrameGPU += (frameGPU - m_FrameGPU) * 0.1f;
+		m_CPUHistory[m_HistoryIndex] = frameCPU;
+		m_GPUHistory[m_HistoryIndex] = frame.m_GPUTimed ? frameGPU : m_FrameGPU;
+		m_HistoryIndex = (m_HistoryIndex + 1) % PROFILER_HISTORY;
+
+		if(m_CaptureFrames > 0 && frame.m_GPUTimed)
+		{
+			capture(frame);
+			if(--m_CaptureFrames == 0)
+				writeCapture();
+		}
+	}
+
+	ProfileStat& findStat(const ProfileEvent& event)
+	{
+		for(unsigned int i = 0; i < m_Stats.size(); i++)
+			if(m_Stats[i].m_Depth == event.m_Depth && std::strcmp(m_Stats[i].m_Name, event.m_Name) == 0)
+				return m_Stats[i];
+
+		//scopes are added in the order they first ran, which keeps children under their parents
+		ProfileStat stat = { event.m_Name, event.m_Depth, 0.0f, 0.0f, 0, 0, 0.0, 0 };
+		m_Stats.push_back(stat);
+		return m_Stats.back();
+	}
+	//the first scope with the name at any depth
+	const ProfileStat* findStat(const char* name) const
+	{
+		for(unsigned int i = 0; i < m_Stats.size(); i++)
+			if(std::strcmp(m_Stats[i].m_Name, name) == 0)
+				return &m_Stats[i];
+		return nullptr;
+	}
+
+	//Chrome trace complete events, the CPU scopes on thread 0 and the GPU scopes on thread 1, in microseconds
+	void capture(const Frame& frame)
+	{
+		char buffer[256];
+		snprintf(buffer, sizeof(buffer), "{\"name\":\"Frame %llu\",\"cat\":\"CPU\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}",
+				 frame.m_FrameIndex, frame.m_CPUStart * 1000.0, (frame.m_CPUEnd - frame.m_CPUStart) * 1000.0);
+		m_CaptureEvents.push_back(buffer);
+		for(unsigned int i = 0; i < frame.m_Events.size(); i++)
+		{
+			const ProfileEvent& event = frame.m_Events[i];
+			snprintf(buffer, sizeof(buffer), "{\"name\":\"%s\",\"cat\":\"CPU\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}",
+					 event.m_Name, event.m_CPUStart * 1000.0, (event.m_CPUEnd - event.m_CPUStart) * 1000.0);
+			m_CaptureEvents.push_back(buffer);
+			if(event.m_Query < 0)
+				continue;
+			snprintf(buffer, sizeof(buffer), "{\"name\":\"%s\",\"cat\":\"GPU\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+					 event.m_Name, (event.m_GPUStart + m_GPUOffset) * 1000.0, (event.m_GPUEnd - event.m_GPUStart) * 1000.0);
+			m_CaptureEvents.push_back(buffer);
+		}
+	}
+	void writeCapture()
+	{
+		std::ofstream file(m_CapturePath.c_str(), std::ios::out | std::ios::trunc);
+		file << "{\"traceEvents\":[\n";
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"CPU\"}},\n";
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"GPU\"}}";
+		for(unsigned int i = 0; i < m_CaptureEvents.size(); i++)
+			file << ",\n" << m_CaptureEvents[i];
+		file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+		if(!file.good())
+			std::cout << "Failed to write profile: " << m_CapturePath << std::endl;
+		else
+			std::cout << "Profile written to " << m_CapturePath << std::endl;
+		m_CaptureEvents.clear();
+	}
+};
+
+//the profiler the PROFILE_ macros record into
+inline Profiler& GetProfiler()
+{
+	static Profiler profiler;
+	return profiler;
+}
+
+class ProfileScope
+{
+public:
+	ProfileScope(const char* name, bool gpu)
+	{
+		m_Index = GetProfiler().BeginScope(name, gpu);
+	}
+	~ProfileScope()
+	{
+		GetProfiler().EndScope(m_Index);
+	}
+private:
+	int m_Index;
+};
+
+#endif
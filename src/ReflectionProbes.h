@@ -0,0 +1,327 @@
+#ifndef REFLECTION_PROBES_H
+#define REFLECTION_PROBES_H
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <functional>
+#include "IBLCache.h"
+
+#define REFLECTION_PROBE_MAX 4 //has to match MAX_REFLECTION_PROBES in PBRSecondPass.F.shader
+#define REFLECTION_PROBE_SIZE 128
+#define REFLECTION_PROBE_MIPS 5
+#define REFLECTION_PROBE_FIRST_UNIT 9 //texture units REFLECTION_PROBE_FIRST_UNIT to REFLECTION_PROBE_FIRST_UNIT + REFLECTION_PROBE_MAX - 1
+#define REFLECTION_PROBE_DEFAULT_BUDGET 1.0f //ms per frame
+//6 capture faces, 1 mip generation and 6 faces for every prefiltered mip
+#define REFLECTION_PROBE_BAKE_STEPS (6 + 1 + 6 * REFLECTION_PROBE_MIPS)
+void renderCube();
+
+//draws the scene (without the sky) for a probe face and sets the capture shader's lighting uniforms, the shader is already in use with its matrices set
+typedef std::function<void(Shader& captureShader)> ProbeSceneFunction;
+
+struct ReflectionProbe
+{
+	glm::vec3 m_Position;
+	glm::vec3 m_BoxMin, m_BoxMax; //influence volume, also the proxy geometry reflections are parallax corrected against
+	unsigned int m_Radiance;      //captured scene, the source of the prefilter pass
+	unsigned int m_Prefiltered;   //what PBRSecondPass samples, same layout as the global prefilter map
+	unsigned int m_Step;          //next bake step, REFLECTION_PROBE_BAKE_STEPS when baked
+	bool m_Baked;                 //the prefiltered map holds a complete bake
+	unsigned long long m_Key;
+};
+
+//Local reflection probes: small prefiltered cubemaps with box parallax correction that PBRSecondPass blends per pixel (the 2 nearest probes
+//that contain the pixel, falling back to the global prefilter map outside of them). The probes are baked incrementally, one face at a time
+//until the per frame time budget is used up, and stored in IBL cache files so they are only baked on the first run or after they move.
+//The cache key covers the bake shaders, the probe's placement and whatever the caller says the captured scene depends on.
+//GL 3.3 has no cubemap arrays, so every probe is its own cubemap bound to a fixed texture unit.
+class ReflectionProbeRenderer
+{
+public:
+	bool m_Enabled;
+	float m_Budget; //CPU time in ms spent submitting bake steps per frame, at least one step runs every frame while a probe is baking
+	ReflectionProbeRenderer()
+		:m_Init(0), m_Enabled(1), m_Budget(REFLECTION_PROBE_DEFAULT_BUDGET), m_CaptureFBO(0), m_CaptureRBO(0), m_EnvironmentMap(0),
+		 m_CaptureShader(nullptr), m_SkyShader(nullptr), m_PrefilterShader(nullptr)
+	{
+
+	}
+	~ReflectionProbeRenderer()
+	{
+
+	}
+
+	//environmentMap is drawn behind the scene in the captures, drawScene renders the scene with the capture shader.
+	//sceneFiles (e.g. the environment and the textures) and sceneParameters (e.g. the lights and the object transforms) are what drawScene
+	//and environmentMap are made from, they go into every probe's cache key so a changed scene is baked again
+	bool Init(unsigned int environmentMap, ProbeSceneFunction drawScene, const std::vector<std::string>& sceneFiles, const std::vector<float>& sceneParameters)
+	{
+		if(m_Init) return 1;
+
+		m_EnvironmentMap = environmentMap;
+		m_DrawScene = drawScene;
+		m_KeyFiles = { "ProgramFiles\\Resources\\Shaders\\ReflectionProbes\\ProbeCapture.V.shader", "ProgramFiles\\Resources\\Shaders\\ReflectionProbes\\ProbeCapture.F.shader",
+		               "ProgramFiles\\Resources\\Shaders\\cubemap.V.shader", "ProgramFiles\\Resources\\Shaders\\ReflectionProbes\\ProbeSky.F.shader",
+		               "ProgramFiles\\Resources\\Shaders\\prefilter.F.shader" };
+		m_KeyFiles.insert(m_KeyFiles.end(), sceneFiles.begin(), sceneFiles.end());
+		m_SceneParameters = sceneParameters;
+
+		glGenFramebuffers(1, &m_CaptureFBO);
+		glGenRenderbuffers(1, &m_CaptureRBO);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_CaptureFBO);
+		glBindRenderbuffer(GL_RENDERBUFFER, m_CaptureRBO);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, REFLECTION_PROBE_SIZE, REFLECTION_PROBE_SIZE);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_CaptureRBO);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		m_CaptureShader = new Shader("ProgramFiles\\Resources\\Shaders\\ReflectionProbes\\ProbeCapture.V.shader", "ProgramFiles\\Resources\\Shaders\\ReflectionProbes\\ProbeCapture.F.shader");
+		m_CaptureShader->use();
+		m_CaptureShader->setInt("albedoMap", 0);
+		m_SkyShader = new Shader("ProgramFiles\\Resources\\Shaders\\cubemap.V.shader", "ProgramFiles\\Resources\\Shaders\\ReflectionProbes\\ProbeSky.F.shader");
+		m_SkyShader->use();
+		m_SkyShader->setInt("environmentMap", 0);
+		m_PrefilterShader = new Shader("ProgramFiles\\Resources\\Shaders\\cubemap.V.shader", "ProgramFiles\\Resources\\Shaders\\prefilter.F.shader");
+		m_PrefilterShader->use();
+		m_PrefilterShader->setInt("environmentMap", 0);
+		m_PrefilterShader->setFloat("resolution", (float)REFLECTION_PROBE_SIZE);
+		glUseProgram(0);
+
+		m_Init = 1;
+		return 1;
+	}
+	void Destroy()
+	{
+		for(unsigned int i = 0; i < m_Probes.size(); i++)
+		{
+			glDeleteTextures(1, &m_Probes[i].m_Radiance);
+			glDeleteTextures(1, &m_Probes[i].m_Prefiltered);
+		}
+		m_Probes.clear();
+		glDeleteRenderbuffers(1, &m_CaptureRBO);
+		glDeleteFramebuffers(1, &m_CaptureFBO);
+		Shader** shaders[3] = { &m_CaptureShader, &m_SkyShader, &m_PrefilterShader };
+		for(unsigned int i = 0; i < 3; i++)
+		{
+			if(*shaders[i])
+			{
+				(*shaders[i])->destroy();
+				delete *shaders[i];
+				*shaders[i] = nullptr;
+			}
+		}
+		m_Init = 0;
+	}
+
+	//adds a probe at position with the influence box [boxMin, boxMax] (which has to contain position), returns its index or -1 if all slots are used.
+	//the bake is loaded from the probe's cache file if the probe was baked at the same place before, otherwise it's queued
+	int AddProbe(glm::vec3 position, glm::vec3 boxMin, glm::vec3 boxMax)
+	{
+		if(m_Probes.size() >= REFLECTION_PROBE_MAX)
+		{
+			std::cout << "Can't add more than " << REFLECTION_PROBE_MAX << " reflection probes" << std::endl;
+			return -1;
+		}
+
+		ReflectionProbe probe;
+		probe.m_Position = position;
+		probe.m_BoxMin = boxMin;
+		probe.m_BoxMax = boxMax;
+		std::vector<float> parameters = { position.x, position.y, position.z, boxMin.x, boxMin.y, boxMin.z, boxMax.x, boxMax.y, boxMax.z,
+										  (float)REFLECTION_PROBE_SIZE, (float)REFLECTION_PROBE_MIPS };
+		parameters.insert(parameters.end(), m_SceneParameters.begin(), m_SceneParameters.end());
+		probe.m_Key = IBLCache::ComputeKey(m_KeyFiles, parameters);
+
+		glGenTextures(1, &probe.m_Radiance);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, probe.m_Radiance);
+		for(unsigned int face = 0; face < 6; face++)
+			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGB16F, REFLECTION_PROBE_SIZE, REFLECTION_PROBE_SIZE, 0, GL_RGB, GL_FLOAT, nullptr);
+		setCubemapParameters();
+
+		int index = (int)m_Probes.size();
+		if(IBLCache::Load(cachePath(index).c_str(), probe.m_Key, REFLECTION_PROBE_SIZE, REFLECTION_PROBE_MIPS, probe.m_Prefiltered))
+		{
+			probe.m_Step = REFLECTION_PROBE_BAKE_STEPS;
+			probe.m_Baked = 1;
+		}
+		else
+		{
+			glGenTextures(1, &probe.m_Prefiltered);
+			glBindTexture(GL_TEXTURE_CUBE_MAP, probe.m_Prefiltered);
+			for(unsigned int mip = 0; mip < REFLECTION_PROBE_MIPS; mip++)
+			{
+				unsigned int mipSize = REFLECTION_PROBE_SIZE >> mip;
+				for(unsigned int face = 0; face < 6; face++)
+					glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, mip, GL_RGB16F, mipSize, mipSize, 0, GL_RGB, GL_FLOAT, nullptr);
+			}
+			setCubemapParameters();
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, REFLECTION_PROBE_MIPS - 1);
+			probe.m_Step = 0;
+			probe.m_Baked = 0;
+		}
+		m_Probes.push_back(probe);
+		return index;
+	}
+	//queues every probe to be baked again (after the scene changed), the probes stay in use and their faces are replaced one step at a time
+	void RebakeAll()
+	{
+		for(unsigned int i = 0; i < m_Probes.size(); i++)
+			m_Probes[i].m_Step = 0;
+	}
+
+	//runs bake steps of the first unfinished probe until the time budget is used up
+	void Update()
+	{
+		if(!m_Init || !m_Enabled)
+			return;
+
+		int current = -1;
+		for(unsigned int i = 0; i < m_Probes.size() && current < 0; i++)
+			if(m_Probes[i].m_Step < REFLECTION_PROBE_BAKE_STEPS)
+				current = i;
+		if(current < 0)
+			return;
+
+		int viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		ReflectionProbe& probe = m_Probes[current];
+		do
+		{
+			bakeStep(probe);
+			probe.m_Step++;
+			if(probe.m_Step == REFLECTION_PROBE_BAKE_STEPS)
+			{
+				probe.m_Baked = 1;
+				IBLCache::Save(cachePath(current).c_str(), probe.m_Key, probe.m_Prefiltered, REFLECTION_PROBE_SIZE, REFLECTION_PROBE_MIPS);
+				break;
+			}
+		} while(std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count() < m_Budget);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+		glEnable(GL_DEPTH_TEST);
+		glDepthFunc(GL_LEQUAL);
+	}
+
+	//binds the baked probes to their texture units and sets the probe uniforms of shader (which has to be in use)
+	void Bind(Shader& shader)
+	{
+		int nrOfProbes = 0;
+		for(unsigned int i = 0; i < m_Probes.size() && m_Enabled; i++)
+		{
+			if(!m_Probes[i].m_Baked)
+				continue;
+			std::string index = "[" + std::to_string(nrOfProbes) + "]";
+			shader.setVec3("probePositions" + index, m_Probes[i].m_Position);
+			shader.setVec3("probeBoxMin" + index, m_Probes[i].m_BoxMin);
+			shader.setVec3("probeBoxMax" + index, m_Probes[i].m_BoxMax);
+			glActiveTexture(GL_TEXTURE0 + REFLECTION_PROBE_FIRST_UNIT + nrOfProbes);
+			glBindTexture(GL_TEXTURE_CUBE_MAP, m_Probes[i].m_Prefiltered);
+			nrOfProbes++;
+		}
+		shader.setInt("nrOfProbes", nrOfProbes);
+	}
+	//sets the sampler units of shader's probeMaps array, only needed once
+	static void SetSamplers(Shader& shader)
+	{
+		shader.use();
+		for(unsigned int i = 0; i < REFLECTION_PROBE_MAX; i++)
+			shader.setInt("probeMaps[" + std::to_string(i) + "]", REFLECTION_PROBE_FIRST_UNIT + i);
+	}
+
+	unsigned int NrOfProbes()
+	{
+		return (unsigned int)m_Probes.size();
+	}
+	const ReflectionProbe& Probe(unsigned int index)
+	{
+		return m_Probes[index];
+	}
+private:
+	bool m_Init;
+	unsigned int m_CaptureFBO, m_CaptureRBO;
+	unsigned int m_EnvironmentMap;
+	ProbeSceneFunction m_DrawScene;
+	std::vector<std::string> m_KeyFiles; //bake shaders and scene files hashed into the cache keys
+	std::vector<float> m_SceneParameters;
+	Shader* m_CaptureShader;
+	Shader* m_SkyShader;
+	Shader* m_PrefilterShader;
+	std::vector<ReflectionProbe> m_Probes;
+
+	static std::string cachePath(int index)
+	{
+		return "reflectionProbe" + std::to_string(index) + ".iblcache";
+	}
+	static void setCubemapParameters()
+	{
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	}
+	static glm::mat4 faceView(unsigned int face)
+	{
+		const glm::vec3 targets[6] = { glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f),
+		                               glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f) };
+		const glm::vec3 ups[6] = { glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f),
+		                           glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f) };
+		return glm::lookAt(glm::vec3(0.0f), targets[face], ups[face]);
+	}
+
+	//steps 0-5 capture a face of the radiance map, step 6 builds its mips and the rest prefilter one face of one mip each
+	void bakeStep(ReflectionProbe& probe)
+	{
+		glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_CaptureFBO);
+
+		if(probe.m_Step < 6)
+		{
+			unsigned int face = probe.m_Step;
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, probe.m_Radiance, 0);
+			glViewport(0, 0, REFLECTION_PROBE_SIZE, REFLECTION_PROBE_SIZE);
+			glEnable(GL_DEPTH_TEST);
+			glDepthFunc(GL_LEQUAL);
+			glDisable(GL_BLEND);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			glm::mat4 view = faceView(face);
+			m_CaptureShader->use();
+			m_CaptureShader->setMat4("projection", projection);
+			m_CaptureShader->setMat4("view", glm::translate(view, -probe.m_Position));
+			m_DrawScene(*m_CaptureShader);
+
+			m_SkyShader->use();
+			m_SkyShader->setMat4("projection", projection);
+			m_SkyShader->setMat4("view", view);
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_CUBE_MAP, m_EnvironmentMap);
+			renderCube();
+		}
+		else if(probe.m_Step == 6)
+		{
+			glBindTexture(GL_TEXTURE_CUBE_MAP, probe.m_Radiance);
+			glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+		}
+		else
+		{
+			unsigned int mip = (probe.m_Step - 7) / 6;
+			unsigned int face = (probe.m_Step - 7) % 6;
+			unsigned int mipSize = REFLECTION_PROBE_SIZE >> mip;
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, probe.m_Prefiltered, mip);
+			glViewport(0, 0, mipSize, mipSize);
+			glDisable(GL_DEPTH_TEST);
+
+			m_PrefilterShader->use();
+			m_PrefilterShader->setMat4("projection", projection);
+			m_PrefilterShader->setMat4("view", faceView(face));
+			m_PrefilterShader->setFloat("roughness", (float)mip / (float)(REFLECTION_PROBE_MIPS - 1));
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_CUBE_MAP, probe.m_Radiance);
+			renderCube();
+		}
+	}
+};
+
+#endif
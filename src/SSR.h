@@ -0,0 +1,239 @@
+#ifndef SSR_H
+#define SSR_H
+
+#include <glm/glm.hpp>
+#include <src/shader.h>
+#include <src/Framebuffer.h>
+#include <src/DepthPyramid.h>
+
+#define SSR_DEFAULT_MAX_ROUGHNESS 0.6f //rougher surfaces only get the probes and the prefilter map
+#define SSR_DEFAULT_THICKNESS 0.3f //view space depth a hit surface is assumed to have
+#define SSR_DEFAULT_FEEDBACK 0.9f
+#define SSR_MAX_RAYS 4
+void renderQuad();
+
+//Screen space reflections traced at half resolution through a hierarchical min-depth pyramid (Hi-Z) of the G-buffer depth.
+//Empty space is skipped a whole Hi-Z cell at a time, so a ray costs at most m_MaxIterations steps no matter how far it travels.
+//Smooth surfaces trace 1 ray, rougher ones up to m_MaxRays GGX distributed rays. Hits sample the previous frame's lit scene,
+//the result (reflected color, hit weight in alpha) is temporally filtered and PBRSecondPass mixes it over the probes/prefilter map,
+//so misses fall back to them.
+class SSRRenderer
+{
+public:
+	bool m_Enabled;
+	float m_MaxRoughness;
+	float m_Thickness;
+	float m_Feedback;
+	int m_MaxRays;
+	int m_MaxIterations;
+
+	SSRRenderer()
+		:m_Init(0), m_Enabled(1), m_MaxRoughness(SSR_DEFAULT_MAX_ROUGHNESS), m_Thickness(SSR_DEFAULT_THICKNESS), m_Feedback(SSR_DEFAULT_FEEDBACK), m_MaxRays(SSR_MAX_RAYS),
+		m_MaxIterations(64), m_FrameIndex(0), m_CurrentHistory(0), m_ResetHistory(1), m_HasSceneColor(0), m_PrevRenderSize(0), m_PrevHalfSize(0)
+	{
+
+	}
+	~SSRRenderer()
+	{
+
+	}
+
+	bool Init(unsigned int width, unsigned int height)
+	{
+		if(m_Init) return 1;
+
+		m_Width = width;
+		m_Height = height;
+
+		if(!m_HiZ.Init(width, height, DEPTH_PYRAMID_MIN))
+			return 0;
+
+		//raw trace result and the two ping-ponged temporal histories, all at half resolution
+		m_HalfWidth = (width + 1) / 2;
+		m_HalfHeight = (height + 1) / 2;
+		glGenTextures(1, &m_TraceTexture);
+		glGenTextures(2, m_HistoryTextures);
+		unsigned int halfTextures[3] = { m_TraceTexture, m_HistoryTextures[0], m_HistoryTextures[1] };
+		for(unsigned int i = 0; i < 3; i++)
+		{
+			glBindTexture(GL_TEXTURE_2D, halfTextures[i]);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, m_HalfWidth, m_HalfHeight, 0, GL_RGBA, GL_FLOAT, nullptr);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		}
+
+		//copy of the previous frame's lit scene, what the rays see
+		glGenTextures(1, &m_SceneColorTexture);
+		glBindTexture(GL_TEXTURE_2D, m_SceneColorTexture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		glGenFramebuffers(1, &m_ID);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_ID);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_TraceTexture, 0);
+		unsigned int attachments[1] = { GL_COLOR_ATTACHMENT0 };
+		glDrawBuffers(1, attachments);
+		int status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		if(status != GL_FRAMEBUFFER_COMPLETE)
+		{
+			printf("SSR FRAMEBUFFER ERROR! \nStatus: 0x%x\n", status);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			return 0;
+		}
+		glGenFramebuffers(1, &m_SceneColorFBO);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_SceneColorFBO);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_SceneColorTexture, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		m_TraceShader = new Shader("ProgramFiles\\Resources\\Shaders\\SSR\\SSR.V.shader", "ProgramFiles\\Resources\\Shaders\\SSR\\SSRTrace.F.shader");
+		m_TraceShader->use();
+		m_TraceShader->setInt("hiZ", 0);
+		m_TraceShader->setInt("gNormal", 1);
+		m_TraceShader->setInt("gMetalRoughAO", 2);
+		m_TraceShader->setInt("sceneColor", 3);
+		m_TraceShader->setInt("velocityBuffer", 4);
+		m_TemporalShader = new Shader("ProgramFiles\\Resources\\Shaders\\SSR\\SSR.V.shader", "ProgramFiles\\Resources\\Shaders\\SSR\\SSRTemporal.F.shader");
+		m_TemporalShader->use();
+		m_TemporalShader->setInt("currentReflection", 0);
+		m_TemporalShader->setInt("historyReflection", 1);
+		m_TemporalShader->setInt("velocityBuffer", 2);
+		glUseProgram(0);
+
+		m_Init = 1;
+		return 1;
+	}
+	void Destroy()
+	{
+		m_HiZ.Destroy();
+		glDeleteTextures(1, &m_TraceTexture);
+		glDeleteTextures(2, m_HistoryTextures);
+		glDeleteTextures(1, &m_SceneColorTexture);
+		glDeleteFramebuffers(1, &m_ID);
+		glDeleteFramebuffers(1, &m_SceneColorFBO);
+		Shader* shaders[2] = { m_TraceShader, m_TemporalShader };
+		for(unsigned int i = 0; i < 2; i++)
+		{
+			shaders[i]->destroy();
+			delete shaders[i];
+		}
+		m_ID = 0;
+		m_Init = 0;
+	}
+
+	//builds the Hi-Z pyramid, traces the reflections and filters them into the texture returned by ReflectionTexture().
+	//projection has to be the (jittered) one the G-buffer was rendered with. the viewport is left at renderSize
+	void Render(Framebuffer& gBuffer, const glm::mat4& view, const glm::mat4& projection, float nearPlane, glm::ivec2 renderSize)
+	{
+		if(!m_Enabled)
+			return;
+
+		unsigned int levels = m_HiZ.Build(gBuffer.m_Textures[3], renderSize);
+
+		glDisable(GL_DEPTH_TEST);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_ID);
+
+		//trace
+		glm::ivec2 halfSize((renderSize.x + 1) / 2, (renderSize.y + 1) / 2);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_TraceTexture, 0);
+		glViewport(0, 0, halfSize.x, halfSize.y);
+		m_TraceShader->use();
+		m_TraceShader->setMat4("projection", projection);
+		m_TraceShader->setMat4("invProjection", glm::inverse(projection));
+		m_TraceShader->setMat4("view", view);
+		m_TraceShader->setVec2("renderSize", glm::vec2(renderSize));
+		m_TraceShader->setVec2("prevViewportScale", glm::vec2(m_PrevRenderSize) / glm::vec2((float)m_Width, (float)m_Height));
+		m_TraceShader->setFloat("nearPlane", nearPlane);
+		m_TraceShader->setFloat("maxRoughness", m_MaxRoughness);
+		m_TraceShader->setFloat("thickness", m_Thickness);
+		m_TraceShader->setInt("maxRays", glm::clamp(m_MaxRays, 1, SSR_MAX_RAYS));
+		m_TraceShader->setInt("maxIterations", m_MaxIterations);
+		m_TraceShader->setInt("maxLevel", levels - 1);
+		m_TraceShader->setInt("frameIndex", (int)(m_FrameIndex % 1024));
+		m_TraceShader->setBool("hasSceneColor", m_HasSceneColor);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, m_HiZ.Texture());
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, gBuffer.m_Textures[0]);
+		glActiveTexture(GL_TEXTURE2);
+		glBindTexture(GL_TEXTURE_2D, gBuffer.m_Textures[2]);
+		glActiveTexture(GL_TEXTURE3);
+		glBindTexture(GL_TEXTURE_2D, m_SceneColorTexture);
+		glActiveTexture(GL_TEXTURE4);
+		glBindTexture(GL_TEXTURE_2D, gBuffer.m_Textures[4]);
+		renderQuad();
+
+		//temporal filter, reprojected with the velocity of the reflecting surface
+		unsigned int target = m_HistoryTextures[m_CurrentHistory];
+		unsigned int history = m_HistoryTextures[1 - m_CurrentHistory];
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
+		m_TemporalShader->use();
+		m_TemporalShader->setVec2("halfSize", glm::vec2(halfSize));
+		m_TemporalShader->setVec2("renderSize", glm::vec2(renderSize));
+		m_TemporalShader->setVec2("prevViewportScale", glm::vec2(m_PrevHalfSize) / glm::vec2((float)m_HalfWidth, (float)m_HalfHeight));
+		m_TemporalShader->setFloat("feedback", m_Feedback);
+		m_TemporalShader->setBool("resetHistory", m_ResetHistory);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, m_TraceTexture);
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, history);
+		glActiveTexture(GL_TEXTURE2);
+		glBindTexture(GL_TEXTURE_2D, gBuffer.m_Textures[4]);
+		renderQuad();
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, renderSize.x, renderSize.y);
+		glEnable(GL_DEPTH_TEST);
+
+		m_CurrentHistory = 1 - m_CurrentHistory;
+		m_PrevHalfSize = halfSize;
+		m_ResetHistory = 0;
+		m_FrameIndex++;
+	}
+	//copies the lit scene (color attachment 0 of sceneFramebuffer), the next frame's rays sample it
+	void CaptureSceneColor(unsigned int sceneFramebuffer, glm::ivec2 renderSize)
+	{
+		if(!m_Enabled)
+			return;
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFramebuffer);
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_SceneColorFBO);
+		glBlitFramebuffer(0, 0, renderSize.x, renderSize.y, 0, 0, renderSize.x, renderSize.y, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		m_PrevRenderSize = renderSize;
+		m_HasSceneColor = 1;
+	}
+	//the filtered reflections of the last Render, covering the same part of the texture as the render targets
+	unsigned int ReflectionTexture()
+	{
+		return m_HistoryTextures[1 - m_CurrentHistory];
+	}
+	void ResetHistory()
+	{
+		m_ResetHistory = 1;
+	}
+	inline unsigned int NrOfHiZLevels() const { return m_HiZ.NrOfLevels(); }
+
+private:
+	bool m_Init;
+	unsigned int m_ID;
+	unsigned int m_Width, m_Height, m_HalfWidth, m_HalfHeight;
+	DepthPyramid m_HiZ;
+	unsigned int m_TraceTexture;
+	unsigned int m_HistoryTextures[2];
+	unsigned int m_SceneColorTexture, m_SceneColorFBO;
+	unsigned long long m_FrameIndex;
+	unsigned int m_CurrentHistory;
+	bool m_ResetHistory;
+	bool m_HasSceneColor;
+	glm::ivec2 m_PrevRenderSize, m_PrevHalfSize;
+	Shader* m_TraceShader;
+	Shader* m_TemporalShader;
+};
+
+#endif
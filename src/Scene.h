@@ -4,143 +4,109 @@
 #include <src/Model.h>
 #include <src/Light.h>
 #include <src/Material.h>
+#include <src/TransformHierarchy.h>
+#include <src/SlotMap.h>
 #include <iterator>
 #include <unordered_map>
 #include <map>
 #include <vector>
 #include <tuple>
 
+typedef SlotHandle NodeHandle;
+
+//A node of the scene graph. Nodes are identified by generational handles from a slot map, so creating, destroying and finding
+//a node is O(1) and handles to destroyed nodes are detected. The hierarchy and the transforms of all nodes live in one
+//TransformHierarchy, call updateTransforms() once per frame before reading world matrices with getMatrix()
 struct SceneNode
 {
-	std::unordered_map<unsigned int, SceneNode*>* m_ChildNodes;
-	std::string* m_ModelKey;
-	std::string* m_LightKey;
-	std::string* m_MaterialKey;
-	glm::vec3 m_Pos;
-	glm::vec3 m_Scale;
-	glm::quat m_Rot;
+	NodeHandle m_Handle;
+	unsigned int m_Transform; //the node's ID in s_Transforms
+	std::string m_ModelKey;
+	std::string m_LightKey;
+	std::string m_MaterialKey;
+	//local space bounds, empty for nodes without geometry
+	BoundingBox m_Bounds;
+	BoundingSphere m_BoundingSphere;
 
-	SceneNode(unsigned int id)
+	SceneNode()
 	{
-		s_AllNodes[id] = this;
-		m_ChildNodes = nullptr;
-
-		m_ModelKey = nullptr;
-		m_LightKey = nullptr;
-		m_MaterialKey = nullptr;
-
-		m_Pos = { 0.0f, 0.0f, 0.0f };
-		m_Scale = { 0.0f, 0.0f, 0.0f };
-		m_Rot = { 0.0f, 0.0f, 0.0f, 0.0f };
+		attach(s_Transforms.Create());
 	}
-	SceneNode(unsigned int id, std::string&& modelKey, std::string&& lightKey, std::string&& materialKey)
+	SceneNode(std::string&& modelKey, std::string&& lightKey, std::string&& materialKey)
+		:m_ModelKey(std::move(modelKey)), m_LightKey(std::move(lightKey)), m_MaterialKey(std::move(materialKey))
 	{
-		s_AllNodes[id] = this;
-		m_ChildNodes = nullptr;
-
-		m_ModelKey    = new std::string(std::move(modelKey));
-		m_LightKey    = new std::string(std::move(lightKey));
-		m_MaterialKey = new std::string(std::move(materialKey));
-
-		m_Pos   = { 0.0f, 0.0f, 0.0f };
-		m_Scale = { 0.0f, 0.0f, 0.0f };
-		m_Rot   = { 0.0f, 0.0f, 0.0f, 0.0f };
+		attach(s_Transforms.Create());
 	}
-	SceneNode(unsigned int id, std::string&& modelKey, std::string&& lightKey, std::string&& materialKey, glm::vec3 pos, glm::vec3 scale, glm::quat rot)
+	SceneNode(std::string&& modelKey, std::string&& lightKey, std::string&& materialKey, glm::vec3 pos, glm::vec3 scale, glm::quat rot)
+		:m_ModelKey(std::move(modelKey)), m_LightKey(std::move(lightKey)), m_MaterialKey(std::move(materialKey))
 	{
-		s_AllNodes[id] = this;
-		m_ChildNodes = nullptr;
-
-		m_ModelKey    = new std::string(std::move(modelKey));
-		m_LightKey    = new std::string(std::move(lightKey));
-		m_MaterialKey = new std::string(std::move(materialKey));
-
-		m_Pos = pos;
-		m_Scale = scale;
-		m_Rot = rot;
+		attach(s_Transforms.Create(TRANSFORM_NONE, pos, rot, scale));
 	}
-	SceneNode(unsigned int id, SceneNode& node)
+	//copies the node and all of its child nodes, the copy is a root node
+	SceneNode(const SceneNode& node)
+		:m_ModelKey(node.m_ModelKey), m_LightKey(node.m_LightKey), m_MaterialKey(node.m_MaterialKey)
 	{
-		s_AllNodes[id] = this;
-		m_ChildNodes = nullptr;
-		if(!node.m_ChildNodes->empty())
+		attach(s_Transforms.Create(TRANSFORM_NONE, node.getPosition(), node.getRotation(), node.getScale()));
+		setBounds(node.m_Bounds, node.m_BoundingSphere);
+
+		std::vector<unsigned int> children;
+		s_Transforms.Children(node.m_Transform, children);
+		for(unsigned int i = 0; i < children.size(); i++)
 		{
-			m_ChildNodes = new std::unordered_map<unsigned int, SceneNode*>;
-			auto map = getAllChildren(*node.m_ChildNodes);
-			for(auto iter = map.begin(); iter != map.end(); iter++)
-			{
-				unsigned int id = getFreeID();
-				SceneNode* node = new SceneNode(id, std::move(*(*iter).second));
-				(*m_ChildNodes)[id] = node;
-			}
+			SceneNode* child = new SceneNode(*s_Owners[children[i]]);
+			addChildNode(*child);
 		}
-
-		m_ModelKey    = new std::string(*node.m_ModelKey);
-		m_LightKey    = new std::string(*node.m_LightKey);
-		m_MaterialKey = new std::string(*node.m_MaterialKey);
-		
-		m_Pos = node.m_Pos;
-		m_Scale = node.m_Scale;
-		m_Rot = node.m_Rot;
 	}
-	SceneNode(unsigned int id, SceneNode&& node)
+	//takes over the handle, the transform and the child nodes of node
+	SceneNode(SceneNode&& node)
+		:m_ModelKey(std::move(node.m_ModelKey)), m_LightKey(std::move(node.m_LightKey)), m_MaterialKey(std::move(node.m_MaterialKey)), m_Bounds(node.m_Bounds), m_BoundingSphere(node.m_BoundingSphere)
 	{
-		s_AllNodes[id] = this;
-
-		m_ChildNodes = std::move(node.m_ChildNodes);
-		node.m_ChildNodes = nullptr;
-
-		m_ModelKey    = new std::string(std::move(*node.m_ModelKey));
-		m_LightKey    = new std::string(std::move(*node.m_LightKey));
-		m_MaterialKey = new std::string(std::move(*node.m_MaterialKey));
-		node.m_ModelKey    = nullptr;
-		node.m_LightKey    = nullptr;
-		node.m_MaterialKey = nullptr;
-
-		m_Pos   = std::move(node.m_Pos);
-		m_Scale = std::move(node.m_Scale);
-		m_Rot   = std::move(node.m_Rot);
+		m_Handle = node.m_Handle;
+		m_Transform = node.m_Transform;
+		node.m_Handle = NodeHandle();
+		node.m_Transform = TRANSFORM_NONE;
+		if(m_Transform != TRANSFORM_NONE)
+		{
+			*s_Nodes.Get(m_Handle) = this;
+			s_Owners[m_Transform] = this;
+		}
 	}
+	SceneNode& operator=(const SceneNode&) = delete;
 
 	~SceneNode()
 	{
 		destroy();
 	}
 
-	//destroys the Scene Node object and all of its child nodes
+	//destroys the Scene Node object and all of its child nodes, their handles become invalid
 	void destroy()
 	{
-		if(!m_ChildNodes->empty())
+		if(m_Transform == TRANSFORM_NONE)
+			return;
+		std::vector<unsigned int> removed;
+		s_Transforms.Destroy(m_Transform, &removed);
+		for(unsigned int i = 0; i < removed.size(); i++)
 		{
-			auto map = getAllChildren(*m_ChildNodes);
-			for(auto iter = map.begin(); iter != map.end(); iter++)
-			{
-				(*iter).second->destroy();
-				(*iter).second->m_ChildNodes = nullptr;
-				s_AllNodes.erase((*iter).first);
-			}
+			SceneNode* node = s_Owners[removed[i]];
+			s_Owners[removed[i]] = nullptr;
+			s_Nodes.Erase(node->m_Handle);
+			node->m_Transform = TRANSFORM_NONE;
 		}
-		m_ChildNodes = nullptr;
-
-		m_ModelKey = nullptr;
-		m_LightKey = nullptr;
-		m_MaterialKey = nullptr;
 	}
 	//Use to add a child node to current node
-	void addChildNode(unsigned int id, SceneNode& node)
+	void addChildNode(SceneNode& node)
 	{
-		if(m_ChildNodes == nullptr)
-			m_ChildNodes = new std::unordered_map<unsigned int, SceneNode*>;
-		(*m_ChildNodes)[id] = &node;
+		s_Transforms.SetParent(node.m_Transform, m_Transform);
 	}
 	//Use to remove a Child node from both this current node and all scene nodes
 	//returns 0 if the child node has been successfully erased
 	//returns 1 otherwise
-	bool destroyChildNode(unsigned int id)
+	bool destroyChildNode(NodeHandle handle)
 	{
-		if(s_AllNodes.find(id) != s_AllNodes.end() && m_ChildNodes->find(id) != m_ChildNodes->end())
+		SceneNode* node = getNodeFromID(handle);
+		if(node != nullptr && s_Transforms.Parent(node->m_Transform) == m_Transform)
 		{
-			(*m_ChildNodes)[id]->destroy();
+			node->destroy();
 			return 0;
 		}
 		else
@@ -151,115 +117,101 @@ struct SceneNode
 
 	void updatePosition(glm::vec3 pos)
 	{
-		m_Pos = pos;
+		s_Transforms.SetPosition(m_Transform, pos);
 	}
 	void updateScale(glm::vec3 scale)
 	{
-		m_Scale = scale;
+		s_Transforms.SetScale(m_Transform, scale);
 	}
 	void updateRotation(glm::quat rot)
 	{
-		m_Rot = rot;
+		s_Transforms.SetRotation(m_Transform, rot);
 	}
 	void updateRotation(glm::mat4 rot)
 	{
-		m_Rot = glm::quat_cast(rot);
+		s_Transforms.SetRotation(m_Transform, glm::quat_cast(rot));
 	}
 	void updateRotation(float angle, glm::vec3 vector)
 	{
-		m_Rot = glm::quat_cast(glm::rotate(glm::mat4(1.0f), angle, vector));
+		s_Transforms.SetRotation(m_Transform, glm::angleAxis(angle, glm::normalize(vector)));
 	}
 
 	void changeModelKey(std::string key)
 	{
-		if(m_ModelKey == nullptr)
-			m_ModelKey = new std::string(key);
-		else
-			*m_ModelKey = key;
+		m_ModelKey = key;
 	}
-	void changeLightKey(std::string key)
+	//also takes over the bounds of the model
+	void changeModelKey(std::string key, const Model& model)
 	{
-		if(m_LightKey == nullptr)
-			m_LightKey = new std::string(key);
-		else
-			*m_LightKey = key;
+		m_ModelKey = key;
+		setBounds(model.m_Bounds, model.m_BoundingSphere);
 	}
-	void changeMaterialKey(std::string key)
+	//the world space bounds follow the node's transform from the next updateTransforms() on
+	void setBounds(const BoundingBox& box, const BoundingSphere& sphere)
 	{
-		if(m_MaterialKey == nullptr)
-			m_MaterialKey = new std::string(key);
+		m_Bounds = box;
+		m_BoundingSphere = sphere;
+		if(box.IsEmpty())
+			s_Transforms.SetBounds(m_Transform, glm::vec3(1.0f), glm::vec3(-1.0f));
 		else
-			*m_MaterialKey = key;
+			s_Transforms.SetBounds(m_Transform, box.m_Min, box.m_Max);
 	}
-
-	glm::mat4 getMatrix()
+	void changeLightKey(std::string key)
 	{
-		glm::mat4 matrix(1.0f);
-		matrix = glm::translate(matrix, m_Pos);
-		matrix = matrix * glm::mat4_cast(m_Rot);
-		matrix = glm::scale(matrix, m_Scale);
-		return matrix;
+		m_LightKey = key;
 	}
-	inline unsigned int getID()
+	void changeMaterialKey(std::string key)
 	{
-		std::unordered_map<unsigned int, SceneNode*>::iterator iter;
-		for(iter = s_AllNodes.begin(); iter != s_AllNodes.end(); iter++)
-		{
-			if(this == (*iter).second)
-				return (*iter).first;
-		}
-		return -1;
+		m_MaterialKey = key;
 	}
-	inline unsigned int getNrOfChildren()
+
+	inline const glm::vec3& getPosition() const { return s_Transforms.Position(m_Transform); }
+	inline const glm::vec3& getScale() const { return s_Transforms.Scale(m_Transform); }
+	inline const glm::quat& getRotation() const { return s_Transforms.Rotation(m_Transform); }
+	//the world matrix as of the last updateTransforms()
+	inline const glm::mat4& getMatrix() const { return s_Transforms.World(m_Transform); }
+	inline glm::mat4 getLocalMatrix() const { return s_Transforms.Local(m_Transform); }
+	//world space bounds as of the last updateTransforms(), empty if the node has no bounds
+	inline BoundingBox getWorldBounds() const { return s_Transforms.HasBounds(m_Transform) ? BoundingBox(s_Transforms.WorldMin(m_Transform), s_Transforms.WorldMax(m_Transform)) : BoundingBox(); }
+	inline BoundingSphere getWorldBoundingSphere() const { return m_BoundingSphere.Transformed(getMatrix()); }
+	inline NodeHandle getID() const { return m_Handle; }
+	inline unsigned int getNrOfChildren() const
 	{
-		if(m_ChildNodes == nullptr)
+		if(m_Transform == TRANSFORM_NONE)
 			return 0;
 		else
-			return m_ChildNodes->size();
-	}
-
-	inline SceneNode* operator[](unsigned int id) { return SceneNode::getNodeFromID(id); }
-	inline bool operator<(SceneNode other) { return this->getID() < other.getID(); }
-	inline bool operator==(SceneNode other) { return this->getID() == other.getID(); }
-	inline bool operator>(SceneNode other) { return this->getID() > other.getID(); }
-	inline static std::unordered_map<unsigned int, SceneNode*>* getMapOfAllNodes() { return &s_AllNodes;  }
-	inline static SceneNode* getNodeFromID(unsigned int id) { return s_AllNodes[id]; }
-	inline static unsigned int getNrOfNodes() { return s_AllNodes.size(); }
-	static unsigned int getFreeID()
-	{
-		for(unsigned int i = 1; i < INT_MAX; i++)
-		{
-			bool isUsed = 0;
-			for(auto iter = s_AllNodes.begin(); iter != s_AllNodes.end(); iter++)
-			{
-				if((*iter).first == i)
-					isUsed = 1;
-			}
-			if(!isUsed)
-				return i;
-		}
-	}
+			return s_Transforms.NrOfChildren(m_Transform);
+	}
+
+	inline SceneNode* operator[](NodeHandle handle) { return SceneNode::getNodeFromID(handle); }
+	inline bool operator<(const SceneNode& other) const { return m_Handle < other.m_Handle; }
+	inline bool operator==(const SceneNode& other) const { return m_Handle == other.m_Handle; }
+	inline bool operator>(const SceneNode& other) const { return m_Handle > other.m_Handle; }
+	inline static SlotMap<SceneNode*>& getAllNodes() { return s_Nodes; }
+	//nullptr if the node has been destroyed
+	inline static SceneNode* getNodeFromID(NodeHandle handle) { SceneNode** node = s_Nodes.Get(handle); return node ? *node : nullptr; }
+	inline static unsigned int getNrOfNodes() { return s_Nodes.Size(); }
+	inline static TransformHierarchy& getTransforms() { return s_Transforms; }
+	//propagates the changed local transforms to the world matrices of all nodes
+	inline static void updateTransforms() { s_Transforms.Update(); }
 private:
-	static std::unordered_map<unsigned int, SceneNode*> s_AllNodes; //The map of all Scene Nodes
-	std::unordered_map<unsigned int, SceneNode*>& getAllChildren(std::unordered_map<unsigned int, SceneNode*>& map)
+	static SlotMap<SceneNode*> s_Nodes; //all Scene Nodes
+	static TransformHierarchy s_Transforms; //hierarchy and transforms of all Scene Nodes
+	static std::vector<SceneNode*> s_Owners; //the node of every transform ID
+
+	void attach(unsigned int transform)
 	{
-		if(map.empty())
-			return map;
-		std::unordered_map<unsigned int, SceneNode*> resultantMap;
-		for(auto iter = map.begin(); iter != map.end(); iter++)
-		{
-			if((*iter).second->getNrOfChildren() != 0)
-			{
-				auto temp = getAllChildren(*(*iter).second->m_ChildNodes);
-				resultantMap.insert(temp.begin(), temp.end());
-			}
-			resultantMap.insert(*iter);
-		}
-		return resultantMap;
+		m_Handle = s_Nodes.Insert(this);
+		m_Transform = transform;
+		if(s_Owners.size() <= transform)
+			s_Owners.resize(transform + 1, nullptr);
+		s_Owners[transform] = this;
 	}
 };
 
-std::unordered_map<unsigned int, SceneNode*> SceneNode::s_AllNodes;
+SlotMap<SceneNode*> SceneNode::s_Nodes;
+TransformHierarchy SceneNode::s_Transforms;
+std::vector<SceneNode*> SceneNode::s_Owners;
 
 class Scene
 {
@@ -270,21 +222,30 @@ public:
 	std::unordered_map<std::string, Material*>* m_Materials;
 	Scene()
 	{
-		m_Nodes = SceneNode::getMapOfAllNodes();
-		(*m_Nodes)[0] = new SceneNode(0);
+		m_Nodes = &SceneNode::getAllNodes();
+		m_Root = (new SceneNode())->getID();
 		m_Materials = Material::getMapOfAllMaterials();
 		//m_Models = Model::getMapOfAllModels();
 		//m_Models = Model::getMapOfAllLights();
 	}
 	~Scene()
 	{
-		for(auto iter = m_Nodes->begin(); iter != m_Nodes->end(); iter++)
-		{
-			delete (*iter).second;
-		}
+		//destroying a node unregisters its child nodes, so the slot map can't be iterated while deleting
+		std::vector<SceneNode*> nodes = m_Nodes->Values();
+		for(unsigned int i = 0; i < nodes.size(); i++)
+			delete nodes[i];
+	}
+
+	inline SceneNode* Root() { return SceneNode::getNodeFromID(m_Root); }
+
+	//call once per frame after moving nodes
+	void Update()
+	{
+		SceneNode::updateTransforms();
 	}
 private:
-	std::unordered_map<unsigned int, SceneNode*>* m_Nodes;
+	SlotMap<SceneNode*>* m_Nodes;
+	NodeHandle m_Root;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,170 @@
+#ifndef SCENE_JOBS_H
+#define SCENE_JOBS_H
+
+#include <vector>
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <src/TransformHierarchy.h>
+#include <src/JobSystem.h>
+#include <src/FrustumCuller.h>
+
+#define SCENE_JOBS_GRAIN 2048 //nodes per job
+
+//Updates the world matrices and bounds of a TransformHierarchy and culls them against any number of views in one pass over the nodes.
+//The levels of the hierarchy are processed one after the other, the nodes of each level are split into jobs on the job system.
+//Every job gathers the spheres around its nodes' world boxes into its own FrustumCuller once and culls them against every view with SIMD.
+//Its visible nodes go into its own list per view, the lists are joined in job order so the result doesn't depend on the timing.
+class SceneJobs
+{
+public:
+	SceneJobs()
+		:m_Jobs(nullptr)
+	{
+
+	}
+
+	void Init(JobSystem* jobs)
+	{
+		m_Jobs = jobs;
+	}
+
+	void Update(TransformHierarchy& transforms, CullView* views, unsigned int nrOfViews)
+	{
+		const std::vector<unsigned int>& levels = transforms.Levels();
+		const std::vector<glm::vec3>& worldMin = transforms.WorldMins();
+		const std::vector<glm::vec3>& worldMax = transforms.WorldMaxs();
+		const std::vector<unsigned int>& ids = transforms.IDs();
+
+		//every level starts at a new job so its jobs can be numbered in advance
+		unsigned int nrOfJobs = 0;
+		std::vector<unsigned int> firstJob(levels.size(), 0);
+		for(unsigned int l = 0; l + 1 < levels.size(); l++)
+		{
+			firstJob[l] = nrOfJobs;
+			nrOfJobs += (levels[l + 1] - levels[l] + SCENE_JOBS_GRAIN - 1) / SCENE_JOBS_GRAIN;
+		}
+		if(m_JobVisible.size() < nrOfJobs * nrOfViews)
+			m_JobVisible.resize(nrOfJobs * nrOfViews);
+		if(m_JobBounds.size() < nrOfJobs)
+			m_JobBounds.resize(nrOfJobs);
+
+		transforms.BeginUpdate();
+		for(unsigned int l = 0; l + 1 < levels.size(); l++)
+		{
+			unsigned int levelStart = levels[l];
+			unsigned int levelFirstJob = firstJob[l];
+			m_Jobs->ParallelFor(levels[l + 1] - levelStart, SCENE_JOBS_GRAIN, [&](unsigned int begin, unsigned int end)
+			{
+				begin += levelStart;
+				end += levelStart;
+				transforms.UpdateRange(begin, end);
+
+				unsigned int job = levelFirstJob + (begin - levelStart) / SCENE_JOBS_GRAIN;
+				JobBounds& bounds = m_JobBounds[job];
+				bounds.m_Spheres.Clear();
+				bounds.m_Nodes.clear();
+				for(unsigned int i = begin; i < end; i++)
+				{
+					//nodes without bounds have min > max and are never visible
+					if(worldMin[i].x > worldMax[i].x)
+						continue;
+					glm::vec3 center = (worldMin[i] + worldMax[i]) * 0.5f;
+					bounds.m_Spheres.Add(center, glm::length(worldMax[i] - center));
+					bounds.m_Nodes.push_back(i);
+				}
+				for(unsigned int v = 0; v < nrOfViews; v++)
+				{
+					std::vector<unsigned int>& visible = m_JobVisible[job * nrOfViews + v];
+					visible.clear();
+					if(bounds.m_Spheres.Size() == 0 || bounds.m_Spheres.Cull(views[v].m_Planes, bounds.m_Visible) == 0)
+						continue;
+					for(unsigned int i = 0; i < bounds.m_Spheres.Size(); i++)
+					{
+						if(FrustumCuller::Visible(bounds.m_Visible, i))
+							visible.push_back(ids[bounds.m_Nodes[i]]);
+					}
+				}
+			});
+		}
+		transforms.EndUpdate();
+
+		for(unsigned int v = 0; v < nrOfViews; v++)
+		{
+			std::vector<unsigned int>& visible = views[v].m_Visible;
+			visible.clear();
+			for(unsigned int j = 0; j < nrOfJobs; j++)
+			{
+				const std::vector<unsigned int>& jobVisible = m_JobVisible[j * nrOfViews + v];
+				visible.insert(visible.end(), jobVisible.begin(), jobVisible.end());
+			}
+		}
+	}
+
+	//builds a procedural hierarchy of nrOfNodes boxes and times moving its roots, updating and culling it against one view with 1 to all workers
+	static void Benchmark(JobSystem& jobSystem, unsigned int nrOfNodes, unsigned int nrOfFrames = 20)
+	{
+		TransformHierarchy transforms;
+		transforms.Reserve(nrOfNodes);
+		std::default_random_engine generator(7);
+		std::uniform_real_distribution<float> random(-1.0f, 1.0f);
+		std::vector<unsigned int> roots;
+		for(unsigned int i = 0; i < nrOfNodes; i++)
+		{
+			//64 roots with 8 children per node
+			bool root = i < 64;
+			unsigned int parent = root ? TRANSFORM_NONE : (i - 64) / 8;
+			glm::vec3 position = root ? glm::vec3(random(generator), random(generator), random(generator)) * 200.0f : glm::vec3(random(generator), random(generator), random(generator)) * 4.0f;
+			unsigned int id = transforms.Create(parent, position, glm::angleAxis(random(generator) * 3.14f, glm::vec3(0.0f, 1.0f, 0.0f)), glm::vec3(0.9f));
+			transforms.SetBounds(id, glm::vec3(-0.5f), glm::vec3(0.5f));
+			if(root)
+				roots.push_back(id);
+		}
+
+		CullView view;
+		glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 500.0f);
+		SceneJobs jobs;
+		jobs.Init(&jobSystem);
+		unsigned int nrOfWorkers = jobSystem.NrOfActiveWorkers();
+		std::cout << "Scene update + culling of " << nrOfNodes << " nodes in " << transforms.Levels().size() - 1 << " levels:" << std::endl;
+		double singleThreaded = 0.0;
+		for(unsigned int workers = 0; workers <= nrOfWorkers; workers++)
+		{
+			jobSystem.SetNrOfActiveWorkers(workers);
+			double total = 0.0;
+			for(unsigned int frame = 0; frame < nrOfFrames; frame++)
+			{
+				float angle = frame * 0.05f;
+				for(unsigned int r = 0; r < roots.size(); r++)
+					transforms.SetRotation(roots[r], glm::angleAxis(angle + r, glm::vec3(0.0f, 1.0f, 0.0f)));
+				view.SetViewProjection(projection * glm::lookAt(glm::vec3(0.0f, 50.0f, 0.0f), glm::vec3(sin(angle), 50.0f, cos(angle)), glm::vec3(0.0f, 1.0f, 0.0f)));
+
+				std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+				jobs.Update(transforms, &view, 1);
+				total += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			}
+			double average = total / nrOfFrames;
+			if(workers == 0)
+				singleThreaded = average;
+			std::cout << "  " << workers + 1 << " threads: " << average << "ms (x" << singleThreaded / average << "), " << view.m_Visible.size() << " visible" << std::endl;
+		}
+		jobSystem.SetNrOfActiveWorkers(nrOfWorkers);
+	}
+
+private:
+	//the nodes of one job as bounding spheres, laid out for the SIMD cull
+	struct JobBounds
+	{
+		FrustumCuller m_Spheres;
+		std::vector<unsigned int> m_Nodes; //node index of every sphere
+		std::vector<unsigned int> m_Visible; //one bit per sphere, of the view being culled
+	};
+
+	JobSystem* m_Jobs;
+	std::vector<std::vector<unsigned int>> m_JobVisible; //visible nodes of every job and view
+	std::vector<JobBounds> m_JobBounds;
+};
+
+#endif
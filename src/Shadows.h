@@ -9,6 +9,7 @@
 #define MAX_SHADOW_MAP_RESOLUTION (4096 * 4096)
 
 #include <src/light.h>
+#include <src/FrustumCuller.h>
 
 extern const float Pi;
 extern void renderQuad();
@@ -410,6 +411,58 @@ public:
 	}
 	unsigned int inline getNrOfShadowMaps() const {	return m_NrOfShadowMaps; }
 
+	//culls the casters against every view of a shadow map, faceMasks gets a bit per cube face (bit 0 for the other types) for each caster, 0 if no view sees it
+	void cullShadowCasters(unsigned int index, const FrustumCuller& casters, std::vector<unsigned int>& faceMasks)
+	{
+		ShadowMap* shadowMap = shadowMaps[index];
+		unsigned int nrOfViews = shadowMap->m_Light->m_Type == POINT_LIGHT ? 6 : 1;
+		faceMasks.assign(casters.Size(), 0);
+		for(unsigned int face = 0; face < nrOfViews; face++)
+		{
+			if(casters.Cull(shadowMap->m_TransformMatrix[face], m_FaceVisible) == 0)
+				continue;
+			for(unsigned int i = 0; i < casters.Size(); i++)
+			{
+				if(FrustumCuller::Visible(m_FaceVisible, i))
+					faceMasks[i] |= 1u << face;
+			}
+		}
+	}
+	//same as above for only the candidates, e.g. the casters within range of the light, the masks of the others stay 0
+	void cullShadowCasters(unsigned int index, const FrustumCuller& casters, const std::vector<unsigned int>& candidates, std::vector<unsigned int>& faceMasks)
+	{
+		m_Candidates.Clear();
+		for(unsigned int i = 0; i < candidates.size(); i++)
+			m_Candidates.Add(casters.Center(candidates[i]), casters.Radius(candidates[i]));
+		cullShadowCasters(index, m_Candidates, m_CandidateFaceMasks);
+		faceMasks.assign(casters.Size(), 0);
+		for(unsigned int i = 0; i < candidates.size(); i++)
+			faceMasks[candidates[i]] = m_CandidateFaceMasks[i];
+	}
+	//same masks from views that were already culled, e.g. by SceneJobs::Update(), one per view of the shadow map (6 for point lights, 1 for the other types).
+	//objectOfID maps the transform IDs in their m_Visible to the casters' indices, IDs of anything else are skipped
+	void cullShadowCasters(unsigned int index, unsigned int nrOfCasters, const CullView* faceViews, const std::vector<unsigned int>& objectOfID, std::vector<unsigned int>& faceMasks)
+	{
+		unsigned int nrOfViews = shadowMaps[index]->m_Light->m_Type == POINT_LIGHT ? 6 : 1;
+		faceMasks.assign(nrOfCasters, 0);
+		for(unsigned int face = 0; face < nrOfViews; face++)
+		{
+			const std::vector<unsigned int>& visible = faceViews[face].m_Visible;
+			for(unsigned int i = 0; i < visible.size(); i++)
+			{
+				unsigned int caster = CullView::Object(objectOfID, visible[i]);
+				if(caster < nrOfCasters)
+					faceMasks[caster] |= 1u << face;
+			}
+		}
+	}
+	//the point depth shader only emits a caster's triangles into the cube faces of its mask, call after use()
+	void setShadowCasterFaces(unsigned int faceMask)
+	{
+		if(m_CurrentShader == m_PointDepthShader)
+			m_CurrentShader->setInt("culledFaces", ~faceMask & 63);
+	}
+
 	void debugShadowMap(unsigned int index)
 	{
 		m_DebugShader->use();
@@ -423,6 +476,9 @@ private:
 	bool m_Init;
 	bool m_ShadowMapsCreated[MAX_SHADOWMAPS];
 	unsigned int m_NrOfShadowMaps;
+	std::vector<unsigned int> m_FaceVisible; //bitset of the casters in the view being culled
+	FrustumCuller m_Candidates;
+	std::vector<unsigned int> m_CandidateFaceMasks;
 	static Shader* m_SimpleDepthShader;
 	static Shader* m_PointDepthShader;
 	static Shader* m_DebugShader;
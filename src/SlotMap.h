@@ -0,0 +1,126 @@
+#ifndef SLOT_MAP_H
+#define SLOT_MAP_H
+
+#include <vector>
+
+#define SLOT_MAP_INVALID_INDEX 0xFFFFFFFFu
+
+//Identifies a value in a SlotMap. The generation is bumped every time a slot is reused, so handles to erased values stay detectable
+struct SlotHandle
+{
+	unsigned int m_Index;
+	unsigned int m_Generation;
+
+	SlotHandle()
+		:m_Index(SLOT_MAP_INVALID_INDEX), m_Generation(0)
+	{
+
+	}
+	SlotHandle(unsigned int index, unsigned int generation)
+		:m_Index(index), m_Generation(generation)
+	{
+
+	}
+
+	inline bool IsNull() const { return m_Index == SLOT_MAP_INVALID_INDEX; }
+	inline bool operator==(const SlotHandle& other) const { return m_Index == other.m_Index && m_Generation == other.m_Generation; }
+	inline bool operator!=(const SlotHandle& other) const { return !(*this == other); }
+	inline bool operator<(const SlotHandle& other) const { return m_Index < other.m_Index || (m_Index == other.m_Index && m_Generation < other.m_Generation); }
+	inline bool operator>(const SlotHandle& other) const { return other < *this; }
+};
+
+//Values stored densely with O(1) insertion, erasure and lookup through generational handles.
+//Free slots form a list through their m_Dense field, erasing moves the last value into the hole so the values stay packed.
+template<typename T>
+class SlotMap
+{
+public:
+	SlotMap()
+		:m_FreeHead(SLOT_MAP_INVALID_INDEX)
+	{
+
+	}
+
+	void Reserve(unsigned int size)
+	{
+		m_Slots.reserve(size);
+		m_Values.reserve(size);
+		m_DenseToSlot.reserve(size);
+	}
+
+	SlotHandle Insert(const T& value)
+	{
+		unsigned int index;
+		if(m_FreeHead != SLOT_MAP_INVALID_INDEX)
+		{
+			index = m_FreeHead;
+			m_FreeHead = m_Slots[index].m_Dense;
+		}
+		else
+		{
+			index = (unsigned int)m_Slots.size();
+			Slot slot = { 0, 1 };
+			m_Slots.push_back(slot);
+		}
+		m_Slots[index].m_Dense = (unsigned int)m_Values.size();
+		m_Values.push_back(value);
+		m_DenseToSlot.push_back(index);
+		return SlotHandle(index, m_Slots[index].m_Generation);
+	}
+	//returns 0 if the handle was stale
+	bool Erase(SlotHandle handle)
+	{
+		if(!Valid(handle))
+			return 0;
+		Slot& slot = m_Slots[handle.m_Index];
+		unsigned int last = (unsigned int)m_Values.size() - 1;
+		if(slot.m_Dense != last)
+		{
+			m_Values[slot.m_Dense] = m_Values[last];
+			m_DenseToSlot[slot.m_Dense] = m_DenseToSlot[last];
+			m_Slots[m_DenseToSlot[last]].m_Dense = slot.m_Dense;
+		}
+		m_Values.pop_back();
+		m_DenseToSlot.pop_back();
+
+		slot.m_Generation++;
+		slot.m_Dense = m_FreeHead;
+		m_FreeHead = handle.m_Index;
+		return 1;
+	}
+	void Clear()
+	{
+		while(!m_Values.empty())
+			Erase(Handle((unsigned int)m_Values.size() - 1));
+	}
+
+	inline bool Valid(SlotHandle handle) const { return handle.m_Index < m_Slots.size() && m_Slots[handle.m_Index].m_Generation == handle.m_Generation && !isFree(handle.m_Index); }
+	//nullptr for stale handles
+	inline T* Get(SlotHandle handle) { return Valid(handle) ? &m_Values[m_Slots[handle.m_Index].m_Dense] : nullptr; }
+	inline const T* Get(SlotHandle handle) const { return Valid(handle) ? &m_Values[m_Slots[handle.m_Index].m_Dense] : nullptr; }
+	inline unsigned int Size() const { return (unsigned int)m_Values.size(); }
+
+	//the packed values and the handle of each, the order changes when values are erased
+	inline std::vector<T>& Values() { return m_Values; }
+	inline const std::vector<T>& Values() const { return m_Values; }
+	inline SlotHandle Handle(unsigned int dense) const { unsigned int index = m_DenseToSlot[dense]; return SlotHandle(index, m_Slots[index].m_Generation); }
+
+private:
+	struct Slot
+	{
+		unsigned int m_Dense; //position of the value, or the next free slot while the slot is free
+		unsigned int m_Generation;
+	};
+	std::vector<Slot> m_Slots;
+	std::vector<T> m_Values;
+	std::vector<unsigned int> m_DenseToSlot;
+	unsigned int m_FreeHead;
+
+	inline bool isFree(unsigned int index) const
+	{
+		unsigned int dense = m_Slots[index].m_Dense;
+		return dense >= m_DenseToSlot.size() || m_DenseToSlot[dense] != index;
+	}
+};
+
+#endif
@@ -0,0 +1,434 @@
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <cmath>
+#include <glm/glm.hpp>
+
+#define SPATIAL_INVALID 0xFFFFFFFFu
+#define SPATIAL_OCTREE_MAX_DEPTH 10
+#define SPATIAL_GRID_MIN_BUCKETS 1024 //the bucket table doubles whenever there are more objects than buckets
+
+enum SpatialIndexMode
+{
+	SPATIAL_LOOSE_OCTREE = 0,
+	SPATIAL_HASHED_GRID,
+	NR_OF_SPATIAL_INDEX_MODES
+};
+
+struct SpatialObject
+{
+	glm::vec3 m_Center;
+	float m_Radius;
+	unsigned int m_Cell; //octree node or grid bucket the object is linked into, SPATIAL_INVALID once removed
+	unsigned int m_Next, m_Prev; //neighbours in the list of that node or bucket, m_Next links the free list after removal
+	int m_X, m_Y, m_Z; //grid cell of the center
+};
+
+struct SpatialOctreeNode
+{
+	glm::vec3 m_Center;
+	float m_HalfSize; //of the cell, the loose bounds reach half of that further on every side
+	unsigned int m_Parent;
+	unsigned int m_Children[8];
+	unsigned int m_First; //first object stored in this node
+	unsigned int m_Count; //objects in the whole subtree, empty subtrees are skipped by queries
+	unsigned int m_Depth;
+};
+
+//Bounding spheres that move every frame, indexed either by a loose octree or by a hashed uniform grid, to find the objects within some radius of a point.
+//Loose octree: an object is stored in the deepest cell containing its center whose size is at least 4x its radius,
+//so it never straddles a boundary and moving it only relinks it when it leaves that cell.
+//Hashed grid: an object is stored in the cell containing its center, the cells are hashed into a table of linked lists so the world is unbounded.
+//Queries grow by the largest object radius seen, so a few huge objects make every grid query visit more cells.
+//Both keep objects in intrusive doubly linked lists, so insert, move and remove are O(1) (the octree walks its depth).
+class SpatialIndex
+{
+public:
+	SpatialIndex()
+		:m_Mode(SPATIAL_LOOSE_OCTREE), m_Center(0.0f), m_HalfSize(1.0f), m_CellSize(1.0f), m_InverseCellSize(1.0f), m_MaxRadius(0.0f), m_NrOfObjects(0), m_FirstFree(SPATIAL_INVALID)
+	{
+
+	}
+
+	//the octree covers the cube of halfSize around center, objects outside of it stay in the root.
+	//cellSize is the grid spacing, somewhere between the object size and the usual query radius
+	void Init(SpatialIndexMode mode, const glm::vec3& center, float halfSize, float cellSize)
+	{
+		m_Mode = mode;
+		m_Center = center;
+		m_HalfSize = halfSize;
+		m_CellSize = cellSize;
+		m_InverseCellSize = 1.0f / cellSize;
+		Clear();
+	}
+	void Clear()
+	{
+		m_Objects.clear();
+		m_FirstFree = SPATIAL_INVALID;
+		m_NrOfObjects = 0;
+		m_MaxRadius = 0.0f;
+		resetCells(SPATIAL_GRID_MIN_BUCKETS);
+	}
+	//relinks every object into the structure of the new mode, the ids stay the same
+	void SetMode(SpatialIndexMode mode)
+	{
+		if(mode == m_Mode)
+			return;
+		m_Mode = mode;
+		relink((unsigned int)m_Buckets.size());
+	}
+
+	//returns the id of the object, ids of removed objects are reused
+	unsigned int Insert(const glm::vec3& center, float radius)
+	{
+		if(m_Mode == SPATIAL_HASHED_GRID && m_NrOfObjects >= m_Buckets.size())
+			relink((unsigned int)m_Buckets.size() * 2);
+
+		unsigned int id = m_FirstFree;
+		if(id != SPATIAL_INVALID)
+			m_FirstFree = m_Objects[id].m_Next;
+		else
+		{
+			id = (unsigned int)m_Objects.size();
+			m_Objects.push_back(SpatialObject());
+		}
+		m_Objects[id].m_Center = center;
+		m_Objects[id].m_Radius = radius;
+		m_MaxRadius = std::max(m_MaxRadius, radius);
+		link(id);
+		m_NrOfObjects++;
+		return id;
+	}
+	//only relinks the object when it left its octree cell (or no longer fits its depth) or its grid cell
+	void Move(unsigned int id, const glm::vec3& center, float radius)
+	{
+		SpatialObject& object = m_Objects[id];
+		object.m_Center = center;
+		object.m_Radius = radius;
+		m_MaxRadius = std::max(m_MaxRadius, radius);
+		if(m_Mode == SPATIAL_LOOSE_OCTREE)
+		{
+			if(octreeKeeps(object.m_Cell, center, radius))
+				return;
+		}
+		else if(object.m_X == gridCoordinate(center.x) && object.m_Y == gridCoordinate(center.y) && object.m_Z == gridCoordinate(center.z))
+			return;
+		unlink(id);
+		link(id);
+	}
+	void Remove(unsigned int id)
+	{
+		if(id >= m_Objects.size() || m_Objects[id].m_Cell == SPATIAL_INVALID)
+			return;
+		unlink(id);
+		m_Objects[id].m_Cell = SPATIAL_INVALID;
+		m_Objects[id].m_Next = m_FirstFree;
+		m_FirstFree = id;
+		m_NrOfObjects--;
+	}
+
+	//the ids of every object whose sphere overlaps the query sphere, in no particular order
+	void QuerySphere(const glm::vec3& center, float radius, std::vector<unsigned int>& results) const
+	{
+		results.clear();
+		if(m_Mode == SPATIAL_LOOSE_OCTREE)
+			queryOctree(center, radius, results);
+		else
+			queryGrid(center, radius, results);
+	}
+
+	inline SpatialIndexMode Mode() const { return m_Mode; }
+	inline unsigned int NrOfObjects() const { return m_NrOfObjects; }
+	inline unsigned int NrOfNodes() const { return (unsigned int)m_Nodes.size(); }
+	inline unsigned int NrOfBuckets() const { return (unsigned int)m_Buckets.size(); }
+	inline const SpatialObject& Object(unsigned int id) const { return m_Objects[id]; }
+
+	static const char* ModeName(SpatialIndexMode mode)
+	{
+		static const char* names[NR_OF_SPATIAL_INDEX_MODES] = { "Loose octree", "Hashed grid" };
+		return names[mode];
+	}
+
+	//Inserts, moves and queries the same spheres with both modes at increasing numbers of objects in the same volume,
+	//the query results are checked against brute force. The cell size is kept fixed so the densities are comparable.
+	static void Benchmark()
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+		const float worldSize = 500.0f, cellSize = 8.0f, queryRadius = 25.0f;
+		const unsigned int nrOfQueries = 1000, nrOfChecked = 50;
+		const unsigned int counts[4] = { 1000, 10000, 100000, 1000000 };
+		std::cout << "Spatial index, spheres in a " << 2.0f * worldSize << "^3 volume, " << nrOfQueries << " queries of radius " << queryRadius << ":" << std::endl;
+		for(unsigned int c = 0; c < 4; c++)
+		{
+			unsigned int nrOfObjects = counts[c];
+			std::default_random_engine generator(7);
+			std::uniform_real_distribution<float> position(-worldSize, worldSize), size(0.5f, 3.0f), unit(-1.0f, 1.0f);
+			std::vector<glm::vec3> centers(nrOfObjects), moved(nrOfObjects), queries(nrOfQueries);
+			std::vector<float> radii(nrOfObjects);
+			for(unsigned int i = 0; i < nrOfObjects; i++)
+			{
+				centers[i] = glm::vec3(position(generator), position(generator), position(generator));
+				moved[i] = centers[i] + glm::vec3(unit(generator), unit(generator), unit(generator));
+				radii[i] = size(generator);
+			}
+			for(unsigned int i = 0; i < nrOfQueries; i++)
+				queries[i] = glm::vec3(position(generator), position(generator), position(generator));
+
+			std::cout << "  " << nrOfObjects << " objects (" << nrOfObjects / (8.0 * worldSize * worldSize * worldSize) * 1e6 << " per 100^3):" << std::endl;
+			double totals[NR_OF_SPATIAL_INDEX_MODES];
+			for(unsigned int m = 0; m < NR_OF_SPATIAL_INDEX_MODES; m++)
+			{
+				SpatialIndex index;
+				index.Init((SpatialIndexMode)m, glm::vec3(0.0f), worldSize, cellSize);
+				Clock::time_point start = Clock::now();
+				for(unsigned int i = 0; i < nrOfObjects; i++)
+					index.Insert(centers[i], radii[i]);
+				double insertTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+				start = Clock::now();
+				for(unsigned int i = 0; i < nrOfObjects; i++)
+					index.Move(i, moved[i], radii[i]);
+				double moveTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+				std::vector<unsigned int> results;
+				unsigned int nrOfResults = 0;
+				start = Clock::now();
+				for(unsigned int i = 0; i < nrOfQueries; i++)
+				{
+					index.QuerySphere(queries[i], queryRadius, results);
+					nrOfResults += (unsigned int)results.size();
+				}
+				double queryTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+				unsigned int errors = 0;
+				for(unsigned int i = 0; i < nrOfChecked; i++)
+				{
+					index.QuerySphere(queries[i], queryRadius, results);
+					unsigned int expected = 0;
+					for(unsigned int j = 0; j < nrOfObjects; j++)
+					{
+						glm::vec3 offset = moved[j] - queries[i];
+						expected += glm::dot(offset, offset) <= (queryRadius + radii[j]) * (queryRadius + radii[j]);
+					}
+					errors += expected != results.size();
+				}
+
+				totals[m] = moveTime + queryTime;
+				std::cout << "    " << ModeName((SpatialIndexMode)m) << ": insert " << insertTime << "ms, move all " << moveTime << "ms, queries " << queryTime << "ms ("
+				          << (double)nrOfResults / nrOfQueries << " hits each), " << (m == SPATIAL_LOOSE_OCTREE ? index.NrOfNodes() : index.NrOfBuckets())
+				          << (m == SPATIAL_LOOSE_OCTREE ? " nodes" : " buckets") << ", " << errors << " mismatches" << std::endl;
+			}
+			std::cout << "    per frame (move all + queries) the " << ModeName(totals[SPATIAL_LOOSE_OCTREE] <= totals[SPATIAL_HASHED_GRID] ? SPATIAL_LOOSE_OCTREE : SPATIAL_HASHED_GRID) << " wins" << std::endl;
+		}
+	}
+
+private:
+	SpatialIndexMode m_Mode;
+	glm::vec3 m_Center;
+	float m_HalfSize;
+	float m_CellSize;
+	float m_InverseCellSize;
+	float m_MaxRadius; //never shrinks, so a grid query can always rely on it
+	unsigned int m_NrOfObjects;
+	unsigned int m_FirstFree;
+	std::vector<SpatialObject> m_Objects;
+	std::vector<SpatialOctreeNode> m_Nodes; //the root is node 0, nodes are only freed by Clear()
+	std::vector<unsigned int> m_Buckets; //first object of each bucket, the size is a power of two
+
+	void resetCells(unsigned int nrOfBuckets)
+	{
+		m_Nodes.clear();
+		m_Nodes.push_back(octreeNode(m_Center, m_HalfSize, SPATIAL_INVALID, 0));
+		m_Buckets.assign(nrOfBuckets, SPATIAL_INVALID);
+	}
+	void relink(unsigned int nrOfBuckets)
+	{
+		resetCells(nrOfBuckets);
+		for(unsigned int i = 0; i < m_Objects.size(); i++)
+		{
+			if(m_Objects[i].m_Cell != SPATIAL_INVALID)
+				link(i);
+		}
+	}
+
+	void link(unsigned int id)
+	{
+		SpatialObject& object = m_Objects[id];
+		unsigned int* first;
+		if(m_Mode == SPATIAL_LOOSE_OCTREE)
+		{
+			object.m_Cell = octreeTarget(object.m_Center, object.m_Radius);
+			for(unsigned int node = object.m_Cell; node != SPATIAL_INVALID; node = m_Nodes[node].m_Parent)
+				m_Nodes[node].m_Count++;
+			first = &m_Nodes[object.m_Cell].m_First;
+		}
+		else
+		{
+			object.m_X = gridCoordinate(object.m_Center.x);
+			object.m_Y = gridCoordinate(object.m_Center.y);
+			object.m_Z = gridCoordinate(object.m_Center.z);
+			object.m_Cell = bucket(object.m_X, object.m_Y, object.m_Z);
+			first = &m_Buckets[object.m_Cell];
+		}
+		object.m_Prev = SPATIAL_INVALID;
+		object.m_Next = *first;
+		if(*first != SPATIAL_INVALID)
+			m_Objects[*first].m_Prev = id;
+		*first = id;
+	}
+	void unlink(unsigned int id)
+	{
+		SpatialObject& object = m_Objects[id];
+		unsigned int* first;
+		if(m_Mode == SPATIAL_LOOSE_OCTREE)
+		{
+			for(unsigned int node = object.m_Cell; node != SPATIAL_INVALID; node = m_Nodes[node].m_Parent)
+				m_Nodes[node].m_Count--;
+			first = &m_Nodes[object.m_Cell].m_First;
+		}
+		else
+			first = &m_Buckets[object.m_Cell];
+		if(object.m_Prev != SPATIAL_INVALID)
+			m_Objects[object.m_Prev].m_Next = object.m_Next;
+		else
+			*first = object.m_Next;
+		if(object.m_Next != SPATIAL_INVALID)
+			m_Objects[object.m_Next].m_Prev = object.m_Prev;
+	}
+
+	static SpatialOctreeNode octreeNode(const glm::vec3& center, float halfSize, unsigned int parent, unsigned int depth)
+	{
+		SpatialOctreeNode node;
+		node.m_Center = center;
+		node.m_HalfSize = halfSize;
+		node.m_Parent = parent;
+		for(unsigned int i = 0; i < 8; i++)
+			node.m_Children[i] = SPATIAL_INVALID;
+		node.m_First = SPATIAL_INVALID;
+		node.m_Count = 0;
+		node.m_Depth = depth;
+		return node;
+	}
+	static inline bool insideCell(const SpatialOctreeNode& node, const glm::vec3& center)
+	{
+		glm::vec3 offset = glm::abs(center - node.m_Center);
+		return offset.x <= node.m_HalfSize && offset.y <= node.m_HalfSize && offset.z <= node.m_HalfSize;
+	}
+	//a child's loose bounds hold every sphere centered in its cell with a radius up to half the child's half size
+	static inline bool fitsChild(const SpatialOctreeNode& node, float radius)
+	{
+		return node.m_Depth < SPATIAL_OCTREE_MAX_DEPTH && radius <= node.m_HalfSize * 0.25f;
+	}
+	bool octreeKeeps(unsigned int node, const glm::vec3& center, float radius) const
+	{
+		const SpatialOctreeNode& cell = m_Nodes[node];
+		if(node == 0)
+			return !insideCell(cell, center) || !fitsChild(cell, radius);
+		return insideCell(cell, center) && radius <= cell.m_HalfSize * 0.5f && !fitsChild(cell, radius);
+	}
+	//the node an object belongs to, missing nodes on the way are created
+	unsigned int octreeTarget(const glm::vec3& center, float radius)
+	{
+		unsigned int node = 0;
+		if(!insideCell(m_Nodes[0], center))
+			return node;
+		while(fitsChild(m_Nodes[node], radius))
+		{
+			const glm::vec3 nodeCenter = m_Nodes[node].m_Center;
+			unsigned int child = (center.x >= nodeCenter.x ? 1 : 0) | (center.y >= nodeCenter.y ? 2 : 0) | (center.z >= nodeCenter.z ? 4 : 0);
+			if(m_Nodes[node].m_Children[child] == SPATIAL_INVALID)
+			{
+				float childHalfSize = m_Nodes[node].m_HalfSize * 0.5f;
+				glm::vec3 childCenter = nodeCenter + glm::vec3(child & 1 ? childHalfSize : -childHalfSize, child & 2 ? childHalfSize : -childHalfSize, child & 4 ? childHalfSize : -childHalfSize);
+				m_Nodes.push_back(octreeNode(childCenter, childHalfSize, node, m_Nodes[node].m_Depth + 1));
+				m_Nodes[node].m_Children[child] = (unsigned int)m_Nodes.size() - 1;
+			}
+			node = m_Nodes[node].m_Children[child];
+		}
+		return node;
+	}
+	void queryOctree(const glm::vec3& center, float radius, std::vector<unsigned int>& results) const
+	{
+		unsigned int stack[7 * SPATIAL_OCTREE_MAX_DEPTH + 1];
+		unsigned int stackSize = 0;
+		stack[stackSize++] = 0;
+		while(stackSize > 0)
+		{
+			const SpatialOctreeNode& node = m_Nodes[stack[--stackSize]];
+			if(node.m_Count == 0)
+				continue;
+			//the root holds the objects outside of the octree too, so it has no bounds to test
+			if(node.m_Parent != SPATIAL_INVALID)
+			{
+				glm::vec3 offset = glm::max(glm::abs(center - node.m_Center) - 1.5f * node.m_HalfSize, glm::vec3(0.0f));
+				if(glm::dot(offset, offset) > radius * radius)
+					continue;
+			}
+			for(unsigned int id = node.m_First; id != SPATIAL_INVALID; id = m_Objects[id].m_Next)
+			{
+				if(overlaps(m_Objects[id], center, radius))
+					results.push_back(id);
+			}
+			for(unsigned int i = 0; i < 8; i++)
+			{
+				if(node.m_Children[i] != SPATIAL_INVALID)
+					stack[stackSize++] = node.m_Children[i];
+			}
+		}
+	}
+
+	inline int gridCoordinate(float x) const { return (int)std::floor(x * m_InverseCellSize); }
+	inline unsigned int bucket(int x, int y, int z) const
+	{
+		return ((unsigned int)x * 73856093u ^ (unsigned int)y * 19349663u ^ (unsigned int)z * 83492791u) & ((unsigned int)m_Buckets.size() - 1);
+	}
+	//visits the cells the query sphere grown by the largest object can reach, or every bucket once that is fewer lists.
+	//Several cells can share a bucket, so an object only counts in the cell it is actually in
+	void queryGrid(const glm::vec3& center, float radius, std::vector<unsigned int>& results) const
+	{
+		float reach = radius + m_MaxRadius;
+		int minX = gridCoordinate(center.x - reach), minY = gridCoordinate(center.y - reach), minZ = gridCoordinate(center.z - reach);
+		int maxX = gridCoordinate(center.x + reach), maxY = gridCoordinate(center.y + reach), maxZ = gridCoordinate(center.z + reach);
+		double nrOfCells = (double)(maxX - minX + 1) * (double)(maxY - minY + 1) * (double)(maxZ - minZ + 1);
+		if(nrOfCells >= (double)m_Buckets.size())
+		{
+			for(unsigned int b = 0; b < m_Buckets.size(); b++)
+			{
+				for(unsigned int id = m_Buckets[b]; id != SPATIAL_INVALID; id = m_Objects[id].m_Next)
+				{
+					if(overlaps(m_Objects[id], center, radius))
+						results.push_back(id);
+				}
+			}
+			return;
+		}
+		for(int z = minZ; z <= maxZ; z++)
+		{
+			for(int y = minY; y <= maxY; y++)
+			{
+				for(int x = minX; x <= maxX; x++)
+				{
+					for(unsigned int id = m_Buckets[bucket(x, y, z)]; id != SPATIAL_INVALID; id = m_Objects[id].m_Next)
+					{
+						const SpatialObject& object = m_Objects[id];
+						if(object.m_X == x && object.m_Y == y && object.m_Z == z && overlaps(object, center, radius))
+							results.push_back(id);
+					}
+				}
+			}
+		}
+	}
+
+	static inline bool overlaps(const SpatialObject& object, const glm::vec3& center, float radius)
+	{
+		glm::vec3 offset = object.m_Center - center;
+		return glm::dot(offset, offset) <= (radius + object.m_Radius) * (radius + object.m_Radius);
+	}
+};
+
+#endif
@@ -0,0 +1,326 @@
+#ifndef SPHERICAL_HARMONICS_H
+#define SPHERICAL_HARMONICS_H
+
+#include <vector>
+#include <string>
+#include <functional>
+#include "JobSystem.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define SH_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+#define SH_COEFFICIENT_COUNT 9
+#define SH_PROJECT_GRAIN 32 //rows per job
+
+//Order 2 (9 coefficient) spherical harmonics of the irradiance of an environment, evaluated in the shader instead of sampling an irradiance cubemap.
+//The coefficients are already convolved with the cosine lobe and divided by Pi, so evaluating them gives the same value the irradiance convolution shader stores.
+struct SH9Color
+{
+	glm::vec3 coefficients[SH_COEFFICIENT_COUNT];
+
+	SH9Color()
+	{
+		for(unsigned int i = 0; i < SH_COEFFICIENT_COUNT; i++)
+			coefficients[i] = glm::vec3(0.0f);
+	}
+
+	//sets the coefficients as the uniform array name[9]
+	void setUniforms(Shader& shader, const std::string& name) const
+	{
+		for(unsigned int i = 0; i < SH_COEFFICIENT_COUNT; i++)
+			shader.setVec3(name + "[" + std::to_string(i) + "]", coefficients[i]);
+	}
+	//irradiance / Pi in the direction n (normalized), the same as evaluateSH in PBRSecondPass.F.shader
+	glm::vec3 Evaluate(glm::vec3 n) const
+	{
+		glm::vec3 result = coefficients[0] * 0.282095f;
+		result += coefficients[1] * 0.488603f * n.y;
+		result += coefficients[2] * 0.488603f * n.z;
+		result += coefficients[3] * 0.488603f * n.x;
+		result += coefficients[4] * 1.092548f * n.x * n.y;
+		result += coefficients[5] * 1.092548f * n.y * n.z;
+		result += coefficients[6] * 0.315392f * (3.0f * n.z * n.z - 1.0f);
+		result += coefficients[7] * 1.092548f * n.x * n.z;
+		result += coefficients[8] * 0.546274f * (n.x * n.x - n.y * n.y);
+		return glm::max(result, glm::vec3(0.0f));
+	}
+};
+
+//Projects environments onto spherical harmonics on the CPU, the texels are split between threads and each thread works on 4 texels at a time with SSE.
+class SHProjector
+{
+public:
+	//projects the six faces of a cubemap (in the +X, -X, +Y, -Y, +Z, -Z order loadCubemap uses), the colors are used as they are stored like the skybox texture does
+	static bool ProjectCubemap(const std::vector<std::string>& faces, SH9Color& result)
+	{
+		if(faces.size() != 6)
+			return 0;
+
+		std::vector<unsigned char*> data(6, nullptr);
+		int size = 0;
+		bool success = 1;
+		for(unsigned int i = 0; i < 6; i++)
+		{
+			int width, height, channels;
+			data[i] = stbi_load(faces[i].c_str(), &width, &height, &channels, 3);
+			if(!data[i] || width != height || (i > 0 && width != size))
+			{
+				std::cout << "SH projection failed to load cubemap face: " << faces[i] << "\n";
+				success = 0;
+				break;
+			}
+			size = width;
+		}
+
+		if(success)
+		{
+			SampleSource source;
+			source.type = CUBEMAP_SOURCE;
+			source.faces = &data[0];
+			source.width = size;
+			source.height = size;
+			source.rows = size * 6;
+			project(source, result);
+		}
+
+		for(unsigned int i = 0; i < 6; i++)
+			if(data[i])
+				stbi_image_free(data[i]);
+		return success;
+	}
+	//projects an equirectangular (latitude/longitude) HDR image, like the ones in Resources/Textures/equirectangular
+	//expects the image to be loaded top row first (stbi vertical flip disabled), with the same mapping as equirectangularToCubemap.F.shader
+	static bool ProjectEquirectangular(const char* path, SH9Color& result)
+	{
+		int width, height, nrChannels;
+		float* data = stbi_loadf(path, &width, &height, &nrChannels, 3);
+		if(!data)
+		{
+			std::cout << "SH projection failed to load equirectangular map: " << path << "\n";
+			return 0;
+		}
+
+		SampleSource source;
+		source.type = EQUIRECTANGULAR_SOURCE;
+		source.hdr = data;
+		source.width = width;
+		source.height = height;
+		source.rows = height;
+		project(source, result);
+
+		stbi_image_free(data);
+		return 1;
+	}
+private:
+	enum SourceType
+	{
+		CUBEMAP_SOURCE = 0,
+		EQUIRECTANGULAR_SOURCE = 1
+	};
+	struct SampleSource
+	{
+		SourceType type;
+		unsigned char** faces; //cubemap faces, 8 bit RGB
+		float* hdr; //equirectangular image, float RGB
+		int width, height;
+		int rows; //total number of rows over all faces
+	};
+	//un-normalized accumulation of one chunk of rows
+	struct Accumulator
+	{
+		float r[SH_COEFFICIENT_COUNT], g[SH_COEFFICIENT_COUNT], b[SH_COEFFICIENT_COUNT];
+		float weight;
+	};
+
+	static void project(const SampleSource& source, SH9Color& result)
+	{
+		//one accumulator per chunk so the sum doesn't depend on which thread ran what
+		unsigned int nrOfChunks = (source.rows + SH_PROJECT_GRAIN - 1) / SH_PROJECT_GRAIN;
+		std::vector<Accumulator> accumulators(nrOfChunks);
+		GetJobSystem().ParallelFor(source.rows, SH_PROJECT_GRAIN, [&](unsigned int begin, unsigned int end)
+		{
+			projectRows(source, begin, end, &accumulators[begin / SH_PROJECT_GRAIN]);
+		});
+
+		float r[SH_COEFFICIENT_COUNT] = {}, g[SH_COEFFICIENT_COUNT] = {}, b[SH_COEFFICIENT_COUNT] = {};
+		float weight = 0.0f;
+		for(unsigned int i = 0; i < nrOfChunks; i++)
+		{
+			for(unsigned int c = 0; c < SH_COEFFICIENT_COUNT; c++)
+			{
+				r[c] += accumulators[i].r[c];
+				g[c] += accumulators[i].g[c];
+				b[c] += accumulators[i].b[c];
+			}
+			weight += accumulators[i].weight;
+		}
+
+		//the solid angles of the texels should sum up to 4Pi, normalizing removes the error of the approximation.
+		//the cosine lobe convolution scales each band by Pi, 2Pi/3 and Pi/4, which is divided by Pi to match the irradiance map
+		const float band[SH_COEFFICIENT_COUNT] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+		float normalization = weight > 0.0f ? 4.0f * 3.14159265359f / weight : 0.0f;
+		for(unsigned int c = 0; c < SH_COEFFICIENT_COUNT; c++)
+			result.coefficients[c] = glm::vec3(r[c], g[c], b[c]) * normalization * band[c];
+	}
+
+	//builds the directions, solid angles and colors of one row at a time and accumulates them
+	static void projectRows(const SampleSource& source, int firstRow, int lastRow, Accumulator* accumulator)
+	{
+		for(unsigned int c = 0; c < SH_COEFFICIENT_COUNT; c++)
+			accumulator->r[c] = accumulator->g[c] = accumulator->b[c] = 0.0f;
+		accumulator->weight = 0.0f;
+
+		//padded to a multiple of 4 so the SSE loop never needs a scalar tail
+		int paddedWidth = (source.width + 3) & ~3;
+		std::vector<float> x(paddedWidth), y(paddedWidth), z(paddedWidth), w(paddedWidth), r(paddedWidth), g(paddedWidth), b(paddedWidth);
+
+		for(int row = firstRow; row < lastRow; row++)
+		{
+			for(int i = source.width; i < paddedWidth; i++)
+				x[i] = y[i] = z[i] = w[i] = r[i] = g[i] = b[i] = 0.0f;
+
+			if(source.type == CUBEMAP_SOURCE)
+			{
+				int face = row / source.height;
+				int texelRow = row % source.height;
+				const unsigned char* pixels = source.faces[face] + (size_t)texelRow * source.width * 3;
+				float v = 2.0f * (texelRow + 0.5f) / source.height - 1.0f;
+				for(int i = 0; i < source.width; i++)
+				{
+					float u = 2.0f * (i + 0.5f) / source.width - 1.0f;
+					glm::vec3 dir = cubemapDirection(face, u, v);
+					float lengthSquared = 1.0f + u * u + v * v;
+					float invLength = 1.0f / std::sqrt(lengthSquared);
+					x[i] = dir.x * invLength;
+					y[i] = dir.y * invLength;
+					z[i] = dir.z * invLength;
+					//solid angle of the texel, proportional to 1 / (1 + u^2 + v^2)^(3/2)
+					w[i] = invLength * invLength * invLength;
+					r[i] = pixels[i * 3 + 0] / 255.0f;
+					g[i] = pixels[i * 3 + 1] / 255.0f;
+					b[i] = pixels[i * 3 + 2] / 255.0f;
+				}
+			}
+			else
+			{
+				//stbi loads the image top row first, the top of the image is +Y
+				float theta = 3.14159265359f * (row + 0.5f) / source.height;
+				float sinTheta = std::sin(theta);
+				float cosTheta = std::cos(theta);
+				const float* pixels = source.hdr + (size_t)row * source.width * 3;
+				for(int i = 0; i < source.width; i++)
+				{
+					float phi = 2.0f * 3.14159265359f * (i + 0.5f) / source.width - 3.14159265359f;
+					x[i] = sinTheta * std::cos(phi);
+					y[i] = cosTheta;
+					z[i] = sinTheta * std::sin(phi);
+					w[i] = sinTheta;
+					r[i] = pixels[i * 3 + 0];
+					g[i] = pixels[i * 3 + 1];
+					b[i] = pixels[i * 3 + 2];
+				}
+			}
+
+			accumulate(&x[0], &y[0], &z[0], &w[0], &r[0], &g[0], &b[0], paddedWidth, accumulator);
+		}
+	}
+
+	//direction (not normalized) of the texel at u, v in [-1, 1] on a face, as defined by the GL cube map face selection table
+	static glm::vec3 cubemapDirection(int face, float u, float v)
+	{
+		switch(face)
+		{
+			case 0:  return glm::vec3( 1.0f, -v, -u);
+			case 1:  return glm::vec3(-1.0f, -v,  u);
+			case 2:  return glm::vec3( u,  1.0f,  v);
+			case 3:  return glm::vec3( u, -1.0f, -v);
+			case 4:  return glm::vec3( u, -v,  1.0f);
+			default: return glm::vec3(-u, -v, -1.0f);
+		}
+	}
+
+	//adds color * weight * Y(direction) of count samples to the accumulator, count has to be a multiple of 4
+	static void accumulate(const float* x, const float* y, const float* z, const float* w, const float* r, const float* g, const float* b, int count, Accumulator* accumulator)
+	{
+#ifdef SH_USE_SSE
+		__m128 sumR[SH_COEFFICIENT_COUNT], sumG[SH_COEFFICIENT_COUNT], sumB[SH_COEFFICIENT_COUNT];
+		for(unsigned int c = 0; c < SH_COEFFICIENT_COUNT; c++)
+			sumR[c] = sumG[c] = sumB[c] = _mm_setzero_ps();
+		__m128 sumW = _mm_setzero_ps();
+
+		for(int i = 0; i < count; i += 4)
+		{
+			__m128 vx = _mm_loadu_ps(x + i);
+			__m128 vy = _mm_loadu_ps(y + i);
+			__m128 vz = _mm_loadu_ps(z + i);
+			__m128 vw = _mm_loadu_ps(w + i);
+			__m128 vr = _mm_mul_ps(_mm_loadu_ps(r + i), vw);
+			__m128 vg = _mm_mul_ps(_mm_loadu_ps(g + i), vw);
+			__m128 vb = _mm_mul_ps(_mm_loadu_ps(b + i), vw);
+
+			__m128 basis[SH_COEFFICIENT_COUNT];
+			basis[0] = _mm_set1_ps(0.282095f);
+			basis[1] = _mm_mul_ps(_mm_set1_ps(0.488603f), vy);
+			basis[2] = _mm_mul_ps(_mm_set1_ps(0.488603f), vz);
+			basis[3] = _mm_mul_ps(_mm_set1_ps(0.488603f), vx);
+			basis[4] = _mm_mul_ps(_mm_set1_ps(1.092548f), _mm_mul_ps(vx, vy));
+			basis[5] = _mm_mul_ps(_mm_set1_ps(1.092548f), _mm_mul_ps(vy, vz));
+			basis[6] = _mm_mul_ps(_mm_set1_ps(0.315392f), _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(3.0f), _mm_mul_ps(vz, vz)), _mm_set1_ps(1.0f)));
+			basis[7] = _mm_mul_ps(_mm_set1_ps(1.092548f), _mm_mul_ps(vx, vz));
+			basis[8] = _mm_mul_ps(_mm_set1_ps(0.546274f), _mm_sub_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)));
+
+			for(unsigned int c = 0; c < SH_COEFFICIENT_COUNT; c++)
+			{
+				sumR[c] = _mm_add_ps(sumR[c], _mm_mul_ps(vr, basis[c]));
+				sumG[c] = _mm_add_ps(sumG[c], _mm_mul_ps(vg, basis[c]));
+				sumB[c] = _mm_add_ps(sumB[c], _mm_mul_ps(vb, basis[c]));
+			}
+			sumW = _mm_add_ps(sumW, vw);
+		}
+
+		for(unsigned int c = 0; c < SH_COEFFICIENT_COUNT; c++)
+		{
+			accumulator->r[c] += horizontalSum(sumR[c]);
+			accumulator->g[c] += horizontalSum(sumG[c]);
+			accumulator->b[c] += horizontalSum(sumB[c]);
+		}
+		accumulator->weight += horizontalSum(sumW);
+#else
+		for(int i = 0; i < count; i++)
+		{
+			float basis[SH_COEFFICIENT_COUNT] = {
+				0.282095f,
+				0.488603f * y[i],
+				0.488603f * z[i],
+				0.488603f * x[i],
+				1.092548f * x[i] * y[i],
+				1.092548f * y[i] * z[i],
+				0.315392f * (3.0f * z[i] * z[i] - 1.0f),
+				1.092548f * x[i] * z[i],
+				0.546274f * (x[i] * x[i] - y[i] * y[i])
+			};
+			for(unsigned int c = 0; c < SH_COEFFICIENT_COUNT; c++)
+			{
+				accumulator->r[c] += r[i] * w[i] * basis[c];
+				accumulator->g[c] += g[i] * w[i] * basis[c];
+				accumulator->b[c] += b[i] * w[i] * basis[c];
+			}
+			accumulator->weight += w[i];
+		}
+#endif
+	}
+#ifdef SH_USE_SSE
+	static float horizontalSum(__m128 v)
+	{
+		__m128 shuffled = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+		__m128 sums = _mm_add_ps(v, shuffled);
+		shuffled = _mm_movehl_ps(shuffled, sums);
+		sums = _mm_add_ss(sums, shuffled);
+		return _mm_cvtss_f32(sums);
+	}
+#endif
+};
+
+#endif
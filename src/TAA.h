@@ -0,0 +1,148 @@
+#ifndef TAA_H
+#define TAA_H
+
+#define TAA_DEFAULT_FEEDBACK 0.9f
+void renderQuad();
+
+//Temporal anti-aliasing: blends the jittered current frame with a reprojected history buffer.
+//The history is clamped to the current frame's 3x3 neighbourhood so disoccluded or changed pixels don't ghost.
+class TAARenderer
+{
+public:
+	unsigned int m_ID;
+	float m_Feedback;
+	TAARenderer()
+		:m_Init(0), m_ID(0), m_Feedback(TAA_DEFAULT_FEEDBACK), m_CurrentHistory(0), m_ResetHistory(1), m_PrevViewportScale(1.0f)
+	{
+
+	}
+	~TAARenderer()
+	{
+
+	}
+
+	bool Init(unsigned int width, unsigned int height)
+	{
+		if(m_Init) return 1;
+
+		m_Width = width;
+		m_Height = height;
+
+		glGenFramebuffers(1, &m_ID);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_ID);
+
+		//two history buffers that are ping-ponged, one is read as the previous frame while the other is resolved into
+		glGenTextures(2, m_HistoryTextures);
+		for(unsigned int i = 0; i < 2; i++)
+		{
+			glBindTexture(GL_TEXTURE_2D, m_HistoryTextures[i]);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, m_Width, m_Height, 0, GL_RGBA, GL_FLOAT, nullptr);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		}
+
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_HistoryTextures[0], 0);
+		unsigned int attachments[1] = { GL_COLOR_ATTACHMENT0 };
+		glDrawBuffers(1, attachments);
+
+		int status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		if(status != GL_FRAMEBUFFER_COMPLETE)
+		{
+			printf("TAA FRAMEBUFFER ERROR! \nStatus: 0x%x\n", status);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			return 0;
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		m_ResolveShader = new Shader("ProgramFiles\\Resources\\Shaders\\TAA\\TAA.V.shader", "ProgramFiles\\Resources\\Shaders\\TAA\\TAAResolve.F.shader");
+		m_ResolveShader->use();
+		m_ResolveShader->setInt("currentColor", 0);
+		m_ResolveShader->setInt("historyColor", 1);
+		m_ResolveShader->setInt("velocityBuffer", 2);
+		m_ResolveShader->setInt("gDepth", 3);
+		glUseProgram(0);
+
+		m_CurrentHistory = 0;
+		m_ResetHistory = 1;
+		m_Init = 1;
+		return 1;
+	}
+	void Destroy()
+	{
+		glDeleteTextures(2, m_HistoryTextures);
+		glDeleteFramebuffers(1, &m_ID);
+		m_ResolveShader->destroy();
+		delete m_ResolveShader;
+		m_ID = 0;
+		m_Init = 0;
+	}
+
+	//resolves the current (jittered) HDR color buffer against the history and returns the anti-aliased texture
+	//invViewProjection is the current frame's un-jittered inverse view-projection, it's used to reproject pixels without velocity (the skybox)
+	//renderSize is the part of the inputs that was rendered to (dynamic resolution), the history keeps the size it was resolved at
+	unsigned int Resolve(unsigned int currentColor, unsigned int velocityTexture, unsigned int depthTexture, const glm::mat4& invViewProjection, const glm::mat4& prevViewProjection, glm::ivec2 renderSize)
+	{
+		glm::vec2 viewportScale((float)renderSize.x / (float)m_Width, (float)renderSize.y / (float)m_Height);
+		if(m_ResetHistory)
+			m_PrevViewportScale = viewportScale;
+
+		unsigned int target = m_HistoryTextures[m_CurrentHistory];
+		unsigned int history = m_HistoryTextures[1 - m_CurrentHistory];
+
+		glBindFramebuffer(GL_FRAMEBUFFER, m_ID);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
+		glViewport(0, 0, renderSize.x, renderSize.y);
+		glDisable(GL_DEPTH_TEST);
+		glDisable(GL_BLEND);
+
+		m_ResolveShader->use();
+		m_ResolveShader->setVec2("resolution", glm::vec2((float)m_Width, (float)m_Height));
+		m_ResolveShader->setVec2("viewportScale", viewportScale);
+		m_ResolveShader->setVec2("prevViewportScale", m_PrevViewportScale);
+		m_ResolveShader->setFloat("feedback", m_Feedback);
+		m_ResolveShader->setBool("resetHistory", m_ResetHistory);
+		m_ResolveShader->setMat4("invViewProjection", invViewProjection);
+		m_ResolveShader->setMat4("prevViewProjection", prevViewProjection);
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, currentColor);
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, history);
+		glActiveTexture(GL_TEXTURE2);
+		glBindTexture(GL_TEXTURE_2D, velocityTexture);
+		glActiveTexture(GL_TEXTURE3);
+		glBindTexture(GL_TEXTURE_2D, depthTexture);
+
+		renderQuad();
+
+		glUseProgram(0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glEnable(GL_DEPTH_TEST);
+
+		m_CurrentHistory = 1 - m_CurrentHistory;
+		m_PrevViewportScale = viewportScale;
+		m_ResetHistory = 0;
+		return target;
+	}
+	//discards the accumulated history, the next resolve only outputs the current frame
+	void ResetHistory()
+	{
+		m_ResetHistory = 1;
+	}
+	unsigned int HistoryTexture()
+	{
+		return m_HistoryTextures[1 - m_CurrentHistory];
+	}
+private:
+	bool m_Init;
+	unsigned int m_Width, m_Height;
+	unsigned int m_HistoryTextures[2];
+	unsigned int m_CurrentHistory;
+	bool m_ResetHistory;
+	glm::vec2 m_PrevViewportScale;
+	Shader* m_ResolveShader;
+};
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <glad/glad.h>
+#include <stb_image/stb_image.h>
+
+#include <iostream>
+#include <string>
+#include <deque>
+#include "JobSystem.h"
+
+//Decodes a batch of textures on the job system. Load() hands out the texture name right away and starts the decode,
+//Finish() waits for the decodes and uploads the images on the calling thread since that's the one with the GL context.
+//stbi settings like the vertical flip are global, so they shouldn't change between Load() and Finish()
+class TextureLoader
+{
+public:
+	TextureLoader()
+	{
+
+	}
+	~TextureLoader()
+	{
+		Finish();
+	}
+
+	unsigned int Load(const char* path, bool gammaCorrection = false)
+	{
+		m_Pending.push_back(PendingTexture());
+		PendingTexture& texture = m_Pending.back();
+		texture.m_Path = path;
+		texture.m_GammaCorrection = gammaCorrection;
+		texture.m_Data = nullptr;
+		glGenTextures(1, &texture.m_Texture);
+		//deque elements don't move when more are added, so the job can keep the reference
+		GetJobSystem().Run([&texture]()
+		{
+			texture.m_Data = stbi_load(texture.m_Path.c_str(), &texture.m_Width, &texture.m_Height, &texture.m_NrOfComponents, 0);
+		}, &m_Counter);
+		return texture.m_Texture;
+	}
+	void Finish()
+	{
+		GetJobSystem().Wait(m_Counter);
+		for(unsigned int i = 0; i < m_Pending.size(); i++)
+		{
+			PendingTexture& texture = m_Pending[i];
+			if(texture.m_Data)
+				Upload(texture.m_Texture, texture.m_Data, texture.m_Width, texture.m_Height, texture.m_NrOfComponents, texture.m_GammaCorrection);
+			else
+				std::cout << "Texture failed to load at path: " << texture.m_Path << std::endl;
+			stbi_image_free(texture.m_Data);
+		}
+		m_Pending.clear();
+	}
+
+	//fills texture with a decoded 8 bit image with mipmaps, repeat wrapping and trilinear filtering
+	static void Upload(unsigned int texture, const unsigned char* data, int width, int height, int nrComponents, bool gammaCorrection)
+	{
+		GLenum internalFormat = gammaCorrection ? GL_SRGB_ALPHA : GL_RGBA;
+		GLenum dataFormat = GL_RGBA;
+		if(nrComponents == 1)
+			internalFormat = dataFormat = GL_RED;
+		else if(nrComponents == 3)
+		{
+			internalFormat = gammaCorrection ? GL_SRGB : GL_RGB;
+			dataFormat = GL_RGB;
+		}
+
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, dataFormat, GL_UNSIGNED_BYTE, data);
+		glGenerateMipmap(GL_TEXTURE_2D);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	}
+
+private:
+	struct PendingTexture
+	{
+		std::string m_Path;
+		bool m_GammaCorrection;
+		unsigned int m_Texture;
+		unsigned char* m_Data;
+		int m_Width, m_Height, m_NrOfComponents;
+	};
+	std::deque<PendingTexture> m_Pending;
+	JobCounter m_Counter;
+};
+
+#endif
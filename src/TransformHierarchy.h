@@ -0,0 +1,405 @@
+#ifndef TRANSFORM_HIERARCHY_H
+#define TRANSFORM_HIERARCHY_H
+
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#define TRANSFORM_NONE 0xFFFFFFFFu
+
+//Local and world transforms of a node hierarchy stored as flat arrays (structure of arrays). Nodes are kept sorted so every
+//parent comes before its children, so Update() computes all world matrices in one linear pass without following pointers.
+//Transforms are addressed by stable IDs, their position in the arrays changes when nodes are destroyed or reparented.
+//Only nodes whose local transform changed, and their descendants, get new world matrices and world bounds.
+//Levels() orders the nodes by depth, every level can then be updated in parallel with UpdateRange() (see SceneJobs).
+class TransformHierarchy
+{
+public:
+	TransformHierarchy()
+		:m_Unsorted(0), m_LevelsValid(0), m_FirstDirty(0), m_NrOfDirty(0)
+	{
+
+	}
+
+	void Reserve(unsigned int nrOfNodes)
+	{
+		m_Parent.reserve(nrOfNodes);
+		m_Position.reserve(nrOfNodes);
+		m_Rotation.reserve(nrOfNodes);
+		m_Scale.reserve(nrOfNodes);
+		m_World.reserve(nrOfNodes);
+		m_LocalMin.reserve(nrOfNodes);
+		m_LocalMax.reserve(nrOfNodes);
+		m_WorldMin.reserve(nrOfNodes);
+		m_WorldMax.reserve(nrOfNodes);
+		m_Dirty.reserve(nrOfNodes);
+		m_Changed.reserve(nrOfNodes);
+		m_NrOfChildren.reserve(nrOfNodes);
+		m_ID.reserve(nrOfNodes);
+		m_Index.reserve(nrOfNodes);
+	}
+
+	//returns the ID of the new transform, parent is TRANSFORM_NONE for a root
+	unsigned int Create(unsigned int parent = TRANSFORM_NONE, glm::vec3 position = glm::vec3(0.0f), glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3 scale = glm::vec3(1.0f))
+	{
+		unsigned int id;
+		if(!m_FreeIDs.empty())
+		{
+			id = m_FreeIDs.back();
+			m_FreeIDs.pop_back();
+		}
+		else
+		{
+			id = (unsigned int)m_Index.size();
+			m_Index.push_back(-1);
+		}
+
+		//appending keeps the parent in front of the child
+		int index = (int)m_ID.size();
+		int parentIndex = parent != TRANSFORM_NONE && Valid(parent) ? m_Index[parent] : -1;
+		m_Index[id] = index;
+		m_ID.push_back(id);
+		m_Parent.push_back(parentIndex);
+		m_Position.push_back(position);
+		m_Rotation.push_back(rotation);
+		m_Scale.push_back(scale);
+		m_World.push_back(glm::mat4(1.0f));
+		m_LocalMin.push_back(glm::vec3(1.0f));
+		m_LocalMax.push_back(glm::vec3(-1.0f));
+		m_WorldMin.push_back(glm::vec3(1.0f));
+		m_WorldMax.push_back(glm::vec3(-1.0f));
+		m_Dirty.push_back(0);
+		m_Changed.push_back(0);
+		m_NrOfChildren.push_back(0);
+		if(parentIndex >= 0)
+			m_NrOfChildren[parentIndex]++;
+		m_LevelsValid = 0;
+		markDirty(index);
+		return id;
+	}
+	//destroys the transform and all of its descendants, their IDs are appended to removed if given. O(number of nodes after it)
+	void Destroy(unsigned int id, std::vector<unsigned int>* removed = nullptr)
+	{
+		if(!Valid(id))
+			return;
+		if(m_Unsorted)
+			sort();
+
+		int first = m_Index[id];
+		if(m_Parent[first] >= 0)
+			m_NrOfChildren[m_Parent[first]]--;
+
+		//descendants are all behind the node, so one pass finds the whole subtree
+		std::vector<int> remap(m_ID.size() - first);
+		int next = first;
+		for(int i = first; i < (int)m_ID.size(); i++)
+		{
+			int parent = m_Parent[i];
+			bool remove = i == first || (parent >= first && remap[parent - first] < 0);
+			if(remove)
+			{
+				remap[i - first] = -1;
+				if(removed)
+					removed->push_back(m_ID[i]);
+				m_Index[m_ID[i]] = -1;
+				m_FreeIDs.push_back(m_ID[i]);
+				if(m_Dirty[i])
+					m_NrOfDirty--;
+				continue;
+			}
+			remap[i - first] = next;
+			if(parent >= first)
+				parent = remap[parent - first];
+			move(i, next, parent);
+			next++;
+		}
+		resize(next);
+		m_LevelsValid = 0;
+		m_FirstDirty = std::min(m_FirstDirty, (unsigned int)first);
+	}
+	//moves the transform under another parent, TRANSFORM_NONE makes it a root. the local transform is kept
+	void SetParent(unsigned int id, unsigned int parent)
+	{
+		if(!Valid(id))
+			return;
+		int index = m_Index[id];
+		int parentIndex = parent != TRANSFORM_NONE && Valid(parent) ? m_Index[parent] : -1;
+		for(int i = parentIndex; i >= 0; i = m_Parent[i])
+		{
+			if(i == index)
+			{
+				std::cout << "ERROR::TRANSFORM_HIERARCHY::SET_PARENT::A node can't become a child of its own descendant" << std::endl;
+				return;
+			}
+		}
+
+		if(m_Parent[index] >= 0)
+			m_NrOfChildren[m_Parent[index]]--;
+		m_Parent[index] = parentIndex;
+		if(parentIndex >= 0)
+			m_NrOfChildren[parentIndex]++;
+		if(parentIndex > index)
+			m_Unsorted = 1;
+		m_LevelsValid = 0;
+		markDirty(index);
+	}
+
+	void SetPosition(unsigned int id, glm::vec3 position) { int index = m_Index[id]; m_Position[index] = position; markDirty(index); }
+	void SetRotation(unsigned int id, glm::quat rotation) { int index = m_Index[id]; m_Rotation[index] = rotation; markDirty(index); }
+	void SetScale(unsigned int id, glm::vec3 scale) { int index = m_Index[id]; m_Scale[index] = scale; markDirty(index); }
+	void SetLocal(unsigned int id, glm::vec3 position, glm::quat rotation, glm::vec3 scale)
+	{
+		int index = m_Index[id];
+		m_Position[index] = position;
+		m_Rotation[index] = rotation;
+		m_Scale[index] = scale;
+		markDirty(index);
+	}
+	//local space bounding box, nodes without bounds (the default) are left out of culling
+	void SetBounds(unsigned int id, glm::vec3 minimum, glm::vec3 maximum)
+	{
+		int index = m_Index[id];
+		m_LocalMin[index] = minimum;
+		m_LocalMax[index] = maximum;
+		markDirty(index);
+	}
+
+	//recomputes the world matrices and bounds of the changed nodes and their descendants
+	void Update()
+	{
+		if(m_Unsorted)
+			sort();
+		BeginUpdate();
+		//nodes in front of the first dirty one can't have a dirty ancestor
+		if(m_NrOfDirty > 0)
+			UpdateRange(m_FirstDirty, Size());
+		EndUpdate();
+	}
+
+	//Update() split up for parallel updates: BeginUpdate(), then UpdateRange() over the ranges of one level after the other, then EndUpdate().
+	//ranges of the same level may run on different threads, every node only reads its parent
+	void BeginUpdate()
+	{
+		std::fill(m_Changed.begin(), m_Changed.end(), 0);
+	}
+	void UpdateRange(unsigned int begin, unsigned int end)
+	{
+		if(m_NrOfDirty == 0)
+			return;
+		for(unsigned int i = std::max(begin, m_FirstDirty); i < end; i++)
+		{
+			int parent = m_Parent[i];
+			if(!m_Dirty[i] && (parent < 0 || !m_Changed[parent]))
+				continue;
+			glm::mat4 local = localMatrix(i);
+			m_World[i] = parent >= 0 ? m_World[parent] * local : local;
+			updateBounds(i);
+			m_Changed[i] = 1;
+			m_Dirty[i] = 0;
+		}
+	}
+	void EndUpdate()
+	{
+		m_NrOfDirty = 0;
+		m_FirstDirty = Size();
+	}
+	//start of every level and the end of the last one, the nodes are reordered by depth first if needed
+	const std::vector<unsigned int>& Levels()
+	{
+		if(m_Unsorted || !m_LevelsValid)
+			sort();
+		return m_Levels;
+	}
+
+	inline bool Valid(unsigned int id) const { return id < m_Index.size() && m_Index[id] >= 0; }
+	inline unsigned int Size() const { return (unsigned int)m_ID.size(); }
+	inline unsigned int Parent(unsigned int id) const { int parent = m_Parent[m_Index[id]]; return parent >= 0 ? m_ID[parent] : TRANSFORM_NONE; }
+	inline unsigned int NrOfChildren(unsigned int id) const { return m_NrOfChildren[m_Index[id]]; }
+	//scans the nodes behind the transform, O(number of nodes)
+	void Children(unsigned int id, std::vector<unsigned int>& children) const
+	{
+		int index = m_Index[id];
+		for(unsigned int i = 0; i < m_ID.size(); i++)
+			if(m_Parent[i] == index)
+				children.push_back(m_ID[i]);
+	}
+
+	inline const glm::vec3& Position(unsigned int id) const { return m_Position[m_Index[id]]; }
+	inline const glm::quat& Rotation(unsigned int id) const { return m_Rotation[m_Index[id]]; }
+	inline const glm::vec3& Scale(unsigned int id) const { return m_Scale[m_Index[id]]; }
+	inline glm::mat4 Local(unsigned int id) const { return localMatrix(m_Index[id]); }
+	//valid after Update()
+	inline const glm::mat4& World(unsigned int id) const { return m_World[m_Index[id]]; }
+	//whether the world matrix changed in the last Update()
+	inline bool Changed(unsigned int id) const { return m_Changed[m_Index[id]] != 0; }
+	inline bool HasBounds(unsigned int id) const { return hasBounds(m_Index[id]); }
+	inline const glm::vec3& WorldMin(unsigned int id) const { return m_WorldMin[m_Index[id]]; }
+	inline const glm::vec3& WorldMax(unsigned int id) const { return m_WorldMax[m_Index[id]]; }
+
+	//the arrays in hierarchy order for passes that walk all nodes, e.g. culling
+	inline const std::vector<glm::mat4>& WorldMatrices() const { return m_World; }
+	inline const std::vector<unsigned char>& ChangedFlags() const { return m_Changed; }
+	inline const std::vector<glm::vec3>& WorldMins() const { return m_WorldMin; }
+	inline const std::vector<glm::vec3>& WorldMaxs() const { return m_WorldMax; }
+	inline const std::vector<unsigned int>& IDs() const { return m_ID; }
+
+private:
+	//indexed by position in hierarchy order
+	std::vector<int> m_Parent; //position of the parent, -1 for roots
+	std::vector<glm::vec3> m_Position;
+	std::vector<glm::quat> m_Rotation;
+	std::vector<glm::vec3> m_Scale;
+	std::vector<glm::mat4> m_World;
+	std::vector<glm::vec3> m_LocalMin, m_LocalMax; //min > max for nodes without bounds
+	std::vector<glm::vec3> m_WorldMin, m_WorldMax;
+	std::vector<unsigned char> m_Dirty; //the local transform changed since the last update
+	std::vector<unsigned char> m_Changed; //the world matrix was recomputed in the last update
+	std::vector<unsigned int> m_NrOfChildren;
+	std::vector<unsigned int> m_ID;
+
+	std::vector<int> m_Index; //position of every ID, -1 for free IDs
+	std::vector<unsigned int> m_FreeIDs;
+	bool m_Unsorted; //a node was moved under a parent behind it
+	bool m_LevelsValid; //the nodes are ordered by depth and m_Levels is up to date
+	std::vector<unsigned int> m_Levels;
+	unsigned int m_FirstDirty;
+	unsigned int m_NrOfDirty;
+
+	void markDirty(int index)
+	{
+		if(!m_Dirty[index])
+		{
+			m_Dirty[index] = 1;
+			m_NrOfDirty++;
+		}
+		m_FirstDirty = std::min(m_FirstDirty, (unsigned int)index);
+	}
+
+	glm::mat4 localMatrix(unsigned int index) const
+	{
+		//translate * rotate * scale without the full matrix products
+		glm::mat3 rotation = glm::mat3_cast(m_Rotation[index]);
+		const glm::vec3& scale = m_Scale[index];
+		return glm::mat4(glm::vec4(rotation[0] * scale.x, 0.0f), glm::vec4(rotation[1] * scale.y, 0.0f), glm::vec4(rotation[2] * scale.z, 0.0f), glm::vec4(m_Position[index], 1.0f));
+	}
+
+	inline bool hasBounds(unsigned int index) const { return m_LocalMin[index].x <= m_LocalMax[index].x; }
+	//the box around the transformed local box, from its center and the absolute matrix applied to its extents
+	void updateBounds(unsigned int index)
+	{
+		if(!hasBounds(index))
+			return;
+		const glm::mat4& world = m_World[index];
+		glm::vec3 center = glm::vec3(world * glm::vec4((m_LocalMin[index] + m_LocalMax[index]) * 0.5f, 1.0f));
+		glm::vec3 extent = (m_LocalMax[index] - m_LocalMin[index]) * 0.5f;
+		glm::vec3 worldExtent = glm::abs(glm::vec3(world[0])) * extent.x + glm::abs(glm::vec3(world[1])) * extent.y + glm::abs(glm::vec3(world[2])) * extent.z;
+		m_WorldMin[index] = center - worldExtent;
+		m_WorldMax[index] = center + worldExtent;
+	}
+
+	void move(int from, int to, int parent)
+	{
+		m_Parent[to] = parent;
+		if(from == to)
+			return;
+		m_Position[to] = m_Position[from];
+		m_Rotation[to] = m_Rotation[from];
+		m_Scale[to] = m_Scale[from];
+		m_World[to] = m_World[from];
+		m_LocalMin[to] = m_LocalMin[from];
+		m_LocalMax[to] = m_LocalMax[from];
+		m_WorldMin[to] = m_WorldMin[from];
+		m_WorldMax[to] = m_WorldMax[from];
+		m_Dirty[to] = m_Dirty[from];
+		m_Changed[to] = m_Changed[from];
+		m_NrOfChildren[to] = m_NrOfChildren[from];
+		m_ID[to] = m_ID[from];
+		m_Index[m_ID[to]] = to;
+	}
+	void resize(unsigned int size)
+	{
+		m_Parent.resize(size);
+		m_Position.resize(size);
+		m_Rotation.resize(size);
+		m_Scale.resize(size);
+		m_World.resize(size);
+		m_LocalMin.resize(size);
+		m_LocalMax.resize(size);
+		m_WorldMin.resize(size);
+		m_WorldMax.resize(size);
+		m_Dirty.resize(size);
+		m_Changed.resize(size);
+		m_NrOfChildren.resize(size);
+		m_ID.resize(size);
+	}
+
+	//restores the parent before child order by sorting the nodes by depth, a stable counting sort so it stays O(n)
+	void sort()
+	{
+		unsigned int size = (unsigned int)m_ID.size();
+		std::vector<int> depth(size, -1);
+		std::vector<int> chain;
+		unsigned int maxDepth = 0;
+		for(unsigned int i = 0; i < size; i++)
+		{
+			int node = i;
+			while(node >= 0 && depth[node] < 0)
+			{
+				chain.push_back(node);
+				node = m_Parent[node];
+			}
+			int d = node >= 0 ? depth[node] : -1;
+			while(!chain.empty())
+			{
+				depth[chain.back()] = ++d;
+				chain.pop_back();
+			}
+			maxDepth = std::max(maxDepth, (unsigned int)depth[i]);
+		}
+
+		std::vector<unsigned int> offsets(maxDepth + 2, 0);
+		for(unsigned int i = 0; i < size; i++)
+			offsets[depth[i] + 1]++;
+		for(unsigned int d = 1; d < offsets.size(); d++)
+			offsets[d] += offsets[d - 1];
+		m_Levels.assign(offsets.begin(), offsets.end() - (size > 0 ? 0 : 1));
+		std::vector<int> remap(size);
+		for(unsigned int i = 0; i < size; i++)
+			remap[i] = offsets[depth[i]]++;
+
+		permute(m_Position, remap);
+		permute(m_Rotation, remap);
+		permute(m_Scale, remap);
+		permute(m_World, remap);
+		permute(m_LocalMin, remap);
+		permute(m_LocalMax, remap);
+		permute(m_WorldMin, remap);
+		permute(m_WorldMax, remap);
+		permute(m_Dirty, remap);
+		permute(m_Changed, remap);
+		permute(m_NrOfChildren, remap);
+		permute(m_ID, remap);
+		std::vector<int> parents(size);
+		for(unsigned int i = 0; i < size; i++)
+			parents[remap[i]] = m_Parent[i] >= 0 ? remap[m_Parent[i]] : -1;
+		m_Parent.swap(parents);
+		for(unsigned int i = 0; i < size; i++)
+			m_Index[m_ID[i]] = i;
+
+		m_FirstDirty = 0;
+		m_Unsorted = 0;
+		m_LevelsValid = 1;
+	}
+	template<typename T>
+	static void permute(std::vector<T>& values, const std::vector<int>& remap)
+	{
+		std::vector<T> result(values.size());
+		for(unsigned int i = 0; i < values.size(); i++)
+			result[remap[i]] = values[i];
+		values.swap(result);
+	}
+};
+
+#endif
@@ -0,0 +1,470 @@
+#ifndef TRANSPARENCY_H
+#define TRANSPARENCY_H
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <src/shader.h>
+#include <src/SphericalHarmonics.h>
+#include <src/Bounds.h>
+#include <src/HiZOcclusion.h>
+
+#define TRANSPARENCY_MAX_LIGHTS 4
+void renderQuad();
+
+struct TransparentInstance
+{
+	glm::mat4 m_Model;
+	glm::vec4 m_Tint; //multiplies the albedo map, alpha included
+};
+
+//Weighted blended order-independent transparency (McGuire and Bavoil). Every transparent instance is drawn in one instanced draw
+//into an accumulation target (weighted premultiplied color, revealage in alpha) and a target with the summed weights,
+//then one full screen pass composites their weighted average over the lit scene, so nothing has to be sorted.
+//Both targets use the same blend state (rgb added, alpha multiplied by 1 - alpha) since GL 3.3 has no per-attachment blend functions.
+//The opaque depth of the G-buffer is attached read-only, transparent surfaces are depth tested against it but don't write depth.
+//With a HiZOcclusion the instances hidden behind the opaque depth are culled on the GPU, only the kept ones are drawn.
+//Where the context has transform feedback draws the kept instances are drawn as the points of the culling's output, one instance
+//of that draw per triangle of the mesh, which a geometry shader fetches from buffer textures, so their number never comes back to the CPU.
+//Otherwise the counts are polled, a frame whose counts aren't back from the GPU yet draws every instance instead of waiting.
+class TransparencyRenderer
+{
+public:
+	bool m_Enabled;
+
+	TransparencyRenderer()
+		:m_Init(0), m_Enabled(1), m_ID(0), m_VAO(0), m_VertexVBO(0), m_EBO(0), m_InstanceVBO(0), m_IndexCount(0), m_InstanceCapacity(0), m_AlbedoMap(0),
+		m_VertexTexture(0), m_IndexTexture(0), m_Occlusion(nullptr), m_NrOfDrawn(0), m_NrOfDisoccluded(0), m_CullingLate(0), m_NrOfCulledFrames(0), m_NrOfLateFrames(0),
+		m_AccumulationShader(nullptr), m_FeedbackShader(nullptr), m_CompositeShader(nullptr)
+	{
+		for(unsigned int i = 0; i < NR_OF_HIZ_CULL_PASSES; i++)
+		{
+			m_VisibleVAOs[i] = 0;
+			m_VisibleVBOs[i] = 0;
+			m_FeedbackVAOs[i] = 0;
+		}
+	}
+	~TransparencyRenderer()
+	{
+
+	}
+
+	//depthTexture is the G-buffer's depth, it has to be as big as the transparency targets
+	bool Init(unsigned int width, unsigned int height, unsigned int depthTexture)
+	{
+		if(m_Init) return 1;
+
+		m_Width = width;
+		m_Height = height;
+
+		glGenFramebuffers(1, &m_ID);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_ID);
+
+		glGenTextures(1, &m_AccumulationTexture);
+		glBindTexture(GL_TEXTURE_2D, m_AccumulationTexture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, m_Width, m_Height, 0, GL_RGBA, GL_FLOAT, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		glGenTextures(1, &m_WeightTexture);
+		glBindTexture(GL_TEXTURE_2D, m_WeightTexture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R16F, m_Width, m_Height, 0, GL_RED, GL_FLOAT, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_AccumulationTexture, 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_WeightTexture, 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+		unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+		glDrawBuffers(2, attachments);
+
+		int status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		if(status != GL_FRAMEBUFFER_COMPLETE)
+		{
+			printf("TRANSPARENCY FRAMEBUFFER ERROR! \nStatus: 0x%x\n", status);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			return 0;
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		m_AccumulationShader = new Shader("ProgramFiles\\Resources\\Shaders\\Transparency\\Accumulation.V.shader", "ProgramFiles\\Resources\\Shaders\\Transparency\\Accumulation.F.shader");
+		m_AccumulationShader->use();
+		m_AccumulationShader->setInt("albedoMap", 0);
+		m_FeedbackShader = new Shader("ProgramFiles\\Resources\\Shaders\\Transparency\\AccumulationFeedback.V.shader", "ProgramFiles\\Resources\\Shaders\\Transparency\\AccumulationFeedback.G.shader",
+									  "ProgramFiles\\Resources\\Shaders\\Transparency\\Accumulation.F.shader");
+		m_FeedbackShader->use();
+		m_FeedbackShader->setInt("albedoMap", 0);
+		m_FeedbackShader->setInt("meshVertices", 1);
+		m_FeedbackShader->setInt("meshIndices", 2);
+		m_CompositeShader = new Shader("ProgramFiles\\Resources\\Shaders\\Transparency\\Composite.V.shader", "ProgramFiles\\Resources\\Shaders\\Transparency\\Composite.F.shader");
+		m_CompositeShader->use();
+		m_CompositeShader->setInt("accumulation", 0);
+		m_CompositeShader->setInt("weights", 1);
+		glUseProgram(0);
+
+		m_Init = 1;
+		return 1;
+	}
+	void Destroy()
+	{
+		glDeleteTextures(1, &m_AccumulationTexture);
+		glDeleteTextures(1, &m_WeightTexture);
+		glDeleteFramebuffers(1, &m_ID);
+		if(m_VAO)
+		{
+			glDeleteVertexArrays(1, &m_VAO);
+			glDeleteBuffers(1, &m_VertexVBO);
+			glDeleteBuffers(1, &m_EBO);
+			glDeleteBuffers(1, &m_InstanceVBO);
+			glDeleteVertexArrays(NR_OF_HIZ_CULL_PASSES, m_VisibleVAOs);
+			glDeleteBuffers(NR_OF_HIZ_CULL_PASSES, m_VisibleVBOs);
+			glDeleteVertexArrays(NR_OF_HIZ_CULL_PASSES, m_FeedbackVAOs);
+			glDeleteTextures(1, &m_VertexTexture);
+			glDeleteTextures(1, &m_IndexTexture);
+			m_VAO = 0;
+		}
+		Shader* shaders[2] = { m_AccumulationShader, m_FeedbackShader };
+		for(unsigned int i = 0; i < 2; i++)
+		{
+			if(shaders[i])
+			{
+				shaders[i]->destroy();
+				delete shaders[i];
+			}
+		}
+		m_AccumulationShader = nullptr;
+		m_FeedbackShader = nullptr;
+		if(m_CompositeShader)
+		{
+			m_CompositeShader->destroy();
+			delete m_CompositeShader;
+			m_CompositeShader = nullptr;
+		}
+		m_ID = 0;
+		m_Init = 0;
+	}
+
+	//the mesh every instance is drawn with, as an indexed triangle list
+	void SetMesh(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& normals, const std::vector<glm::vec2>& uvs, const std::vector<unsigned int>& indices)
+	{
+		std::vector<float> data;
+		data.reserve(positions.size() * 8);
+		for(unsigned int i = 0; i < positions.size(); i++)
+		{
+			data.push_back(positions[i].x);
+			data.push_back(positions[i].y);
+			data.push_back(positions[i].z);
+			data.push_back(normals[i].x);
+			data.push_back(normals[i].y);
+			data.push_back(normals[i].z);
+			data.push_back(uvs[i].x);
+			data.push_back(uvs[i].y);
+		}
+
+		if(m_VAO == 0)
+		{
+			glGenVertexArrays(1, &m_VAO);
+			glGenBuffers(1, &m_VertexVBO);
+			glGenBuffers(1, &m_EBO);
+			glGenBuffers(1, &m_InstanceVBO);
+			glGenVertexArrays(NR_OF_HIZ_CULL_PASSES, m_VisibleVAOs);
+			glGenBuffers(NR_OF_HIZ_CULL_PASSES, m_VisibleVBOs);
+			glGenVertexArrays(NR_OF_HIZ_CULL_PASSES, m_FeedbackVAOs);
+			glGenTextures(1, &m_VertexTexture);
+			glGenTextures(1, &m_IndexTexture);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, m_VertexVBO);
+		glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		//the same mesh with all instances and with the instances each culling pass kept
+		setupVertexArray(m_VAO, m_InstanceVBO);
+		for(unsigned int i = 0; i < NR_OF_HIZ_CULL_PASSES; i++)
+		{
+			setupVertexArray(m_VisibleVAOs[i], m_VisibleVBOs[i]);
+			setupFeedbackVertexArray(m_FeedbackVAOs[i], m_VisibleVBOs[i]);
+		}
+		//the vertices and indices again as buffer textures for the transform feedback draws, 8 floats are 2 RGBA texels
+		glBindTexture(GL_TEXTURE_BUFFER, m_VertexTexture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_VertexVBO);
+		glBindTexture(GL_TEXTURE_BUFFER, m_IndexTexture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, m_EBO);
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+		m_IndexCount = (unsigned int)indices.size();
+		BoundingSphere sphere;
+		ComputeBounds(&positions[0].x, (unsigned int)positions.size(), 3, m_MeshBounds, sphere);
+	}
+	void SetAlbedoMap(unsigned int albedoMap)
+	{
+		m_AlbedoMap = albedoMap;
+	}
+
+	//filled by the caller every frame, in any order
+	inline std::vector<TransparentInstance>& Instances() { return m_Instances; }
+	inline unsigned int NrOfInstances() const { return (unsigned int)m_Instances.size(); }
+	//of the last Render, the second number is included in the first. Drawn from the transform feedback they are of an earlier frame
+	inline unsigned int NrOfDrawn() const { return m_NrOfDrawn; }
+	inline unsigned int NrOfDisoccluded() const { return m_NrOfDisoccluded; }
+	//whether the last Render drew every instance because the culled counts weren't back yet
+	inline bool CullingLate() const { return m_CullingLate; }
+	//frames drawn with the polled counts, and how many of them had to draw every instance
+	inline unsigned int NrOfCulledFrames() const { return m_NrOfCulledFrames; }
+	inline unsigned int NrOfLateFrames() const { return m_NrOfLateFrames; }
+	void ResetCullingStatistics()
+	{
+		m_NrOfCulledFrames = 0;
+		m_NrOfLateFrames = 0;
+	}
+
+	//uploads this frame's instances, with occlusion the first culling pass keeps the ones visible in the previous frame's depth.
+	//Has to be called every frame before Render, ideally before the G-buffer pass so the GPU culls while the CPU submits the scene
+	void Upload(HiZOcclusion* occlusion)
+	{
+		m_Occlusion = nullptr;
+		m_CullingLate = 0;
+		if(!m_Enabled || m_Instances.empty() || m_VAO == 0)
+			return;
+
+		//the buffer is orphaned every frame so the upload doesn't wait for last frame's draw
+		glBindBuffer(GL_ARRAY_BUFFER, m_InstanceVBO);
+		if(m_Instances.size() > m_InstanceCapacity)
+		{
+			m_InstanceCapacity = (unsigned int)m_Instances.size();
+			//transform feedback can't grow its buffers, they get room for every instance up front
+			for(unsigned int i = 0; i < NR_OF_HIZ_CULL_PASSES; i++)
+			{
+				glBindBuffer(GL_ARRAY_BUFFER, m_VisibleVBOs[i]);
+				glBufferData(GL_ARRAY_BUFFER, m_InstanceCapacity * sizeof(TransparentInstance), nullptr, GL_STREAM_COPY);
+			}
+			glBindBuffer(GL_ARRAY_BUFFER, m_InstanceVBO);
+		}
+		glBufferData(GL_ARRAY_BUFFER, m_InstanceCapacity * sizeof(TransparentInstance), nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, m_Instances.size() * sizeof(TransparentInstance), &m_Instances[0]);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		if(occlusion)
+		{
+			m_Occlusion = occlusion;
+			//drawn from the transform feedback nothing reads the counts before the next Cull restarts the queries, last frame's are usually back by now
+			unsigned int counts[NR_OF_HIZ_CULL_PASSES];
+			if(m_Occlusion->DrawsFromFeedback() && pollCounts(counts))
+			{
+				m_NrOfDisoccluded = counts[HIZ_CULL_DISOCCLUDED];
+				m_NrOfDrawn = counts[HIZ_CULL_VISIBLE] + m_NrOfDisoccluded;
+			}
+			m_Occlusion->Cull(HIZ_CULL_VISIBLE, m_InstanceVBO, (unsigned int)m_Instances.size(), m_MeshBounds.m_Min, m_MeshBounds.m_Max, m_VisibleVBOs[HIZ_CULL_VISIBLE]);
+		}
+		else
+		{
+			m_NrOfDrawn = (unsigned int)m_Instances.size();
+			m_NrOfDisoccluded = 0;
+		}
+	}
+	//the second culling pass, for the instances the first one rejected that are visible in this frame's depth.
+	//The occlusion's newest pyramid has to be built from that depth by now. Called as long before Render as possible,
+	//the GPU work in between is what gives the polled counts time to come back
+	void CullDisoccluded()
+	{
+		if(!m_Occlusion || !m_Enabled || m_Instances.empty() || m_VAO == 0)
+			return;
+		m_Occlusion->Cull(HIZ_CULL_DISOCCLUDED, m_InstanceVBO, (unsigned int)m_Instances.size(), m_MeshBounds.m_Min, m_MeshBounds.m_Max, m_VisibleVBOs[HIZ_CULL_DISOCCLUDED]);
+	}
+
+	//accumulates the instances, the depth attachment has to hold this frame's opaque depth.
+	//With occlusion in Upload CullDisoccluded has to have been called before
+	void Render(const glm::mat4& view, const glm::mat4& projection, glm::vec3 camPos, const glm::vec3* lightPositions, const glm::vec3* lightColors, unsigned int nrOfLights,
+				const SH9Color& irradianceSH, glm::ivec2 renderSize)
+	{
+		if(!m_Enabled || m_Instances.empty() || m_VAO == 0)
+			return;
+
+		//drawn from the transform feedback the counts aren't needed. otherwise they are only polled,
+		//if either pass hasn't finished on the GPU all instances are drawn instead of stalling for it
+		bool feedback = m_Occlusion && m_Occlusion->DrawsFromFeedback();
+		unsigned int counts[NR_OF_HIZ_CULL_PASSES] = {};
+		bool counted = 0;
+		if(m_Occlusion && !feedback)
+		{
+			counted = pollCounts(counts);
+			m_NrOfCulledFrames++;
+			if(counted)
+			{
+				m_NrOfDisoccluded = counts[HIZ_CULL_DISOCCLUDED];
+				m_NrOfDrawn = counts[HIZ_CULL_VISIBLE] + m_NrOfDisoccluded;
+			}
+			else
+			{
+				m_CullingLate = 1;
+				m_NrOfLateFrames++;
+				m_NrOfDisoccluded = 0;
+				m_NrOfDrawn = (unsigned int)m_Instances.size();
+			}
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, m_ID);
+		glViewport(0, 0, renderSize.x, renderSize.y);
+		const float clearAccumulation[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		const float clearWeights[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		glClearBufferfv(GL_COLOR, 0, clearAccumulation);
+		glClearBufferfv(GL_COLOR, 1, clearWeights);
+
+		glEnable(GL_DEPTH_TEST);
+		glDepthFunc(GL_LESS);
+		glDepthMask(GL_FALSE);
+		glEnable(GL_BLEND);
+		glBlendEquation(GL_FUNC_ADD);
+		glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+
+		Shader& shader = feedback ? *m_FeedbackShader : *m_AccumulationShader;
+		shader.use();
+		shader.setMat4("view", view);
+		shader.setMat4("projection", projection);
+		shader.setVec3("camPos", camPos);
+		shader.setInt("nrOfLights", glm::min(nrOfLights, (unsigned int)TRANSPARENCY_MAX_LIGHTS));
+		for(unsigned int i = 0; i < nrOfLights && i < TRANSPARENCY_MAX_LIGHTS; i++)
+		{
+			shader.setVec3("lightPositions[" + std::to_string(i) + "]", lightPositions[i]);
+			shader.setVec3("lightColors[" + std::to_string(i) + "]", lightColors[i]);
+		}
+		irradianceSH.setUniforms(shader, "irradianceSH");
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, m_AlbedoMap);
+
+		if(feedback)
+		{
+			glActiveTexture(GL_TEXTURE1);
+			glBindTexture(GL_TEXTURE_BUFFER, m_VertexTexture);
+			glActiveTexture(GL_TEXTURE2);
+			glBindTexture(GL_TEXTURE_BUFFER, m_IndexTexture);
+			for(unsigned int i = 0; i < NR_OF_HIZ_CULL_PASSES; i++)
+			{
+				glBindVertexArray(m_FeedbackVAOs[i]);
+				m_Occlusion->DrawFeedback((HiZCullPass)i, m_IndexCount / 3);
+			}
+			glActiveTexture(GL_TEXTURE0);
+		}
+		else if(counted)
+		{
+			for(unsigned int i = 0; i < NR_OF_HIZ_CULL_PASSES; i++)
+			{
+				if(counts[i] == 0)
+					continue;
+				glBindVertexArray(m_VisibleVAOs[i]);
+				glDrawElementsInstanced(GL_TRIANGLES, m_IndexCount, GL_UNSIGNED_INT, 0, (GLsizei)counts[i]);
+			}
+		}
+		else
+		{
+			glBindVertexArray(m_VAO);
+			glDrawElementsInstanced(GL_TRIANGLES, m_IndexCount, GL_UNSIGNED_INT, 0, (GLsizei)m_Instances.size());
+		}
+		glBindVertexArray(0);
+
+		glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ZERO);
+		glDisable(GL_BLEND);
+		glDepthMask(GL_TRUE);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+	//blends the weighted average of the transparent layers over the color attachment of framebuffer
+	void Composite(unsigned int framebuffer, glm::ivec2 renderSize)
+	{
+		if(!m_Enabled || m_Instances.empty() || m_VAO == 0)
+			return;
+
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glViewport(0, 0, renderSize.x, renderSize.y);
+		glDisable(GL_DEPTH_TEST);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+		m_CompositeShader->use();
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, m_AccumulationTexture);
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, m_WeightTexture);
+		renderQuad();
+
+		glDisable(GL_BLEND);
+		glEnable(GL_DEPTH_TEST);
+	}
+
+private:
+	bool m_Init;
+	unsigned int m_Width, m_Height;
+	unsigned int m_ID;
+	unsigned int m_AccumulationTexture, m_WeightTexture;
+	unsigned int m_VAO, m_VertexVBO, m_EBO, m_InstanceVBO;
+	unsigned int m_IndexCount;
+	unsigned int m_InstanceCapacity;
+	unsigned int m_AlbedoMap;
+	std::vector<TransparentInstance> m_Instances;
+	BoundingBox m_MeshBounds;
+	unsigned int m_VisibleVAOs[NR_OF_HIZ_CULL_PASSES], m_VisibleVBOs[NR_OF_HIZ_CULL_PASSES]; //instances kept by each culling pass
+	HiZOcclusion* m_Occlusion; //the one of this frame's Upload, null without culling
+	unsigned int m_NrOfDrawn, m_NrOfDisoccluded;
+	bool m_CullingLate;
+	unsigned int m_NrOfCulledFrames, m_NrOfLateFrames;
+	unsigned int m_VertexTexture, m_IndexTexture; //the mesh as buffer textures, read by the transform feedback draws
+	unsigned int m_FeedbackVAOs[NR_OF_HIZ_CULL_PASSES]; //the instances each culling pass kept as vertices
+	Shader* m_AccumulationShader;
+	Shader* m_FeedbackShader; //draws a mesh triangle per instance for every vertex of a transform feedback draw
+	Shader* m_CompositeShader;
+
+	void setupVertexArray(unsigned int vao, unsigned int instanceBuffer)
+	{
+		glBindVertexArray(vao);
+		glBindBuffer(GL_ARRAY_BUFFER, m_VertexVBO);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+		unsigned int stride = 8 * sizeof(float);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
+
+		//per instance model matrix (one column per location) and tint
+		glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+		for(unsigned int i = 0; i < 4; i++)
+		{
+			glEnableVertexAttribArray(3 + i);
+			glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(TransparentInstance), (void*)(i * sizeof(glm::vec4)));
+			glVertexAttribDivisor(3 + i, 1);
+		}
+		glEnableVertexAttribArray(7);
+		glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, sizeof(TransparentInstance), (void*)offsetof(TransparentInstance, m_Tint));
+		glVertexAttribDivisor(7, 1);
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	//false while either culling pass hasn't finished on the GPU
+	bool pollCounts(unsigned int* counts)
+	{
+		bool counted = 1;
+		for(unsigned int i = 0; i < NR_OF_HIZ_CULL_PASSES && counted; i++)
+			counted = m_Occlusion->Count((HiZCullPass)i, counts[i]);
+		return counted;
+	}
+	//the model matrix and tint of every instance in instanceBuffer as one vertex, see AccumulationFeedback.V
+	void setupFeedbackVertexArray(unsigned int vao, unsigned int instanceBuffer)
+	{
+		glBindVertexArray(vao);
+		glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+		for(unsigned int i = 0; i < 5; i++)
+		{
+			glEnableVertexAttribArray(i);
+			glVertexAttribPointer(i, 4, GL_FLOAT, GL_FALSE, sizeof(TransparentInstance), (void*)(i * sizeof(glm::vec4)));
+		}
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+};
+
+#endif
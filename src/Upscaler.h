@@ -0,0 +1,152 @@
+#ifndef UPSCALER_H
+#define UPSCALER_H
+
+#define UPSCALER_DEFAULT_SHARPNESS 0.8f
+void renderQuad();
+
+enum UpscalerPreset
+{
+	UPSCALER_NATIVE = 0,
+	UPSCALER_ULTRA_QUALITY = 1,
+	UPSCALER_QUALITY = 2,
+	UPSCALER_BALANCED = 3,
+	UPSCALER_PERFORMANCE = 4,
+	UPSCALER_PRESET_COUNT
+};
+
+//Spatial edge-adaptive upscaler (in the style of FSR 1): the tone mapped scene is rendered at a lower resolution into this class' input texture
+//and upscaled to the window in a single pass that reconstructs edges along their direction and sharpens the result.
+class SpatialUpscaler
+{
+public:
+	unsigned int m_ID;
+	float m_Sharpness; //0 = no sharpening, 1 = strongest
+	SpatialUpscaler()
+		:m_Init(0), m_ID(0), m_Sharpness(UPSCALER_DEFAULT_SHARPNESS), m_InputTexture(0), m_Width(0), m_Height(0), m_UpscaleShader(nullptr)
+	{
+
+	}
+	~SpatialUpscaler()
+	{
+
+	}
+
+	//width and height are the largest size that can be rendered at
+	bool Init(unsigned int width, unsigned int height)
+	{
+		if(m_Init) return 1;
+
+		m_Width = width;
+		m_Height = height;
+
+		glGenFramebuffers(1, &m_ID);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_ID);
+
+		//the input is already tone mapped and gamma corrected so 8 bits per channel are enough
+		glGenTextures(1, &m_InputTexture);
+		glBindTexture(GL_TEXTURE_2D, m_InputTexture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_InputTexture, 0);
+		unsigned int attachments[1] = { GL_COLOR_ATTACHMENT0 };
+		glDrawBuffers(1, attachments);
+
+		int status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		if(status != GL_FRAMEBUFFER_COMPLETE)
+		{
+			printf("UPSCALER FRAMEBUFFER ERROR! \nStatus: 0x%x\n", status);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			return 0;
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		m_UpscaleShader = new Shader("ProgramFiles\\Resources\\Shaders\\Upscale\\Upscale.V.shader", "ProgramFiles\\Resources\\Shaders\\Upscale\\EdgeAdaptiveUpscale.F.shader");
+		m_UpscaleShader->use();
+		m_UpscaleShader->setInt("inputTexture", 0);
+		glUseProgram(0);
+
+		m_Init = 1;
+		return 1;
+	}
+	void Destroy()
+	{
+		glDeleteTextures(1, &m_InputTexture);
+		glDeleteFramebuffers(1, &m_ID);
+		if(m_UpscaleShader)
+		{
+			m_UpscaleShader->destroy();
+			delete m_UpscaleShader;
+			m_UpscaleShader = nullptr;
+		}
+		m_ID = 0;
+		m_Init = 0;
+	}
+
+	//binds the input texture as the render target, the composite pass renders the scene at inputSize into it
+	void BindInput(glm::ivec2 inputSize)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, m_ID);
+		glViewport(0, 0, inputSize.x, inputSize.y);
+	}
+	//upscales the inputSize part of the input texture to outputSize on the default framebuffer
+	void Upscale(glm::ivec2 inputSize, glm::ivec2 outputSize)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, outputSize.x, outputSize.y);
+		glDisable(GL_DEPTH_TEST);
+		glDisable(GL_BLEND);
+
+		m_UpscaleShader->use();
+		m_UpscaleShader->setVec2("inputSize", glm::vec2(inputSize));
+		m_UpscaleShader->setVec2("outputSize", glm::vec2(outputSize));
+		m_UpscaleShader->setVec2("textureSize", glm::vec2((float)m_Width, (float)m_Height));
+		m_UpscaleShader->setFloat("sharpness", m_Sharpness);
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, m_InputTexture);
+
+		renderQuad();
+
+		glUseProgram(0);
+		glEnable(GL_DEPTH_TEST);
+	}
+	unsigned int InputTexture()
+	{
+		return m_InputTexture;
+	}
+
+	//fraction of the output width/height the scene is rendered at for each preset
+	static float PresetScale(UpscalerPreset preset)
+	{
+		switch(preset)
+		{
+			case UPSCALER_ULTRA_QUALITY: return 0.77f;
+			case UPSCALER_QUALITY:       return 0.67f;
+			case UPSCALER_BALANCED:      return 0.59f;
+			case UPSCALER_PERFORMANCE:   return 0.5f;
+			default:                     return 1.0f;
+		}
+	}
+	static const char* PresetName(UpscalerPreset preset)
+	{
+		switch(preset)
+		{
+			case UPSCALER_ULTRA_QUALITY: return "Ultra Quality (77%)";
+			case UPSCALER_QUALITY:       return "Quality (67%)";
+			case UPSCALER_BALANCED:      return "Balanced (59%)";
+			case UPSCALER_PERFORMANCE:   return "Performance (50%)";
+			default:                     return "Native (100%)";
+		}
+	}
+private:
+	bool m_Init;
+	unsigned int m_InputTexture;
+	unsigned int m_Width, m_Height;
+	Shader* m_UpscaleShader;
+};
+
+#endif
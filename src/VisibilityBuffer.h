@@ -0,0 +1,367 @@
+#ifndef VISIBILITY_BUFFER_H
+#define VISIBILITY_BUFFER_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <src/shader.h>
+#include <src/Framebuffer.h>
+#include <src/Mesh.h>
+
+#define VISIBILITY_BUFFER_MATERIAL_SIZE 512 //every material map is resampled to this size for the material texture arrays
+#define VISIBILITY_BUFFER_FIRST_UNIT 0 //the resolve pass uses texture units VISIBILITY_BUFFER_FIRST_UNIT to VISIBILITY_BUFFER_FIRST_UNIT + 9
+void renderQuad();
+
+struct VisibilityMesh
+{
+	unsigned int m_FirstIndex; //into the shared index buffer
+	unsigned int m_NrOfIndices;
+	unsigned int m_BaseVertex; //added to the mesh's indices
+};
+
+struct VisibilityMaterial
+{
+	unsigned int m_Maps[5]; //albedo, normal, metallic, roughness, ambient occlusion
+	MaterialID m_ID;
+};
+
+struct VisibilityInstance
+{
+	unsigned int m_Mesh;
+	unsigned int m_Material;
+	glm::mat4 m_Model;
+	glm::mat4 m_PrevModel;
+};
+
+//Visibility buffer path for the G-buffer pass: the geometry is rasterized with a position only vertex stream into a target that
+//holds nothing but the triangle ID and instance ID of every pixel, then one full screen pass fetches the 3 vertices of that triangle
+//from texture buffers, reconstructs the perspective correct barycentrics and their screen space derivatives, and writes the
+//G-buffer. Every G-buffer texel is written once however much the geometry overdraws, at the cost of fetching vertices per pixel.
+//GL 3.3 has no bindless textures, so the material maps are resampled into one texture array per map type, a layer per material.
+class VisibilityBuffer
+{
+public:
+	VisibilityBuffer()
+		:m_Init(0), m_ID(0), m_VisibilityTexture(0), m_VAO(0), m_PositionVBO(0), m_VertexBuffer(0), m_IndexBuffer(0),
+		 m_InstanceTransformBuffer(0), m_InstanceDataBuffer(0), m_GeometryShader(nullptr), m_ResolveShader(nullptr)
+	{
+		for(unsigned int i = 0; i < 4; i++)
+			m_BufferTextures[i] = 0;
+		for(unsigned int i = 0; i < 5; i++)
+			m_MaterialArrays[i] = 0;
+	}
+	~VisibilityBuffer()
+	{
+
+	}
+
+	//adds an indexed triangle list, the meshes have to be added before Init. returns the mesh index
+	unsigned int AddMesh(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& normals, const std::vector<glm::vec2>& uvs, const std::vector<unsigned int>& indices)
+	{
+		VisibilityMesh mesh;
+		mesh.m_FirstIndex = (unsigned int)m_Indices.size();
+		mesh.m_NrOfIndices = (unsigned int)indices.size();
+		mesh.m_BaseVertex = (unsigned int)m_Positions.size();
+		for(unsigned int i = 0; i < positions.size(); i++)
+		{
+			m_Positions.push_back(positions[i]);
+			m_VertexData.push_back(glm::vec4(positions[i], uvs[i].x));
+			m_VertexData.push_back(glm::vec4(normals[i], uvs[i].y));
+		}
+		m_Indices.insert(m_Indices.end(), indices.begin(), indices.end());
+		m_Meshes.push_back(mesh);
+		return (unsigned int)m_Meshes.size() - 1;
+	}
+	//for meshes loaded by Model
+	unsigned int AddMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+	{
+		std::vector<glm::vec3> positions(vertices.size()), normals(vertices.size());
+		std::vector<glm::vec2> uvs(vertices.size());
+		for(unsigned int i = 0; i < vertices.size(); i++)
+		{
+			positions[i] = vertices[i].m_Position;
+			normals[i] = vertices[i].m_Normal;
+			uvs[i] = vertices[i].m_TexCoords;
+		}
+		return AddMesh(positions, normals, uvs, indices);
+	}
+	//the maps are copied into the material arrays in Init, so the materials have to be added before it. returns the material index
+	unsigned int AddMaterial(unsigned int albedoMap, unsigned int normalMap, unsigned int metallicMap, unsigned int roughnessMap, unsigned int aoMap, MaterialID id)
+	{
+		VisibilityMaterial material;
+		material.m_Maps[0] = albedoMap;
+		material.m_Maps[1] = normalMap;
+		material.m_Maps[2] = metallicMap;
+		material.m_Maps[3] = roughnessMap;
+		material.m_Maps[4] = aoMap;
+		material.m_ID = id;
+		m_Materials.push_back(material);
+		return (unsigned int)m_Materials.size() - 1;
+	}
+	//instances can be added at any time, returns the instance index
+	unsigned int AddInstance(unsigned int mesh, unsigned int material, const glm::mat4& model = glm::mat4(1.0f))
+	{
+		VisibilityInstance instance;
+		instance.m_Mesh = mesh;
+		instance.m_Material = material;
+		instance.m_Model = model;
+		instance.m_PrevModel = model;
+		m_Instances.push_back(instance);
+		return (unsigned int)m_Instances.size() - 1;
+	}
+	//prevModel is the transform of the previous frame, for the velocity
+	void SetTransform(unsigned int instance, const glm::mat4& model, const glm::mat4& prevModel)
+	{
+		m_Instances[instance].m_Model = model;
+		m_Instances[instance].m_PrevModel = prevModel;
+	}
+
+	//depthTexture is the G-buffer's depth attachment, which the visibility pass renders into so the later passes can use it as usual
+	bool Init(unsigned int depthTexture, unsigned int width, unsigned int height)
+	{
+		if(m_Init) return 1;
+		if(m_Meshes.empty() || m_Materials.empty())
+		{
+			std::cout << "The visibility buffer needs at least one mesh and material before Init" << std::endl;
+			return 0;
+		}
+
+		glGenFramebuffers(1, &m_ID);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_ID);
+		glGenTextures(1, &m_VisibilityTexture);
+		glBindTexture(GL_TEXTURE_2D, m_VisibilityTexture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32UI, width, height, 0, GL_RG_INTEGER, GL_UNSIGNED_INT, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_VisibilityTexture, 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+		int status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		if(status != GL_FRAMEBUFFER_COMPLETE)
+		{
+			printf("VISIBILITY BUFFER FRAMEBUFFER ERROR! \nStatus: 0x%x\n", status);
+			return 0;
+		}
+
+		//the geometry pass only reads positions, the resolve pass reads everything through texture buffers
+		glGenVertexArrays(1, &m_VAO);
+		glGenBuffers(1, &m_PositionVBO);
+		glGenBuffers(1, &m_IndexBuffer);
+		glBindVertexArray(m_VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, m_PositionVBO);
+		glBufferData(GL_ARRAY_BUFFER, m_Positions.size() * sizeof(glm::vec3), &m_Positions[0], GL_STATIC_DRAW);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBuffer);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_Indices.size() * sizeof(unsigned int), &m_Indices[0], GL_STATIC_DRAW);
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		glGenBuffers(1, &m_VertexBuffer);
+		glBindBuffer(GL_TEXTURE_BUFFER, m_VertexBuffer);
+		glBufferData(GL_TEXTURE_BUFFER, m_VertexData.size() * sizeof(glm::vec4), &m_VertexData[0], GL_STATIC_DRAW);
+		glGenBuffers(1, &m_InstanceTransformBuffer);
+		glGenBuffers(1, &m_InstanceDataBuffer);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+		//GL 3.3 texture buffers only take 1, 2 or 4 component formats, so vertices are 2 RGBA32F texels
+		glGenTextures(4, m_BufferTextures);
+		attachBuffer(m_BufferTextures[0], GL_RGBA32F, m_VertexBuffer);
+		attachBuffer(m_BufferTextures[1], GL_R32UI, m_IndexBuffer);
+		attachBuffer(m_BufferTextures[2], GL_RGBA32F, m_InstanceTransformBuffer);
+		attachBuffer(m_BufferTextures[3], GL_RGBA32UI, m_InstanceDataBuffer);
+
+		createMaterialArrays();
+
+		m_GeometryShader = new Shader("ProgramFiles\\Resources\\Shaders\\VisibilityBuffer\\Visibility.V.shader", "ProgramFiles\\Resources\\Shaders\\VisibilityBuffer\\Visibility.F.shader");
+		m_ResolveShader = new Shader("ProgramFiles\\Resources\\Shaders\\VisibilityBuffer\\Resolve.V.shader", "ProgramFiles\\Resources\\Shaders\\VisibilityBuffer\\Resolve.F.shader");
+		m_ResolveShader->use();
+		const char* samplers[10] = { "visibilityBuffer", "vertexData", "indexData", "instanceTransforms", "instanceData",
+									 "albedoMaps", "normalMaps", "metallicMaps", "roughnessMaps", "aoMaps" };
+		for(unsigned int i = 0; i < 10; i++)
+			m_ResolveShader->setInt(samplers[i], VISIBILITY_BUFFER_FIRST_UNIT + i);
+		glUseProgram(0);
+
+		m_Init = 1;
+		return 1;
+	}
+	void Destroy()
+	{
+		glDeleteFramebuffers(1, &m_ID);
+		glDeleteTextures(1, &m_VisibilityTexture);
+		glDeleteTextures(4, m_BufferTextures);
+		glDeleteTextures(5, m_MaterialArrays);
+		unsigned int buffers[5] = { m_PositionVBO, m_IndexBuffer, m_VertexBuffer, m_InstanceTransformBuffer, m_InstanceDataBuffer };
+		glDeleteBuffers(5, buffers);
+		glDeleteVertexArrays(1, &m_VAO);
+		Shader** shaders[2] = { &m_GeometryShader, &m_ResolveShader };
+		for(unsigned int i = 0; i < 2; i++)
+		{
+			if(*shaders[i])
+			{
+				(*shaders[i])->destroy();
+				delete *shaders[i];
+				*shaders[i] = nullptr;
+			}
+		}
+		m_ID = 0;
+		m_Init = 0;
+	}
+
+	//renders the instances into the visibility buffer and the depth texture, then resolves them into gBuffer. the view and projection
+	//have to be the ones the deferred path would use, viewProjection and prevViewProjection are the un-jittered ones for the velocity
+	void Render(Framebuffer& gBuffer, const glm::mat4& view, const glm::mat4& projection, const glm::mat4& viewProjection, const glm::mat4& prevViewProjection, glm::ivec2 renderSize)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, m_ID);
+		glViewport(0, 0, renderSize.x, renderSize.y);
+		glEnable(GL_DEPTH_TEST);
+		glDepthMask(GL_TRUE);
+		glDisable(GL_BLEND);
+		unsigned int clearValue[4] = { 0, 0, 0, 0 };
+		glClearBufferuiv(GL_COLOR, 0, clearValue);
+		glClear(GL_DEPTH_BUFFER_BIT);
+
+		m_GeometryShader->use();
+		m_GeometryShader->setMat4("view", view);
+		m_GeometryShader->setMat4("projection", projection);
+		glBindVertexArray(m_VAO);
+		for(unsigned int i = 0; i < m_Instances.size(); i++)
+		{
+			const VisibilityMesh& mesh = m_Meshes[m_Instances[i].m_Mesh];
+			m_GeometryShader->setMat4("model", m_Instances[i].m_Model);
+			m_GeometryShader->setInt("instanceID", i);
+			glDrawElementsBaseVertex(GL_TRIANGLES, mesh.m_NrOfIndices, GL_UNSIGNED_INT, (void*)(mesh.m_FirstIndex * sizeof(unsigned int)), mesh.m_BaseVertex);
+		}
+		glBindVertexArray(0);
+
+		uploadInstances();
+
+		//every pixel of the render area is written, empty ones with material ID 0, so the G-buffer doesn't need a clear
+		gBuffer.use();
+		glDisable(GL_DEPTH_TEST);
+		glDepthMask(GL_FALSE);
+		m_ResolveShader->use();
+		m_ResolveShader->setMat4("view", view);
+		m_ResolveShader->setMat4("projection", projection);
+		m_ResolveShader->setMat4("viewProjection", viewProjection);
+		m_ResolveShader->setMat4("prevViewProjection", prevViewProjection);
+		m_ResolveShader->setVec2("renderSize", glm::vec2(renderSize));
+		glActiveTexture(GL_TEXTURE0 + VISIBILITY_BUFFER_FIRST_UNIT);
+		glBindTexture(GL_TEXTURE_2D, m_VisibilityTexture);
+		for(unsigned int i = 0; i < 4; i++)
+		{
+			glActiveTexture(GL_TEXTURE0 + VISIBILITY_BUFFER_FIRST_UNIT + 1 + i);
+			glBindTexture(GL_TEXTURE_BUFFER, m_BufferTextures[i]);
+		}
+		for(unsigned int i = 0; i < 5; i++)
+		{
+			glActiveTexture(GL_TEXTURE0 + VISIBILITY_BUFFER_FIRST_UNIT + 5 + i);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, m_MaterialArrays[i]);
+		}
+		renderQuad();
+
+		for(unsigned int i = 0; i < 4; i++)
+		{
+			glActiveTexture(GL_TEXTURE0 + VISIBILITY_BUFFER_FIRST_UNIT + 1 + i);
+			glBindTexture(GL_TEXTURE_BUFFER, 0);
+		}
+		glActiveTexture(GL_TEXTURE0);
+		glDepthMask(GL_TRUE);
+		glEnable(GL_DEPTH_TEST);
+	}
+
+	inline unsigned int NrOfInstances() const { return (unsigned int)m_Instances.size(); }
+	inline unsigned int NrOfTriangles() const
+	{
+		unsigned int triangles = 0;
+		for(unsigned int i = 0; i < m_Instances.size(); i++)
+			triangles += m_Meshes[m_Instances[i].m_Mesh].m_NrOfIndices / 3;
+		return triangles;
+	}
+
+private:
+	bool m_Init;
+	unsigned int m_ID;
+	unsigned int m_VisibilityTexture; //RG32UI: triangle ID within the instance's draw, instance ID + 1 (0 where nothing was drawn)
+	unsigned int m_VAO, m_PositionVBO;
+	unsigned int m_VertexBuffer, m_IndexBuffer, m_InstanceTransformBuffer, m_InstanceDataBuffer;
+	unsigned int m_BufferTextures[4]; //vertices, indices, instance transforms, instance data
+	unsigned int m_MaterialArrays[5]; //same order as VisibilityMaterial::m_Maps
+	Shader* m_GeometryShader;
+	Shader* m_ResolveShader;
+
+	std::vector<glm::vec3> m_Positions;
+	std::vector<glm::vec4> m_VertexData; //position and u, normal and v
+	std::vector<unsigned int> m_Indices;
+	std::vector<VisibilityMesh> m_Meshes;
+	std::vector<VisibilityMaterial> m_Materials;
+	std::vector<VisibilityInstance> m_Instances;
+
+	void attachBuffer(unsigned int texture, unsigned int internalFormat, unsigned int buffer)
+	{
+		glBindTexture(GL_TEXTURE_BUFFER, texture);
+		glTexBuffer(GL_TEXTURE_BUFFER, internalFormat, buffer);
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+	}
+
+	//the transforms are re-uploaded every frame, they're 128 bytes per instance
+	void uploadInstances()
+	{
+		std::vector<glm::vec4> transforms(m_Instances.size() * 8);
+		std::vector<glm::uvec4> data(m_Instances.size());
+		for(unsigned int i = 0; i < m_Instances.size(); i++)
+		{
+			const VisibilityInstance& instance = m_Instances[i];
+			for(unsigned int column = 0; column < 4; column++)
+			{
+				transforms[i * 8 + column] = instance.m_Model[column];
+				transforms[i * 8 + 4 + column] = instance.m_PrevModel[column];
+			}
+			const VisibilityMesh& mesh = m_Meshes[instance.m_Mesh];
+			data[i] = glm::uvec4(mesh.m_FirstIndex, mesh.m_BaseVertex, instance.m_Material, (unsigned int)m_Materials[instance.m_Material].m_ID);
+		}
+		glBindBuffer(GL_TEXTURE_BUFFER, m_InstanceTransformBuffer);
+		glBufferData(GL_TEXTURE_BUFFER, transforms.size() * sizeof(glm::vec4), transforms.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_TEXTURE_BUFFER, m_InstanceDataBuffer);
+		glBufferData(GL_TEXTURE_BUFFER, data.size() * sizeof(glm::uvec4), data.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	}
+
+	//blits every material map into its layer of the array for its map type, scaling it to VISIBILITY_BUFFER_MATERIAL_SIZE
+	void createMaterialArrays()
+	{
+		unsigned int readFBO, drawFBO;
+		glGenFramebuffers(1, &readFBO);
+		glGenFramebuffers(1, &drawFBO);
+		glGenTextures(5, m_MaterialArrays);
+		for(unsigned int map = 0; map < 5; map++)
+		{
+			glBindTexture(GL_TEXTURE_2D_ARRAY, m_MaterialArrays[map]);
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, VISIBILITY_BUFFER_MATERIAL_SIZE, VISIBILITY_BUFFER_MATERIAL_SIZE, (int)m_Materials.size(), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+			for(unsigned int i = 0; i < m_Materials.size(); i++)
+			{
+				int width = 0, height = 0;
+				glBindTexture(GL_TEXTURE_2D, m_Materials[i].m_Maps[map]);
+				glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+				glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+				glBindTexture(GL_TEXTURE_2D, 0);
+
+				glBindFramebuffer(GL_READ_FRAMEBUFFER, readFBO);
+				glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_Materials[i].m_Maps[map], 0);
+				glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFBO);
+				glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_MaterialArrays[map], 0, i);
+				glBlitFramebuffer(0, 0, width, height, 0, 0, VISIBILITY_BUFFER_MATERIAL_SIZE, VISIBILITY_BUFFER_MATERIAL_SIZE, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+			}
+			glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		}
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &readFBO);
+		glDeleteFramebuffers(1, &drawFBO);
+	}
+};
+
+#endif
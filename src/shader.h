@@ -426,6 +426,43 @@ public:
 		glDeleteShader(fragment);
 	}
 
+	//takes in a file path to the vertex and geometry shader (respectively) and the outputs that transform feedback captures, interleaved in that order.
+	//there is no fragment shader, draw with GL_RASTERIZER_DISCARD enabled
+	Shader(const char* vertexPath, const char* geometryPath, const char* const* feedbackVaryings, unsigned int nrOfVaryings)
+	{
+		//the two file constructor reads the second file into the fragment shader
+		m_SourceCode = new ShaderSourceCode(vertexPath, geometryPath);
+		m_SourceCode->m_GeometryShader.swap(m_SourceCode->m_FragmentShader);
+		m_SourceCode->m_FragmentShader = " ";
+
+		const char* vShaderCode = m_SourceCode->m_VertexShader.c_str();
+		const char* gShaderCode = m_SourceCode->m_GeometryShader.c_str();
+
+		unsigned int vertex, geometry;
+
+		//creates and compiles the vertex shader
+		vertex = glCreateShader(GL_VERTEX_SHADER);
+		glShaderSource(vertex, 1, &vShaderCode, NULL);
+		glCompileShader(vertex);
+		checkCompileErrors(vertex, "VERTEX", vertexPath);
+		//creates and compiles the geometry shader
+		geometry = glCreateShader(GL_GEOMETRY_SHADER);
+		glShaderSource(geometry, 1, &gShaderCode, NULL);
+		glCompileShader(geometry);
+		checkCompileErrors(geometry, "GEOMETRY", geometryPath);
+		//creates and links the shader program, the captured outputs have to be declared before linking
+		m_ID = glCreateProgram();
+		glAttachShader(m_ID, vertex);
+		glAttachShader(m_ID, geometry);
+		glTransformFeedbackVaryings(m_ID, nrOfVaryings, feedbackVaryings, GL_INTERLEAVED_ATTRIBS);
+		glLinkProgram(m_ID);
+		checkCompileErrors(m_ID, "PROGRAM", "Program");
+
+		//deletes the shader objects since they won't be used again
+		glDeleteShader(vertex);
+		glDeleteShader(geometry);
+	}
+
 	Shader(ShaderSourceCode& sourceCode)
 	{
 		m_SourceCode = new ShaderSourceCode(sourceCode);